@@ -95,15 +95,20 @@ ext_modules = [
                 "src/accelerator.cc",
                 "src/aperture.cc",
                 "src/config_type.cc",
+                "src/driving_terms.cc",
                 "src/elements.cc",
                 "src/enums.cc",
+                "src/ibs.cc",
                 "src/flame.cc",
                 "src/interpolation.cc",
+                "src/naff.cc",
                 "src/observer.cc",
                 "src/pybind_test.cc",
                 "src/radiation.cc",
+                "src/result_cache.cc",
                 "src/tps.cc",
                 "src/thor_scsi.cc",
+                "src/touschek.cc",
                 "src/custom.cc"
             ]
         ),
@@ -1,10 +1,24 @@
 #include <pybind11/stl.h>
 // #include <pybind11/complex.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
 #include "thor_scsi.h"
 #include <thor_scsi/core/machine.h>
 #include <thor_scsi/std_machine/std_machine.h>
 #include <thor_scsi/std_machine/accelerator.h>
+#include <thor_scsi/std_machine/lattice_hash.h>
+#include <thor_scsi/std_machine/girders.h>
+#include <thor_scsi/std_machine/radiation_summary.h>
+#include <thor_scsi/std_machine/envelope.h>
+#include <thor_scsi/std_machine/dynamic_aperture.h>
+#include <thor_scsi/std_machine/closed_orbit.h>
+#include <thor_scsi/std_machine/twiss.h>
+#include <thor_scsi/std_machine/tune_shift.h>
+#include <thor_scsi/core/girder.h>
+#include <tps/enums.h>
+#include <algorithm>
+#include <optional>
+#include <sstream>
 
 //namespace tse = thor_scsi::elements;
 namespace tsc = thor_scsi::core;
@@ -50,6 +64,229 @@ Warning:\n\
 
 static const char prop_doc[] = "propagate phase space through elements";
 
+static const char content_hash_doc[] = \
+"canonical hash over the element parameters (and calc_config switches if given)\n\
+\n\
+Args:\n\
+   calc_config: if given its switches (radiation, cavity, ...) are included\n\
+\n\
+Returns:\n\
+   64 bit hash, suitable as key for :class:`ResultCache`";
+
+static const char mount_on_girders_doc[] = \
+"mount the elements between girder start and end markers on girders\n\
+\n\
+Args:\n\
+   start_marker: name of the marker starting a girder\n\
+   end_marker:   name of the marker ending a girder\n\
+\n\
+Returns:\n\
+   list of girders in lattice order. Moving a girder moves all elements\n\
+   mounted on it";
+
+static const char radiation_summary_doc[] = \
+"equilibrium emittances, damping times and energy loss computed in C++\n\
+\n\
+Args:\n\
+   calc_config: energy of the beam, results are stored here too\n\
+   A:           fix point (constant part) and linear normal form\n\
+                (Jacobian) of the one turn map with radiation and cavity on\n\
+   alpha_rad:   damping coefficients\n\
+\n\
+Requires radiation delegates installed on the elements. Propagates the\n\
+fix point and A once each and sums the contributions of the delegates.\n\
+\n\
+Returns:\n\
+   :class:`RadiationSummary`";
+
+static const char dynamic_aperture_doc[] = \
+"dynamic aperture by binary search along rays, per momentum offset\n\
+\n\
+Tracking is done in parallel (rays and momentum offsets), in C++.\n\
+\n\
+Args:\n\
+   calc_config: switches of the calculation (copied for each thread)\n\
+   x0:          reference orbit, typically the fix point\n\
+   deltas:      momentum offsets\n\
+   options:     :class:`DynamicApertureOptions`\n\
+\n\
+Returns:\n\
+   :class:`DynamicApertureBoundary`";
+
+static const char survival_map_doc[] = \
+"turns survived on the grid xs x ys (relative to x0) per momentum offset\n\
+\n\
+Returns:\n\
+   :class:`SurvivalMap`, its turns of shape (n_delta, n_y, n_x)";
+
+static const char momentum_aperture_doc[] = \
+"local momentum aperture at the exit of the elements given by indices\n\
+\n\
+Tracking is done in parallel (positions and signs), in C++. A particle\n\
+on the reference orbit x0 receives a momentum kick, completes the turn\n\
+and has to survive options.n_turns further ones.\n\
+\n\
+Returns:\n\
+   :class:`MomentumAperture`, delta_minus negative";
+
+static const char frequency_map_doc[] = \
+"frequency map analysis on the grid xs x second (y or delta)\n\
+\n\
+Each particle is tracked 2 options.n_turns in parallel, in C++; NAFF is\n\
+applied to both halves. Turn by turn data are not returned.\n\
+\n\
+Args:\n\
+   calc_config: switches of the calculation (copied for each thread)\n\
+   x0:          reference orbit; for plane XDelta include a small\n\
+                vertical amplitude\n\
+   plane:       :class:`FrequencyMapPlane`\n\
+\n\
+Returns:\n\
+   :class:`FrequencyMap`, its arrays of shape (n_second, n_x)";
+
+static const char track_chaos_doc[] = \
+"track particles with a chaos indicator (MEGNO or FLI), in parallel\n\
+\n\
+Particles classified chaotic (and regular ones if options.stop_regular)\n\
+are not tracked beyond the classification. The indicators are a finite\n\
+difference estimate from a shadow particle 1e-9 away, not the tangent\n\
+map: round off of about 1e-7 relative per turn limits them, and with\n\
+quantum excitation on they are meaningless.\n\
+\n\
+Args:\n\
+   calc_config: switches of the calculation (copied for each thread)\n\
+   particles:   array of shape (n, 6), initial phase space coordinates\n\
+   options:     :class:`ChaosOptions`\n\
+\n\
+Returns:\n\
+   :class:`ChaosResult`";
+
+static const char find_closed_orbit_doc[] = \
+"closed orbit by Newton iteration, in C++\n\
+\n\
+4D (6D with the cavity on) at the momentum offset x0[delta], see\n\
+:func:`thor_scsi.utils.closed_orbit.compute_closed_orbit`. The Jacobian\n\
+is obtained from an order 1 TPSA map each iteration.\n\
+calc_config.dPparticle is set and follows delta in 6D; a closed orbit\n\
+found is propagated once more for the observers.\n\
+\n\
+Returns:\n\
+   :class:`ClosedOrbitResult`";
+
+static const char find_closed_orbits_doc[] = \
+"closed orbits for many momentum offsets, searched in parallel in C++\n\
+\n\
+Each search starts on the axis at its momentum offset with a copy of\n\
+calc_config. It does not install observers; the ones installed are\n\
+still called, and then the searches run in one thread. The cavities\n\
+have to be off.\n\
+\n\
+Returns:\n\
+   list of :class:`ClosedOrbitResult`";
+
+static const char twiss_along_lattice_doc[] = \
+"Twiss parameters at the exit of each element, in C++\n\
+\n\
+Propagates the normalising map A (6x6, e.g. of compute_map_and_diag)\n\
+around the orbit starting at x0 (default: zero). It does not install\n\
+observers; the ones installed on the elements are still called.\n\
+\n\
+Returns:\n\
+   :class:`Twiss`, its arrays of shape (n_elements, 2) viewing its memory";
+
+static const char tune_shift_doc[] = \
+"tunes depending on amplitude and momentum, from the normal form of the\n\
+one turn map, in C++\n\
+\n\
+The map of the given order is propagated around x0 (default: zero),\n\
+which is expected to be the closed orbit. Cavity and radiation off.\n\
+Use :class:`TuneShiftAnalysis` to keep the TPSA workspace in loops.\n\
+\n\
+Returns:\n\
+   :class:`TuneShift`";
+
+static const char tune_shift_analysis_doc[] = \
+"tunes depending on amplitude and momentum, from the normal form of the\n\
+one turn map\n\
+\n\
+Linear normalisation, Dragt-Finn factorisation and removal of the non\n\
+resonant generators order by order leave K(J_x, J_y, delta);\n\
+nu_k = (mu_k - dK/dJ_k) / (2 pi). A map of order n gives K up to\n\
+degree n + 1: n >= 2 for chromaticities, n >= 3 for the detuning with\n\
+amplitude. The descriptor and the TPSA map are kept between calls.";
+
+static const char envelope_init_doc[] = \
+"linearise each element around the orbit starting at x0\n\
+\n\
+Args:\n\
+   acc:         accelerator, radiation delegates installed for diffusion\n\
+   calc_config: switches (radiation, cavity, ...) of the calculation\n\
+   x0:          start of the orbit, typically the fix point";
+
+/* armadillo stores column major, the arrays returned are row major */
+static py::array_t<double> mat_to_array(const arma::mat& mat)
+{
+	py::array_t<double> result({mat.n_rows, mat.n_cols});
+	auto r = result.mutable_unchecked<2>();
+	for(size_t i = 0; i < mat.n_rows; ++i){
+		for(size_t j = 0; j < mat.n_cols; ++j){
+			r(i, j) = mat(i, j);
+		}
+	}
+	return result;
+}
+
+static py::array_t<double> mats_to_array(const std::vector<arma::mat>& mats)
+{
+	const size_t n = mats.size(), dim = 6;
+	py::array_t<double> result({n, dim, dim});
+	auto r = result.mutable_unchecked<3>();
+	for(size_t k = 0; k < n; ++k){
+		for(size_t i = 0; i < dim; ++i){
+			for(size_t j = 0; j < dim; ++j){
+				r(k, i, j) = mats[k](i, j);
+			}
+		}
+	}
+	return result;
+}
+
+static arma::mat array_to_mat(const py::array_t<double, py::array::c_style | py::array::forcecast>& array)
+{
+	if(array.ndim() != 2){
+		throw std::invalid_argument("expected a 2 dimensional array");
+	}
+	auto a = array.unchecked<2>();
+	arma::mat result(a.shape(0), a.shape(1));
+	for(py::ssize_t i = 0; i < a.shape(0); ++i){
+		for(py::ssize_t j = 0; j < a.shape(1); ++j){
+			result(i, j) = a(i, j);
+		}
+	}
+	return result;
+}
+
+template<typename Types, typename Class>
+void add_methods_girder(py::class_<Class, std::shared_ptr<Class>> t_girder)
+{
+	using double_type = typename Types::double_type;
+
+	t_girder
+		.def(py::init<const std::string&>(), py::arg("name") = "")
+		.def_readwrite("name", &Class::name)
+		.def("set_dx",   [](Class &girder, const double_type dx){girder.getTransform()->setDx(dx);})
+		.def("set_dy",   [](Class &girder, const double_type dy){girder.getTransform()->setDy(dy);})
+		.def("set_roll", [](Class &girder, const double_type roll){girder.getTransform()->setRoll(roll);})
+		.def("get_dx",   [](Class &girder){return girder.getTransform()->getDx();})
+		.def("get_dy",   [](Class &girder){return girder.getTransform()->getDy();})
+		.def("__repr__", [](const Class &girder){
+			std::stringstream strm;
+			girder.show(strm, 0);
+			return strm.str();
+		})
+		;
+}
+
 template<typename Types, typename Class>
 void add_methods_accelerator(py::class_<Class> t_acc)
 {
@@ -78,6 +315,76 @@ void add_methods_accelerator(py::class_<Class> t_acc)
 			)
 #endif
 		//.def("__copy__",             &Class::clone, "make a copy of the accelerator")
+		.def("content_hash", [](const Class& t_acc){ return ts::lattice_hash(t_acc); }, content_hash_doc)
+		.def("content_hash", [](const Class& t_acc, const tsc::ConfigType& conf){ return ts::lattice_hash(t_acc, conf); },
+		     content_hash_doc, py::arg("calc_config"))
+		.def("mount_on_girders", &ts::mount_on_girders<Types>, mount_on_girders_doc,
+		     py::arg("start_marker"), py::arg("end_marker"))
+		.def("unmount_from_girders", &ts::unmount_from_girders<Types>, "remove all elements from their girders")
+		.def("dynamic_aperture", &ts::dynamic_aperture<Types>, dynamic_aperture_doc,
+		     py::arg("calc_config"), py::arg("x0"), py::arg("deltas"),
+		     py::arg("options") = ts::DynamicApertureOptions(),
+		     py::call_guard<py::gil_scoped_release>())
+		.def("survival_map", &ts::survival_map<Types>, survival_map_doc,
+		     py::arg("calc_config"), py::arg("x0"), py::arg("deltas"), py::arg("xs"), py::arg("ys"),
+		     py::arg("options") = ts::DynamicApertureOptions(),
+		     py::call_guard<py::gil_scoped_release>())
+		.def("momentum_aperture", &ts::momentum_aperture<Types>, momentum_aperture_doc,
+		     py::arg("calc_config"), py::arg("x0"), py::arg("indices"),
+		     py::arg("options") = ts::MomentumApertureOptions(),
+		     py::call_guard<py::gil_scoped_release>())
+		.def("frequency_map", &ts::frequency_map<Types>, frequency_map_doc,
+		     py::arg("calc_config"), py::arg("x0"), py::arg("xs"), py::arg("second"),
+		     py::arg("plane") = ts::FrequencyMapPlane::XY,
+		     py::arg("options") = ts::FrequencyMapOptions(),
+		     py::call_guard<py::gil_scoped_release>())
+		.def("track_chaos", [](Class& acc, const tsc::ConfigType& conf,
+				       const py::array_t<double, py::array::c_style | py::array::forcecast>& particles,
+				       const ts::ChaosOptions& options){
+			if(particles.ndim() != 2 || particles.shape(1) != ps_dim){
+				throw std::invalid_argument("track_chaos: expected particles of shape (n, 6)");
+			}
+			auto p = particles.unchecked<2>();
+			std::vector<gtpsa::ss_vect<double>> ps;
+			for(py::ssize_t i = 0; i < p.shape(0); ++i){
+				gtpsa::ss_vect<double> x(0e0);
+				for(int k = 0; k < ps_dim; ++k){
+					x[k] = p(i, k);
+				}
+				ps.push_back(x);
+			}
+			py::gil_scoped_release release;
+			return ts::track_chaos<Types>(acc, conf, ps, options);
+		}, track_chaos_doc, py::arg("calc_config"), py::arg("particles"),
+		     py::arg("options") = ts::ChaosOptions())
+		.def("find_closed_orbit", &ts::find_closed_orbit<Types>, find_closed_orbit_doc,
+		     py::arg("calc_config"), py::arg("x0"),
+		     py::arg("options") = ts::ClosedOrbitOptions())
+		.def("find_closed_orbits", &ts::find_closed_orbits<Types>, find_closed_orbits_doc,
+		     py::arg("calc_config"), py::arg("deltas"),
+		     py::arg("options") = ts::ClosedOrbitOptions(),
+		     py::call_guard<py::gil_scoped_release>())
+		.def("twiss_along_lattice", [](Class& acc, tsc::ConfigType& conf,
+					       const py::array_t<double, py::array::c_style | py::array::forcecast>& A,
+					       const std::optional<ts::ss_vect_dbl>& x0){
+			ts::ss_vect_dbl ps(0e0);
+			ps.set_zero();
+			if(x0){
+				ps = x0->clone();
+			}
+			return ts::twiss_along_lattice<Types>(acc, conf, array_to_mat(A), ps);
+		}, twiss_along_lattice_doc, py::arg("calc_config"), py::arg("A"), py::arg("x0") = py::none())
+		.def("tune_shift", [](Class& acc, tsc::ConfigType& conf, const std::optional<ts::ss_vect_dbl>& x0,
+				      const int order){
+			ts::ss_vect_dbl ps(0e0);
+			ps.set_zero();
+			if(x0){
+				ps = x0->clone();
+			}
+			return ts::tune_shift<Types>(acc, conf, ps, order);
+		}, tune_shift_doc, py::arg("calc_config"), py::arg("x0") = py::none(), py::arg("order") = 3)
+		.def("compute_radiation_summary", &ts::compute_radiation_summary<Types>, radiation_summary_doc,
+		     py::arg("calc_config"), py::arg("A"), py::arg("alpha_rad"))
 		.def("__len__",              &Class::size)
 		.def("__getitem__", py::overload_cast<size_t>(&Class::at))
 		.def("propagate", py::overload_cast<tsc::ConfigType&, ts::ss_vect_dbl&, size_t, int, size_t, bool>(&Class::propagate), prop_doc,
@@ -121,12 +428,265 @@ void py_thor_scsi_init_accelerator(py::module &m)
 
 
 
+	py::class_<tsc::Girder, std::shared_ptr<tsc::Girder>> girder(m, "Girder");
+	add_methods_girder<tsc::StandardDoubleType, tsc::Girder>(girder);
+
+	py::class_<tsc::GirderTpsa, std::shared_ptr<tsc::GirderTpsa>> girderK(m, "GirderTpsa");
+	add_methods_girder<tsc::TpsaVariantType, tsc::GirderTpsa>(girderK);
+
+	py::class_<ts::RadiationSummary>(m, "RadiationSummary")
+		.def_readonly("circumference", &ts::RadiationSummary::circumference)
+		.def_readonly("U0",            &ts::RadiationSummary::U0)
+		.def_readonly("dE",            &ts::RadiationSummary::dE)
+		.def_readonly("sigma_delta",   &ts::RadiationSummary::sigma_delta)
+		.def_readonly("I",             &ts::RadiationSummary::I)
+		.def_readonly("alpha_rad",     &ts::RadiationSummary::alpha_rad)
+		.def_readonly("D_rad",         &ts::RadiationSummary::D_rad)
+		.def_readonly("J",             &ts::RadiationSummary::J)
+		.def_readonly("tau",           &ts::RadiationSummary::tau)
+		.def_readonly("eps",           &ts::RadiationSummary::eps)
+		.def("__repr__", [](const ts::RadiationSummary& s){
+			std::stringstream strm;
+			strm << "RadiationSummary(U0=" << s.U0
+			     << ", eps=[" << s.eps[0] << ", " << s.eps[1] << ", " << s.eps[2] << "]"
+			     << ", tau=[" << s.tau[0] << ", " << s.tau[1] << ", " << s.tau[2] << "]"
+			     << ", J=[" << s.J[0] << ", " << s.J[1] << ", " << s.J[2] << "]"
+			     << ", sigma_delta=" << s.sigma_delta << ")";
+			return strm.str();
+		});
+
+	py::class_<ts::DynamicApertureOptions>(m, "DynamicApertureOptions")
+		.def(py::init<>())
+		.def_readwrite("n_turns",         &ts::DynamicApertureOptions::n_turns)
+		.def_readwrite("n_rays",          &ts::DynamicApertureOptions::n_rays)
+		.def_readwrite("angle_min",       &ts::DynamicApertureOptions::angle_min)
+		.def_readwrite("angle_max",       &ts::DynamicApertureOptions::angle_max)
+		.def_readwrite("r_start",         &ts::DynamicApertureOptions::r_start)
+		.def_readwrite("r_max",           &ts::DynamicApertureOptions::r_max)
+		.def_readwrite("r_tolerance",     &ts::DynamicApertureOptions::r_tolerance)
+		.def_readwrite("amplitude_limit", &ts::DynamicApertureOptions::amplitude_limit)
+		.def_readwrite("n_threads",       &ts::DynamicApertureOptions::n_threads);
+
+	py::class_<ts::DynamicApertureBoundary>(m, "DynamicApertureBoundary")
+		.def_readonly("delta", &ts::DynamicApertureBoundary::delta)
+		.def_readonly("angle", &ts::DynamicApertureBoundary::angle)
+		.def_readonly("x",     &ts::DynamicApertureBoundary::x)
+		.def_readonly("y",     &ts::DynamicApertureBoundary::y)
+		.def_readonly("area",  &ts::DynamicApertureBoundary::area);
+
+	py::class_<ts::SurvivalMap>(m, "SurvivalMap")
+		.def_readonly("delta", &ts::SurvivalMap::delta)
+		.def_readonly("x",     &ts::SurvivalMap::x)
+		.def_readonly("y",     &ts::SurvivalMap::y)
+		.def_property_readonly("turns", [](const ts::SurvivalMap& sm){
+			py::array_t<size_t> result({sm.delta.size(), sm.y.size(), sm.x.size()});
+			std::copy(sm.turns.begin(), sm.turns.end(), result.mutable_data());
+			return result;
+		});
+
+	py::class_<ts::MomentumApertureOptions>(m, "MomentumApertureOptions")
+		.def(py::init<>())
+		.def_readwrite("n_turns",         &ts::MomentumApertureOptions::n_turns)
+		.def_readwrite("delta_max",       &ts::MomentumApertureOptions::delta_max)
+		.def_readwrite("delta_tolerance", &ts::MomentumApertureOptions::delta_tolerance)
+		.def_readwrite("amplitude_limit", &ts::MomentumApertureOptions::amplitude_limit)
+		.def_readwrite("n_threads",       &ts::MomentumApertureOptions::n_threads);
+
+	py::class_<ts::MomentumAperture>(m, "MomentumAperture")
+		.def_readonly("index",       &ts::MomentumAperture::index)
+		.def_readonly("delta_plus",  &ts::MomentumAperture::delta_plus)
+		.def_readonly("delta_minus", &ts::MomentumAperture::delta_minus);
+
+	py::enum_<ts::FrequencyMapPlane>(m, "FrequencyMapPlane")
+		.value("XY",     ts::FrequencyMapPlane::XY)
+		.value("XDelta", ts::FrequencyMapPlane::XDelta);
+
+	py::class_<ts::FrequencyMapOptions>(m, "FrequencyMapOptions")
+		.def(py::init<>())
+		.def_readwrite("n_turns",         &ts::FrequencyMapOptions::n_turns)
+		.def_readwrite("amplitude_limit", &ts::FrequencyMapOptions::amplitude_limit)
+		.def_readwrite("window_order",    &ts::FrequencyMapOptions::window_order)
+		.def_readwrite("n_threads",       &ts::FrequencyMapOptions::n_threads);
+
+	/* grid values as arrays of shape (n_second, n_x) */
+	auto grid_array = [](const ts::FrequencyMap& fm, const auto& values){
+		typedef typename std::decay_t<decltype(values)>::value_type value_type;
+		py::array_t<value_type> result({fm.second.size(), fm.x.size()});
+		std::copy(values.begin(), values.end(), result.mutable_data());
+		return result;
+	};
+	py::class_<ts::FrequencyMap>(m, "FrequencyMap")
+		.def_readonly("plane",  &ts::FrequencyMap::plane)
+		.def_readonly("x",      &ts::FrequencyMap::x)
+		.def_readonly("second", &ts::FrequencyMap::second)
+		.def_property_readonly("nu_x", [grid_array](const ts::FrequencyMap& fm){
+			return py::make_tuple(grid_array(fm, fm.nu_x[0]), grid_array(fm, fm.nu_x[1]));
+		}, "tunes of the first and second half")
+		.def_property_readonly("nu_y", [grid_array](const ts::FrequencyMap& fm){
+			return py::make_tuple(grid_array(fm, fm.nu_y[0]), grid_array(fm, fm.nu_y[1]));
+		}, "tunes of the first and second half")
+		.def_property_readonly("diffusion", [grid_array](const ts::FrequencyMap& fm){
+			return grid_array(fm, fm.diffusion);
+		})
+		.def_property_readonly("lost_turn", [grid_array](const ts::FrequencyMap& fm){
+			return grid_array(fm, fm.lost_turn);
+		});
+
+	py::enum_<ts::ChaosIndicator>(m, "ChaosIndicator")
+		.value("MEGNO", ts::ChaosIndicator::MEGNO)
+		.value("FLI",   ts::ChaosIndicator::FLI);
+
+	py::enum_<ts::ChaosState>(m, "ChaosState")
+		.value("Survived", ts::ChaosState::Survived)
+		.value("Regular",  ts::ChaosState::Regular)
+		.value("Chaotic",  ts::ChaosState::Chaotic)
+		.value("Lost",     ts::ChaosState::Lost);
+
+	py::class_<ts::ChaosOptions>(m, "ChaosOptions")
+		.def(py::init<>())
+		.def_readwrite("indicator",         &ts::ChaosOptions::indicator)
+		.def_readwrite("n_turns",           &ts::ChaosOptions::n_turns)
+		.def_readwrite("min_turns",         &ts::ChaosOptions::min_turns)
+		.def_readwrite("check_interval",    &ts::ChaosOptions::check_interval)
+		.def_readwrite("chaotic_threshold", &ts::ChaosOptions::chaotic_threshold)
+		.def_readwrite("regular_threshold", &ts::ChaosOptions::regular_threshold)
+		.def_readwrite("stop_regular",      &ts::ChaosOptions::stop_regular)
+		.def_readwrite("reversibility",     &ts::ChaosOptions::reversibility)
+		.def_readwrite("amplitude_limit",   &ts::ChaosOptions::amplitude_limit)
+		.def_readwrite("n_threads",         &ts::ChaosOptions::n_threads);
+
+	py::class_<ts::ChaosResult>(m, "ChaosResult")
+		.def_property_readonly("indicator", [](const ts::ChaosResult& r){
+			return py::array_t<double>(r.indicator.size(), r.indicator.data());
+		})
+		.def_property_readonly("turns", [](const ts::ChaosResult& r){
+			return py::array_t<size_t>(r.turns.size(), r.turns.data());
+		})
+		.def_property_readonly("state", [](const ts::ChaosResult& r){
+			py::array_t<int> result(r.state.size());
+			std::transform(r.state.begin(), r.state.end(), result.mutable_data(),
+				       [](const ts::ChaosState s){ return static_cast<int>(s); });
+			return result;
+		}, "as int, see :class:`ChaosState`")
+		.def_property_readonly("reversibility_error", [](const ts::ChaosResult& r){
+			return py::array_t<double>(r.reversibility_error.size(), r.reversibility_error.data());
+		});
+
+	py::class_<ts::ClosedOrbitOptions>(m, "ClosedOrbitOptions")
+		.def(py::init<>())
+		.def_readwrite("max_iter",  &ts::ClosedOrbitOptions::max_iter)
+		.def_readwrite("eps",       &ts::ClosedOrbitOptions::eps)
+		.def_readwrite("n_threads", &ts::ClosedOrbitOptions::n_threads);
+
+	py::class_<ts::ClosedOrbitResult>(m, "ClosedOrbitResult")
+		.def_readonly("found",  &ts::ClosedOrbitResult::found)
+		.def_readonly("x0",     &ts::ClosedOrbitResult::x0)
+		.def_readonly("lost",   &ts::ClosedOrbitResult::lost)
+		.def_readonly("n_iter", &ts::ClosedOrbitResult::n_iter)
+		.def_readonly("dx_abs", &ts::ClosedOrbitResult::dx_abs)
+		.def_property_readonly("one_turn_map", [](const ts::ClosedOrbitResult& r){
+			return mat_to_array(r.one_turn_map);
+		});
+
+	/* arrays of shape (n_elements, 2) sharing the memory of the Twiss object */
+	auto twiss_array = [](py::object self, std::vector<double> ts::Twiss::* member){
+		const auto& twiss = self.cast<const ts::Twiss&>();
+		const auto& values = twiss.*member;
+		return py::array_t<double>({twiss.size(), size_t(2)}, values.data(), self);
+	};
+	py::class_<ts::Twiss>(m, "Twiss")
+		.def("__len__", &ts::Twiss::size)
+		.def_readonly("length", &ts::Twiss::length)
+		.def_property_readonly("s", [](py::object self){
+			const auto& twiss = self.cast<const ts::Twiss&>();
+			return py::array_t<double>(twiss.s.size(), twiss.s.data(), self);
+		})
+		.def_property_readonly("alpha", [twiss_array](py::object self){ return twiss_array(self, &ts::Twiss::alpha); })
+		.def_property_readonly("beta",  [twiss_array](py::object self){ return twiss_array(self, &ts::Twiss::beta); })
+		.def_property_readonly("nu",    [twiss_array](py::object self){ return twiss_array(self, &ts::Twiss::nu); },
+				       "phase advance from the start [2 pi]")
+		.def_property_readonly("eta",   [twiss_array](py::object self){ return twiss_array(self, &ts::Twiss::eta); })
+		.def_property_readonly("etap",  [twiss_array](py::object self){ return twiss_array(self, &ts::Twiss::etap); })
+		.def("lattice_functions", &ts::Twiss::latticeFunctions,
+		     "as input for the intrabeam scattering and Touschek calculations");
+
+	py::class_<ts::TuneShiftTerm>(m, "TuneShiftTerm")
+		.def_readonly("exponents", &ts::TuneShiftTerm::exponents, "powers of J_x, J_y and delta")
+		.def_readonly("nu",        &ts::TuneShiftTerm::nu, "coefficients of nu_x and nu_y")
+		.def("__repr__", [](const ts::TuneShiftTerm& t){
+			std::stringstream strm;
+			strm << "TuneShiftTerm(J_x^" << t.exponents[0] << " J_y^" << t.exponents[1]
+			     << " delta^" << t.exponents[2] << ", nu=[" << t.nu[0] << ", " << t.nu[1] << "])";
+			return strm.str();
+		});
+
+	py::class_<ts::TuneShift>(m, "TuneShift")
+		.def_readonly("order", &ts::TuneShift::order)
+		.def_readonly("nu",    &ts::TuneShift::nu, "fractional tunes on the orbit")
+		.def_readonly("terms", &ts::TuneShift::terms)
+		.def("coefficient",  &ts::TuneShift::coefficient, "of J_x^i J_y^j delta^m in nu_k",
+		     py::arg("k"), py::arg("i"), py::arg("j"), py::arg("m"))
+		.def("detuning",     &ts::TuneShift::detuning, "d nu_k / d J_l", py::arg("k"), py::arg("l"))
+		.def("chromaticity", &ts::TuneShift::chromaticity, "coefficient of delta^m in nu_k",
+		     py::arg("k"), py::arg("m") = 1)
+		.def("tune",         &ts::TuneShift::tune,
+		     py::arg("k"), py::arg("J_x"), py::arg("J_y"), py::arg("delta") = 0e0);
+
 	py::class_<ts::Accelerator, std::shared_ptr<ts::Accelerator>> acc(m, "Accelerator");
 	add_methods_accelerator<tsc::StandardDoubleType, ts::Accelerator>(acc);
 
 	py::class_<ts::AcceleratorTpsa, std::shared_ptr<ts::AcceleratorTpsa>> accK(m, "AcceleratorTpsa");
 	  add_methods_accelerator<tsc::TpsaVariantType, ts::AcceleratorTpsa>(accK);
 
+	py::class_<ts::TuneShiftAnalysis>(m, "TuneShiftAnalysis", tune_shift_analysis_doc)
+		.def(py::init<const int>(), py::arg("order") = 3)
+		.def_property_readonly("order", &ts::TuneShiftAnalysis::getOrder)
+		.def("compute", &ts::TuneShiftAnalysis::compute<tsc::StandardDoubleType>,
+		     py::arg("acc"), py::arg("calc_config"), py::arg("x0"))
+		.def("compute", &ts::TuneShiftAnalysis::compute<tsc::TpsaVariantType>,
+		     py::arg("acc"), py::arg("calc_config"), py::arg("x0"));
+
+	typedef py::array_t<double, py::array::c_style | py::array::forcecast> np_mat;
+	py::class_<ts::EnvelopeTracker>(m, "EnvelopeTracker")
+		.def(py::init<ts::Accelerator&, tsc::ConfigType&, const ts::ss_vect_dbl&>(), envelope_init_doc,
+		     py::arg("acc"), py::arg("calc_config"), py::arg("x0"))
+		.def(py::init<ts::AcceleratorTpsa&, tsc::ConfigType&, const ts::ss_vect_dbl&>(), envelope_init_doc,
+		     py::arg("acc"), py::arg("calc_config"), py::arg("x0"))
+		.def("__len__", &ts::EnvelopeTracker::size)
+		.def("get_map", [](const ts::EnvelopeTracker& t, const size_t i){
+			return mat_to_array(t.getMap(i));
+		}, "Jacobian of element i", py::arg("index"))
+		.def("get_diffusion", [](const ts::EnvelopeTracker& t, const size_t i){
+			return mat_to_array(t.getDiffusion(i));
+		}, "diffusion matrix of element i, at its exit", py::arg("index"))
+		.def("get_one_turn_map", [](const ts::EnvelopeTracker& t){
+			return mat_to_array(t.getOneTurnMap());
+		})
+		.def("get_one_turn_diffusion", [](const ts::EnvelopeTracker& t){
+			return mat_to_array(t.getOneTurnDiffusion());
+		})
+		.def("propagate", [](const ts::EnvelopeTracker& t, const np_mat& sigma, const size_t n_turns){
+			arma::mat s = array_to_mat(sigma);
+			t.propagate(s, n_turns);
+			return mat_to_array(s);
+		}, "sigma matrix after n_turns turns", py::arg("sigma"), py::arg("n_turns") = 1)
+		.def("along_ring", [](const ts::EnvelopeTracker& t, const np_mat& sigma){
+			return mats_to_array(t.alongRing(array_to_mat(sigma)));
+		}, "sigma matrices at the exit of each element, shape (n_elements, 6, 6)", py::arg("sigma"))
+		.def("turn_by_turn", [](const ts::EnvelopeTracker& t, const np_mat& sigma, const size_t n_turns){
+			return mats_to_array(t.turnByTurn(array_to_mat(sigma), n_turns));
+		}, "sigma matrices at the end of each turn, shape (n_turns, 6, 6)", py::arg("sigma"), py::arg("n_turns"))
+		.def("equilibrium", [](const ts::EnvelopeTracker& t){
+			return mat_to_array(t.equilibrium());
+		}, "equilibrium sigma matrix at the start of the turn (Ohmi envelope)");
+
+	m.def("solve_discrete_lyapunov", [](const np_mat& M, const np_mat& B){
+		return mat_to_array(ts::solve_discrete_lyapunov(array_to_mat(M), array_to_mat(B)));
+	}, "solve M S M^T + B = S for S", py::arg("M"), py::arg("B"));
+	m.def("eigen_emittances", [](const np_mat& sigma){
+		return ts::eigen_emittances(array_to_mat(sigma));
+	}, "eigen emittances of a 6x6 sigma matrix, ordered by plane", py::arg("sigma"));
+
 
 }
 /*
@@ -17,6 +17,7 @@ void py_thor_scsi_init_config_type(py::module &m)
       .def_readwrite("Cavity_on",      &tsc::ConfigType::Cavity_on)
       .def_readwrite("radiation",      &tsc::ConfigType::radiation)
       .def_readwrite("emittance",      &tsc::ConfigType::emittance)
+      .def_readwrite("quantum_excitation", &tsc::ConfigType::quantum_excitation)
       .def_readwrite("quad_fringe",    &tsc::ConfigType::quad_fringe)
       .def_readwrite("H_exact",        &tsc::ConfigType::H_exact)
       .def_readwrite("Cart_Bend",      &tsc::ConfigType::Cart_Bend)
@@ -46,6 +47,10 @@ void py_thor_scsi_init_config_type(py::module &m)
       .def_readwrite("ge",             &tsc::ConfigType::ge)
       .def_readwrite("RingType",       &tsc::ConfigType::RingType)
       .def_readwrite("lossplane",      &tsc::ConfigType::lossplane)
+      // quantum excitation
+      .def_readwrite("qe_seed",        &tsc::ConfigType::qe_seed)
+      .def_readwrite("particle_id",    &tsc::ConfigType::particle_id)
+      .def_readwrite("turn",           &tsc::ConfigType::turn)
       // double
       .def_readwrite("dPcommon",       &tsc::ConfigType::dPcommon)
       .def_readwrite("dPparticle",     &tsc::ConfigType::dPparticle)
@@ -0,0 +1,75 @@
+#include <pybind11/pybind11.h>
+#include <pybind11/complex.h>
+#include <pybind11/stl.h>
+#include "thor_scsi.h"
+#include <thor_scsi/std_machine/driving_terms.h>
+#include <sstream>
+
+namespace ts = thor_scsi;
+namespace py = pybind11;
+
+static const char driving_terms_doc[] = \
+"first and second order resonance driving terms of thin multipoles\n\
+\n\
+Per element generator -(b_n L / n) / (1 + delta) Re[(x + eta_x delta + i y)^n]\n\
+expanded up to delta^2 (SLS Note 09/97), second order terms 1/2 sum_{i<j} [f_i, f_j]. Sums of\n\
+unit strength are cached per family (and pair of families) on\n\
+construction, the cross terms computed in parallel. Changing the\n\
+strength of a family afterwards is cheap.\n\
+\n\
+Args:\n\
+   twiss:     :class:`Twiss`, e.g. of Accelerator.twiss_along_lattice\n\
+   families:  list of :class:`DrivingTermFamily`\n\
+   n_threads: 0: all cores";
+
+void py_thor_scsi_init_driving_terms(py::module &m)
+{
+	py::class_<ts::DrivingTermFamily>(m, "DrivingTermFamily")
+		.def(py::init([](const std::string& name, const int n, const std::vector<size_t>& index,
+				 const double strength){
+			return ts::DrivingTermFamily{name, n, index, strength};
+		}), "n: multipole number, index: positions in the Twiss arrays, strength: b_n L of each kick",
+		     py::arg("name"), py::arg("n"), py::arg("index"), py::arg("strength") = 0e0)
+		.def_readwrite("name",     &ts::DrivingTermFamily::name)
+		.def_readwrite("n",        &ts::DrivingTermFamily::n)
+		.def_readwrite("index",    &ts::DrivingTermFamily::index)
+		.def_readwrite("strength", &ts::DrivingTermFamily::strength);
+
+	py::class_<ts::DrivingTerm>(m, "DrivingTerm")
+		.def_readonly("exponents", &ts::DrivingTerm::exponents, "i, j, k, l, m of h_ijklm")
+		.def_readonly("first",     &ts::DrivingTerm::first)
+		.def_readonly("second",    &ts::DrivingTerm::second)
+		.def("__repr__", [](const ts::DrivingTerm& t){
+			std::stringstream strm;
+			strm << "DrivingTerm(h";
+			for(const auto e : t.exponents){
+				strm << e;
+			}
+			strm << ", first=" << t.first << ", second=" << t.second << ")";
+			return strm.str();
+		});
+
+	py::class_<ts::DrivingTerms>(m, "DrivingTerms", driving_terms_doc)
+		.def(py::init<const ts::Twiss&, const std::vector<ts::DrivingTermFamily>&, const size_t>(),
+		     py::arg("twiss"), py::arg("families"), py::arg("n_threads") = 0,
+		     py::call_guard<py::gil_scoped_release>())
+		.def("__len__",        &ts::DrivingTerms::nFamilies)
+		.def("get_family",     &ts::DrivingTerms::getFamily, py::arg("family"))
+		.def("get_strength",   &ts::DrivingTerms::getStrength, py::arg("family"))
+		.def("set_strength",   &ts::DrivingTerms::setStrength, "incremental update",
+		     py::arg("family"), py::arg("strength"))
+		.def("set_strengths",  &ts::DrivingTerms::setStrengths, py::arg("strengths"))
+		.def("first_order",    &ts::DrivingTerms::firstOrder,
+		     py::arg("i"), py::arg("j"), py::arg("k"), py::arg("l"), py::arg("m") = 0)
+		.def("second_order",   &ts::DrivingTerms::secondOrder,
+		     py::arg("i"), py::arg("j"), py::arg("k"), py::arg("l"), py::arg("m") = 0)
+		.def("__call__",       &ts::DrivingTerms::get, "first plus second order term h_ijklm",
+		     py::arg("i"), py::arg("j"), py::arg("k"), py::arg("l"), py::arg("m") = 0)
+		.def("terms",          &ts::DrivingTerms::terms);
+}
+/*
+ * Local Variables:
+ * mode: c++
+ * c-file-style: "python"
+ * End:
+ */
@@ -15,6 +15,7 @@
 #include <thor_scsi/elements/corrector.h>
 #include <thor_scsi/elements/cavity.h>
 #include <thor_scsi/custom/nonlinear_kicker.h>
+#include <thor_scsi/custom/field_map_kick.h>
 
 
 namespace tse = thor_scsi::elements;
@@ -136,6 +137,8 @@ void add_methods_field_kick(py::class_<Class> t_mapper)
 		.def("get_dx",                          [](Class &kick){return kick.getTransform()->getDx();})
 		.def("get_dy",                          [](Class &kick){return kick.getTransform()->getDy();})
 		// .def("get_roll",                        [](Class &kick){kick.getTransform()->getRoll();})
+		.def("set_girder",                      &Class::setGirder, "mount on girder (None: remove from girder)")
+		.def("get_girder",                      &Class::getGirder)
 		.def("is_thick",                        &Class::isThick)
 		.def("as_thick",                        &Class::asThick)
 		.def("get_number_of_integration_steps", &Class::getNumberOfIntegrationSteps)
@@ -150,6 +153,8 @@ void add_methods_field_kick(py::class_<Class> t_mapper)
 		.def("get_entrance_angle",              &Class::getEntranceAngle)
 		.def("set_exit_angle",                  &Class::setExitAngle)
 		.def("get_exit_angle",                  &Class::getExitAngle)
+		.def("set_gap",                         &Class::setGap)
+		.def("get_gap",                         &Class::getGap)
 		.def("get_radiation_delegate",          &Class::getRadiationDelegate)
 		.def("set_radiation_delegate",          &Class::setRadiationDelegate)
 		.def("get_field_interpolator",          &Class::getFieldInterpolator)
@@ -267,6 +272,13 @@ struct TemplatedClasses
 			.def("get_field_interpolator", &nlk::getFieldInterpolator)
 			.def("set_field_interpolator", &nlk::setFieldInterpolator)
 			.def(py::init<const Config &>());
+
+		std::string fmap_name =  "FieldMap" + this->m_suffix;
+		typedef tsu::FieldMapKickKnobbed<C> fmap;
+		py::class_<fmap, std::shared_ptr<fmap>>(this->m_module, fmap_name.c_str(), field_kick)
+			.def("get_field_interpolator", &fmap::getFieldInterpolator)
+			.def("set_field_interpolator", &fmap::setFieldInterpolator)
+			.def(py::init<const Config &>());
 		return elem_type;
 	}
 };
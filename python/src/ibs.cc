@@ -0,0 +1,148 @@
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+#include "thor_scsi.h"
+#include <thor_scsi/std_machine/ibs.h>
+#include <sstream>
+
+namespace ts = thor_scsi;
+namespace py = pybind11;
+
+typedef py::array_t<double, py::array::c_style | py::array::forcecast> np_array;
+
+static const char lattice_functions_doc[] = \
+"lattice functions at a set of positions around the ring (IBS, Touschek)\n\
+\n\
+Args:\n\
+   length: length of each position (weight for the ring average)\n\
+   alpha, beta, eta, etap: arrays of shape (n, 2), index and plane (x, y),\n\
+                           e.g. twiss.sel(par='alpha') of\n\
+                           :func:`compute_twiss_along_lattice`";
+
+static const char growth_rates_doc[] = \
+"intrabeam scattering amplitude growth rates [1/s]\n\
+\n\
+Computed at each position in parallel (n_threads=0: all cores).\n\
+\n\
+Returns:\n\
+   :class:`IBSGrowthRates`: rate (x, y, p) averaged around the ring\n\
+   and local of shape (n, 3)";
+
+static const char equilibrium_doc[] = \
+"equilibrium of radiation damping, quantum excitation and IBS\n\
+\n\
+Args:\n\
+   beam0: zero current beam parameters\n\
+   tau:   amplitude damping times [s] (x, y, z)\n\
+\n\
+Alternatively a :class:`RadiationSummary` provides eps_x, sigma_delta\n\
+and tau; the remaining parameters are taken from beam.\n\
+\n\
+Returns:\n\
+   :class:`BeamParameters` at equilibrium";
+
+static std::vector<double> to_vector(const np_array& array, const char *name)
+{
+	if(array.ndim() != 1){
+		std::stringstream strm;
+		strm << name << ": expected a 1 dimensional array";
+		throw std::invalid_argument(strm.str());
+	}
+	return std::vector<double>(array.data(), array.data() + array.size());
+}
+
+static std::array<std::vector<double>, 2> to_planes(const np_array& array, const char *name)
+{
+	if(array.ndim() != 2 || array.shape(1) != 2){
+		std::stringstream strm;
+		strm << name << ": expected an array of shape (n, 2)";
+		throw std::invalid_argument(strm.str());
+	}
+	auto a = array.unchecked<2>();
+	std::array<std::vector<double>, 2> result;
+	for(int k = 0; k < 2; ++k){
+		result[k].resize(a.shape(0));
+		for(py::ssize_t i = 0; i < a.shape(0); ++i){
+			result[k][i] = a(i, k);
+		}
+	}
+	return result;
+}
+
+void py_thor_scsi_init_ibs(py::module &m)
+{
+	py::enum_<ts::IBSModel>(m, "IBSModel")
+		.value("BjorkenMtingwa", ts::IBSModel::BjorkenMtingwa)
+		.value("Bane",           ts::IBSModel::Bane);
+
+	py::class_<ts::LatticeFunctions>(m, "LatticeFunctions", lattice_functions_doc)
+		.def(py::init([](const np_array& length, const np_array& alpha, const np_array& beta,
+				 const np_array& eta, const np_array& etap){
+			ts::LatticeFunctions lf;
+			lf.length = to_vector(length, "length");
+			lf.alpha = to_planes(alpha, "alpha");
+			lf.beta = to_planes(beta, "beta");
+			lf.eta = to_planes(eta, "eta");
+			lf.etap = to_planes(etap, "etap");
+			lf.check();
+			return lf;
+		}), py::arg("length"), py::arg("alpha"), py::arg("beta"), py::arg("eta"), py::arg("etap"))
+		.def("__len__", &ts::LatticeFunctions::size);
+
+	py::class_<ts::BeamParameters>(m, "BeamParameters")
+		.def(py::init<>())
+		.def_readwrite("energy",      &ts::BeamParameters::energy)
+		.def_readwrite("n_particles", &ts::BeamParameters::n_particles)
+		.def_readwrite("eps",         &ts::BeamParameters::eps)
+		.def_readwrite("sigma_delta", &ts::BeamParameters::sigma_delta)
+		.def_readwrite("sigma_s",     &ts::BeamParameters::sigma_s)
+		.def_readwrite("coulomb_log", &ts::BeamParameters::coulomb_log)
+		.def("__repr__", [](const ts::BeamParameters& b){
+			std::stringstream strm;
+			strm << "BeamParameters(energy=" << b.energy << ", n_particles=" << b.n_particles
+			     << ", eps=[" << b.eps[0] << ", " << b.eps[1] << "]"
+			     << ", sigma_delta=" << b.sigma_delta << ", sigma_s=" << b.sigma_s
+			     << ", coulomb_log=" << b.coulomb_log << ")";
+			return strm.str();
+		});
+
+	py::class_<ts::IBSGrowthRates>(m, "IBSGrowthRates")
+		.def_readonly("rate", &ts::IBSGrowthRates::rate)
+		.def_property_readonly("local", [](const ts::IBSGrowthRates& r){
+			const size_t n = r.local[0].size();
+			py::array_t<double> result({n, size_t(3)});
+			auto a = result.mutable_unchecked<2>();
+			for(size_t i = 0; i < n; ++i){
+				for(size_t k = 0; k < 3; ++k){
+					a(i, k) = r.local[k][i];
+				}
+			}
+			return result;
+		});
+
+	m.def("ibs_growth_rates", &ts::ibs_growth_rates, growth_rates_doc,
+	      py::arg("lattice_functions"), py::arg("beam"),
+	      py::arg("model") = ts::IBSModel::BjorkenMtingwa, py::arg("n_threads") = 0,
+	      py::call_guard<py::gil_scoped_release>());
+	m.def("ibs_equilibrium",
+	      py::overload_cast<const ts::LatticeFunctions&, const ts::BeamParameters&, const std::array<double, 3>&,
+	      const ts::IBSModel, const double, const int, const size_t>(&ts::ibs_equilibrium),
+	      equilibrium_doc,
+	      py::arg("lattice_functions"), py::arg("beam0"), py::arg("tau"),
+	      py::arg("model") = ts::IBSModel::BjorkenMtingwa, py::arg("tolerance") = 1e-6,
+	      py::arg("max_iter") = 100, py::arg("n_threads") = 0,
+	      py::call_guard<py::gil_scoped_release>());
+	m.def("ibs_equilibrium",
+	      py::overload_cast<const ts::LatticeFunctions&, const ts::RadiationSummary&, const ts::BeamParameters&,
+	      const ts::IBSModel, const double, const int, const size_t>(&ts::ibs_equilibrium),
+	      py::arg("lattice_functions"), py::arg("summary"), py::arg("beam"),
+	      py::arg("model") = ts::IBSModel::BjorkenMtingwa, py::arg("tolerance") = 1e-6,
+	      py::arg("max_iter") = 100, py::arg("n_threads") = 0,
+	      py::call_guard<py::gil_scoped_release>());
+}
+/*
+ * Local Variables:
+ * mode: c++
+ * c-file-style: "python"
+ * End:
+ */
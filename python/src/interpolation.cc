@@ -6,7 +6,9 @@
 #include <pybind11/pytypes.h>
 #include <thor_scsi/core/field_interpolation.h>
 #include <thor_scsi/core/multipoles.h>
+#include <algorithm>
 #include <complex>
+#include <vector>
 
 namespace py = pybind11;
 namespace tsc = thor_scsi::core;
@@ -16,6 +18,7 @@ typedef std::complex<double> cdbl_intern;
 
 #include <thor_scsi/custom/aircoil_interpolation.h>
 #include <thor_scsi/custom/nonlinear_kicker_interpolation.h>
+#include <thor_scsi/custom/field_map_interpolation.h>
 namespace tsu = thor_scsi::custom;
 
 template<class C>
@@ -124,6 +127,46 @@ public:
 };
 
 
+/*
+ * x and y of any (but the same) shape, field returned in that shape.
+ * The GIL is released unless the interpolation is implemented in python
+ */
+template<class C, class PyClass>
+static void add_methods_batch(PyClass& a_class)
+{
+	using Interpolation = tsc::Field2DInterpolationKnobbed<C>;
+	using array_in = py::array_t<double, py::array::c_style|py::array::forcecast>;
+	using batch_method = void (Interpolation::*)(const double *, const double *, double *, double *, const size_t) const;
+
+	auto batch = [](const Interpolation& inst, const array_in& x, const array_in& y, batch_method method){
+		if(x.ndim() != y.ndim() || !std::equal(x.shape(), x.shape() + x.ndim(), y.shape())){
+			throw std::invalid_argument("x and y must have the same shape");
+		}
+		const std::vector<py::ssize_t> shape(x.shape(), x.shape() + x.ndim());
+		py::array_t<double> t_x(shape), t_y(shape);
+		const double *px = x.data(), *py_ = y.data();
+		double *pBx = t_x.mutable_data(), *pBy = t_y.mutable_data();
+		const size_t n = x.size();
+		if(dynamic_cast<const PyField2DInterpolation<C> *>(&inst)){
+			(inst.*method)(px, py_, pBx, pBy, n);
+		} else {
+			py::gil_scoped_release release;
+			(inst.*method)(px, py_, pBx, pBy, n);
+		}
+		return py::make_tuple(t_x, t_y);
+	};
+
+	a_class
+		.def("field_batch", [batch](const Interpolation& inst, const array_in& x, const array_in& y){
+			return batch(inst, x, y, &Interpolation::field_batch);
+		}, "field at all points (x[i], y[i]): returns arrays (Bx, By) of the shape of x",
+		     py::arg("x"), py::arg("y"))
+		.def("gradient_batch", [batch](const Interpolation& inst, const array_in& x, const array_in& y){
+			return batch(inst, x, y, &Interpolation::gradient_batch);
+		}, "gradient at all points (x[i], y[i]): returns arrays (Gx, Gy) of the shape of x",
+		     py::arg("x"), py::arg("y"));
+}
+
 template<typename Types, typename Class>
 void add_methods_interpolation(py::class_<Class> t_mapper)
 {
@@ -163,6 +206,21 @@ void add_methods_multipoles(py::class_<Class> t_mapper)
 }
 
 
+template<class C>
+static void add_methods_field_map(py::class_<tsu::FieldMapInterpolationKnobbed<C>, std::shared_ptr<tsu::FieldMapInterpolationKnobbed<C>>>& a_class)
+{
+	using FieldMap = tsu::FieldMapInterpolationKnobbed<C>;
+	a_class
+	    .def(py::init<const std::string&, const double>(), "bicubic interpolation of a field map file",
+		 py::arg("filename"), py::arg("scale") = 1e0)
+	    .def("set_scale", &FieldMap::setScale)
+	    .def("get_scale", &FieldMap::getScale)
+	    .def("get_grid", [](const FieldMap& inst){
+		    return std::const_pointer_cast<tsu::FieldMapGrid>(inst.getGrid());
+		})
+	    ;
+}
+
 static const std::vector<tsu::aircoil_filament_t>
 aircoil_filaments_from_array(const py::array_t<tsu::aircoil_filament_t>& input)
 {
@@ -190,6 +248,7 @@ void py_thor_scsi_init_field_interpolation(py::module &m) {
 		>
 		field2dintp (m, "Field2DInterpolation");
 	add_methods_interpolation<tsc::StandardDoubleType, tsc::Field2DInterpolation>(field2dintp);
+	add_methods_batch<tsc::StandardDoubleType>(field2dintp);
 
 	py::class_<
 		tsc::Field2DInterpolationDependence,
@@ -197,6 +256,7 @@ void py_thor_scsi_init_field_interpolation(py::module &m) {
 		std::shared_ptr<tsc::Field2DInterpolationDependence>
 		> field2dintpvar(m, "Field2DInterpolationDependence");
 	add_methods_interpolation<tsc::StandardDoubleType, tsc::Field2DInterpolation>(field2dintpvar);
+	add_methods_batch<tsc::TpsaVariantType>(field2dintpvar);
 	field2dintpvar
             .def(py::init<>());
 
@@ -348,6 +408,23 @@ void py_thor_scsi_init_field_interpolation(py::module &m) {
         ;
 
 
+	py::class_<tsu::aircoil_expansion_report_t> aircoil_report(m, "AirCoilExpansionReport");
+	aircoil_report
+	    .def_readonly("radius",        &tsu::aircoil_expansion_report_t::radius)
+	    .def_readonly("order",         &tsu::aircoil_expansion_report_t::order)
+	    .def_readonly("n_samples",     &tsu::aircoil_expansion_report_t::n_samples)
+	    .def_readonly("max_abs_error", &tsu::aircoil_expansion_report_t::max_abs_error)
+	    .def_readonly("max_field",     &tsu::aircoil_expansion_report_t::max_field)
+	    .def_readonly("max_rel_error", &tsu::aircoil_expansion_report_t::max_rel_error)
+	    .def("__repr__",  [](tsu::aircoil_expansion_report_t& report){
+		std::stringstream strm;
+		strm << "AirCoilExpansionReport(";
+		report.show(strm, 10);
+		strm << ")";
+		return strm.str();
+	    })
+	    ;
+
 	py::class_<
 	    tsu:: AirCoilMagneticFieldKnobbed<tsc::StandardDoubleType>,
 	    std::shared_ptr<tsu:: AirCoilMagneticFieldKnobbed<tsc::StandardDoubleType>>
@@ -361,6 +438,20 @@ void py_thor_scsi_init_field_interpolation(py::module &m) {
             auto tmp = inst.getUsedFilaments();
             return (tmp);
         })
+	    .def("fit_multipole_expansion", &tsu::AirCoilMagneticFieldKnobbed<tsc::StandardDoubleType>::fitMultipoleExpansion,
+		 "precompute a multipole expansion used within radius, exact sum used outside. Returns the error estimate",
+		 py::arg("radius"), py::arg("order"), py::arg("n_samples") = 128)
+	    .def("clear_multipole_expansion", &tsu::AirCoilMagneticFieldKnobbed<tsc::StandardDoubleType>::clearMultipoleExpansion)
+	    .def("has_multipole_expansion", &tsu::AirCoilMagneticFieldKnobbed<tsc::StandardDoubleType>::hasMultipoleExpansion)
+	    .def("get_expansion_radius", &tsu::AirCoilMagneticFieldKnobbed<tsc::StandardDoubleType>::getExpansionRadius)
+	    .def("get_multipole_expansion", &tsu::AirCoilMagneticFieldKnobbed<tsc::StandardDoubleType>::getMultipoleExpansion,
+		 "coefficients c_n of B_y - i B_x = sum c_n z^n for scale 1")
+	    .def("field_and_gradient", [](const tsu::AirCoilMagneticFieldKnobbed<tsc::StandardDoubleType>& inst,
+					  const double x, const double y){
+		double Bx, By, Gx, Gy;
+		inst.fieldAndGradient(x, y, &Bx, &By, &Gx, &Gy);
+		return std::make_tuple(Bx, By, Gx, Gy);
+	    }, "field and its derivative in one pass: (Bx, By, dBx/dx, dBy/dx)", py::arg("x"), py::arg("y"))
 	    .def(py::init([](py::array_t<tsu::aircoil_filament_t, py::array::c_style|py::array::forcecast>& a) {
 		return tsu::AirCoilMagneticField(aircoil_filaments_from_array(a));
 	    }) , "initalise with filaments (x, y, current)");
@@ -381,4 +472,48 @@ void py_thor_scsi_init_field_interpolation(py::module &m) {
 	    }
      */
      ;
+
+	/* memory mapped field maps */
+	m.def("write_field_map", [](const std::string& filename, const double x0, const double y0,
+				    const double dx, const double dy,
+				    py::array_t<double, py::array::c_style|py::array::forcecast> Bx,
+				    py::array_t<double, py::array::c_style|py::array::forcecast> By){
+		if(Bx.ndim() != 2 || By.ndim() != 2){
+			throw std::invalid_argument("field map: Bx and By must be 2 dimensional arrays [iy, ix]");
+		}
+		const size_t ny = Bx.shape(0), nx = Bx.shape(1);
+		std::vector<double> vBx(Bx.data(), Bx.data() + Bx.size()), vBy(By.data(), By.data() + By.size());
+		tsu::write_field_map(filename, x0, y0, dx, dy, nx, ny, vBx, vBy);
+	}, "convert field values sampled on a grid (arrays indexed [iy, ix]) to a field map file",
+	      py::arg("filename"), py::arg("x0"), py::arg("y0"), py::arg("dx"), py::arg("dy"),
+	      py::arg("Bx"), py::arg("By"));
+
+	py::class_<tsu::FieldMapGrid, std::shared_ptr<tsu::FieldMapGrid>> field_map_grid(m, "FieldMapGrid");
+	field_map_grid
+	    .def_static("open", [](const std::string& filename){
+		    return std::const_pointer_cast<tsu::FieldMapGrid>(tsu::FieldMapGrid::open(filename));
+		}, "map the file read only, shared with other users of the same file")
+	    .def_property_readonly("filename", &tsu::FieldMapGrid::filename)
+	    .def_property_readonly("nx", &tsu::FieldMapGrid::nx)
+	    .def_property_readonly("ny", &tsu::FieldMapGrid::ny)
+	    .def_property_readonly("x0", &tsu::FieldMapGrid::x0)
+	    .def_property_readonly("y0", &tsu::FieldMapGrid::y0)
+	    .def_property_readonly("dx", &tsu::FieldMapGrid::dx)
+	    .def_property_readonly("dy", &tsu::FieldMapGrid::dy)
+	    .def_property_readonly("x_max", &tsu::FieldMapGrid::xMax)
+	    .def_property_readonly("y_max", &tsu::FieldMapGrid::yMax)
+	    .def("contains", &tsu::FieldMapGrid::contains, py::arg("x"), py::arg("y"))
+	    .def("__repr__", [](const tsu::FieldMapGrid& grid){
+		    std::stringstream strm;
+		    grid.show(strm, 0);
+		    return strm.str();
+		})
+	    ;
+
+	py::class_<tsu::FieldMapInterpolation, std::shared_ptr<tsu::FieldMapInterpolation>>
+	    field_map_interpolation(m, "FieldMapInterpolation", field2dintp);
+	add_methods_field_map(field_map_interpolation);
+	py::class_<tsu::FieldMapInterpolationTpsa, std::shared_ptr<tsu::FieldMapInterpolationTpsa>>
+	    field_map_interpolation_tpsa(m, "FieldMapInterpolationTpsa", field2dintpvar);
+	add_methods_field_map(field_map_interpolation_tpsa);
 }
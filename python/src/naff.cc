@@ -0,0 +1,108 @@
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/complex.h>
+#include <pybind11/stl.h>
+#include "thor_scsi.h"
+#include <thor_scsi/std_machine/naff.h>
+#include <optional>
+#include <sstream>
+
+namespace ts = thor_scsi;
+namespace py = pybind11;
+
+typedef py::array_t<double, py::array::c_style | py::array::forcecast> np_array;
+
+static const char naff_doc[] = \
+"numerical analysis of fundamental frequencies (J. Laskar)\n\
+\n\
+Hanning window of order window_order, Gram-Schmidt extraction of the\n\
+terms. The object keeps the workspace for signals of n_samples.\n\
+\n\
+Args:\n\
+   n_samples:    length of the signals\n\
+   max_terms:    workspace reserved for this number of terms\n\
+   window_order: 0 rectangular, 1 Hanning, ...";
+
+static const char naff_analyse_doc[] = \
+"terms of many signals, computed in parallel\n\
+\n\
+Args:\n\
+   x:  array of shape (n_signals, n_samples), e.g. turn by turn data\n\
+   px: same shape, or None for real signals\n\
+\n\
+Returns:\n\
+   frequencies (n_signals, n_terms) and amplitudes (complex, same\n\
+   shape). Signals exhausted before n_terms are padded with NaN.";
+
+static size_t check_samples(const np_array& x, const np_array* px, size_t *n_signals)
+{
+	if(x.ndim() < 1 || x.ndim() > 2){
+		throw std::invalid_argument("NAFF: expected an array of shape (n_samples,) or (n_signals, n_samples)");
+	}
+	if(px && (px->ndim() != x.ndim() || px->size() != x.size())){
+		throw std::invalid_argument("NAFF: x and px have to be of the same shape");
+	}
+	const size_t n_samples = x.shape(x.ndim() - 1);
+	*n_signals = (x.ndim() == 2) ? x.shape(0) : 1;
+	return n_samples;
+}
+
+void py_thor_scsi_init_naff(py::module &m)
+{
+	py::class_<ts::NAFFTerm>(m, "NAFFTerm")
+		.def_readonly("frequency", &ts::NAFFTerm::frequency)
+		.def_readonly("amplitude", &ts::NAFFTerm::amplitude)
+		.def("__repr__", [](const ts::NAFFTerm& t){
+			std::stringstream strm;
+			strm << "NAFFTerm(frequency=" << t.frequency << ", amplitude=" << t.amplitude << ")";
+			return strm.str();
+		});
+
+	py::class_<ts::NAFF>(m, "NAFF", naff_doc)
+		.def(py::init<const size_t, const size_t, const unsigned>(),
+		     py::arg("n_samples"), py::arg("max_terms") = 1, py::arg("window_order") = 1)
+		.def_property_readonly("n_samples", &ts::NAFF::nSamples)
+		.def_property_readonly("window_order", &ts::NAFF::windowOrder)
+		.def("analyse", [](ts::NAFF& naff, const np_array& x, std::optional<np_array> px, const size_t n_terms){
+			size_t n_signals = 0;
+			const size_t n_samples = check_samples(x, px ? &px.value() : nullptr, &n_signals);
+			if(n_signals != 1 || n_samples != naff.nSamples()){
+				std::stringstream strm;
+				strm << "NAFF: expected a signal of " << naff.nSamples() << " samples";
+				throw std::invalid_argument(strm.str());
+			}
+			return naff.analyse(x.data(), px ? px.value().data() : nullptr, n_terms);
+		}, "the n_terms strongest terms of x - i px (or x if px is None)",
+		     py::arg("x"), py::arg("px") = py::none(), py::arg("n_terms") = 1);
+
+	m.def("naff_analyse", [](const np_array& x, std::optional<np_array> px, const size_t n_terms,
+				 const unsigned window_order, const size_t n_threads){
+		size_t n_signals = 0;
+		const size_t n_samples = check_samples(x, px ? &px.value() : nullptr, &n_signals);
+		std::vector<std::vector<ts::NAFFTerm>> terms;
+		{
+			py::gil_scoped_release release;
+			terms = ts::naff_analyse(x.data(), px ? px.value().data() : nullptr, n_signals, n_samples,
+						 n_terms, window_order, n_threads);
+		}
+		py::array_t<double> frequencies({n_signals, n_terms});
+		py::array_t<std::complex<double>> amplitudes({n_signals, n_terms});
+		auto f = frequencies.mutable_unchecked<2>();
+		auto a = amplitudes.mutable_unchecked<2>();
+		for(size_t i = 0; i < n_signals; ++i){
+			for(size_t k = 0; k < n_terms; ++k){
+				const bool found = k < terms[i].size();
+				f(i, k) = found ? terms[i][k].frequency : NAN;
+				a(i, k) = found ? terms[i][k].amplitude : std::complex<double>(NAN, NAN);
+			}
+		}
+		return py::make_tuple(frequencies, amplitudes);
+	}, naff_analyse_doc, py::arg("x"), py::arg("px") = py::none(), py::arg("n_terms") = 1,
+	      py::arg("window_order") = 1, py::arg("n_threads") = 0);
+}
+/*
+ * Local Variables:
+ * mode: c++
+ * c-file-style: "python"
+ * End:
+ */
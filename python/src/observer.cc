@@ -1,5 +1,10 @@
 #include <pybind11/pybind11.h>
+#include <pybind11/functional.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
 #include <thor_scsi/elements/standard_observer.h>
+#include <thor_scsi/elements/buffering_observer.h>
+#include <algorithm>
 
 namespace py = pybind11;
 namespace tsc = thor_scsi::core;
@@ -53,4 +58,45 @@ void py_thor_scsi_init_observers(py::module &m)
 		.def("reset",                        &tse::StandardObserver::reset)
 		.def(py::init<>());
 
+	py::class_<tse::BufferingObserver, tsc::Observer, std::shared_ptr<tse::BufferingObserver>> buffering_observer(m, "BufferingObserver");
+	buffering_observer
+		.def("__str__",                      &tse::BufferingObserver::pstr)
+		.def("__repr__",                     &tse::BufferingObserver::repr)
+		.def("__len__",                      &tse::BufferingObserver::size)
+		.def("capacity",                     &tse::BufferingObserver::capacity)
+		.def("get_turns_per_batch",          &tse::BufferingObserver::getTurnsPerBatch)
+		.def("get_turn",                     &tse::BufferingObserver::getTurn)
+		.def("flush",                        &tse::BufferingObserver::flush)
+		.def("reset",                        &tse::BufferingObserver::reset)
+		.def("set_callback", [](tse::BufferingObserver& inst, py::object callback){
+			if(callback.is_none()){
+				inst.setCallback(nullptr);
+				return;
+			}
+			/*
+			 * arrays are copies: the buffer is reused after the
+			 * callback returned
+			 */
+			inst.setCallback([callback](const tse::BufferingObserver& o){
+				py::gil_scoped_acquire acquire;
+				const size_t n = o.size(), dim = tse::BufferingObserver::ps_dim;
+				py::array_t<size_t> index(n), turn(n);
+				py::array_t<int> state(n), cnt(n);
+				py::array_t<double> ps({n, dim});
+				std::copy(o.indices(), o.indices() + n, index.mutable_data());
+				std::copy(o.turns(), o.turns() + n, turn.mutable_data());
+				std::copy(o.states(), o.states() + n, state.mutable_data());
+				std::copy(o.counts(), o.counts() + n, cnt.mutable_data());
+				std::copy(o.phaseSpace(), o.phaseSpace() + n * dim, ps.mutable_data());
+				callback(index, state, turn, cnt, ps);
+			});
+		}, "callback(index, state, turn, cnt, ps) called with the rows of a batch as numpy arrays,"
+		   " ps of shape (n, 6). None removes the callback",
+		   py::arg("callback"))
+		.def(py::init<const size_t, const size_t, const std::vector<tsc::ObservedState>&>(),
+		     "record the phase space at the given states into a buffer of capacity rows,"
+		     " handed to the callback every n_turns turns",
+		     py::arg("capacity"), py::arg("n_turns") = 1,
+		     py::arg("states") = std::vector<tsc::ObservedState>{tsc::ObservedState::end});
+
 }
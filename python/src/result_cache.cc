@@ -0,0 +1,69 @@
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+#include "thor_scsi.h"
+#include <thor_scsi/std_machine/result_cache.h>
+#include <thor_scsi/std_machine/lattice_hash.h>
+
+namespace ts = thor_scsi;
+namespace py = pybind11;
+
+static const char result_cache_doc[] = \
+"on disk cache for expensive results (one turn maps, twiss, ...)\n\
+\n\
+Entries are identified by a key (typically :meth:`Accelerator.content_hash`)\n\
+and a product name (e.g. 'twiss'). Arrays are stored in a memory mapped\n\
+binary file per entry.\n\
+\n\
+Args:\n\
+   directory: where to store the files. Default: $THOR_SCSI_CACHE_DIR,\n\
+              $XDG_CACHE_HOME/thor_scsi or $HOME/.cache/thor_scsi\n";
+
+static const char load_doc[] = \
+"load an entry\n\
+\n\
+Returns:\n\
+   numpy array (a copy of the stored data) or None if no entry exists";
+
+void py_thor_scsi_init_result_cache(py::module &m)
+{
+	m.def("hash_to_string", &ts::hash_to_string, "hash as fixed width hexadecimal string");
+
+	py::class_<ts::ResultCache, std::shared_ptr<ts::ResultCache>>(m, "ResultCache", result_cache_doc)
+		.def(py::init<const std::string&>(), py::arg("directory") = "")
+		.def_property_readonly("directory", &ts::ResultCache::directory)
+		.def_static("default_directory", &ts::ResultCache::defaultDirectory)
+		.def("__contains__", [](const ts::ResultCache& cache, std::pair<uint64_t, std::string> entry){
+			return cache.contains(entry.first, entry.second);
+		})
+		.def("contains", &ts::ResultCache::contains, py::arg("key"), py::arg("product"))
+		.def("store", [](ts::ResultCache& cache, const uint64_t key, const std::string& product,
+				 py::array_t<double, py::array::f_style | py::array::forcecast> data){
+			std::vector<size_t> shape(data.shape(), data.shape() + data.ndim());
+			cache.store(key, product, data.data(), shape);
+		}, "store an array", py::arg("key"), py::arg("product"), py::arg("data"))
+		.def("load", [](const ts::ResultCache& cache, const uint64_t key, const std::string& product) -> py::object {
+			auto entry = cache.load(key, product);
+			if(!entry){
+				return py::none();
+			}
+			const auto& shape = entry->shape();
+			std::vector<py::ssize_t> strides(shape.size());
+			py::ssize_t stride = sizeof(double);
+			for(size_t i=0; i<shape.size(); ++i){
+				strides[i] = stride;
+				stride *= shape[i];
+			}
+			/* no base given: pybind11 copies, the mapping is released with the entry */
+			return py::array_t<double>(std::vector<py::ssize_t>(shape.begin(), shape.end()), strides, entry->data());
+		}, load_doc, py::arg("key"), py::arg("product"))
+		.def("erase", &ts::ResultCache::erase, py::arg("key"), py::arg("product"))
+		.def("filename", &ts::ResultCache::filename, py::arg("key"), py::arg("product"))
+		;
+}
+/*
+ * Local Variables:
+ * mode: c++
+ * c-file-style: "python"
+ * End:
+ */
@@ -21,6 +21,11 @@ PYBIND11_MODULE(lib, m) {
     py_thor_scsi_init_observers(m);
     py_thor_scsi_init_accelerator(m);
     py_thor_scsi_init_config_type(m);
+    py_thor_scsi_init_result_cache(m);
+    py_thor_scsi_init_ibs(m);
+    py_thor_scsi_init_touschek(m);
+    py_thor_scsi_init_naff(m);
+    py_thor_scsi_init_driving_terms(m);
     // py_thor_scsi_init_lattice(scsi);
 
 
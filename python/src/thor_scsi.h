@@ -46,6 +46,11 @@ void py_thor_scsi_init_radiation(py::module &m);
 void py_thor_scsi_init_observers(py::module &m);
 void py_thor_scsi_init_accelerator(py::module &m);
 void py_thor_scsi_init_config_type(py::module &m);
+void py_thor_scsi_init_result_cache(py::module &m);
+void py_thor_scsi_init_ibs(py::module &m);
+void py_thor_scsi_init_touschek(py::module &m);
+void py_thor_scsi_init_naff(py::module &m);
+void py_thor_scsi_init_driving_terms(py::module &m);
 //void py_thor_scsi_init_arma(py::module &m);
 
 // void py_thor_scsi_init_lattice(py::module_ &m);
@@ -0,0 +1,46 @@
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include "thor_scsi.h"
+#include <thor_scsi/std_machine/touschek.h>
+
+namespace ts = thor_scsi;
+namespace py = pybind11;
+
+static const char lifetime_doc[] = \
+"Touschek lifetime for the local momentum aperture\n\
+\n\
+Args:\n\
+   lattice_functions: :class:`LatticeFunctions` at the positions the\n\
+                      momentum aperture is given at\n\
+   beam:              :class:`BeamParameters` (coulomb_log unused)\n\
+   delta_plus, delta_minus: momentum aperture, e.g. of\n\
+                      :meth:`Accelerator.momentum_aperture`\n\
+\n\
+The momentum aperture is used as is: limit it to the RF acceptance if\n\
+required.\n\
+\n\
+Returns:\n\
+   :class:`TouschekLifetime`: lifetime [s] and the local loss rate [1/s]";
+
+void py_thor_scsi_init_touschek(py::module &m)
+{
+	py::class_<ts::TouschekLifetime>(m, "TouschekLifetime")
+		.def_readonly("lifetime", &ts::TouschekLifetime::lifetime)
+		.def_readonly("rate",     &ts::TouschekLifetime::rate)
+		.def("__repr__", [](const ts::TouschekLifetime& t){
+			return "TouschekLifetime(lifetime=" + std::to_string(t.lifetime) + " s)";
+		});
+
+	m.def("touschek_lifetime", &ts::touschek_lifetime, lifetime_doc,
+	      py::arg("lattice_functions"), py::arg("beam"), py::arg("delta_plus"), py::arg("delta_minus"),
+	      py::arg("n_threads") = 0,
+	      py::call_guard<py::gil_scoped_release>());
+	m.def("touschek_integral", &ts::touschek_integral,
+	      "Touschek loss function D(u) / sqrt(u)", py::arg("u"));
+}
+/*
+ * Local Variables:
+ * mode: c++
+ * c-file-style: "python"
+ * End:
+ */
@@ -196,3 +196,26 @@ def test40_variance_multipoles():
     print("order", r.order)
     print(r.print("result"))
     assert(1==0)
+
+
+def test50_field_batch():
+    mul = tslib.TwoDimensionalMultipoles(0e0)
+    mul.set_multipole(2, 1 + 0.5j)
+    mul.set_multipole(3, 0.2)
+
+    x = np.linspace(-1e-2, 1e-2, num=12).reshape(3, 4)
+    y = np.linspace(2e-2, -1e-2, num=12).reshape(3, 4)
+    Bx, By = mul.field_batch(x, y)
+    assert Bx.shape == x.shape
+    assert By.shape == x.shape
+    for xi, yi, bx, by in zip(x.ravel(), y.ravel(), Bx.ravel(), By.ravel()):
+        B = mul.field(np.array([xi, yi]))
+        assert bx == pytest.approx(B[0], abs=1e-15)
+        assert by == pytest.approx(B[1], abs=1e-15)
+
+    Gx, Gy = mul.gradient_batch(x, y)
+    assert Gy == pytest.approx(np.ones_like(x))
+    assert Gx == pytest.approx(0.5 * np.ones_like(x))
+
+    with pytest.raises(ValueError):
+        mul.field_batch(x, y.ravel())
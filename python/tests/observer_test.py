@@ -0,0 +1,98 @@
+import gc
+import weakref
+
+import gtpsa
+import numpy as np
+import thor_scsi.lib as tslib
+from thor_scsi.observer import BatchedObserverAdapter
+from thor_scsi.pyflame import GLPSParser
+
+mini_lat = """
+d1: Drift, L = 0.25;
+q1: Quadrupole, L = 0.5, K = 1.4, N = 4, Method = 4;
+mini_cell : LINE = (d1, q1, d1);
+"""
+
+
+class RecordingObserver(tslib.Observer):
+    def __init__(self):
+        tslib.Observer.__init__(self)
+        self.views = []
+
+    def view(self, element, ps, observed_state, cnt):
+        self.views.append((element.index, ps, observed_state, cnt))
+
+
+def start_point():
+    ps = gtpsa.ss_vect_double(0e0)
+    ps.set_zero()
+    ps[0] = 1e-3
+    return ps
+
+
+def test10_set_callback():
+    acc = tslib.Accelerator(GLPSParser().parse_byte(mini_lat, None))
+    buffer = tslib.BufferingObserver(100, 1, [tslib.ObservedState.end])
+    batches = []
+    buffer.set_callback(lambda *args: batches.append(args))
+    for elem in acc:
+        elem.set_observer(buffer)
+
+    ps = start_point()
+    acc.propagate(tslib.ConfigType(), ps, n_turns=2)
+    buffer.flush()
+
+    assert len(batches) == 2
+    index, state, turn, cnt, rows = batches[-1]
+    assert list(index) == list(range(len(acc)))
+    assert np.all(state == int(tslib.ObservedState.end))
+    assert np.all(turn == 1)
+    assert np.all(cnt == 0)
+    assert rows.shape == (len(acc), 6)
+    assert rows[-1, 0] == ps[0]
+
+    buffer.set_callback(None)
+    acc.propagate(tslib.ConfigType(), ps)
+    buffer.flush()
+    assert len(batches) == 2
+
+
+def test20_adapter():
+    acc = tslib.Accelerator(GLPSParser().parse_byte(mini_lat, None))
+    q1 = acc.find("q1", 0)
+    ob = RecordingObserver()
+    q1.set_observer(ob)
+
+    adapter = BatchedObserverAdapter(acc, capacity=10, n_turns=1)
+    adapter.install()
+    assert isinstance(q1.get_observer(), tslib.BufferingObserver)
+
+    ps = start_point()
+    acc.propagate(tslib.ConfigType(), ps, n_turns=3)
+    adapter.uninstall()
+    assert q1.get_observer() is ob
+
+    # start and end for each turn, each with its own phase space
+    assert len(ob.views) == 6
+    assert all(index == q1.index for index, _, _, _ in ob.views)
+    assert [state for _, _, state, _ in ob.views] == [
+        tslib.ObservedState.start, tslib.ObservedState.end
+    ] * 3
+    assert len(set(id(view_ps) for _, view_ps, _, _ in ob.views)) == 6
+    assert ob.views[0][1][0] == 1e-3
+    assert ob.views[-1][1][0] != ob.views[0][1][0]
+
+
+def test30_adapter_collected():
+    acc = tslib.Accelerator(GLPSParser().parse_byte(mini_lat, None))
+    adapter = BatchedObserverAdapter(acc, capacity=10)
+    buffer = adapter.buffer
+    ref = weakref.ref(adapter)
+    del adapter
+    gc.collect()
+    assert ref() is None
+
+    # the buffer outlives the adapter: its callback does nothing
+    acc[0].set_observer(buffer)
+    acc.propagate(tslib.ConfigType(), start_point())
+    buffer.flush()
@@ -0,0 +1,87 @@
+import os
+import tempfile
+
+import numpy as np
+import pytest
+import thor_scsi.lib as tslib
+from thor_scsi.elements.air_coil import NonlinearKickerField
+from thor_scsi.pyflame import Config
+from thor_scsi.utils.tabulate_field import (
+    fit_multipoles,
+    replace_by_native,
+    sample_field,
+    tabulate_on_grid,
+)
+
+
+class PythonMultipoles(tslib.Field2DInterpolation):
+    """By + i Bx = 0.1 + 2 z + 5 z**2"""
+
+    def __init__(self):
+        tslib.Field2DInterpolation.__init__(self)
+
+    def field_py(self, pos, field):
+        z = pos[0] + 1j * pos[1]
+        B = 0.1 + 2 * z + 5 * z ** 2
+        field[0] = B.imag
+        field[1] = B.real
+
+
+@pytest.fixture
+def field_map_file():
+    fd, filename = tempfile.mkstemp(suffix=".tsfm")
+    os.close(fd)
+    yield filename
+    os.remove(filename)
+
+
+def test10_grid():
+    nlkf = NonlinearKickerField(position=20e-3 + 10e-3j, current=1e3)
+    with tempfile.TemporaryDirectory() as tmpdir:
+        native, report = tabulate_on_grid(
+            nlkf, x_range=(-10e-3, 10e-3), y_range=(-5e-3, 5e-3), nx=81, ny=41,
+            filename=os.path.join(tmpdir, "nlk.tsfm")
+        )
+        assert report.method == "grid"
+        assert report.n_samples == 81 * 41
+        assert report.n_checked == 80 * 40
+        assert report.max_rel_error < 1e-3
+
+        x, y = np.array([1.2e-3, -7e-3]), np.array([-3.3e-3, 2e-3])
+        Bx_ref, By_ref = sample_field(nlkf, x, y)
+        Bx, By = sample_field(native, x, y)
+        assert Bx == pytest.approx(Bx_ref, rel=1e-3)
+        assert By == pytest.approx(By_ref, rel=1e-3)
+
+
+def test20_multipoles():
+    native, report = fit_multipoles(PythonMultipoles(), radius=10e-3, order=4)
+    assert report.method == "multipoles"
+    assert report.max_rel_error < 1e-12
+    assert native.get_multipole(1) == pytest.approx(0.1)
+    assert native.get_multipole(2) == pytest.approx(2)
+    assert native.get_multipole(3) == pytest.approx(5)
+    assert abs(native.get_multipole(4)) < 1e-10
+
+    with pytest.raises(ValueError):
+        fit_multipoles(PythonMultipoles(), radius=10e-3, order=4, n_samples=7)
+
+
+def test30_replace_by_native(field_map_file):
+    C = Config()
+    C.setAny("L", 0e0)
+    C.setAny("name", "nlk")
+    C.setAny("N", 1)
+    nlk = tslib.FieldKick(C)
+    nlk.set_field_interpolator(PythonMultipoles())
+
+    report = replace_by_native(
+        nlk, "grid", x_range=(-5e-3, 5e-3), y_range=(-5e-3, 5e-3), nx=21, ny=21,
+        filename=field_map_file
+    )
+    # quadratic field: only the one sided derivatives at the border are approximate
+    assert report.max_rel_error < 1e-4
+    assert isinstance(nlk.get_field_interpolator(), tslib.FieldMapInterpolation)
+
+    with pytest.raises(ValueError):
+        replace_by_native(nlk, "spline")
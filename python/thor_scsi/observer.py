@@ -2,9 +2,10 @@
 
 See :class:`Observer`
 '''
-from .lib import ObservedState, Observer as _AbstractObserver
+from .lib import ObservedState, Observer as _AbstractObserver, BufferingObserver
 import gtpsa
 import numpy as np
+import weakref
 
 
 class Observer(_AbstractObserver):
@@ -58,3 +59,69 @@ class Observer(_AbstractObserver):
             self.jac = np.array(ps.jacobian())
 
         # Other observed states are not recognised
+
+
+class BatchedObserverAdapter:
+    """Feed python observers from a native buffering observer
+
+    Opt in replacement for python observers set on the elements:
+    :meth:`install` moves them into the adapter and sets one
+    :class:`thor_scsi.lib.BufferingObserver` on these elements instead.
+    Tracking then does not call into python for every element; the
+    recorded states are replayed to the python observers once per
+    batch (every n_turns turns).
+
+    Only the constant part of the phase space is recorded: each view
+    gets a fresh :class:`gtpsa.ss_vect_double`, so observers can keep
+    it.
+
+    Call :meth:`flush` after propagation to replay the last, partial
+    batch.
+    """
+
+    def __init__(
+        self, acc, *, capacity: int, n_turns: int = 1,
+        states=(ObservedState.start, ObservedState.end)
+    ):
+        self.acc = acc
+        self.buffer = BufferingObserver(capacity, n_turns, list(states))
+        # the buffer must not keep the adapter alive: that would be a
+        # cycle through the native callback, invisible to the collector
+        replay = weakref.WeakMethod(self._replay)
+
+        def callback(*args):
+            method = replay()
+            if method is not None:
+                method(*args)
+
+        self.buffer.set_callback(callback)
+        self.observers = dict()
+
+    def install(self):
+        """move the python observers of the elements into the adapter"""
+        for elem in self.acc:
+            ob = elem.get_observer()
+            if ob is None or isinstance(ob, BufferingObserver):
+                continue
+            self.observers[elem.index] = ob
+            elem.set_observer(self.buffer)
+
+    def uninstall(self):
+        """give the python observers back to their elements"""
+        self.flush()
+        for index, ob in self.observers.items():
+            self.acc[index].set_observer(ob)
+        self.observers = dict()
+
+    def flush(self):
+        self.buffer.flush()
+
+    def _replay(self, index, state, turn, cnt, ps):
+        for idx, st, c, row in zip(index, state, cnt, ps):
+            ob = self.observers.get(int(idx))
+            if ob is None:
+                continue
+            ps_vec = gtpsa.ss_vect_double(0e0)
+            for i, v in enumerate(row):
+                ps_vec[i] = v
+            ob.view(self.acc[int(idx)], ps_vec, ObservedState(int(st)), int(c))
@@ -4,5 +4,6 @@ __all__ = [
     "linear_optics",
     "twiss_output",
     "radiate",
+    "tabulate_field",
     "twiss_output",
 ]
@@ -120,12 +120,14 @@ def compute_radiation(
         A_cpy  = gtpsa.ss_vect_tpsa(desc, 1)
         A_cpy += r.x0
         A_cpy.set_jacobian(A)
-        acc.propagate(calc_config, A_cpy)
 
-        D_rad = compute_diffusion_coefficients(rad_del_kicks)
-
-        U_0, J, tau, eps = \
-            compute_rad_prop(acc, calc_config, r.x0, dE, alpha_rad, D_rad)
+        # diffusion coefficients and synchrotron integrals summed in C++
+        summary = acc.compute_radiation_summary(calc_config, A_cpy, alpha_rad)
+        logger.info("\n%s", summary)
+        U_0 = summary.U0
+        J = np.array(summary.J)
+        tau = np.array(summary.tau)
+        eps = np.array(summary.eps)
     else:
         U_0 = np.nan
         J = np.zeros(3, float)
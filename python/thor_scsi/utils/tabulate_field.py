@@ -0,0 +1,192 @@
+"""Replace python defined field interpolations by native ones
+
+Interpolations implemented in python (e.g.
+:class:`thor_scsi.elements.air_coil.AirCoilMagneticField`) are called
+through the pybind11 trampoline for every kick of every integration
+step. Here they are sampled once and replaced by an equivalent
+interpolation implemented in C++:
+
+* :func:`tabulate_on_grid`: bicubic field map
+  (:class:`thor_scsi.lib.FieldMapInterpolation`), applicable to any field
+* :func:`fit_multipoles`: :class:`thor_scsi.lib.TwoDimensionalMultipoles`
+  computed from the field on a circle, applicable to fields with
+  :math:`B_y + i B_x` an analytic function of :math:`z = x + i y`
+
+Each returns a :class:`TabulationReport`, comparing the native
+interpolation to the python one at points not used for sampling.
+"""
+import thor_scsi.lib as tslib
+import numpy as np
+from dataclasses import dataclass
+import logging
+
+logger = logging.getLogger("thor-scsi")
+
+
+@dataclass
+class TabulationReport:
+    #: "grid" or "multipoles"
+    method: str
+    #: number of points the python interpolation was sampled at
+    n_samples: int
+    #: number of points the native interpolation was checked at
+    n_checked: int
+    #: max |B_native - B_python| at the check points
+    max_abs_error: float
+    #: max |B_python| at the check points
+    max_field: float
+    #: max_abs_error / max_field
+    max_rel_error: float
+
+
+def sample_field(interpolation, x, y):
+    """field of interpolation at all points (x, y)
+
+    Returns:
+        Bx, By: arrays of the shape of x
+    """
+    x = np.asarray(x, dtype=float)
+    y = np.asarray(y, dtype=float)
+    return interpolation.field_batch(x, y)
+
+
+def _report(method, n_samples, reference, native, x, y):
+    Bx_ref, By_ref = sample_field(reference, x, y)
+    Bx, By = sample_field(native, x, y)
+    err = np.absolute((Bx - Bx_ref) + 1j * (By - By_ref))
+    B = np.absolute(Bx_ref + 1j * By_ref)
+    max_abs_error = float(err.max())
+    max_field = float(B.max())
+    report = TabulationReport(
+        method=method,
+        n_samples=int(n_samples),
+        n_checked=int(np.size(x)),
+        max_abs_error=max_abs_error,
+        max_field=max_field,
+        max_rel_error=max_abs_error / max_field if max_field > 0 else 0e0,
+    )
+    logger.info("tabulated field interpolation %s: %s", reference, report)
+    return report
+
+
+def tabulate_on_grid(
+    interpolation, *, x_range, y_range, nx: int, ny: int, filename: str,
+    tpsa: bool = False
+):
+    """sample the field on a regular grid and store it as field map
+
+    Args:
+        interpolation: field interpolation to sample
+        x_range, y_range: (min, max) of the grid
+        nx, ny: number of grid points in each direction
+        filename: field map file to write (see :func:`thor_scsi.lib.write_field_map`)
+        tpsa: return :class:`thor_scsi.lib.FieldMapInterpolationTpsa`
+              for elements tracking with dependence on knobs
+
+    Returns:
+        native interpolation, :class:`TabulationReport`
+
+    The field is checked at the centres of the cells, thus where the
+    interpolation error is largest.
+    """
+    if nx < 2 or ny < 2:
+        raise ValueError(f"grid requires at least 2 x 2 points, got {nx} x {ny}")
+    x = np.linspace(x_range[0], x_range[1], num=nx)
+    y = np.linspace(y_range[0], y_range[1], num=ny)
+    dx = x[1] - x[0]
+    dy = y[1] - y[0]
+
+    # indexed [iy, ix] as expected by write_field_map
+    X, Y = np.meshgrid(x, y)
+    Bx, By = sample_field(interpolation, X, Y)
+    tslib.write_field_map(filename, x[0], y[0], dx, dy, Bx, By)
+
+    cls = tslib.FieldMapInterpolationTpsa if tpsa else tslib.FieldMapInterpolation
+    native = cls(filename, 1e0)
+
+    Xc, Yc = np.meshgrid(x[:-1] + dx / 2, y[:-1] + dy / 2)
+    report = _report("grid", X.size, interpolation, native, Xc, Yc)
+    return native, report
+
+
+def fit_multipoles(
+    interpolation, *, radius: float, order: int, n_samples: int = None,
+    tpsa: bool = False
+):
+    """multipoles of the field on a circle around the origin
+
+    Args:
+        interpolation: field interpolation to sample
+        radius: radius of the circle, within the good field region
+        order: number of multipoles (2: up to quadrupole)
+        n_samples: points on the circle, by default 4 * order
+        tpsa: return :class:`thor_scsi.lib.TwoDimensionalMultipolesTpsa`
+
+    Returns:
+        native interpolation, :class:`TabulationReport`
+
+    :math:`B_y + i B_x = \\sum_n C_n (z / r)^{n-1}` is obtained by a
+    discrete Fourier transform of the field on the circle. The fit is
+    checked on the circle between the sample points and on half the
+    radius. A field which is not of this form (e.g. the one of
+    :class:`thor_scsi.elements.air_coil.AirCoilMagneticField`, which
+    follows the opposite sign convention) shows up as large error:
+    use :func:`tabulate_on_grid` instead.
+    """
+    if order < 1:
+        raise ValueError(f"order must be at least 1, got {order}")
+    if not radius > 0:
+        raise ValueError(f"radius must be positive, got {radius}")
+    if n_samples is None:
+        n_samples = 4 * order
+    if n_samples < 2 * order:
+        raise ValueError(
+            f"{n_samples} samples can not resolve {order} multipoles:"
+            f" at least {2 * order} required"
+        )
+
+    phi = 2 * np.pi * np.arange(n_samples) / n_samples
+    z = radius * np.exp(1j * phi)
+    Bx, By = sample_field(interpolation, z.real, z.imag)
+    spectrum = np.fft.fft(By + 1j * Bx) / n_samples
+
+    cls = tslib.TwoDimensionalMultipolesTpsa if tpsa else tslib.TwoDimensionalMultipoles
+    native = cls(0e0, order)
+    for n in range(1, order + 1):
+        native.set_multipole(n, complex(spectrum[n - 1] / radius ** (n - 1)))
+
+    zc = np.concatenate([z * np.exp(1j * np.pi / n_samples), z / 2])
+    report = _report("multipoles", n_samples, interpolation, native, zc.real, zc.imag)
+    return native, report
+
+
+def replace_by_native(element, method: str = "grid", **kwargs):
+    """tabulate the field interpolation of element and use the native one
+
+    Args:
+        element: element with field interpolation (e.g. :class:`thor_scsi.lib.FieldKick`)
+        method: "grid" (:func:`tabulate_on_grid`) or "multipoles"
+                (:func:`fit_multipoles`)
+        kwargs: passed to the tabulation function
+
+    Returns:
+        :class:`TabulationReport`
+    """
+    methods = dict(grid=tabulate_on_grid, multipoles=fit_multipoles)
+    try:
+        tabulate = methods[method]
+    except KeyError:
+        raise ValueError(f"unknown method {method}, use one of {list(methods)}")
+
+    native, report = tabulate(element.get_field_interpolator(), **kwargs)
+    element.set_field_interpolator(native)
+    return report
+
+
+__all__ = [
+    "TabulationReport",
+    "sample_field",
+    "tabulate_on_grid",
+    "fit_multipoles",
+    "replace_by_native",
+]
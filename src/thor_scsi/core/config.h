@@ -1,6 +1,7 @@
 #ifndef  _THOR_SCSI_CORE_CONFIG_H_
 #define _THOR_SCSI_CORE_CONFIG_H_ 1
 
+#include <cstdint>
 #include <vector>
 #include <armadillo>
 
@@ -16,6 +17,7 @@ namespace thor_scsi {
 				Cavity_on  = false,           ///< if true, cavity turned on
 				radiation  = false,           ///< if true, radiation turned on
 				emittance  = false,
+				quantum_excitation = false,   ///< if true (and radiation on), stochastic photon emission
 				quad_fringe  = false,        ///< quadrupole hard-edge fringe field.
 				H_exact  = false,            ///< "Small Ring" Hamiltonian.
 				Cart_Bend  = false,
@@ -50,6 +52,19 @@ namespace thor_scsi {
 				lossplane = 0;                    /** lost in: horizontal    1
 								 vertical      2
 								 longitudinal  3 */
+			/*
+			 * Quantum excitation: key and counter of the random
+			 * numbers. Particles tracked with the same seed and
+			 * particle id see the same photon emission. The
+			 * counter is kept here, not in the elements, so that
+			 * threads with their own copy draw independently.
+			 */
+			uint32_t
+			qe_seed = 0,                         //< seed of the random numbers
+				particle_id = 0,             //< particle tracked
+				turn = 0,                    //< incremented by the accelerator after each complete turn
+				qe_element = 0,              //< index of the element radiating, set on entering it
+				qe_kick = 0;                 //< kick within the element, incremented by each one
 			double
 			dPcommon = 0e0,                     //< dp for numerical differentiation.
 				dPparticle  = 0e0,                   //< Energy deviation.
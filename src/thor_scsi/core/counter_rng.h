@@ -0,0 +1,78 @@
+#ifndef _THOR_SCSI_CORE_COUNTER_RNG_H_
+#define _THOR_SCSI_CORE_COUNTER_RNG_H_ 1
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+namespace thor_scsi::core {
+
+	/**
+	 * @brief Philox4x32-10 counter based random number generator
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * J. K. Salmon, M. A. Moraes, R. O. Dror and D. E. Shaw,
+	 * "Parallel random numbers: as easy as 1, 2, 3", SC11.
+	 *
+	 * The random numbers are a pure function of (counter, key): a
+	 * stream needs no state and can be reproduced or split freely,
+	 * e.g. one key per particle and the counter built from turn and
+	 * element. So results do not depend on the order particles are
+	 * tracked in or on the thread tracking them.
+	 *
+	 * \endverbatim
+	 */
+	class Philox4x32 {
+	public:
+		typedef std::array<uint32_t, 4> counter_type;
+		typedef std::array<uint32_t, 2> key_type;
+
+		/// 4 independent uniformly distributed 32 bit words
+		static inline counter_type generate(counter_type ctr, key_type key){
+			for(int round = 0; round < 10; ++round){
+				if(round){
+					key[0] += W0;
+					key[1] += W1;
+				}
+				const uint64_t p0 = uint64_t(M0) * ctr[0];
+				const uint64_t p1 = uint64_t(M1) * ctr[2];
+				ctr = {
+					uint32_t(p1 >> 32) ^ ctr[1] ^ key[0], uint32_t(p1),
+					uint32_t(p0 >> 32) ^ ctr[3] ^ key[1], uint32_t(p0)
+				};
+			}
+			return ctr;
+		}
+
+		/// uniform in the open interval (0, 1) with 52 bits taken from hi and lo
+		static inline double uniform(const uint32_t hi, const uint32_t lo){
+			const uint64_t u = ((uint64_t(hi) << 32) | lo) >> 12;
+			return (double(u) + 0.5) * 0x1p-52;
+		}
+
+		/**
+		 * @brief two independent standard normal random numbers
+		 *
+		 * Box-Muller transform of the words of one call to generate
+		 */
+		static inline std::array<double, 2> normal(const counter_type& ctr, const key_type& key){
+			const auto w = generate(ctr, key);
+			const double r = std::sqrt(-2e0 * std::log(uniform(w[0], w[1])));
+			const double phi = 2e0 * M_PI * uniform(w[2], w[3]);
+			return {r * std::cos(phi), r * std::sin(phi)};
+		}
+
+	private:
+		static constexpr uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57;
+		static constexpr uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85;
+	};
+
+} // namespace thor_scsi::core
+#endif /* _THOR_SCSI_CORE_COUNTER_RNG_H_ */
+/*
+ * Local Variables:
+ * mode: c++
+ * c-file-style: "python"
+ * End:
+ */
@@ -1,5 +1,6 @@
 #ifndef _THOR_SCSI_CORE_FIELD_INTERPOLATION_H_
 #define _THOR_SCSI_CORE_FIELD_INTERPOLATION_H_ 1
+#include <cstddef>
 #include <ostream>
 #include <gtpsa/tpsa.hpp>
 #include <tps/tps_type.h>
@@ -61,6 +62,37 @@ namespace thor_scsi::core {
 		virtual void gradient(const gtpsa::tpsa& x, const gtpsa::tpsa& y, double      *Gx, double      *Gy) const = 0;
 		virtual void show(std::ostream&, int level) const = 0;
 
+		/**
+		 * @brief field at n points
+		 *
+		 * \verbatim embed:rst:leading-asterisk
+		 *
+		 * Equivalent to calling :meth:`field` for each point
+		 * (x[i], y[i]) storing the result in Bx[i], By[i], but
+		 * with one virtual call for all of them. Implementations
+		 * override it to hoist their set up out of the loop.
+		 *
+		 * The arrays must not overlap.
+		 *
+		 * \endverbatim
+		 */
+		virtual void field_batch(const double *x, const double *y, double *Bx, double *By, const size_t n) const {
+			for(size_t i = 0; i < n; ++i){
+				this->field(x[i], y[i], &Bx[i], &By[i]);
+			}
+		}
+
+		/**
+		 * @brief gradient at n points
+		 *
+		 * Equivalent to calling :meth:`gradient` for each point.
+		 */
+		virtual void gradient_batch(const double *x, const double *y, double *Gx, double *Gy, const size_t n) const {
+			for(size_t i = 0; i < n; ++i){
+				this->gradient(x[i], y[i], &Gx[i], &Gy[i]);
+			}
+		}
+
 		std::string prettyClassname(void) const;
 		// facilitate python representation
 		std::string repr(void) const;
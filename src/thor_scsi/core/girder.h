@@ -0,0 +1,85 @@
+#ifndef _THOR_SCSI_CORE_GIRDER_H_
+#define _THOR_SCSI_CORE_GIRDER_H_ 1
+
+#include <thor_scsi/core/transform_phase_space.h>
+#include <thor_scsi/core/multipole_types.h>
+#include <ostream>
+#include <string>
+
+namespace thor_scsi::core {
+	/**
+	 * @brief a support (girder) carrying a set of elements
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * The transform describes the misalignment of the girder with
+	 * respect to the design (global) coordinates. Elements mounted on
+	 * the girder describe their own misalignment with respect to the
+	 * girder. So moving the girder moves all elements on it.
+	 *
+	 * Elements keep the transform composed of the girder and their own
+	 * one. They listen to the girder transform: the composed one is
+	 * updated when the girder is moved, the propagation only reads it.
+	 *
+	 * \endverbatim
+	 */
+	template<class C>
+	class GirderKnobbed {
+	public:
+		inline GirderKnobbed(const std::string& a_name = "")
+			: name(a_name)
+			, transform()
+			{}
+		virtual ~GirderKnobbed(){}
+		GirderKnobbed(GirderKnobbed&& o) = default;
+
+		inline auto* getTransform(void){
+			return &this->transform;
+		}
+
+		/**
+		 * @brief from global to girder coordinates
+		 */
+		template<typename T>
+		inline void forward(gtpsa::ss_vect<T>& ps){
+			this->transform.forward(ps);
+		}
+
+		/**
+		 * @brief from girder to global coordinates
+		 */
+		template<typename T>
+		inline void backward(gtpsa::ss_vect<T>& ps){
+			this->transform.backward(ps);
+		}
+
+		inline void show(std::ostream& strm, int level) const {
+			strm << "Girder(name=" << this->name << ", ";
+			this->transform.show(strm, level);
+			strm << ")";
+		}
+
+		std::string name;
+		PhaseSpaceGalilean2DTransformKnobbed<C> transform;
+	};
+
+	template<class C>
+	inline
+	std::ostream& operator<<(std::ostream& strm, const GirderKnobbed<C>& girder)
+	{
+		girder.show(strm, 0);
+		return strm;
+	}
+
+	typedef GirderKnobbed<StandardDoubleType> Girder;
+	typedef GirderKnobbed<TpsaVariantType> GirderTpsa;
+
+} // namespace thor_scsi::core
+
+#endif /* _THOR_SCSI_CORE_GIRDER_H_ */
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -2,7 +2,9 @@
 #include <thor_scsi/core/math_comb.h>
 #include <tps/utils.h>
 #include <algorithm>
+#include <array>
 #include <iostream>
+#include <utility>
 
 namespace tsc = thor_scsi::core;
 
@@ -45,6 +47,182 @@ tsc::TwoDimensionalMultipolesKnobbed::TwoDimensionalMultipolesKnobbed(std::vecto
 */
 
 
+/*
+ * Horner scheme in real arithmetic (std::complex multiplication checks
+ * for NaN and infinity). The derivative follows the same scheme:
+ * d = d z + p, p = p z + c_i
+ */
+template<bool with_gradient>
+static inline void horner_eval(const std::complex<double> *c, const unsigned int n, const double x, const double y,
+			       double *Bx, double *By, double *Gx, double *Gy)
+{
+	double pr = c[n - 1].real(), pi = c[n - 1].imag();
+	double dr = 0e0, di = 0e0;
+	for(int i = int(n) - 2; i >= 0; --i){
+		if(with_gradient){
+			const double tr = dr * x - di * y + pr;
+			di = dr * y + di * x + pi;
+			dr = tr;
+		}
+		const double tr = pr * x - pi * y + c[i].real();
+		pi = pr * y + pi * x + c[i].imag();
+		pr = tr;
+	}
+	*By = pr;
+	*Bx = pi;
+	if(with_gradient){
+		*Gy = dr;
+		*Gx = di;
+	}
+}
+
+/* N known at compile time: the loop is unrolled */
+template<unsigned int N, bool with_gradient>
+static void horner_kernel(const std::complex<double> *c, const double x, const double y,
+			  double *Bx, double *By, double *Gx, double *Gy)
+{
+	horner_eval<with_gradient>(c, N, x, y, Bx, By, Gx, Gy);
+}
+
+/*
+ * single non zero coefficient c_K: B = c_K z^K, dB/dz = K c_K z^(K-1)
+ */
+template<unsigned int K, bool with_gradient>
+static void monomial_kernel(const std::complex<double> *c, const double x, const double y,
+			    double *Bx, double *By, double *Gx, double *Gy)
+{
+	const double cr = c[K].real(), ci = c[K].imag();
+	if constexpr (K == 0) {
+		*By = cr;
+		*Bx = ci;
+		if(with_gradient){
+			*Gy = *Gx = 0e0;
+		}
+		return;
+	} else {
+		/* z^(K-1) */
+		double zr = 1e0, zi = 0e0;
+		for(unsigned int i = 1; i < K; ++i){
+			const double tr = zr * x - zi * y;
+			zi = zr * y + zi * x;
+			zr = tr;
+		}
+		if(with_gradient){
+			*Gy = K * (cr * zr - ci * zi);
+			*Gx = K * (cr * zi + ci * zr);
+		}
+		/* z^K */
+		const double tr = zr * x - zi * y;
+		zi = zr * y + zi * x;
+		zr = tr;
+		*By = cr * zr - ci * zi;
+		*Bx = cr * zi + ci * zr;
+	}
+}
+
+typedef void (*multipole_kernel_t)(const std::complex<double> *, const double, const double,
+				    double *, double *, double *, double *);
+
+/* entry i: kernel for N = i + 1 coefficients, or for the monomial of order K = i */
+template<bool with_gradient, size_t... I>
+static constexpr std::array<multipole_kernel_t, sizeof...(I)> make_horner_kernels(std::index_sequence<I...>)
+{
+	return {&horner_kernel<I + 1, with_gradient>...};
+}
+
+template<bool with_gradient, size_t... I>
+static constexpr std::array<multipole_kernel_t, sizeof...(I)> make_monomial_kernels(std::index_sequence<I...>)
+{
+	return {&monomial_kernel<I, with_gradient>...};
+}
+
+static const auto horner_kernels = make_horner_kernels<false>(std::make_index_sequence<tsc::max_unrolled_multipole>());
+static const auto horner_gradient_kernels = make_horner_kernels<true>(std::make_index_sequence<tsc::max_unrolled_multipole>());
+static const auto monomial_kernels = make_monomial_kernels<false>(std::make_index_sequence<tsc::max_unrolled_multipole>());
+static const auto monomial_gradient_kernels = make_monomial_kernels<true>(std::make_index_sequence<tsc::max_unrolled_multipole>());
+
+template<bool with_gradient>
+static inline void multipoles_eval(const std::complex<double> *coeffs, const tsc::multipole_layout_t& layout,
+				   const double x, const double y, double *Bx, double *By, double *Gx, double *Gy)
+{
+	const auto& horner = with_gradient ? horner_gradient_kernels : horner_kernels;
+	const auto& monomial = with_gradient ? monomial_gradient_kernels : monomial_kernels;
+
+	if(layout.n_used == 0){
+		*Bx = *By = 0e0;
+		if(with_gradient){
+			*Gx = *Gy = 0e0;
+		}
+	} else if(layout.single >= 0 && size_t(layout.single) < monomial.size()){
+		monomial[layout.single](coeffs, x, y, Bx, By, Gx, Gy);
+	} else if(layout.n_used <= horner.size()){
+		horner[layout.n_used - 1](coeffs, x, y, Bx, By, Gx, Gy);
+	} else {
+		/* more coefficients than unrolled kernels */
+		horner_eval<with_gradient>(coeffs, layout.n_used, x, y, Bx, By, Gx, Gy);
+	}
+}
+
+void tsc::multipoles_field(const std::complex<double> *coeffs, const tsc::multipole_layout_t& layout,
+			   const double x, const double y, double *Bx, double *By)
+{
+	multipoles_eval<false>(coeffs, layout, x, y, Bx, By, nullptr, nullptr);
+}
+
+void tsc::multipoles_field_gradient(const std::complex<double> *coeffs, const tsc::multipole_layout_t& layout,
+				    const double x, const double y, double *Bx, double *By, double *Gx, double *Gy)
+{
+	multipoles_eval<true>(coeffs, layout, x, y, Bx, By, Gx, Gy);
+}
+
+/*
+ * The kernel is a template argument: inlined into the loop over the
+ * points, which thus carries no dispatch
+ */
+template<multipole_kernel_t kernel>
+static void batch_kernel(const std::complex<double> *c, const double *x, const double *y,
+			 double *Bx, double *By, const size_t n)
+{
+	for(size_t i = 0; i < n; ++i){
+		kernel(c, x[i], y[i], &Bx[i], &By[i], nullptr, nullptr);
+	}
+}
+
+typedef void (*multipole_batch_kernel_t)(const std::complex<double> *, const double *, const double *,
+					  double *, double *, const size_t);
+
+template<size_t... I>
+static constexpr std::array<multipole_batch_kernel_t, sizeof...(I)> make_horner_batch_kernels(std::index_sequence<I...>)
+{
+	return {&batch_kernel<&horner_kernel<I + 1, false>>...};
+}
+
+template<size_t... I>
+static constexpr std::array<multipole_batch_kernel_t, sizeof...(I)> make_monomial_batch_kernels(std::index_sequence<I...>)
+{
+	return {&batch_kernel<&monomial_kernel<I, false>>...};
+}
+
+static const auto horner_batch_kernels = make_horner_batch_kernels(std::make_index_sequence<tsc::max_unrolled_multipole>());
+static const auto monomial_batch_kernels = make_monomial_batch_kernels(std::make_index_sequence<tsc::max_unrolled_multipole>());
+
+void tsc::multipoles_field_batch(const std::complex<double> *coeffs, const tsc::multipole_layout_t& layout,
+				 const double *x, const double *y, double *Bx, double *By, const size_t n)
+{
+	if(layout.n_used == 0){
+		std::fill(Bx, Bx + n, 0e0);
+		std::fill(By, By + n, 0e0);
+	} else if(layout.single >= 0 && size_t(layout.single) < monomial_batch_kernels.size()){
+		monomial_batch_kernels[layout.single](coeffs, x, y, Bx, By, n);
+	} else if(layout.n_used <= horner_batch_kernels.size()){
+		horner_batch_kernels[layout.n_used - 1](coeffs, x, y, Bx, By, n);
+	} else {
+		for(size_t i = 0; i < n; ++i){
+			horner_eval<false>(coeffs, layout.n_used, x[i], y[i], &Bx[i], &By[i], nullptr, nullptr);
+		}
+	}
+}
+
 template<typename T>
 void tsc::right_multiply_helper(const std::vector<T> &scale, const bool begnin, std::vector<T>* coeffs)
 {
@@ -8,6 +8,7 @@
 #include <ostream>
 #include <vector>
 #include <stdexcept>
+#include <type_traits>
 #include <thor_scsi/core/field_interpolation.h>
 #include <thor_scsi/core/exceptions.h>
 #include <thor_scsi/core/multipole_types.h>
@@ -35,9 +36,14 @@ namespace thor_scsi::core {
 	//typedef std::complex<double> cdbl;
 
 
+    /**
+     * @brief Horner scheme using only the first n_used coefficients
+     *
+     * The others are known to be zero. n_used has to be at least 1
+     */
     template<typename Tcc, typename Tcp> // a complex type
-    inline auto honer_complex(const Tcc& coeffs, const Tcp& z) {
-        size_t n = coeffs.size() -1;
+    inline auto honer_complex(const Tcc& coeffs, const Tcp& z, const size_t n_used) {
+        size_t n = n_used -1;
         // how to handle maximum order in case of ctpsa?
         auto rB = gtpsa::clone(coeffs[n]) * (1.0 + z * 0e0);
         for(int i=n - 1; i >= 0; --i) {
@@ -46,6 +52,85 @@ namespace thor_scsi::core {
         return rB;
     }
 
+    template<typename Tcc, typename Tcp> // a complex type
+    inline auto honer_complex(const Tcc& coeffs, const Tcp& z) {
+        return honer_complex(coeffs, z, coeffs.size());
+    }
+
+    /**
+     * @brief maximum number of coefficients with an unrolled kernel
+     *
+     * Same as HOMmax of the field kick. Larger representations are
+     * evaluated by a loop
+     */
+    const unsigned int max_unrolled_multipole = 21;
+
+    /**
+     * @brief which coefficients of a set of multipoles are non zero
+     *
+     * n_used: number of coefficients up to the highest non zero one
+     * (i.e. the highest non zero multipole in European convention).
+     * single: index of the only non zero coefficient (American
+     * convention, i.e. the exponent of z) or -1 if there are more
+     */
+    struct multipole_layout_t {
+        unsigned int n_used = 0;
+        int single = -1;
+    };
+
+    inline bool is_zero_multipole(const std::complex<double>& c) {
+        return c.real() == 0e0 && c.imag() == 0e0;
+    }
+
+    /* can not be checked cheaply: treated as non zero */
+    template<typename T>
+    inline bool is_zero_multipole(const T&) {
+        return false;
+    }
+
+    template<typename T>
+    inline multipole_layout_t compute_multipole_layout(const std::vector<T>& coeffs) {
+        multipole_layout_t layout;
+        unsigned int n_nonzero = 0;
+        for(size_t i = 0; i < coeffs.size(); ++i){
+            if(!is_zero_multipole(coeffs[i])){
+                layout.n_used = i + 1;
+                layout.single = i;
+                ++n_nonzero;
+            }
+        }
+        if(n_nonzero != 1){
+            layout.single = -1;
+        }
+        return layout;
+    }
+
+    /**
+     * @brief field of multipoles at (x, y) using only the coefficients given by layout
+     *
+     * Dispatches to kernels unrolled for the number of used
+     * coefficients. Pure multipoles (a single non zero coefficient)
+     * are evaluated as a monomial. Plain double arithmetic: neither
+     * temporaries nor complex multiplication with its NaN checks.
+     */
+    void multipoles_field(const std::complex<double> *coeffs, const multipole_layout_t& layout,
+                          const double x, const double y, double *Bx, double *By);
+
+    /**
+     * @brief field and its derivative in one pass
+     *
+     * Gy + I Gx = d/dz (By + I Bx), i.e. Gx = dBx/dx and Gy = dBy/dx
+     */
+    void multipoles_field_gradient(const std::complex<double> *coeffs, const multipole_layout_t& layout,
+                                   const double x, const double y, double *Bx, double *By,
+                                   double *Gx, double *Gy);
+
+    /**
+     * @brief field at n points: kernel selected once for all of them
+     */
+    void multipoles_field_batch(const std::complex<double> *coeffs, const multipole_layout_t& layout,
+                                const double *x, const double *y, double *Bx, double *By, const size_t n);
+
     /**
      *
      * solely here for support of tps ... to be removed with tps
@@ -135,6 +220,7 @@ namespace thor_scsi::core {
             for(auto h : this->coeffs){
                 h = default_value;
             }
+            this->updateLayout();
         }
 
         TwoDimensionalMultipolesKnobbed(std::vector<complex_type> const coeffs)
@@ -144,6 +230,7 @@ namespace thor_scsi::core {
             if(coeffs.size()<=1){
                 throw std::logic_error("max multipole must be at least 1");
             }
+            this->updateLayout();
         }
 
         virtual inline ~TwoDimensionalMultipolesKnobbed(void){};
@@ -152,18 +239,19 @@ namespace thor_scsi::core {
         TwoDimensionalMultipolesKnobbed(const TwoDimensionalMultipolesKnobbed& o)
 	    :  m_max_multipole(std::move(o.m_max_multipole))
 	    , coeffs(o.coeffs)
-	    {}
+	    { this->updateLayout(); }
 
         TwoDimensionalMultipolesKnobbed(const TwoDimensionalMultipolesKnobbed&& o)
 	    :  m_max_multipole(std::move(o.m_max_multipole))
                 , coeffs(std::move(o.coeffs))
-        {}
+        { this->updateLayout(); }
 
 	// Required e.g. for engineering tolerance studies
 	TwoDimensionalMultipolesKnobbed& operator= (const  TwoDimensionalMultipolesKnobbed &o)
         {
             this->coeffs = o.coeffs;
             this->m_max_multipole = o.m_max_multipole;
+            this->updateLayout();
             return *this;
         }
 
@@ -233,18 +321,23 @@ namespace thor_scsi::core {
         }
 
         inline void _field(const double x, const double y, double *Bx, double *By) const {
-            std::complex<double> z(x, y);
-            auto tmp = this->_cfield<std::complex<double>>(z);
-            // in case a power series is returned
-            // review _cfield and honer implementation?
-            std::complex<double> cst = gtpsa::cst(tmp);
-            *By = cst.real();
-            *Bx = cst.imag();
+            if constexpr (std::is_same<complex_intern_type, std::complex<double>>::value) {
+                multipoles_field(this->coeffs.data(), this->m_layout, x, y, Bx, By);
+            } else {
+                std::complex<double> z(x, y);
+                auto tmp = this->_cfield<std::complex<double>>(z);
+                // in case a power series is returned
+                // review _cfield and honer implementation?
+                std::complex<double> cst = gtpsa::cst(tmp);
+                *By = cst.real();
+                *Bx = cst.imag();
+            }
         }
 
         inline void _field(const gtpsa::tpsa& x, const gtpsa::tpsa& y, gtpsa::tpsa *Bx, gtpsa::tpsa *By) const {
             gtpsa::ctpsa z(x, y);
-            auto tmp = this->_cfield(z);
+            // zero coefficients above the highest non zero one are skipped
+            auto tmp = honer_complex(this->coeffs, z, std::max(this->m_layout.n_used, 1u));
             tmp.real(By);
             tmp.imag(Bx);
         }
@@ -335,6 +428,67 @@ namespace thor_scsi::core {
             auto tmp = this->getMultipole(2);
             return gtpsa::cst(tmp);
         }
+
+		/**
+		 * @brief field and its derivative at (x, y) in one pass
+		 *
+		 * \verbatim embed:rst:leading-asterisk
+		 *
+		 * Gx = dBx/dx and Gy = dBy/dx at the given position.
+		 *
+		 * .. note::
+		 *     :meth:`gradient` returns the quadrupole component (i.e.
+		 *     the derivative at the origin) as expected by the
+		 *     synchrotron integrals.
+		 *
+		 * \endverbatim
+		 */
+		inline void fieldAndGradient(const double x, const double y, double *Bx, double *By, double *Gx, double *Gy) const {
+			if constexpr (std::is_same<complex_intern_type, std::complex<double>>::value) {
+				multipoles_field_gradient(this->coeffs.data(), this->m_layout, x, y, Bx, By, Gx, Gy);
+			} else {
+				std::vector<std::complex<double>> c(this->coeffs.size());
+				std::transform(this->coeffs.begin(), this->coeffs.end(), c.begin(),
+					       [](const complex_intern_type& v){ return std::complex<double>(gtpsa::cst(v)); });
+				multipoles_field_gradient(c.data(), compute_multipole_layout(c), x, y, Bx, By, Gx, Gy);
+			}
+		}
+
+		void field_batch(const double *x, const double *y, double *Bx, double *By, const size_t n) const override {
+			if constexpr (std::is_same<complex_intern_type, std::complex<double>>::value) {
+				multipoles_field_batch(this->coeffs.data(), this->m_layout, x, y, Bx, By, n);
+			} else {
+				for(size_t i = 0; i < n; ++i){
+					this->_field(x[i], y[i], &Bx[i], &By[i]);
+				}
+			}
+		}
+
+		/// gradient does not depend on the position, see :meth:`gradient`
+		void gradient_batch(const double *x, const double *y, double *Gx, double *Gy, const size_t n) const override {
+			const std::complex<double> g = this->gradient(std::complex<double>(0e0, 0e0));
+			std::fill(Gy, Gy + n, g.real());
+			std::fill(Gx, Gx + n, g.imag());
+		}
+
+		/**
+		 * @brief non zero pattern of the coefficients, used to select the kernel
+		 */
+		inline const multipole_layout_t& getLayout(void) const {
+			return this->m_layout;
+		}
+
+		/**
+		 * @brief recompute the non zero pattern
+		 *
+		 * Required after the coefficients were modified through the
+		 * reference returned by the non const :meth:`getCoeffs`. Until
+		 * then all coefficients are evaluated.
+		 */
+		inline void updateLayout(void) {
+			this->m_coeffs_exposed = false;
+			this->m_layout = compute_multipole_layout(this->coeffs);
+		}
  		virtual inline void gradient(const double& x, const double& y, double *Gx, double *Gy) const override final {
 			auto tmp = this->gradient(std::complex<double>(x,y));
 			*Gy = tmp.real();
@@ -389,6 +543,7 @@ namespace thor_scsi::core {
 			// assert(use_n >= 0);
 			assert(use_n <this->m_max_multipole);
             this->coeffs[use_n] = c;
+            this->layoutChanged();
 			//this->coeffs[use_n] = complex_type(c.real(), c.imag());
 		}
 
@@ -414,6 +569,7 @@ namespace thor_scsi::core {
 				complex_intern_type scale = exp(I * phase);
 				this->coeffs[i] *= scale;
 			}
+			this->layoutChanged();
 		}
 
 		/**
@@ -443,6 +599,7 @@ namespace thor_scsi::core {
                     this->coeffs[i] += double(binom(j, i)) * (this->coeffs[j] * dzi);
                 }
             }
+            this->layoutChanged();
         }
 
         inline void applyTranslation(const double dx, const double dy) {
@@ -457,10 +614,12 @@ namespace thor_scsi::core {
 	private:
 	TwoDimensionalMultipolesKnobbed& right_multiply (const std::vector<complex_type>& scale, const bool begnin) {
 		right_multiply_helper<complex_intern_type>(scale, begnin, &this->coeffs);
+		this->layoutChanged();
 		return *this;
 	}
 	TwoDimensionalMultipolesKnobbed& right_add (const TwoDimensionalMultipolesKnobbed &other, const bool begnin){
 		right_add_helper<complex_intern_type>(other.coeffs, begnin, &this->coeffs);
+		this->layoutChanged();
                 return *this;
             }
 
@@ -483,6 +642,7 @@ namespace thor_scsi::core {
 			    return c * scale;
 		    };
 		    std::transform(c.begin(), c.end(), c.begin(), f);
+		    this->layoutChanged();
 			return *this;
 	    }
 
@@ -503,13 +663,14 @@ namespace thor_scsi::core {
 	    TwoDimensionalMultipolesKnobbed &operator += (const std::vector<complex_type> &other){
 		    bool benign = true;
 		    right_add_helper<complex_intern_type>(other, benign, &this->coeffs);
+		    this->layoutChanged();
             return *this;
             }
 	    TwoDimensionalMultipolesKnobbed& operator += (const double other) {
-		    auto& c = this->getCoeffs();
-		    for (auto& val : c){
+		    for (auto& val : this->coeffs){
 			    val += other;
 		    }
+		    this->layoutChanged();
 		    return *this;
 	    }
 
@@ -577,11 +738,15 @@ namespace thor_scsi::core {
 		 *
 		 * .. note::
 		 *     access to the same memory. If you change the coefficients
-		 *     outside you also change them here.
+		 *     outside you also change them here. All coefficients are
+		 *     evaluated afterwards, call :meth:`updateLayout` when done.
 		 *
 		 * \endverbatim
 		 */
 		inline std::vector<complex_intern_type>& getCoeffs(void) {
+			this->m_coeffs_exposed = true;
+			this->m_layout.n_used = this->coeffs.size();
+			this->m_layout.single = -1;
 			return this->coeffs;
 		}
 		/**
@@ -612,8 +777,17 @@ namespace thor_scsi::core {
 		}
 
 	protected:
+		/* coefficients may be modified through a reference handed out */
+		inline void layoutChanged(void) {
+			if(!this->m_coeffs_exposed){
+				this->m_layout = compute_multipole_layout(this->coeffs);
+			}
+		}
+
 		unsigned int m_max_multipole;
 		std::vector<complex_intern_type> coeffs;
+		multipole_layout_t m_layout;
+		bool m_coeffs_exposed = false;
 
 
 	};
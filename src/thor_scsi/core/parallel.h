@@ -0,0 +1,92 @@
+#ifndef _THOR_SCSI_CORE_PARALLEL_H_
+#define _THOR_SCSI_CORE_PARALLEL_H_ 1
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace thor_scsi::core {
+
+	/**
+	 * @brief number of threads to use
+	 *
+	 * n_threads if not 0, else the hardware concurrency. Never
+	 * more than there is work for.
+	 */
+	inline size_t number_of_threads(const size_t n_threads, const size_t n_work){
+		size_t n = n_threads;
+		if(!n){
+			n = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+		}
+		return std::max<size_t>(std::min(n, n_work), 1);
+	}
+
+	/**
+	 * @brief call func(i) for i in [0, n) using n_threads threads
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * The range is split into contiguous chunks, one per thread.
+	 * func has to be safe to call concurrently for different i;
+	 * typically each i writes only to its own slot of a result
+	 * vector. With one thread func is called in the calling thread.
+	 *
+	 * The first exception thrown by func is rethrown once all threads
+	 * are joined; the remaining calls of the thread that threw are
+	 * skipped.
+	 *
+	 * \endverbatim
+	 */
+	template<class F>
+	void parallel_for(const size_t n, const size_t n_threads, F&& func){
+		const size_t n_thr = number_of_threads(n_threads, n);
+		if(n_thr == 1){
+			for(size_t i = 0; i < n; ++i){
+				func(i);
+			}
+			return;
+		}
+
+		std::exception_ptr error = nullptr;
+		std::mutex error_mutex;
+		auto work = [&](const size_t start, const size_t stop){
+			try {
+				for(size_t i = start; i < stop; ++i){
+					func(i);
+				}
+			} catch(...) {
+				std::lock_guard<std::mutex> lock(error_mutex);
+				if(!error){
+					error = std::current_exception();
+				}
+			}
+		};
+
+		std::vector<std::thread> threads;
+		threads.reserve(n_thr);
+		const size_t chunk = n / n_thr, rest = n % n_thr;
+		size_t start = 0;
+		for(size_t t = 0; t < n_thr; ++t){
+			const size_t stop = start + chunk + (t < rest ? 1 : 0);
+			threads.emplace_back(work, start, stop);
+			start = stop;
+		}
+		for(auto& thread : threads){
+			thread.join();
+		}
+		if(error){
+			std::rethrow_exception(error);
+		}
+	}
+
+} // namespace thor_scsi::core
+#endif /* _THOR_SCSI_CORE_PARALLEL_H_ */
+/*
+ * Local Variables:
+ * mode: c++
+ * c-file-style: "python"
+ * End:
+ */
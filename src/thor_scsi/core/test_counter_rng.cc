@@ -0,0 +1,61 @@
+#define BOOST_TEST_MODULE counter_rng
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <thor_scsi/core/counter_rng.h>
+#include <cmath>
+
+namespace tsc = thor_scsi::core;
+
+/* known answers of the Random123 reference implementation */
+BOOST_AUTO_TEST_CASE(test10_philox_known_answers)
+{
+	{
+		const auto r = tsc::Philox4x32::generate({0, 0, 0, 0}, {0, 0});
+		BOOST_CHECK_EQUAL(r[0], 0x6627e8d5u);
+		BOOST_CHECK_EQUAL(r[1], 0xe169c58du);
+		BOOST_CHECK_EQUAL(r[2], 0xbc57ac4cu);
+		BOOST_CHECK_EQUAL(r[3], 0x9b00dbd8u);
+	}
+	{
+		const uint32_t m = 0xffffffff;
+		const auto r = tsc::Philox4x32::generate({m, m, m, m}, {m, m});
+		BOOST_CHECK_EQUAL(r[0], 0x408f276du);
+		BOOST_CHECK_EQUAL(r[1], 0x41c83b0eu);
+		BOOST_CHECK_EQUAL(r[2], 0xa20bc7c6u);
+		BOOST_CHECK_EQUAL(r[3], 0x6d5451fdu);
+	}
+	{
+		const auto r = tsc::Philox4x32::generate({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+							 {0xa4093822, 0x299f31d0});
+		BOOST_CHECK_EQUAL(r[0], 0xd16cfe09u);
+		BOOST_CHECK_EQUAL(r[1], 0x94fdccebu);
+		BOOST_CHECK_EQUAL(r[2], 0x5001e420u);
+		BOOST_CHECK_EQUAL(r[3], 0x24126ea1u);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test20_uniform)
+{
+	BOOST_CHECK_GT(tsc::Philox4x32::uniform(0, 0), 0e0);
+	BOOST_CHECK_LT(tsc::Philox4x32::uniform(0xffffffff, 0xffffffff), 1e0);
+	BOOST_CHECK_CLOSE(tsc::Philox4x32::uniform(0x80000000, 0), 0.5, 1e-12);
+}
+
+BOOST_AUTO_TEST_CASE(test30_normal_moments)
+{
+	const int n = 100000;
+	double sum = 0e0, sum2 = 0e0;
+	for(uint32_t i = 0; i < n / 2; ++i){
+		const auto z = tsc::Philox4x32::normal({i, 1, 2, 3}, {7, 9});
+		sum += z[0] + z[1];
+		sum2 += z[0] * z[0] + z[1] * z[1];
+	}
+	BOOST_CHECK_SMALL(sum / n, 5e0 / std::sqrt(double(n)));
+	BOOST_CHECK_CLOSE(sum2 / n, 1e0, 2e0);
+}
+/*
+ * Local Variables:
+ * mode: c++
+ * c-file-style: "python"
+ * End:
+ */
@@ -0,0 +1,46 @@
+#define BOOST_TEST_MODULE parallel
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <thor_scsi/core/parallel.h>
+#include <stdexcept>
+#include <vector>
+
+namespace tsc = thor_scsi::core;
+
+BOOST_AUTO_TEST_CASE(test10_number_of_threads)
+{
+	BOOST_CHECK_EQUAL(tsc::number_of_threads(4, 100), 4u);
+	BOOST_CHECK_EQUAL(tsc::number_of_threads(4, 2), 2u);
+	BOOST_CHECK_EQUAL(tsc::number_of_threads(4, 0), 1u);
+	BOOST_CHECK(tsc::number_of_threads(0, 100) >= 1u);
+}
+
+BOOST_AUTO_TEST_CASE(test20_parallel_for_covers_range)
+{
+	for(size_t n_threads : {1, 3, 8}){
+		const size_t n = 1001;
+		std::vector<int> count(n, 0);
+		tsc::parallel_for(n, n_threads, [&count](const size_t i){ count[i] += 1; });
+		for(size_t i = 0; i < n; ++i){
+			BOOST_CHECK_EQUAL(count[i], 1);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test30_parallel_for_rethrows)
+{
+	auto func = [](const size_t i){
+		if(i == 17){
+			throw std::runtime_error("failed");
+		}
+	};
+	BOOST_CHECK_THROW(tsc::parallel_for(100, 4, func), std::runtime_error);
+	BOOST_CHECK_THROW(tsc::parallel_for(100, 1, func), std::runtime_error);
+}
+
+/*
+ * Local Variables:
+ * mode: c++
+ * c-file-style: "python"
+ * End:
+ */
@@ -297,6 +297,71 @@ BOOST_AUTO_TEST_CASE(test50_roll_half_quater)
 	}
 }
 
+BOOST_AUTO_TEST_CASE(test60_compose)
+{
+	const gtpsa::ss_vect<double> ps_ref{1e-3, -2e-4, -7e-4, 3e-4, 1e-3, 0e0};
+
+	tsc::PhaseSpaceGalilean2DTransform outer, inner, composed;
+	outer.setdS(2e-4, -1e-4);
+	outer.setRoll(3e-3);
+	inner.setdS(-5e-5, 7e-5);
+	inner.setRoll(-1e-3);
+
+	const auto rev = composed.revision();
+	composed.compose(outer, inner);
+	BOOST_CHECK(composed.revision() != rev);
+
+	gtpsa::ss_vect<double> ps_seq = ps_ref.clone(), ps_comp = ps_ref.clone();
+	outer.forward(ps_seq);
+	inner.forward(ps_seq);
+	composed.forward(ps_comp);
+	for(int i=0; i<6; ++i){
+		BOOST_CHECK_SMALL(ps_comp[i] - ps_seq[i], 1e-17);
+	}
+
+	inner.backward(ps_seq);
+	outer.backward(ps_seq);
+	composed.backward(ps_comp);
+	for(int i=0; i<6; ++i){
+		BOOST_CHECK_SMALL(ps_comp[i] - ps_seq[i], 1e-17);
+		BOOST_CHECK_SMALL(ps_comp[i] - ps_ref[i], 1e-17);
+	}
+
+	BOOST_CHECK_CLOSE(composed.getRoll(), 2e-3, 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(test61_compose_prot)
+{
+	const gtpsa::ss_vect<double> ps_ref{1e-3, -2e-4, -7e-4, 3e-4, 1e-3, 0e0};
+
+	tsc::PhaseSpaceGalilean2DTransform outer;
+	tsc::PhaseSpaceGalileanPRot2DTransformKnobbed<tsc::StandardDoubleType> inner, composed;
+	outer.setdS(2e-4, -1e-4);
+	outer.setRoll(3e-3);
+	inner.setdS(-5e-5, 7e-5);
+	inner.setRoll(-1e-3);
+	inner.setC0(1e-4);
+	inner.setC1(2e-4);
+	inner.setS1(-3e-4);
+
+	composed.compose(outer, inner);
+
+	gtpsa::ss_vect<double> ps_seq = ps_ref.clone(), ps_comp = ps_ref.clone();
+	outer.forward(ps_seq);
+	inner.forward(ps_seq);
+	composed.forward(ps_comp);
+	for(int i=0; i<6; ++i){
+		BOOST_CHECK_SMALL(ps_comp[i] - ps_seq[i], 1e-17);
+	}
+
+	inner.backward(ps_seq);
+	outer.backward(ps_seq);
+	composed.backward(ps_comp);
+	for(int i=0; i<6; ++i){
+		BOOST_CHECK_SMALL(ps_comp[i] - ps_seq[i], 1e-17);
+	}
+}
+
 /*
  * Local Variables:
  * mode: c++
@@ -1450,3 +1450,150 @@ BOOST_AUTO_TEST_CASE(test310_hohner_complex_last_coeff)
     BOOST_CHECK_CLOSE(ref_field.real(), f.real(), 1e-12);
     BOOST_CHECK_CLOSE(ref_field.imag(), f.imag(), 1e-12);
 }
+
+/* reference: complex Horner scheme over all coefficients */
+static void reference_field_gradient(const std::vector<std::complex<double>>& c, const std::complex<double> z,
+				     std::complex<double> *B, std::complex<double> *dB)
+{
+    *B = 0e0;
+    *dB = 0e0;
+    for(int i = int(c.size()) - 1; i >= 0; --i){
+	*dB = *dB * z + *B;
+	*B = *B * z + c[i];
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test400_layout)
+{
+    tsc::TwoDimensionalMultipoles h(0e0, 10);
+    BOOST_CHECK_EQUAL(h.getLayout().n_used, 0u);
+
+    h.setMultipole(2, {1.2, 0e0});
+    BOOST_CHECK_EQUAL(h.getLayout().n_used, 2u);
+    BOOST_CHECK_EQUAL(h.getLayout().single, 1);
+
+    h.setMultipole(3, {0e0, 0.3});
+    BOOST_CHECK_EQUAL(h.getLayout().n_used, 3u);
+    BOOST_CHECK_EQUAL(h.getLayout().single, -1);
+
+    h.setMultipole(3, 0e0);
+    BOOST_CHECK_EQUAL(h.getLayout().n_used, 2u);
+    BOOST_CHECK_EQUAL(h.getLayout().single, 1);
+
+    /* translation feeds down */
+    h.applyTranslation(1e-3);
+    BOOST_CHECK_EQUAL(h.getLayout().n_used, 2u);
+    BOOST_CHECK_EQUAL(h.getLayout().single, -1);
+
+    /* copies carry the pattern */
+    tsc::TwoDimensionalMultipoles h2 = h.clone();
+    BOOST_CHECK_EQUAL(h2.getLayout().n_used, 2u);
+
+    /* modified behind the back: all coefficients evaluated until updated */
+    auto& coeffs = h2.getCoeffs();
+    BOOST_CHECK_EQUAL(h2.getLayout().n_used, 10u);
+    coeffs[6] = {1e0, 0e0};
+    h2.setMultipole(2, 0e0);
+    BOOST_CHECK_EQUAL(h2.getLayout().n_used, 10u);
+    double Bx, By;
+    h2.field(0.5, 0e0, &Bx, &By);
+    BOOST_CHECK_CLOSE(By, h.getMultipole(1).real() + std::pow(0.5, 6), 1e-12);
+    h2.updateLayout();
+    BOOST_CHECK_EQUAL(h2.getLayout().n_used, 7u);
+}
+
+BOOST_AUTO_TEST_CASE(test410_field_gradient_kernels)
+{
+    const std::complex<double> z(3e-2, -1.7e-2);
+    /* pure multipoles, sparse and dense sets; more coefficients than unrolled kernels */
+    for(const unsigned int h_max : {4u, 6u, 21u, 25u}){
+	for(unsigned int pattern = 0; pattern < 4; ++pattern){
+	    tsc::TwoDimensionalMultipoles h(0e0, h_max);
+	    for(unsigned int n = 1; n <= h_max; ++n){
+		const bool set = (pattern == 0 && n == 2) || (pattern == 1 && n == h_max)
+		    || (pattern == 2 && n % 3 == 0) || pattern == 3;
+		if(set){
+		    h.setMultipole(n, {1e0 / n, -0.5 / (n * n)});
+		}
+	    }
+	    std::complex<double> B_ref, dB_ref;
+	    reference_field_gradient(h.getCoeffsConst(), z, &B_ref, &dB_ref);
+
+	    double Bx, By, Bx2, By2, Gx, Gy;
+	    h.field(z.real(), z.imag(), &Bx, &By);
+	    h.fieldAndGradient(z.real(), z.imag(), &Bx2, &By2, &Gx, &Gy);
+	    BOOST_CHECK_SMALL(By - B_ref.real(), 1e-15);
+	    BOOST_CHECK_SMALL(Bx - B_ref.imag(), 1e-15);
+	    BOOST_CHECK_EQUAL(Bx2, Bx);
+	    BOOST_CHECK_EQUAL(By2, By);
+	    BOOST_CHECK_SMALL(Gy - dB_ref.real(), 1e-14);
+	    BOOST_CHECK_SMALL(Gx - dB_ref.imag(), 1e-14);
+
+	    /* gradient definition: d/dx */
+	    const double dx = 1e-7;
+	    double Bxp, Byp, Bxm, Bym;
+	    h.field(z.real() + dx, z.imag(), &Bxp, &Byp);
+	    h.field(z.real() - dx, z.imag(), &Bxm, &Bym);
+	    BOOST_CHECK_SMALL(Gx - (Bxp - Bxm) / (2 * dx), 1e-7);
+	    BOOST_CHECK_SMALL(Gy - (Byp - Bym) / (2 * dx), 1e-7);
+	}
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test420_sparse_tpsa)
+{
+    /* truncated at the highest non zero multipole: same result */
+    tsc::TwoDimensionalMultipoles h(0e0, 10);
+    h.setMultipole(3, {2.3, 0.1});
+
+    const double x0 = 2e-3, y0 = -1e-3;
+    gtpsa::tpsa x = ref_pos[0] + x0, y = ref_pos[1] + y0;
+    auto Bx = t_ref.clone(), By = t_ref.clone();
+    h.field(x, y, &Bx, &By);
+
+    double Bxd, Byd;
+    h.field(x0, y0, &Bxd, &Byd);
+    BOOST_CHECK_CLOSE(Bx.cst(), Bxd, 1e-12);
+    BOOST_CHECK_CLOSE(By.cst(), Byd, 1e-12);
+
+    double Bxf, Byf, Gx, Gy;
+    h.fieldAndGradient(x0, y0, &Bxf, &Byf, &Gx, &Gy);
+    BOOST_CHECK_CLOSE(By.get("1"), Gy, 1e-12);
+    BOOST_CHECK_CLOSE(Bx.get("1"), Gx, 1e-12);
+}
+
+BOOST_AUTO_TEST_CASE(test430_field_batch)
+{
+    const std::vector<double> x = {0e0, 1e-2, -3e-2, 2e-2, 5e-3};
+    const std::vector<double> y = {0e0, 0e0, 1e-2, -2e-2, 7e-3};
+    const size_t n = x.size();
+
+    tsc::TwoDimensionalMultipoles h(0e0, 25);
+    /* none, pure, dense and beyond the unrolled kernels */
+    for(const unsigned int n_max : {0u, 3u, 8u, 25u}){
+	if(n_max > 0){
+	    h.setMultipole(n_max, {1e0 / n_max, 0.1});
+	}
+	std::vector<double> Bx(n), By(n), Gx(n), Gy(n);
+	h.field_batch(x.data(), y.data(), Bx.data(), By.data(), n);
+	h.gradient_batch(x.data(), y.data(), Gx.data(), Gy.data(), n);
+	for(size_t i = 0; i < n; ++i){
+	    double Bx_ref, By_ref, Gx_ref, Gy_ref;
+	    h.field(x[i], y[i], &Bx_ref, &By_ref);
+	    h.gradient(x[i], y[i], &Gx_ref, &Gy_ref);
+	    BOOST_CHECK_EQUAL(Bx[i], Bx_ref);
+	    BOOST_CHECK_EQUAL(By[i], By_ref);
+	    BOOST_CHECK_EQUAL(Gx[i], Gx_ref);
+	    BOOST_CHECK_EQUAL(Gy[i], Gy_ref);
+	}
+    }
+
+    /* through the interface */
+    const tsc::Field2DInterpolation& intp = h;
+    std::vector<double> Bx(n), By(n);
+    intp.field_batch(x.data(), y.data(), Bx.data(), By.data(), n);
+    double Bx_ref, By_ref;
+    h.field(x[3], y[3], &Bx_ref, &By_ref);
+    BOOST_CHECK_EQUAL(Bx[3], Bx_ref);
+    BOOST_CHECK_EQUAL(By[3], By_ref);
+}
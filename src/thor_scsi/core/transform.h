@@ -1,9 +1,12 @@
 #ifndef _THOR_SCSI_CORE_TRANSFORM_H_
 #define _THOR_SCSI_CORE_TRANSFORM_H_ 1
 
+#include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstdint>
 #include <ostream>
+#include <vector>
 #include <thor_scsi/core/multipole_types.h>
 
 /* required for parameter study */
@@ -15,6 +18,55 @@ using gtpsa::cos;
  * Should I separate the coefficients from the implementation ...
  */
 namespace thor_scsi::core {
+	/**
+	 * @brief informed each time a parameter of a transform it listens to is set
+	 *
+	 * Allows to keep transforms derived from others (e.g. the one of an
+	 * element composed with the one of its girder) up to date when the
+	 * parameters are set, not when the transform is used.
+	 */
+	class TransformListener {
+	public:
+		virtual ~TransformListener(){}
+		virtual void transformChanged(void) = 0;
+	};
+
+	/**
+	 * @brief revision counter and listeners of a transform
+	 *
+	 * Copies take the revision only: listeners are registered with one
+	 * object and are neither copied nor moved.
+	 */
+	class TransformChanges {
+	public:
+		TransformChanges(void) = default;
+		inline TransformChanges(const TransformChanges& o) : m_revision(o.m_revision) {}
+		TransformChanges& operator= (const TransformChanges& o) = delete;
+
+		inline void changed(void){
+			++this->m_revision;
+			for(auto* listener : this->m_listeners){
+				listener->transformChanged();
+			}
+		}
+		inline uint64_t revision(void) const {
+			return this->m_revision;
+		}
+		inline void addListener(TransformListener* listener){
+			if(std::find(this->m_listeners.begin(), this->m_listeners.end(), listener) == this->m_listeners.end()){
+				this->m_listeners.push_back(listener);
+			}
+		}
+		inline void removeListener(TransformListener* listener){
+			this->m_listeners.erase(std::remove(this->m_listeners.begin(), this->m_listeners.end(), listener),
+						this->m_listeners.end());
+		}
+
+	private:
+		uint64_t m_revision = 0;
+		std::vector<TransformListener*> m_listeners;
+	};
+
 	/**
 	 * Candidate to be replaced by quaterions
 	 *
@@ -38,6 +90,7 @@ namespace thor_scsi::core {
                    , 2>
                    m_dS{0e0, 0e0},              ///< Transverse displacement.
            m_dT{0e0, 0e0};              ///< part of rotation matrix = (cos(dT), sin(dT)).
+           TransformChanges m_changes;  ///< revision, listeners informed on each change
 
        public:
 	       ///< Euclidian Group: dx, dy
@@ -47,7 +100,8 @@ namespace thor_scsi::core {
 	       }
 	       inline Galilean2DTransformKnobbed(Galilean2DTransformKnobbed&& O) :
 		       m_dS(std::move(O.m_dS)),
-		       m_dT(std::move(O.m_dT))
+		       m_dT(std::move(O.m_dT)),
+		       m_changes(O.m_changes)
 		       {}
 
 	       virtual ~Galilean2DTransformKnobbed(){};
@@ -56,18 +110,21 @@ namespace thor_scsi::core {
 		       this->m_dS[1] = O.m_dS[1];
 		       this->m_dT[0] = O.m_dT[0];
 		       this->m_dT[1] = O.m_dT[1];
+		       this->m_changes.changed();
 		       return *this;
 	       }
 
 		inline void setdS(const double_type dx, const double_type dy)  {
 			m_dS[0] = dx;
 			m_dS[1] = dy;
+			this->m_changes.changed();
 		}
 
 		///< Euclidian Group: Roll angle
 		inline void setRoll(const double_type roll)  {
 			m_dT[0] = cos(roll);
 			m_dT[1] = sin(roll);
+			this->m_changes.changed();
 		}
 
 		///< Euclidian Group: Roll angle
@@ -82,17 +139,71 @@ namespace thor_scsi::core {
 		}
 		inline void setDx(const double_type x){
 			m_dS[0] = x;
+			this->m_changes.changed();
 		}
 		inline void setDy(const double_type y){
 			m_dS[1] = y;
+			this->m_changes.changed();
+		}
+
+		/**
+		 * @brief changes whenever one of the parameters is set
+		 *
+		 * Only meaningful for comparing the state of the same object
+		 * at different times.
+		 */
+		inline uint64_t revision(void) const {
+			return this->m_changes.revision();
+		}
+
+		/**
+		 * @brief listener->transformChanged() is called on each change
+		 *
+		 * The listener has to remove itself before it is destroyed.
+		 */
+		inline void addListener(TransformListener* listener){
+			this->m_changes.addListener(listener);
+		}
+		inline void removeListener(TransformListener* listener){
+			this->m_changes.removeListener(listener);
+		}
+
+		/**
+		 * @brief set this transform to the one of outer followed by inner
+		 *
+		 * \verbatim embed:rst:leading-asterisk
+		 *
+		 * Applying the result is equivalent to first applying `outer`
+		 * (e.g. the one of a girder) and then `inner` (e.g. the one of
+		 * an element mounted on this girder). With
+		 * :math:`R(\theta)` the rotation used by the forward transform
+		 * the combined one reads
+		 *
+		 * .. math::
+		 *
+		 *     \theta = \theta_o + \theta_i, \qquad
+		 *     \vec{d} = \vec{d}_o + R^{-1}(\theta_o)\, \vec{d}_i
+		 *
+		 * \endverbatim
+		 */
+		inline void compose(const Galilean2DTransformKnobbed& outer, const Galilean2DTransformKnobbed& inner){
+			const auto& co = outer.m_dT[0], so = outer.m_dT[1];
+			const auto& ci = inner.m_dT[0], si = inner.m_dT[1];
+			const auto& dx = inner.m_dS[0], dy = inner.m_dS[1];
+
+			m_dS[0] = outer.m_dS[0] + co * dx - so * dy;
+			m_dS[1] = outer.m_dS[1] + so * dx + co * dy;
+			m_dT[0] = ci * co - si * so;
+			m_dT[1] = si * co + ci * so;
+			this->m_changes.changed();
 		}
 
 		///< Euclidian Group: dx, dy
-		inline const std::array<double_type, 2>& getdS(void)  {
+		inline const std::array<double_type, 2>& getdS(void) const {
 			return m_dS;
 		}
 
-		inline const std::array<double_type, 2>& getdT(void)  {
+		inline const std::array<double_type, 2>& getdT(void) const {
 			return m_dT;
 		}
 
@@ -135,6 +246,7 @@ namespace thor_scsi::core {
 		: c0(O.c0)
 		, c1(O.c1)
 		, s1(O.s1)
+		, m_changes(O.m_changes)
 		{}
 
 	    virtual ~PRotTransformKnobbed(void) {}
@@ -144,15 +256,21 @@ namespace thor_scsi::core {
 			this->c0 = O.c0;
 			this->c1 = O.c1;
 			this->s1 = O.s1;
+			this->m_changes.changed();
 			return *this;
 		}
 
-		inline void setC0(const double_type val){this->c0 = val;}
-		inline void setC1(const double_type val){this->c1 = val;}
-		inline void setS1(const double_type val){this->s1 = val;}
+		inline void setC0(const double_type val){this->c0 = val; this->m_changes.changed();}
+		inline void setC1(const double_type val){this->c1 = val; this->m_changes.changed();}
+		inline void setS1(const double_type val){this->s1 = val; this->m_changes.changed();}
 		inline double_type getC0(void) const {return this->c0;}
 		inline double_type getC1(void) const {return this->c1;}
 		inline double_type getS1(void) const {return this->s1;}
+		///< see Galilean2DTransformKnobbed::revision
+		inline uint64_t revision(void) const {return this->m_changes.revision();}
+		///< see Galilean2DTransformKnobbed::addListener
+		inline void addListener(TransformListener* listener){this->m_changes.addListener(listener);}
+		inline void removeListener(TransformListener* listener){this->m_changes.removeListener(listener);}
 
 		inline void show(std::ostream& strm, int level) const {
 			strm << "c0 = " << this->getC0() << ", "
@@ -165,6 +283,7 @@ namespace thor_scsi::core {
         //double
 	double_type
         c0, c1, s1;
+	TransformChanges m_changes;
 	};
 
     template<class C>
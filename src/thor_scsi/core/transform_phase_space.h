@@ -252,6 +252,47 @@ namespace thor_scsi::core {
 			PhaseSpaceGalilean2DTransformKnobbed<C>::backward(ps);
 			PhaseSpacePRotTransformMixinKnobbed<C>::backwardStep2(ps);
 		}
+
+		using PhaseSpacePRotTransformMixinKnobbed<C>::setC0;
+		using PhaseSpacePRotTransformMixinKnobbed<C>::setC1;
+		using PhaseSpacePRotTransformMixinKnobbed<C>::setS1;
+		using PhaseSpacePRotTransformMixinKnobbed<C>::getC0;
+		using PhaseSpacePRotTransformMixinKnobbed<C>::getC1;
+		using PhaseSpacePRotTransformMixinKnobbed<C>::getS1;
+
+		inline uint64_t revision(void) const {
+			return PhaseSpaceGalilean2DTransformKnobbed<C>::revision()
+				+ PhaseSpacePRotTransformMixinKnobbed<C>::revision();
+		}
+		/// informed on changes of the Galilean and the momentum kick part
+		inline void addListener(TransformListener* listener){
+			PhaseSpaceGalilean2DTransformKnobbed<C>::addListener(listener);
+			PhaseSpacePRotTransformMixinKnobbed<C>::addListener(listener);
+		}
+		inline void removeListener(TransformListener* listener){
+			PhaseSpaceGalilean2DTransformKnobbed<C>::removeListener(listener);
+			PhaseSpacePRotTransformMixinKnobbed<C>::removeListener(listener);
+		}
+
+		/**
+		 * @brief set this transform to the one of outer followed by inner
+		 *
+		 * The Galilean parts are combined as done by
+		 * Galilean2DTransformKnobbed::compose. The momentum kick
+		 * (c1, s1) is applied before the Galilean transform: it is
+		 * moved in front of the outer one by rotating it back
+		 * by the outer roll angle. c0 is applied in the inner
+		 * (local) frame and thus stays unchanged.
+		 */
+		inline void compose(const Galilean2DTransformKnobbed<C>& outer, const PhaseSpaceGalileanPRot2DTransformKnobbed& inner){
+			PhaseSpaceGalilean2DTransformKnobbed<C>::compose(outer, inner);
+
+			const auto& R = outer.getdT();
+			const auto& c1 = inner.c1, s1 = inner.s1;
+			PhaseSpacePRotTransformMixinKnobbed<C>::setC0(inner.c0);
+			PhaseSpacePRotTransformMixinKnobbed<C>::setC1(R[X_] * c1 - R[Y_] * s1);
+			PhaseSpacePRotTransformMixinKnobbed<C>::setS1(R[Y_] * c1 + R[X_] * s1);
+		}
 	};
 
     typedef Galilean2DTransformKnobbed<StandardDoubleType> Galilean2DTransform;
@@ -1,14 +1,214 @@
 #include <thor_scsi/custom/aircoil_interpolation.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
 
 namespace tsc = thor_scsi::core;
 namespace tsu = thor_scsi::custom;
 
+/*
+ * number of independent accumulators: enough for 4 doubles (AVX2) or
+ * 2 x 2 doubles (SSE2 / NEON). Each lane keeps its own partial sum,
+ * thus the result does not depend on the vector width the compiler
+ * chose but only on this constant.
+ */
+static const size_t n_lanes = 4;
+static_assert(n_lanes == 4, "final reductions are written out for 4 lanes");
+
+/*
+ * One reciprocal per filament: the field is (dx, dy) / r2, the
+ * derivative (dy^2 - dx^2, -2 dx dy) / r2^2 reuses it.
+ */
+template<bool with_gradient>
+static inline void field_gradient_kernel(const tsu::aircoil_filaments_soa_t& filaments, const double x, const double y,
+					 double *Bx, double *By, double *Gx, double *Gy)
+{
+    const size_t n = filaments.size();
+    const double * __restrict__ fx = filaments.x.data();
+    const double * __restrict__ fy = filaments.y.data();
+    const double * __restrict__ fk = filaments.k.data();
+
+    double bx[n_lanes] = {}, by[n_lanes] = {}, gx[n_lanes] = {}, gy[n_lanes] = {};
+
+    const size_t n_blocked = n - n % n_lanes;
+    for(size_t i = 0; i < n_blocked; i += n_lanes){
+	for(size_t l = 0; l < n_lanes; ++l){
+	    const double dx = x - fx[i + l];
+	    const double dy = y - fy[i + l];
+	    const double inv_r2 = 1e0 / (dx * dx + dy * dy);
+	    const double w = fk[i + l] * inv_r2;
+	    by[l] += w * dx;
+	    bx[l] += w * dy;
+	    if(with_gradient){
+		const double w2 = w * inv_r2;
+		gy[l] += w2 * (dy * dy - dx * dx);
+		gx[l] -= 2e0 * w2 * dx * dy;
+	    }
+	}
+    }
+    for(size_t i = n_blocked; i < n; ++i){
+	const size_t l = i - n_blocked;
+	const double dx = x - fx[i];
+	const double dy = y - fy[i];
+	const double inv_r2 = 1e0 / (dx * dx + dy * dy);
+	const double w = fk[i] * inv_r2;
+	by[l] += w * dx;
+	bx[l] += w * dy;
+	if(with_gradient){
+	    const double w2 = w * inv_r2;
+	    gy[l] += w2 * (dy * dy - dx * dx);
+	    gx[l] -= 2e0 * w2 * dx * dy;
+	}
+    }
+
+    *Bx = (bx[0] + bx[1]) + (bx[2] + bx[3]);
+    *By = (by[0] + by[1]) + (by[2] + by[3]);
+    if(with_gradient){
+	*Gx = (gx[0] + gx[1]) + (gx[2] + gx[3]);
+	*Gy = (gy[0] + gy[1]) + (gy[2] + gy[3]);
+    }
+}
+
+void tsu::aircoil_field_kernel(const tsu::aircoil_filaments_soa_t& filaments, const double x, const double y,
+			       double *Bx, double *By)
+{
+    field_gradient_kernel<false>(filaments, x, y, Bx, By, nullptr, nullptr);
+}
+
+void tsu::aircoil_field_gradient_kernel(const tsu::aircoil_filaments_soa_t& filaments, const double x, const double y,
+					double *Bx, double *By, double *Gx, double *Gy)
+{
+    field_gradient_kernel<true>(filaments, x, y, Bx, By, Gx, Gy);
+}
+
+template<class C>
+std::vector<tsu::aircoil_filament_t> tsu::AirCoilMagneticFieldKnobbed<C>::getUsedFilaments(void) const
+{
+    const double mu0 = 4 * M_PI * 1e-7;
+    const double precomp = mu0 / (2 * M_PI);
+    const auto& f = this->m_filaments;
+
+    std::vector<aircoil_filament_t> filaments;
+    filaments.reserve(f.size());
+    for(size_t i = 0; i < f.size(); ++i){
+	filaments.push_back({f.x[i], f.y[i], f.k[i] / precomp});
+    }
+    return filaments;
+}
+
+template<class C>
+tsu::aircoil_expansion_report_t
+tsu::AirCoilMagneticFieldKnobbed<C>::fitMultipoleExpansion(const double radius, const unsigned int order,
+							    const size_t n_samples)
+{
+    const auto& f = this->m_filaments;
+    if(f.size() == 0){
+	throw std::invalid_argument("air coil expansion: no filaments");
+    }
+    if(order < 1){
+	throw std::invalid_argument("air coil expansion: order must be at least 1");
+    }
+    if(n_samples == 0){
+	throw std::invalid_argument("air coil expansion: at least one sample required");
+    }
+
+    double r_min = std::numeric_limits<double>::max();
+    for(size_t i = 0; i < f.size(); ++i){
+	r_min = std::min(r_min, std::hypot(f.x[i], f.y[i]));
+    }
+    if(!(radius > 0e0) || !(radius < r_min)){
+	std::stringstream strm;
+	strm << "air coil expansion: radius " << radius
+	     << " must be positive and smaller than the distance of the closest filament "
+	     << r_min;
+	throw std::invalid_argument(strm.str());
+    }
+
+    /* c_n = - k sum_j I_j / a_j^(n+1): computed with scale 1 */
+    std::vector<std::complex<double>> coeffs(order + 1, std::complex<double>(0e0, 0e0));
+    for(size_t i = 0; i < f.size(); ++i){
+	const std::complex<double> inv_a = 1e0 / std::complex<double>(f.x[i], f.y[i]);
+	std::complex<double> term = - f.k[i] * inv_a;
+	for(unsigned int n = 0; n <= order; ++n){
+	    coeffs[n] += term;
+	    term *= inv_a;
+	}
+    }
+    std::vector<std::complex<double>> derivative(order);
+    for(unsigned int n = 1; n <= order; ++n){
+	derivative[n - 1] = double(n) * coeffs[n];
+    }
+
+    this->m_expansion = std::move(coeffs);
+    this->m_expansion_derivative = std::move(derivative);
+    this->m_expansion_radius = radius;
+
+    /* compared in the complex plane: B_y - I B_x for scale 1 */
+    aircoil_expansion_report_t report = {radius, order, n_samples, 0e0, 0e0, 0e0};
+    for(size_t i = 0; i < n_samples; ++i){
+	const std::complex<double> z = std::polar(radius, 2 * M_PI * i / n_samples);
+	std::complex<double> exact(0e0, 0e0);
+	for(size_t j = 0; j < f.size(); ++j){
+	    exact += f.k[j] / (z - std::complex<double>(f.x[j], f.y[j]));
+	}
+	const std::complex<double> approx = gtpsa::cst(tsc::honer_complex(this->m_expansion, z));
+	report.max_abs_error = std::max(report.max_abs_error, std::abs(approx - exact));
+	report.max_field = std::max(report.max_field, std::abs(exact));
+    }
+    report.max_rel_error = (report.max_field > 0e0) ? report.max_abs_error / report.max_field : 0e0;
+    return report;
+}
+
+/*
+ * B_y - I B_x is given by the expansion: the kernel returns
+ * B_y + I B_x for the coefficients, thus the sign of B_x flips
+ */
+template<bool with_gradient>
+static void aircoil_batch(const tsu::aircoil_filaments_soa_t& filaments, const double scale,
+			  const std::vector<std::complex<double>>& expansion, const double radius,
+			  const double *x, const double *y, double *Bx, double *By, const size_t n)
+{
+    const auto layout = tsc::compute_multipole_layout(expansion);
+    const double r2 = radius * radius;
+    for(size_t i = 0; i < n; ++i){
+	if(!expansion.empty() && x[i] * x[i] + y[i] * y[i] <= r2){
+	    tsc::multipoles_field(expansion.data(), layout, x[i], y[i], &Bx[i], &By[i]);
+	    Bx[i] = -Bx[i];
+	} else if(with_gradient){
+	    double bx, by;
+	    tsu::aircoil_field_gradient_kernel(filaments, x[i], y[i], &bx, &by, &Bx[i], &By[i]);
+	} else {
+	    tsu::aircoil_field_kernel(filaments, x[i], y[i], &Bx[i], &By[i]);
+	}
+	Bx[i] *= scale;
+	By[i] *= scale;
+    }
+}
+
+template<class C>
+void tsu::AirCoilMagneticFieldKnobbed<C>::field_batch(const double *x, const double *y, double *Bx, double *By,
+						      const size_t n) const
+{
+    aircoil_batch<false>(this->m_filaments, this->m_scale, this->m_expansion, this->m_expansion_radius,
+			 x, y, Bx, By, n);
+}
+
+template<class C>
+void tsu::AirCoilMagneticFieldKnobbed<C>::gradient_batch(const double *x, const double *y, double *Gx, double *Gy,
+							 const size_t n) const
+{
+    aircoil_batch<true>(this->m_filaments, this->m_scale, this->m_expansion_derivative, this->m_expansion_radius,
+			x, y, Gx, Gy, n);
+}
+
 template<class C>
 void tsu::AirCoilMagneticFieldKnobbed<C>::show(std::ostream& strm, int level) const
 {
     strm << "AirCoilMagneticFieldKnobbed({ ";
     bool first = true;
-    for(const auto& f: this->m_filaments){
+    for(const auto& f: this->getUsedFilaments()){
 	if(!first){
 	    strm << ", ";
 	}
@@ -17,9 +217,24 @@ void tsu::AirCoilMagneticFieldKnobbed<C>::show(std::ostream& strm, int level) co
 	strm <<"}";
 	first = false;
     }
-    strm << "})";
+    strm << "}";
+    if(this->hasMultipoleExpansion()){
+	strm << ", expansion(radius = " << this->m_expansion_radius
+	     << ", order = " << this->m_expansion.size() - 1 << ")";
+    }
+    strm << ")";
 }
 
 
 template void tsu::AirCoilMagneticFieldKnobbed<tsc::StandardDoubleType>::show(std::ostream& strm, int level) const;
 template void tsu::AirCoilMagneticFieldKnobbed<tsc::TpsaVariantType>::show(std::ostream& strm, int level) const;
+template std::vector<tsu::aircoil_filament_t> tsu::AirCoilMagneticFieldKnobbed<tsc::StandardDoubleType>::getUsedFilaments(void) const;
+template std::vector<tsu::aircoil_filament_t> tsu::AirCoilMagneticFieldKnobbed<tsc::TpsaVariantType>::getUsedFilaments(void) const;
+template tsu::aircoil_expansion_report_t
+tsu::AirCoilMagneticFieldKnobbed<tsc::StandardDoubleType>::fitMultipoleExpansion(const double radius, const unsigned int order, const size_t n_samples);
+template tsu::aircoil_expansion_report_t
+tsu::AirCoilMagneticFieldKnobbed<tsc::TpsaVariantType>::fitMultipoleExpansion(const double radius, const unsigned int order, const size_t n_samples);
+template void tsu::AirCoilMagneticFieldKnobbed<tsc::StandardDoubleType>::field_batch(const double *x, const double *y, double *Bx, double *By, const size_t n) const;
+template void tsu::AirCoilMagneticFieldKnobbed<tsc::TpsaVariantType>::field_batch(const double *x, const double *y, double *Bx, double *By, const size_t n) const;
+template void tsu::AirCoilMagneticFieldKnobbed<tsc::StandardDoubleType>::gradient_batch(const double *x, const double *y, double *Gx, double *Gy, const size_t n) const;
+template void tsu::AirCoilMagneticFieldKnobbed<tsc::TpsaVariantType>::gradient_batch(const double *x, const double *y, double *Gx, double *Gy, const size_t n) const;
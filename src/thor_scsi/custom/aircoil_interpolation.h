@@ -1,11 +1,13 @@
 #ifndef _THOR_SCSI_CUSTOM_AIRCOIL_INTERPOLATION_H_
 #define _THOR_SCSI_CUSTOM_AIRCOIL_INTERPOLATION_H_ 1
 
+#include <complex>
 #include <ostream>
 #include <vector>
 #include <gtpsa/utils.hpp>
 #include <gtpsa/utils_tps.hpp>
 #include <thor_scsi/core/field_interpolation.h>
+#include <thor_scsi/core/multipoles.h>
 
 
 namespace thor_scsi::custom {
@@ -22,18 +24,125 @@ namespace thor_scsi::custom {
 	};
 	typedef struct aircoil_filament aircoil_filament_t;
 
+	/**
+	 * @brief accuracy of the multipole expansion of an air coil field
+	 *
+	 * Errors are given for scale 1 in Tesla.
+	 */
+	struct aircoil_expansion_report {
+		double radius;            ///< expansion used within this radius
+		unsigned int order;       ///< highest power of z used
+		size_t n_samples;         ///< number of points on the circle checked
+		double max_abs_error;     ///< max |B_expansion - B_exact| on the circle
+		double max_field;         ///< max |B_exact| on the circle
+		double max_rel_error;     ///< max_abs_error / max_field
+
+	    inline void show(std::ostream& strm, int level) const {
+		strm << "radius = " << radius
+		     << ", order = " << order
+		     << ", n_samples = " << n_samples
+		     << ", max_abs_error = " << max_abs_error
+		     << ", max_field = " << max_field
+		     << ", max_rel_error = " << max_rel_error;
+	    }
+	};
+	typedef struct aircoil_expansion_report aircoil_expansion_report_t;
+
+	/**
+	 * @brief filaments stored as structure of arrays
+	 *
+	 * k: current times \f$\mu_0 / 2 \pi\f$
+	 */
+	struct aircoil_filaments_soa {
+		std::vector<double> x, y, k;
+
+		inline size_t size(void) const { return this->x.size(); }
+	};
+	typedef struct aircoil_filaments_soa aircoil_filaments_soa_t;
+
+	/**
+	 * @brief field of filaments at (x, y) for scale 1
+	 *
+	 * The loop is blocked in lanes so that the compiler can vectorise
+	 * it without reordering the sums (i.e. without -ffast-math).
+	 */
+	void aircoil_field_kernel(const aircoil_filaments_soa_t& filaments, const double x, const double y,
+				  double *Bx, double *By);
+	/**
+	 * @brief field and its derivative along x in one pass for scale 1
+	 *
+	 * Gx = dBx/dx, Gy = dBy/dx. By Maxwell's equations dBx/dy = dBy/dx and
+	 * dBy/dy = -dBx/dx in the filament free region.
+	 */
+	void aircoil_field_gradient_kernel(const aircoil_filaments_soa_t& filaments, const double x, const double y,
+					   double *Bx, double *By, double *Gx, double *Gy);
+
+	/**
+	 * @brief field of a set of line currents (filaments)
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * The field is computed as the sum over all filaments. As this is
+	 * expensive for many filaments, a multipole expansion can be
+	 * precomputed using :meth:`fitMultipoleExpansion`. Within the
+	 * expansion radius the field is then evaluated with Horner's
+	 * scheme as done for :class:`TwoDimensionalMultipoles`, outside
+	 * the exact sum is used.
+	 *
+	 * The field of the filaments is :math:`B_y - i B_x = \sum_j k I_j / (z - a_j)`
+	 * with :math:`a_j` the position of the filament and :math:`k = \mu_0 / 2 \pi`
+	 * times the scale. For :math:`|z| < \min_j |a_j|` it is expanded to
+	 *
+	 * .. math::
+	 *
+	 *     B_y - i B_x = \sum_{n=0}^{N} c_n z^n, \qquad
+	 *     c_n = - k \sum_j \frac{I_j}{a_j^{n+1}}
+	 *
+	 * i.e. the coefficients are the exact Taylor coefficients: no
+	 * least square fit is required. The truncation error is checked
+	 * on the circle of the expansion radius: as the error is an analytic
+	 * function its maximum within the circle is found on its boundary.
+	 *
+	 * The gradient is returned as derivative along x, i.e.
+	 * :math:`G_y + i G_x = \partial_x (B_y + i B_x)`, which matches the
+	 * definition used by :class:`TwoDimensionalMultipoles`.
+	 *
+	 * \endverbatim
+	 */
 	template<class C>
 	class AirCoilMagneticFieldKnobbed : public thor_scsi::core::Field2DInterpolationKnobbed<C> {
-	        const std::vector<aircoil_filament_t> m_filaments;
+		aircoil_filaments_soa_t m_filaments;
 	        double m_scale;
+		/* coefficients c_n for scale 1 and the ones of the derivative */
+		std::vector<std::complex<double>> m_expansion, m_expansion_derivative;
+		double m_expansion_radius = 0e0;
+
+		static inline aircoil_filaments_soa_t to_soa(const std::vector<aircoil_filament_t>& filaments){
+			const double mu0 = 4 * M_PI * 1e-7;
+			const double precomp = mu0 / (2 * M_PI);
+			aircoil_filaments_soa_t soa;
+			soa.x.reserve(filaments.size());
+			soa.y.reserve(filaments.size());
+			soa.k.reserve(filaments.size());
+			for(const auto& f: filaments){
+				soa.x.push_back(f.x);
+				soa.y.push_back(f.y);
+				soa.k.push_back(precomp * f.current);
+			}
+			return soa;
+		}
 
 	protected:
 	    // subclasses will "multiply the number of filaments during initalisation"
-	    inline void setFilaments(const std::vector<aircoil_filament_t> filaments){ this->m_filaments = filaments;}
+	    inline void setFilaments(const std::vector<aircoil_filament_t> filaments){
+		    this->m_filaments = to_soa(filaments);
+		    // expansion computed for the old filaments
+		    this->clearMultipoleExpansion();
+	    }
 
 	public:
 	    AirCoilMagneticFieldKnobbed(const std::vector<aircoil_filament_t> filaments, const double scale=0e0)
-			: m_filaments(filaments)
+			: m_filaments(to_soa(filaments))
 			, m_scale(scale)
 			{}
 
@@ -43,8 +152,38 @@ namespace thor_scsi::custom {
 		const double getScale(void) const { return this->m_scale;  }
 
 		// required for inspection: e.g. if python transfers filaments correctly
-		inline std::vector<aircoil_filament_t> getUsedFilaments(void) const {
-			return this->m_filaments;
+		std::vector<aircoil_filament_t> getUsedFilaments(void) const;
+
+		/**
+		 * @brief precompute the multipole expansion for the field within radius
+		 *
+		 * @param radius: expansion used for \f$ |z| \le \f$ radius. Must be
+		 *                smaller than the distance of the closest filament to
+		 *                the origin
+		 * @param order:  highest power of z, at least 1
+		 * @param n_samples: number of points on the circle used to estimate
+		 *                the error
+		 *
+		 * @throws std::invalid_argument if radius is not within the filaments
+		 */
+		aircoil_expansion_report_t fitMultipoleExpansion(const double radius, const unsigned int order,
+								 const size_t n_samples=128);
+
+		/// @brief use the exact sum everywhere
+		inline void clearMultipoleExpansion(void) {
+			this->m_expansion.clear();
+			this->m_expansion_derivative.clear();
+			this->m_expansion_radius = 0e0;
+		}
+		inline bool hasMultipoleExpansion(void) const {
+			return !this->m_expansion.empty();
+		}
+		inline double getExpansionRadius(void) const {
+			return this->m_expansion_radius;
+		}
+		/// @brief coefficients \f$c_n\f$ (for scale 1)
+		inline const std::vector<std::complex<double>>& getMultipoleExpansion(void) const {
+			return this->m_expansion;
 		}
 
 
@@ -59,10 +198,7 @@ namespace thor_scsi::custom {
 		 * field[1] = B[1]
 		 */
 		template<typename T>
-		inline void _field(const T& x, const T& y, T *pBx, T *pBy) const {
-			const double mu0 = 4 * M_PI * 1e-7;
-			const double precomp = mu0 / (2 * M_PI) * this->m_scale;
-
+		inline void _exactField(const T& x, const T& y, T *pBx, T *pBy) const {
 			/*
 			 * better allocate new ones and copy back
 			 * otherwise: for tpsa objects don't forget to clear them
@@ -71,14 +207,15 @@ namespace thor_scsi::custom {
 			 * new allocation does that for us ...
 			 */
 			T Bx = gtpsa::same_as_instance(*pBx);
-			T By = gtpsa::same_as_instance(*pBx);
+			T By = gtpsa::same_as_instance(*pBy);
 
-			for(const auto& f: this->m_filaments){
-				const auto dx = x - f.x;
-				const auto dy = y - f.y;
-				const auto r2 = dx*dx + dy*dy;
-				By += precomp * f.current / r2 * dx;
-				Bx += precomp * f.current / r2 * dy;
+			const auto& f = this->m_filaments;
+			for(size_t i = 0; i < f.size(); ++i){
+				const auto dx = x - f.x[i];
+				const auto dy = y - f.y[i];
+				const auto w = (this->m_scale * f.k[i]) / (dx*dx + dy*dy);
+				By += w * dx;
+				Bx += w * dy;
 			}
 
 			*pBx = std::move(Bx);
@@ -86,10 +223,100 @@ namespace thor_scsi::custom {
 
 		}
 
+		inline void _exactField(const double& x, const double& y, double *pBx, double *pBy) const {
+			aircoil_field_kernel(this->m_filaments, x, y, pBx, pBy);
+			*pBx *= this->m_scale;
+			*pBy *= this->m_scale;
+		}
+
+		/*
+		 * d/dx (dx / r2) = (dy^2 - dx^2) / r2^2
+		 * d/dx (dy / r2) = - 2 dx dy / r2^2
+		 */
+		template<typename T>
+		inline void _exactGradient(const T& x, const T& y, T *pGx, T *pGy) const {
+			T Gx = gtpsa::same_as_instance(*pGx);
+			T Gy = gtpsa::same_as_instance(*pGy);
+
+			const auto& f = this->m_filaments;
+			for(size_t i = 0; i < f.size(); ++i){
+				const auto dx = x - f.x[i];
+				const auto dy = y - f.y[i];
+				const auto r2 = dx*dx + dy*dy;
+				const auto w = (this->m_scale * f.k[i]) / (r2 * r2);
+				Gy += w * (dy * dy - dx * dx);
+				Gx += -2e0 * w * dx * dy;
+			}
+
+			*pGx = std::move(Gx);
+			*pGy = std::move(Gy);
+		}
+
+		inline void _exactGradient(const double& x, const double& y, double *pGx, double *pGy) const {
+			double Bx, By;
+			aircoil_field_gradient_kernel(this->m_filaments, x, y, &Bx, &By, pGx, pGy);
+			*pGx *= this->m_scale;
+			*pGy *= this->m_scale;
+		}
+
+		inline bool useExpansion(const double x, const double y) const {
+			return this->hasMultipoleExpansion()
+				&& (x * x + y * y <= this->m_expansion_radius * this->m_expansion_radius);
+		}
+
+		/* B_y + I B_x is the complex conjugate of the expansion, same for the derivative */
+		inline void _expansionEval(const std::vector<std::complex<double>>& coeffs,
+					   const double& x, const double& y, double *pBx, double *pBy) const {
+			const std::complex<double> z(x, y);
+			const std::complex<double> w = gtpsa::cst(thor_scsi::core::honer_complex(coeffs, z));
+			*pBy =  this->m_scale * w.real();
+			*pBx = -this->m_scale * w.imag();
+		}
+
+		inline void _expansionEval(const std::vector<std::complex<double>>& coeffs,
+					   const gtpsa::tpsa& x, const gtpsa::tpsa& y, gtpsa::tpsa *pBx, gtpsa::tpsa *pBy) const {
+			gtpsa::ctpsa z(x, y);
+			auto w = thor_scsi::core::honer_complex(coeffs, z);
+			w.real(pBy);
+			w.imag(pBx);
+			*pBy *=  this->m_scale;
+			*pBx *= -this->m_scale;
+		}
+
 		template<typename T>
-		inline void _gradient(T& x, T& y, T *Gx, T *Gy){
-		    std::runtime_error("air coil interpolation: gradient needs to be added");
+		inline void _field(const T& x, const T& y, T *pBx, T *pBy) const {
+			if(this->useExpansion(gtpsa::cst(x), gtpsa::cst(y))){
+				this->_expansionEval(this->m_expansion, x, y, pBx, pBy);
+				return;
+			}
+			this->_exactField(x, y, pBx, pBy);
+		}
+
+		template<typename T>
+		inline void _gradient(const T& x, const T& y, T *pGx, T *pGy) const {
+			if(this->useExpansion(gtpsa::cst(x), gtpsa::cst(y))){
+				this->_expansionEval(this->m_expansion_derivative, x, y, pGx, pGy);
+				return;
+			}
+			this->_exactGradient(x, y, pGx, pGy);
+		}
+
+		/**
+		 * @brief field and gradient in one pass
+		 */
+		inline void fieldAndGradient(const double& x, const double& y, double *Bx, double *By, double *Gx, double *Gy) const {
+			if(this->useExpansion(x, y)){
+				this->_expansionEval(this->m_expansion, x, y, Bx, By);
+				this->_expansionEval(this->m_expansion_derivative, x, y, Gx, Gy);
+				return;
+			}
+			aircoil_field_gradient_kernel(this->m_filaments, x, y, Bx, By, Gx, Gy);
+			*Bx *= this->m_scale;
+			*By *= this->m_scale;
+			*Gx *= this->m_scale;
+			*Gy *= this->m_scale;
 		}
+
 		inline void field(const double&      x, const double&      y, double      *Bx, double      *By) const override final
 			{
 				this->_field(x, y, Bx, By);
@@ -100,23 +327,31 @@ namespace thor_scsi::custom {
             }
 		inline void field(const tps& x, const tps& y, tps *Bx, tps *By) const override final
 			{
-				this->_field(x, y, Bx, By);
+				this->_exactField(x, y, Bx, By);
 			}
 
 		inline void gradient(const double& x, const double& y, double *Gx, double *Gy) const override final
-			{ /* this->gradient(x, y, Gx, Gy); */ };
+			{ this->_gradient(x, y, Gx, Gy); };
 
 		inline void gradient(const tps& x, const tps& y, tps *Gx, tps *Gy) const override final
-			{ /* this->gradient(x, y, Gx, Gy); */ };
+			{ this->_exactGradient(x, y, Gx, Gy); };
 
 		inline void gradient(const gtpsa::tpsa& x, const gtpsa::tpsa& y, gtpsa::tpsa *Gx, gtpsa::tpsa *Gy) const override final
-			{ /* this->gradient(x, y, Gx, Gy); */ };
+			{ this->_gradient(x, y, Gx, Gy); };
 
 		inline void gradient(const tps& x, const tps& y, double *Gx, double *Gy) const override final
-			{ /* this->gradient(x, y, Gx, Gy); */ };
+			{ this->_gradient(x.cst(), y.cst(), Gx, Gy); };
 
 		inline void gradient(const gtpsa::tpsa& x, const gtpsa::tpsa& y, double *Gx, double *Gy) const override final
-			{ /* this->gradient(x, y, Gx, Gy); */ };
+			{ this->_gradient(x.cst(), y.cst(), Gx, Gy); };
+
+		/*
+		 * expansion layout computed once for all points, thus
+		 * points within the expansion radius use the unrolled
+		 * multipole kernels
+		 */
+		void field_batch(const double *x, const double *y, double *Bx, double *By, const size_t n) const override;
+		void gradient_batch(const double *x, const double *y, double *Gx, double *Gy, const size_t n) const override;
 
 	        void show(std::ostream&, int level) const override;
 	};
@@ -0,0 +1,304 @@
+#include <thor_scsi/custom/field_map_interpolation.h>
+#include <thor_scsi/core/exceptions.h>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ts = thor_scsi;
+namespace tsc = thor_scsi::core;
+namespace tsu = thor_scsi::custom;
+namespace fs = std::filesystem;
+
+/*
+ * File layout: all fields native byte order
+ *
+ *  offset  0: magic      char[8]  "TSFMAP\0\0"
+ *  offset  8: version    uint32
+ *  offset 12: components uint32   always 2 (Bx, By)
+ *  offset 16: nx         uint64
+ *  offset 24: ny         uint64
+ *  offset 32: x0, y0, dx, dy double[4]
+ *  offset header_size: coefficients double[(nx - 1) * (ny - 1) * 2 * 16]
+ *
+ * Cells are stored x first. Per cell the 16 coefficients of Bx are
+ * followed by the ones of By, i.e. one cell spans 4 cache lines.
+ */
+static const char magic[8] = {'T', 'S', 'F', 'M', 'A', 'P', '\0', '\0'};
+static const uint32_t version = 1;
+static const uint32_t n_components = 2;
+static const size_t header_size = 64;
+static const size_t cell_size = n_components * tsu::FieldMapGrid::n_coeffs;
+
+static size_t expected_file_size(const size_t nx, const size_t ny)
+{
+	return header_size + (nx - 1) * (ny - 1) * cell_size * sizeof(double);
+}
+
+/*
+ * grids in use, identified by device and inode: a rewritten file
+ * (written to a temporary and renamed) is a different one
+ */
+static std::mutex grid_registry_mutex;
+static std::map<std::pair<dev_t, ino_t>, std::weak_ptr<const tsu::FieldMapGrid>> grid_registry;
+
+std::shared_ptr<const tsu::FieldMapGrid> tsu::FieldMapGrid::open(const std::string& filename)
+{
+	struct stat st;
+	if(::stat(filename.c_str(), &st) != 0){
+		throw ts::LoadException(std::strerror(errno), "Could not open field map " + filename + ":");
+	}
+	const auto key = std::make_pair(st.st_dev, st.st_ino);
+
+	std::lock_guard<std::mutex> lock(grid_registry_mutex);
+	auto it = grid_registry.find(key);
+	if(it != grid_registry.end()){
+		auto grid = it->second.lock();
+		if(grid){
+			return grid;
+		}
+	}
+	std::shared_ptr<const FieldMapGrid> grid(new FieldMapGrid(filename));
+	grid_registry[key] = grid;
+	return grid;
+}
+
+tsu::FieldMapGrid::FieldMapGrid(const std::string& filename)
+	: m_filename(filename)
+{
+	const int fd = ::open(filename.c_str(), O_RDONLY);
+	if(fd < 0){
+		throw ts::LoadException(std::strerror(errno), "Could not open field map " + filename + ":");
+	}
+	struct stat st;
+	if(::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < header_size){
+		::close(fd);
+		throw ts::LoadException("truncated header", "Field map " + filename + ":");
+	}
+	const size_t length = static_cast<size_t>(st.st_size);
+	void *addr = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+	/* mapping stays valid after closing the descriptor */
+	::close(fd);
+	if(addr == MAP_FAILED){
+		throw ts::LoadException(std::strerror(errno), "Could not map field map " + filename + ":");
+	}
+	this->m_mapping = addr;
+	this->m_length = length;
+
+	const char *header = static_cast<const char *>(addr);
+	uint32_t file_version = 0, components = 0;
+	uint64_t nx = 0, ny = 0;
+	std::array<double, 4> geometry;
+	std::memcpy(&file_version, header + 8, sizeof(file_version));
+	std::memcpy(&components, header + 12, sizeof(components));
+	std::memcpy(&nx, header + 16, sizeof(nx));
+	std::memcpy(&ny, header + 24, sizeof(ny));
+	std::memcpy(geometry.data(), header + 32, sizeof(double) * geometry.size());
+
+	std::string problem;
+	if(std::memcmp(header, magic, sizeof(magic)) != 0){
+		problem = "not a field map (magic mismatch)";
+	} else if(file_version != version){
+		problem = "unsupported version " + std::to_string(file_version);
+	} else if(components != n_components){
+		problem = "unsupported number of components " + std::to_string(components);
+	} else if(nx < 2 || ny < 2){
+		problem = "grid requires at least 2 x 2 points";
+	} else if(!(geometry[2] > 0e0) || !(geometry[3] > 0e0)
+		  || !std::isfinite(geometry[2]) || !std::isfinite(geometry[3])){
+		problem = "grid spacing must be positive";
+	} else if(length != expected_file_size(nx, ny)){
+		problem = "file size " + std::to_string(length) + " does not match grid size "
+			+ std::to_string(expected_file_size(nx, ny));
+	}
+	if(!problem.empty()){
+		::munmap(this->m_mapping, this->m_length);
+		throw ts::LoadException(problem, "Field map " + filename + ":");
+	}
+
+	this->m_nx = nx;
+	this->m_ny = ny;
+	this->m_x0 = geometry[0];
+	this->m_y0 = geometry[1];
+	this->m_dx = geometry[2];
+	this->m_dy = geometry[3];
+	this->m_coeffs = reinterpret_cast<const double *>(header + header_size);
+}
+
+tsu::FieldMapGrid::~FieldMapGrid()
+{
+	if(this->m_mapping){
+		::munmap(this->m_mapping, this->m_length);
+	}
+}
+
+void tsu::FieldMapGrid::show(std::ostream& strm, int level) const
+{
+	strm << "FieldMapGrid(file=" << this->m_filename
+	     << ", nx=" << this->m_nx << ", ny=" << this->m_ny
+	     << ", x=[" << this->m_x0 << ", " << this->xMax() << "]"
+	     << ", y=[" << this->m_y0 << ", " << this->yMax() << "])";
+}
+
+/*
+ * derivative along one axis of a grid stored as [i + nx * j]. stride 1
+ * for x, nx for y. Central differences inside, one sided at the border
+ */
+static std::vector<double> finite_difference(const std::vector<double>& f, const size_t nx, const size_t ny,
+					     const bool along_x, const double h)
+{
+	std::vector<double> df(f.size());
+	const size_t n = along_x ? nx : ny, stride = along_x ? 1 : nx;
+	for(size_t j = 0; j < ny; ++j){
+		for(size_t i = 0; i < nx; ++i){
+			const size_t k = along_x ? i : j, idx = i + nx * j;
+			const size_t lo = (k == 0) ? idx : idx - stride;
+			const size_t hi = (k == n - 1) ? idx : idx + stride;
+			const double steps = (k == 0 || k == n - 1) ? 1e0 : 2e0;
+			df[idx] = (f[hi] - f[lo]) / (steps * h);
+		}
+	}
+	return df;
+}
+
+/*
+ * a = M F M^T with
+ *
+ *  F = | f(0,0)  f(0,1)  fy(0,0)  fy(0,1)  |      M = |  1  0  0  0 |
+ *      | f(1,0)  f(1,1)  fy(1,0)  fy(1,1)  |          |  0  0  1  0 |
+ *      | fx(0,0) fx(0,1) fxy(0,0) fxy(0,1) |          | -3  3 -2 -1 |
+ *      | fx(1,0) fx(1,1) fxy(1,0) fxy(1,1) |          |  2 -2  1  1 |
+ *
+ * derivatives in units of the cell
+ */
+static void hermite_coefficients(const double F[4][4], double *a)
+{
+	static const double M[4][4] = {{1, 0, 0, 0}, {0, 0, 1, 0}, {-3, 3, -2, -1}, {2, -2, 1, 1}};
+	double MF[4][4];
+	for(int i = 0; i < 4; ++i){
+		for(int j = 0; j < 4; ++j){
+			MF[i][j] = 0e0;
+			for(int k = 0; k < 4; ++k){
+				MF[i][j] += M[i][k] * F[k][j];
+			}
+		}
+	}
+	for(int i = 0; i < 4; ++i){
+		for(int j = 0; j < 4; ++j){
+			double s = 0e0;
+			for(int k = 0; k < 4; ++k){
+				s += MF[i][k] * M[j][k];
+			}
+			a[4 * i + j] = s;
+		}
+	}
+}
+
+void tsu::write_field_map(const std::string& filename,
+			  const double x0, const double y0, const double dx, const double dy,
+			  const size_t nx, const size_t ny,
+			  const std::vector<double>& Bx, const std::vector<double>& By)
+{
+	if(nx < 2 || ny < 2){
+		throw std::invalid_argument("field map: grid requires at least 2 x 2 points");
+	}
+	if(!(dx > 0e0) || !(dy > 0e0)){
+		throw std::invalid_argument("field map: grid spacing must be positive");
+	}
+	if(Bx.size() != nx * ny || By.size() != nx * ny){
+		std::stringstream strm;
+		strm << "field map: expected " << nx * ny << " values per component, got "
+		     << Bx.size() << " (Bx) and " << By.size() << " (By)";
+		throw std::invalid_argument(strm.str());
+	}
+
+	std::vector<double> coeffs((nx - 1) * (ny - 1) * cell_size);
+	const std::vector<double>* components[n_components] = {&Bx, &By};
+	for(size_t c = 0; c < n_components; ++c){
+		const auto& f = *components[c];
+		const auto fx = finite_difference(f, nx, ny, true, dx);
+		const auto fy = finite_difference(f, nx, ny, false, dy);
+		const auto fxy = finite_difference(fx, nx, ny, false, dy);
+		for(size_t j = 0; j < ny - 1; ++j){
+			for(size_t i = 0; i < nx - 1; ++i){
+				double F[4][4];
+				for(size_t p = 0; p < 2; ++p){
+					for(size_t q = 0; q < 2; ++q){
+						const size_t idx = (i + p) + nx * (j + q);
+						F[p][q]         = f[idx];
+						F[p][q + 2]     = fy[idx] * dy;
+						F[p + 2][q]     = fx[idx] * dx;
+						F[p + 2][q + 2] = fxy[idx] * dx * dy;
+					}
+				}
+				const size_t cell = j * (nx - 1) + i;
+				hermite_coefficients(F, &coeffs[cell * cell_size + c * FieldMapGrid::n_coeffs]);
+			}
+		}
+	}
+
+	char header[header_size];
+	std::memset(header, 0, header_size);
+	std::memcpy(header, magic, sizeof(magic));
+	const uint64_t nx_ = nx, ny_ = ny;
+	const double geometry[4] = {x0, y0, dx, dy};
+	std::memcpy(header + 8, &version, sizeof(version));
+	std::memcpy(header + 12, &n_components, sizeof(n_components));
+	std::memcpy(header + 16, &nx_, sizeof(nx_));
+	std::memcpy(header + 24, &ny_, sizeof(ny_));
+	std::memcpy(header + 32, geometry, sizeof(geometry));
+
+	/*
+	 * unique per process, thread and call: concurrent writers must not
+	 * share the temporary
+	 */
+	static std::atomic<uint64_t> tmp_counter{0};
+	std::stringstream tmp_name;
+	tmp_name << filename << ".tmp." << ::getpid()
+		 << "." << std::hash<std::thread::id>{}(std::this_thread::get_id())
+		 << "." << tmp_counter++;
+	const auto tmp = tmp_name.str();
+	{
+		std::ofstream strm(tmp, std::ios::binary | std::ios::trunc);
+		strm.write(header, header_size);
+		strm.write(reinterpret_cast<const char *>(coeffs.data()), coeffs.size() * sizeof(double));
+		strm.close();
+		if(!strm){
+			std::remove(tmp.c_str());
+			throw std::runtime_error("Failed to write field map " + tmp);
+		}
+	}
+	std::error_code ec;
+	fs::rename(tmp, filename, ec);
+	if(ec){
+		std::remove(tmp.c_str());
+		throw std::runtime_error("Failed to rename field map to " + filename + ": " + ec.message());
+	}
+}
+
+template<class C>
+void tsu::FieldMapInterpolationKnobbed<C>::show(std::ostream& strm, int level) const
+{
+	strm << "FieldMapInterpolation(scale=" << this->m_scale << ", ";
+	this->m_grid->show(strm, level);
+	strm << ")";
+}
+
+template void tsu::FieldMapInterpolationKnobbed<tsc::StandardDoubleType>::show(std::ostream& strm, int level) const;
+template void tsu::FieldMapInterpolationKnobbed<tsc::TpsaVariantType>::show(std::ostream& strm, int level) const;
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -0,0 +1,280 @@
+#ifndef _THOR_SCSI_CUSTOM_FIELD_MAP_INTERPOLATION_H_
+#define _THOR_SCSI_CUSTOM_FIELD_MAP_INTERPOLATION_H_ 1
+
+#include <thor_scsi/core/field_interpolation.h>
+#include <thor_scsi/core/multipole_types.h>
+#include <thor_scsi/core/exceptions.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace thor_scsi::custom {
+
+	/**
+	 * @brief transverse field (or kick) map on a regular grid
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * The grid is read from a binary file that is memory mapped read
+	 * only. For each cell the coefficients of the bicubic Hermite
+	 * polynomials of both field components are stored in the file
+	 * (see :func:`write_field_map`). So nothing has to be parsed or
+	 * computed when the file is opened: the pages are loaded on first
+	 * access and shared with all other processes mapping the same file.
+	 *
+	 * Within one process :meth:`open` returns the same grid for the same
+	 * file as long as it is in use. Thus copies of a lattice share it.
+	 *
+	 * Within a cell the component is given by
+	 *
+	 * .. math::
+	 *
+	 *     f(u, v) = \sum_{i=0}^3 \sum_{j=0}^3 a_{ij} u^i v^j
+	 *
+	 * with :math:`u = (x - x_k) / \Delta x` and :math:`v = (y - y_l) / \Delta y`
+	 * the position relative to the lower left corner of the cell.
+	 *
+	 * \endverbatim
+	 */
+	class FieldMapGrid {
+	public:
+		/// coefficients of one component in a cell: a_ij at [4 * i + j]
+		static const size_t n_coeffs = 16;
+
+		/**
+		 * @brief map the file
+		 *
+		 * @throws thor_scsi::LoadException if the file can not be
+		 *         mapped or its content is not consistent
+		 */
+		static std::shared_ptr<const FieldMapGrid> open(const std::string& filename);
+
+		~FieldMapGrid();
+
+		inline size_t nx(void) const { return this->m_nx; }
+		inline size_t ny(void) const { return this->m_ny; }
+		inline double x0(void) const { return this->m_x0; }
+		inline double y0(void) const { return this->m_y0; }
+		inline double dx(void) const { return this->m_dx; }
+		inline double dy(void) const { return this->m_dy; }
+		inline double xMax(void) const { return this->m_x0 + (this->m_nx - 1) * this->m_dx; }
+		inline double yMax(void) const { return this->m_y0 + (this->m_ny - 1) * this->m_dy; }
+		inline const std::string& filename(void) const { return this->m_filename; }
+		/// coefficients of all cells in the order used by :meth:`cell`
+		inline const double* coefficients(void) const { return this->m_coeffs; }
+		inline size_t nCoefficients(void) const { return 2 * n_coeffs * (this->m_nx - 1) * (this->m_ny - 1); }
+
+		inline bool contains(const double x, const double y) const {
+			return x >= this->m_x0 && x <= this->xMax() && y >= this->m_y0 && y <= this->yMax();
+		}
+
+		/**
+		 * @brief find the cell containing (x, y)
+		 *
+		 * @param u, v: position within the cell, in [0, 1]
+		 * @returns coefficients of Bx followed by the ones of By
+		 *
+		 * @throws thor_scsi::PhysicsViolation if the point is outside the grid
+		 */
+		inline const double* cell(const double x, const double y, double *u, double *v) const {
+			if(!this->contains(x, y)){
+				std::stringstream strm;
+				strm << "field map " << this->m_filename << ": position x = " << x << ", y = " << y
+				     << " outside of grid x in [" << this->m_x0 << ", " << this->xMax()
+				     << "], y in [" << this->m_y0 << ", " << this->yMax() << "]";
+				throw thor_scsi::PhysicsViolation(strm.str());
+			}
+			const double s = (x - this->m_x0) / this->m_dx, t = (y - this->m_y0) / this->m_dy;
+			/* upper border belongs to the last cell */
+			const size_t i = std::min(static_cast<size_t>(s), this->m_nx - 2);
+			const size_t j = std::min(static_cast<size_t>(t), this->m_ny - 2);
+			*u = s - i;
+			*v = t - j;
+			return this->m_coeffs + 2 * n_coeffs * (j * (this->m_nx - 1) + i);
+		}
+
+		void show(std::ostream& strm, int level) const;
+
+	private:
+		FieldMapGrid(const std::string& filename);
+		FieldMapGrid(const FieldMapGrid&) = delete;
+		FieldMapGrid& operator=(const FieldMapGrid&) = delete;
+
+		std::string m_filename;
+		void *m_mapping = nullptr;
+		size_t m_length = 0;
+		size_t m_nx = 0, m_ny = 0;
+		double m_x0 = 0e0, m_y0 = 0e0, m_dx = 0e0, m_dy = 0e0;
+		const double *m_coeffs = nullptr;
+	};
+
+	/**
+	 * @brief convert sampled field values to a field map file
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * Args:
+	 *     filename: file to write. It is written to a temporary file
+	 *               first and then renamed
+	 *     x0, y0:   position of the first sample
+	 *     dx, dy:   grid spacing
+	 *     nx, ny:   number of samples, at least 2 in each direction
+	 *     Bx, By:   values at x0 + i dx, y0 + j dy stored at [i + nx * j]
+	 *
+	 * The derivatives required for the Hermite interpolation are
+	 * estimated by finite differences: central ones inside the grid,
+	 * one sided ones at the border. Thus the interpolation reproduces the
+	 * samples and is continuously differentiable.
+	 *
+	 * The file is written in native byte order.
+	 *
+	 * \endverbatim
+	 *
+	 * @throws std::invalid_argument if the arguments are inconsistent
+	 * @throws std::runtime_error if the file can not be written
+	 */
+	void write_field_map(const std::string& filename,
+			     const double x0, const double y0, const double dx, const double dy,
+			     const size_t nx, const size_t ny,
+			     const std::vector<double>& Bx, const std::vector<double>& By);
+
+	/**
+	 * @brief bicubic Hermite interpolation of a memory mapped field map
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * The field is the one of the map multiplied by scale. Typically the
+	 * map contains the field in Tesla and scale is 1 / :math:`B\rho`.
+	 * For thin elements (length 0) the map is interpreted as integrated
+	 * field, thus a kick map (:math:`\int B\, ds`) can be used directly.
+	 *
+	 * For truncated power series the cell is selected by the constant
+	 * part of the position. The polynomial of this cell is then evaluated
+	 * for the series, so the derivatives are the ones of the interpolating
+	 * polynomial.
+	 *
+	 * Gradient: Gx = dBx/dx and Gy = dBy/dx
+	 *
+	 * Positions outside the grid raise a :class:`PhysicsViolation`: the
+	 * field is not known there, tracking (e.g. :func:`propagate_lost`)
+	 * counts the particle as lost.
+	 *
+	 * \endverbatim
+	 */
+	template<class C>
+	class FieldMapInterpolationKnobbed : public thor_scsi::core::Field2DInterpolationKnobbed<C> {
+	public:
+		FieldMapInterpolationKnobbed(std::shared_ptr<const FieldMapGrid> grid, const double scale=1e0)
+			: m_grid(std::move(grid))
+			, m_scale(scale)
+			{
+				if(!this->m_grid){
+					throw std::invalid_argument("field map interpolation: no grid given");
+				}
+			}
+
+		FieldMapInterpolationKnobbed(const std::string& filename, const double scale=1e0)
+			: FieldMapInterpolationKnobbed(FieldMapGrid::open(filename), scale)
+			{}
+
+		virtual ~FieldMapInterpolationKnobbed() {}
+
+		inline void setScale(const double scale) { this->m_scale = scale; }
+		inline double getScale(void) const { return this->m_scale; }
+		inline std::shared_ptr<const FieldMapGrid> getGrid(void) const { return this->m_grid; }
+
+		/*
+		 * Horner scheme in u, inner one in v. The coefficients belong to the
+		 * cell of (xd, yd) which is the constant part of (x, y)
+		 */
+		template<typename T>
+		inline void _eval(const T& x, const T& y, const double xd, const double yd,
+				  T *pBx, T *pBy, const bool derivative) const {
+			double u0, v0;
+			const double *a = this->m_grid->cell(xd, yd, &u0, &v0);
+			/* constant part identical to the one used by the double version */
+			const T u = (x - xd) / this->m_grid->dx() + u0;
+			const T v = (y - yd) / this->m_grid->dy() + v0;
+
+			*pBx = this->_evalComponent(a, u, v, derivative);
+			*pBy = this->_evalComponent(a + FieldMapGrid::n_coeffs, u, v, derivative);
+		}
+
+		template<typename T>
+		inline T _evalComponent(const double *a, const T& u, const T& v, const bool derivative) const {
+			const int i_min = derivative ? 1 : 0;
+			T res = this->_evalRow(a + 4 * 3, v) * (derivative ? 3e0 : 1e0);
+			for(int i = 2; i >= i_min; --i){
+				res = res * u + this->_evalRow(a + 4 * i, v) * (derivative ? double(i) : 1e0);
+			}
+			const double f = derivative ? this->m_scale / this->m_grid->dx() : this->m_scale;
+			return res * f;
+		}
+
+		template<typename T>
+		inline T _evalRow(const double *a, const T& v) const {
+			return ((v * a[3] + a[2]) * v + a[1]) * v + a[0];
+		}
+
+		/* plain doubles: no temporaries required */
+		inline void _eval(const double& x, const double& y, const double, const double,
+				  double *pBx, double *pBy, const bool derivative) const {
+			double u, v;
+			const double *a = this->m_grid->cell(x, y, &u, &v);
+			*pBx = this->_evalComponent(a, u, v, derivative);
+			*pBy = this->_evalComponent(a + FieldMapGrid::n_coeffs, u, v, derivative);
+		}
+
+		inline void field(const double& x, const double& y, double *Bx, double *By) const override final
+			{ this->_eval(x, y, x, y, Bx, By, false); }
+		inline void field(const tps& x, const tps& y, tps *Bx, tps *By) const override final
+			{ this->_eval(x, y, x.cst(), y.cst(), Bx, By, false); }
+		inline void field(const gtpsa::tpsa& x, const gtpsa::tpsa& y, gtpsa::tpsa *Bx, gtpsa::tpsa *By) const override final
+			{ this->_eval(x, y, x.cst(), y.cst(), Bx, By, false); }
+
+		inline void gradient(const double& x, const double& y, double *Gx, double *Gy) const override final
+			{ this->_eval(x, y, x, y, Gx, Gy, true); }
+		inline void gradient(const tps& x, const tps& y, tps *Gx, tps *Gy) const override final
+			{ this->_eval(x, y, x.cst(), y.cst(), Gx, Gy, true); }
+		inline void gradient(const gtpsa::tpsa& x, const gtpsa::tpsa& y, gtpsa::tpsa *Gx, gtpsa::tpsa *Gy) const override final
+			{ this->_eval(x, y, x.cst(), y.cst(), Gx, Gy, true); }
+		inline void gradient(const tps& x, const tps& y, double *Gx, double *Gy) const override final
+			{ this->gradient(x.cst(), y.cst(), Gx, Gy); }
+		inline void gradient(const gtpsa::tpsa& x, const gtpsa::tpsa& y, double *Gx, double *Gy) const override final
+			{ this->gradient(x.cst(), y.cst(), Gx, Gy); }
+
+		void field_batch(const double *x, const double *y, double *Bx, double *By, const size_t n) const override final {
+			for(size_t i = 0; i < n; ++i){
+				this->_eval(x[i], y[i], x[i], y[i], &Bx[i], &By[i], false);
+			}
+		}
+		void gradient_batch(const double *x, const double *y, double *Gx, double *Gy, const size_t n) const override final {
+			for(size_t i = 0; i < n; ++i){
+				this->_eval(x[i], y[i], x[i], y[i], &Gx[i], &Gy[i], true);
+			}
+		}
+
+		void show(std::ostream& strm, int level) const override;
+
+	private:
+		std::shared_ptr<const FieldMapGrid> m_grid;
+		double m_scale;
+	};
+
+	typedef FieldMapInterpolationKnobbed<thor_scsi::core::StandardDoubleType> FieldMapInterpolation;
+	typedef FieldMapInterpolationKnobbed<thor_scsi::core::TpsaVariantType> FieldMapInterpolationTpsa;
+
+} // namespace thor_scsi::custom
+
+#endif /* _THOR_SCSI_CUSTOM_FIELD_MAP_INTERPOLATION_H_ */
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -0,0 +1,72 @@
+#ifndef _THOR_SCSI_CUSTOM_FIELD_MAP_KICK_H_
+#define _THOR_SCSI_CUSTOM_FIELD_MAP_KICK_H_
+
+#include <thor_scsi/elements/field_kick.h>
+#include <thor_scsi/custom/field_map_interpolation.h>
+
+namespace thor_scsi::custom {
+	/**
+	 * @brief field kick using a memory mapped field map
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * Replaces the field map and insertion device (kick map) passes of
+	 * the former tracy code. Configuration parameters in addition to the
+	 * ones of the field kick:
+	 *
+	 *    * `FieldMap`: file written by :func:`write_field_map`
+	 *    * `Scale`: factor applied to the map, typically 1 / :math:`B\rho`
+	 *      (default 1)
+	 *
+	 * A thick element (L > 0) integrates the field along its length. A
+	 * thin one (L = 0) applies the map as integrated field, i.e. as a
+	 * kick map.
+	 *
+	 * All elements using the same file share one read only mapping.
+	 *
+	 * A particle leaving the grid raises a :class:`PhysicsViolation`,
+	 * thus it is lost for tracking.
+	 *
+	 * \endverbatim
+	 */
+	template<class C>
+	class FieldMapKickKnobbed : public thor_scsi::elements::FieldKickKnobbed<C> {
+	protected:
+		using field_map_knobbed = FieldMapInterpolationKnobbed<C>;
+	public:
+		inline FieldMapKickKnobbed(const Config &config) : thor_scsi::elements::FieldKickKnobbed<C>(config){
+			auto tmp = std::make_shared<field_map_knobbed>(config.get<std::string>("FieldMap"),
+								       config.get<double>("Scale", 1e0));
+			this->intp = std::dynamic_pointer_cast<thor_scsi::core::Field2DInterpolationKnobbed<C>>(tmp);
+		}
+
+		const char* type_name(void) const override { return "FieldMap"; };
+
+		inline std::shared_ptr<field_map_knobbed> getFieldInterpolator(void) const {
+			auto p = std::dynamic_pointer_cast<field_map_knobbed>(this->intp);
+			if(!p){
+				throw std::runtime_error("field map kick: interpolation object is not a field map");
+			}
+			return p;
+		}
+
+		inline void setFieldInterpolator(std::shared_ptr<field_map_knobbed> intp) {
+			if(!intp){
+				throw std::invalid_argument("field map kick: no interpolation object given");
+			}
+			this->intp = std::dynamic_pointer_cast<thor_scsi::core::Field2DInterpolationKnobbed<C>>(intp);
+		}
+	};
+
+	typedef FieldMapKickKnobbed<core::StandardDoubleType> FieldMapKickType;
+	typedef FieldMapKickKnobbed<core::TpsaVariantType> FieldMapKickTypeTpsa;
+
+} // namespace thor_scsi::custom
+
+#endif /* _THOR_SCSI_CUSTOM_FIELD_MAP_KICK_H_ */
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -23,7 +23,7 @@ namespace thor_scsi::custom {
 	    {}
 
 	inline void setFilaments(const std::vector<aircoil_filament_t> filaments_one_quater) {
-        this->setFilaments(construct_aircoil_filaments(filaments_one_quater));
+        AirCoilMagneticFieldKnobbed<C>::setFilaments(construct_aircoil_filaments(filaments_one_quater));
     }
 	void show(std::ostream&, int level) const override;
     };
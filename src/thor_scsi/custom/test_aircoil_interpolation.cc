@@ -3,6 +3,9 @@
 #include <boost/test/unit_test.hpp>
 
 #include <thor_scsi/custom/aircoil_interpolation.h>
+#include <gtpsa/ss_vect.h>
+#include <cmath>
+#include <vector>
 
 namespace tsc = thor_scsi::core;
 namespace tsu = thor_scsi::custom;
@@ -13,3 +16,122 @@ BOOST_AUTO_TEST_CASE(test02_drift_zero_length)
     tsu::AirCoilMagneticField am({f1});
 
 }
+
+static std::vector<tsu::aircoil_filament_t> test_filaments(void)
+{
+    // not a multiple of the lane width: remainder loop used too
+    std::vector<tsu::aircoil_filament_t> filaments;
+    for(int i = 0; i < 7; ++i){
+        filaments.push_back({10e-3 + i * 1e-3, 5e-3 - i * 2e-3, 100e0 + 10e0 * i});
+    }
+    return filaments;
+}
+
+BOOST_AUTO_TEST_CASE(test10_field_reference)
+{
+    const auto filaments = test_filaments();
+    tsu::AirCoilMagneticField am(filaments, 0.5);
+
+    const double x = 1e-3, y = -2e-3;
+    const double precomp = 4 * M_PI * 1e-7 / (2 * M_PI) * 0.5;
+    double Bx_ref = 0e0, By_ref = 0e0;
+    for(const auto& f: filaments){
+        const double dx = x - f.x, dy = y - f.y, r2 = dx * dx + dy * dy;
+        By_ref += precomp * f.current / r2 * dx;
+        Bx_ref += precomp * f.current / r2 * dy;
+    }
+
+    double Bx, By;
+    am.field(x, y, &Bx, &By);
+    BOOST_CHECK_CLOSE(Bx, Bx_ref, 1e-12);
+    BOOST_CHECK_CLOSE(By, By_ref, 1e-12);
+
+    const auto used = am.getUsedFilaments();
+    BOOST_REQUIRE_EQUAL(used.size(), filaments.size());
+    for(size_t i = 0; i < used.size(); ++i){
+        BOOST_CHECK_EQUAL(used[i].x, filaments[i].x);
+        BOOST_CHECK_EQUAL(used[i].y, filaments[i].y);
+        BOOST_CHECK_CLOSE(used[i].current, filaments[i].current, 1e-12);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test20_gradient)
+{
+    tsu::AirCoilMagneticField am(test_filaments(), 0.5);
+
+    const double x = 1e-3, y = -2e-3, h = 1e-7;
+    double Bx1, By1, Bx2, By2, Gx, Gy;
+    am.field(x + h, y, &Bx1, &By1);
+    am.field(x - h, y, &Bx2, &By2);
+    am.gradient(x, y, &Gx, &Gy);
+    BOOST_CHECK_CLOSE(Gx, (Bx1 - Bx2) / (2 * h), 1e-5);
+    BOOST_CHECK_CLOSE(Gy, (By1 - By2) / (2 * h), 1e-5);
+
+    // fused evaluation
+    double Bx, By, Bx_f, By_f, Gx_f, Gy_f;
+    am.field(x, y, &Bx, &By);
+    am.fieldAndGradient(x, y, &Bx_f, &By_f, &Gx_f, &Gy_f);
+    BOOST_CHECK_EQUAL(Bx_f, Bx);
+    BOOST_CHECK_EQUAL(By_f, By);
+    BOOST_CHECK_EQUAL(Gx_f, Gx);
+    BOOST_CHECK_EQUAL(Gy_f, Gy);
+
+    // derivative of the expansion
+    auto report = am.fitMultipoleExpansion(4e-3, 30);
+    BOOST_CHECK_SMALL(report.max_rel_error, 1e-6);
+    double Gx_e, Gy_e;
+    am.gradient(x, y, &Gx_e, &Gy_e);
+    BOOST_CHECK_CLOSE(Gx_e, Gx, 1e-4);
+    BOOST_CHECK_CLOSE(Gy_e, Gy, 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE(test30_gradient_tpsa)
+{
+    tsu::AirCoilMagneticField am(test_filaments(), 0.5);
+
+    auto desc = std::make_shared<gtpsa::desc>(6, 2);
+    const double x0 = 1e-3, y0 = -2e-3;
+    gtpsa::ss_vect<gtpsa::tpsa> ps(desc, 1);
+    ps.set_identity();
+    gtpsa::tpsa x = ps[0] + x0, y = ps[2] + y0;
+    gtpsa::tpsa Gx = gtpsa::same_as_instance(x), Gy = gtpsa::same_as_instance(x);
+
+    double Gx_ref, Gy_ref;
+    am.gradient(x0, y0, &Gx_ref, &Gy_ref);
+    am.gradient(x, y, &Gx, &Gy);
+    BOOST_CHECK_CLOSE(Gx.cst(), Gx_ref, 1e-12);
+    BOOST_CHECK_CLOSE(Gy.cst(), Gy_ref, 1e-12);
+
+    double Gx_d, Gy_d;
+    am.gradient(x, y, &Gx_d, &Gy_d);
+    BOOST_CHECK_CLOSE(Gx_d, Gx_ref, 1e-12);
+    BOOST_CHECK_CLOSE(Gy_d, Gy_ref, 1e-12);
+}
+
+BOOST_AUTO_TEST_CASE(test40_batch)
+{
+    tsu::AirCoilMagneticField am(test_filaments(), 0.5);
+
+    // inside and outside of the expansion radius used below
+    const std::vector<double> x = {0e0, 1e-3, -2.5e-3, 3e-3, 6e-3, -7e-3};
+    const std::vector<double> y = {0e0, -2e-3, 1e-3, 2.9e-3, 0e0, 4e-3};
+    const size_t n = x.size();
+
+    for(const bool expansion: {false, true}){
+        if(expansion){
+            am.fitMultipoleExpansion(4e-3, 30);
+        }
+        std::vector<double> Bx(n), By(n), Gx(n), Gy(n);
+        am.field_batch(x.data(), y.data(), Bx.data(), By.data(), n);
+        am.gradient_batch(x.data(), y.data(), Gx.data(), Gy.data(), n);
+        for(size_t i = 0; i < n; ++i){
+            double Bx_ref, By_ref, Gx_ref, Gy_ref;
+            am.field(x[i], y[i], &Bx_ref, &By_ref);
+            am.gradient(x[i], y[i], &Gx_ref, &Gy_ref);
+            BOOST_CHECK_CLOSE(Bx[i], Bx_ref, 1e-12);
+            BOOST_CHECK_CLOSE(By[i], By_ref, 1e-12);
+            BOOST_CHECK_CLOSE(Gx[i], Gx_ref, 1e-12);
+            BOOST_CHECK_CLOSE(Gy[i], Gy_ref, 1e-12);
+        }
+    }
+}
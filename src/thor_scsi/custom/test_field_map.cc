@@ -0,0 +1,165 @@
+#define BOOST_TEST_MODULE field_map
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <thor_scsi/custom/field_map_kick.h>
+#include <thor_scsi/core/exceptions.h>
+#include <gtpsa/ss_vect.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+namespace ts = thor_scsi;
+namespace tsc = thor_scsi::core;
+namespace tsu = thor_scsi::custom;
+namespace fs = std::filesystem;
+
+static const double K = 0.7, b = 1e-3;
+static const double x0 = -20e-3, y0 = -10e-3, dx = 1e-3, dy = 0.5e-3;
+static const size_t nx = 41, ny = 41;
+
+static std::string test_file(const std::string& name)
+{
+    return (fs::temp_directory_path()
+	    / ("thor_scsi_test_field_map_" + name + "_" + std::to_string(::getpid()) + ".tsfm")).string();
+}
+
+/* quadrupole with dipole component: reproduced exactly by the interpolation */
+static std::string write_quadrupole_map(const std::string& name)
+{
+    std::vector<double> Bx(nx * ny), By(nx * ny);
+    for(size_t j = 0; j < ny; ++j){
+	for(size_t i = 0; i < nx; ++i){
+	    const double x = x0 + i * dx, y = y0 + j * dy;
+	    Bx[i + nx * j] = K * y;
+	    By[i + nx * j] = K * x + b;
+	}
+    }
+    const auto filename = test_file(name);
+    tsu::write_field_map(filename, x0, y0, dx, dy, nx, ny, Bx, By);
+    return filename;
+}
+
+static Config thin_config(const std::string& filename)
+{
+    Config C;
+    C.set<std::string>("name", "fmap");
+    C.set<double>("Method", 4.0);
+    C.set<double>("N", 1);
+    C.set<double>("L", 0e0);
+    C.set<std::string>("FieldMap", filename);
+    return C;
+}
+
+BOOST_AUTO_TEST_CASE(test10_interpolation)
+{
+    const auto filename = write_quadrupole_map("interpolation");
+    tsu::FieldMapInterpolation intp(filename, 2e0);
+
+    const auto grid = intp.getGrid();
+    BOOST_CHECK_EQUAL(grid->nx(), nx);
+    BOOST_CHECK_EQUAL(grid->ny(), ny);
+    BOOST_CHECK_CLOSE(grid->xMax(), 20e-3, 1e-10);
+    BOOST_CHECK_CLOSE(grid->yMax(), 10e-3, 1e-10);
+
+    const double xs[] = {-20e-3, -3.3e-3, 0e0, 7.1234e-3, 20e-3};
+    const double ys[] = {-10e-3, -0.77e-3, 0e0, 4.321e-3, 10e-3};
+    for(const double x: xs){
+	for(const double y: ys){
+	    double Bx, By, Gx, Gy;
+	    intp.field(x, y, &Bx, &By);
+	    intp.gradient(x, y, &Gx, &Gy);
+	    BOOST_CHECK_SMALL(Bx - 2e0 * K * y, 1e-14);
+	    BOOST_CHECK_SMALL(By - 2e0 * (K * x + b), 1e-14);
+	    BOOST_CHECK_SMALL(Gx, 1e-12);
+	    BOOST_CHECK_CLOSE(Gy, 2e0 * K, 1e-10);
+	}
+    }
+
+    double Bx, By;
+    BOOST_CHECK_THROW(intp.field(20.1e-3, 0e0, &Bx, &By), ts::PhysicsViolation);
+    BOOST_CHECK_THROW(intp.field(0e0, -10.1e-3, &Bx, &By), ts::PhysicsViolation);
+    fs::remove(filename);
+}
+
+BOOST_AUTO_TEST_CASE(test11_grid_shared)
+{
+    const auto filename = write_quadrupole_map("shared");
+    auto g1 = tsu::FieldMapGrid::open(filename);
+    auto g2 = tsu::FieldMapGrid::open(filename);
+    BOOST_CHECK(g1 == g2);
+
+    tsu::FieldMapKickType e1(thin_config(filename)), e2(thin_config(filename));
+    BOOST_CHECK(e1.getFieldInterpolator()->getGrid() == g1);
+    BOOST_CHECK(e2.getFieldInterpolator()->getGrid() == g1);
+
+    /* rewritten file: a new grid */
+    write_quadrupole_map("shared");
+    BOOST_CHECK(tsu::FieldMapGrid::open(filename) != g1);
+    fs::remove(filename);
+}
+
+BOOST_AUTO_TEST_CASE(test12_invalid)
+{
+    BOOST_CHECK_THROW(tsu::FieldMapGrid::open(test_file("does_not_exist")), ts::LoadException);
+
+    const auto filename = test_file("corrupt");
+    {
+	std::ofstream strm(filename, std::ios::binary | std::ios::trunc);
+	strm << "not a field map, but long enough to contain a header ......................";
+    }
+    BOOST_CHECK_THROW(tsu::FieldMapGrid::open(filename), ts::LoadException);
+
+    const std::vector<double> too_short(nx * ny - 1);
+    const std::vector<double> fine(nx * ny);
+    BOOST_CHECK_THROW(tsu::write_field_map(filename, x0, y0, dx, dy, nx, ny, too_short, fine), std::invalid_argument);
+    BOOST_CHECK_THROW(tsu::write_field_map(filename, x0, y0, -dx, dy, nx, ny, fine, fine), std::invalid_argument);
+    BOOST_CHECK_THROW(tsu::write_field_map(filename, x0, y0, dx, dy, 1, nx * ny, fine, fine), std::invalid_argument);
+    fs::remove(filename);
+}
+
+BOOST_AUTO_TEST_CASE(test20_thin_kick)
+{
+    const auto filename = write_quadrupole_map("thin_kick");
+    tsu::FieldMapKickType fmap(thin_config(filename));
+    BOOST_CHECK_EQUAL(fmap.isThick(), false);
+    BOOST_CHECK_CLOSE(fmap.getFieldInterpolator()->getScale(), 1e0, 1e-12);
+
+    tsc::ConfigType calc_config;
+    const double x = 2e-3, y = -1e-3;
+    gtpsa::ss_vect<double> ps{x, 0e0, y, 0e0, 0e0, 0e0};
+    fmap.propagate(calc_config, ps);
+
+    BOOST_CHECK_CLOSE(ps[0], x, 1e-12);
+    BOOST_CHECK_CLOSE(ps[2], y, 1e-12);
+    BOOST_CHECK_CLOSE(ps[1], -(K * x + b), 1e-10);
+    BOOST_CHECK_CLOSE(ps[3], K * y, 1e-10);
+
+    /* same kick and its derivatives for truncated power series */
+    auto desc = std::make_shared<gtpsa::desc>(6, 2);
+    gtpsa::ss_vect<gtpsa::tpsa> v(desc, 2);
+    v.set_identity();
+    v[0] += x;
+    v[2] += y;
+    fmap.propagate(calc_config, v);
+
+    const auto cst = v.cst();
+    BOOST_CHECK_CLOSE(cst[1], ps[1], 1e-10);
+    BOOST_CHECK_CLOSE(cst[3], ps[3], 1e-10);
+    const arma::mat jac = v.jacobian();
+    BOOST_CHECK_CLOSE(jac(1, 0), -K, 1e-10);
+    BOOST_CHECK_CLOSE(jac(3, 2), K, 1e-10);
+    BOOST_CHECK_SMALL(jac(1, 2), 1e-12);
+    BOOST_CHECK_SMALL(jac(3, 0), 1e-12);
+
+    /* outside the grid: lost */
+    gtpsa::ss_vect<double> ps_out{30e-3, 0e0, 0e0, 0e0, 0e0, 0e0};
+    BOOST_CHECK_THROW(fmap.propagate(calc_config, ps_out), ts::PhysicsViolation);
+    fs::remove(filename);
+}
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
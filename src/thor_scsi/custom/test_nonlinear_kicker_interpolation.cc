@@ -3,7 +3,9 @@
 #include <boost/test/unit_test.hpp>
 
 #include <thor_scsi/custom/nonlinear_kicker_interpolation.h>
+#include <cmath>
 #include <iostream>
+#include <stdexcept>
 
 
 namespace tsc = thor_scsi::core;
@@ -131,3 +133,67 @@ BOOST_AUTO_TEST_CASE(test10_nlk_zero_pos)
 
 
 }
+
+static tsu::NonLinearKickerInterpolation bessy_nlk(void)
+{
+    const double s = 14e-2, scale = 1 - s, current = 700, m_cur = current * s, cur = current * scale * scale;
+    const double wire_pos = 8e-3;
+    tsu::aircoil_filament_t outer  = {17e-3 * scale, 15e-3 * scale,   cur};
+    tsu::aircoil_filament_t inner  = { wire_pos * scale,  7e-3 * scale,   cur};
+    tsu::aircoil_filament_t mirror = { wire_pos * scale,  5e-3 * scale, m_cur};
+    return tsu::NonLinearKickerInterpolation({inner, outer, mirror});
+}
+
+BOOST_AUTO_TEST_CASE(test20_nlk_expansion)
+{
+    auto nlk = bessy_nlk();
+    auto nlk_ref = bessy_nlk();
+    const double scale = 0.7;
+    nlk.setScale(scale);
+    nlk_ref.setScale(scale);
+
+    // closest filament at about 8.1 mm
+    BOOST_CHECK_THROW(nlk.fitMultipoleExpansion(9e-3, 20), std::invalid_argument);
+    BOOST_CHECK_THROW(nlk.fitMultipoleExpansion(-1e-3, 20), std::invalid_argument);
+    BOOST_CHECK(!nlk.hasMultipoleExpansion());
+
+    const double radius = 4e-3;
+    auto report = nlk.fitMultipoleExpansion(radius, 30);
+    BOOST_CHECK(nlk.hasMultipoleExpansion());
+    BOOST_CHECK_CLOSE(nlk.getExpansionRadius(), radius, 1e-12);
+    BOOST_CHECK_EQUAL(nlk.getMultipoleExpansion().size(), 31u);
+    BOOST_CHECK(report.max_field > 0e0);
+    BOOST_CHECK_SMALL(report.max_rel_error, 1e-7);
+
+    // inside the radius: within the reported error (for scale 1)
+    for(const auto& pos : std::vector<tsu::position_t>{{0e0, 0e0}, {1e-3, -2e-3}, {-3e-3, 2.5e-3}, {0e0, 3.9e-3}}){
+        double Bx, By, Bx_ref, By_ref;
+        nlk.field(pos.x, pos.y, &Bx, &By);
+        nlk_ref.field(pos.x, pos.y, &Bx_ref, &By_ref);
+        BOOST_CHECK_SMALL(std::hypot(Bx - Bx_ref, By - By_ref), scale * report.max_abs_error * (1 + 1e-6) + 1e-18);
+    }
+
+    // outside the radius: exact sum
+    {
+        double Bx, By, Bx_ref, By_ref;
+        nlk.field(6e-3, 1e-3, &Bx, &By);
+        nlk_ref.field(6e-3, 1e-3, &Bx_ref, &By_ref);
+        BOOST_CHECK_EQUAL(Bx, Bx_ref);
+        BOOST_CHECK_EQUAL(By, By_ref);
+    }
+
+    // truncated power series: same constant part
+    {
+        auto desc = std::make_shared<gtpsa::desc>(6, 2);
+        gtpsa::tpsa x(desc, 1), y(desc, 1), Bx(desc, 1), By(desc, 1), Bx_ref(desc, 1), By_ref(desc, 1);
+        x.setVariable(1e-3, 0 + 1);
+        y.setVariable(-2e-3, 2 + 1);
+        nlk.field(x, y, &Bx, &By);
+        nlk_ref.field(x, y, &Bx_ref, &By_ref);
+        BOOST_CHECK_SMALL(Bx.cst() - Bx_ref.cst(), scale * report.max_abs_error * (1 + 1e-6) + 1e-18);
+        BOOST_CHECK_SMALL(By.cst() - By_ref.cst(), scale * report.max_abs_error * (1 + 1e-6) + 1e-18);
+    }
+
+    nlk.clearMultipoleExpansion();
+    BOOST_CHECK(!nlk.hasMultipoleExpansion());
+}
@@ -0,0 +1,133 @@
+#include <thor_scsi/elements/buffering_observer.h>
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+namespace tse = thor_scsi::elements;
+namespace tsc = thor_scsi::core;
+
+static inline double constant_part(const double v)      { return v; }
+static inline double constant_part(const tps& v)        { return v.cst(); }
+static inline double constant_part(const gtpsa::tpsa& v){ return v.cst(); }
+
+tse::BufferingObserver::BufferingObserver(const size_t capacity, const size_t n_turns,
+					  const std::vector<tsc::ObservedState>& states)
+	: m_index(capacity)
+	, m_turns(capacity)
+	, m_state(capacity)
+	, m_cnt(capacity)
+	, m_ps(capacity * ps_dim)
+	, m_n_turns(n_turns)
+{
+	if(capacity == 0){
+		throw std::invalid_argument("buffering observer: capacity must be at least 1");
+	}
+	if(n_turns == 0){
+		throw std::invalid_argument("buffering observer: at least 1 turn per batch required");
+	}
+	for(const auto state: states){
+		const auto s = static_cast<size_t>(state);
+		if(s >= this->m_record.size()){
+			this->m_record.resize(s + 1, false);
+		}
+		this->m_record[s] = true;
+	}
+}
+
+template<typename T>
+void tse::BufferingObserver::_view(std::shared_ptr<const tsc::CellVoid> elem, const gtpsa::ss_vect<T> &ps, const enum tsc::ObservedState state, const int cnt)
+{
+	if(!this->isRecorded(state)){
+		return;
+	}
+
+	const size_t index = elem->index;
+	if(!this->m_has_first){
+		this->m_has_first = true;
+		this->m_first_index = index;
+		this->m_first_state = state;
+	} else if(index == this->m_first_index && int(state) == this->m_first_state){
+		++this->m_turn;
+		if(this->m_turn % this->m_n_turns == 0){
+			this->flush();
+		}
+	}
+	if(this->m_size >= this->capacity()){
+		this->flush();
+	}
+
+	const size_t row = this->m_size;
+	this->m_index[row] = index;
+	this->m_state[row] = state;
+	this->m_turns[row] = this->m_turn;
+	this->m_cnt[row] = cnt;
+	double *dst = &this->m_ps[ps_dim * row];
+	for(size_t i = 0; i < ps_dim; ++i){
+		dst[i] = constant_part(ps[i]);
+	}
+	++this->m_size;
+}
+
+void tse::BufferingObserver::view(std::shared_ptr<const tsc::CellVoid> elem, const gtpsa::ss_vect<double> &ps, const enum tsc::ObservedState state, const int cnt)
+{
+	_view(elem, ps, state, cnt);
+}
+
+void tse::BufferingObserver::view(std::shared_ptr<const tsc::CellVoid> elem, const gtpsa::ss_vect<tps> &ps, const enum tsc::ObservedState state, const int cnt)
+{
+	_view(elem, ps, state, cnt);
+}
+
+void tse::BufferingObserver::view(std::shared_ptr<const tsc::CellVoid> elem, const gtpsa::ss_vect<gtpsa::tpsa> &ps, const enum tsc::ObservedState state, const int cnt)
+{
+	_view(elem, ps, state, cnt);
+}
+
+void tse::BufferingObserver::flush(void)
+{
+	if(this->m_size == 0){
+		return;
+	}
+	if(this->m_callback){
+		this->m_callback(*this);
+	}
+	this->m_size = 0;
+}
+
+void tse::BufferingObserver::reset(void)
+{
+	this->m_size = 0;
+	this->m_has_first = false;
+	this->m_turn = 0;
+}
+
+void tse::BufferingObserver::show(std::ostream& strm, const int level) const
+{
+	strm << "BufferingObserver("
+	     << "size=" << this->m_size
+	     << ", capacity=" << this->capacity()
+	     << ", turns_per_batch=" << this->m_n_turns
+	     << ", turn=" << this->m_turn
+	     << ", has_callback=" << bool(this->m_callback)
+	     << ")";
+}
+
+std::string tse::BufferingObserver::repr(void) const
+{
+	std::ostringstream strm;
+	this->show(strm, 10);
+	return strm.str();
+}
+
+std::string tse::BufferingObserver::pstr(void) const
+{
+	std::ostringstream strm;
+	this->show(strm, 0);
+	return strm.str();
+}
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -0,0 +1,126 @@
+#ifndef _THOR_SCSI_ELEMENTS_BUFFERING_OBSERVER_H_
+#define _THOR_SCSI_ELEMENTS_BUFFERING_OBSERVER_H_
+#include <thor_scsi/core/cell_void.h>
+#include <functional>
+#include <vector>
+
+namespace thor_scsi::elements{
+	/**
+	 * @brief observer recording the phase space into preallocated buffers
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * One instance is typically shared by all elements of interest.
+	 * Each call to :meth:`view` with a recorded state appends a row
+	 * (element index, state, turn, count, phase space). The rows are handed
+	 * to the callback in one batch
+	 *
+	 *    * every `n_turns` turns
+	 *    * when the buffer is full
+	 *    * when :meth:`flush` is called, e.g. after propagation
+	 *
+	 * and the buffer is reused afterwards. Batches end at the turns
+	 * that are multiples of `n_turns` (counted since construction or
+	 * :meth:`reset`): flushes in between split a batch, but do not
+	 * shift the following ones.
+	 *
+	 * A turn is completed when the first (element, state) pair
+	 * recorded is seen again. So every turn has to pass the same
+	 * elements.
+	 *
+	 * For truncated power series the constant part is recorded.
+	 *
+	 * \endverbatim
+	 */
+	class BufferingObserver : public thor_scsi::core::Observer{
+	public:
+		/// number of phase space coordinates per row
+		static const size_t ps_dim = 6;
+
+		/// called with the observer holding the rows recorded since the last flush
+		typedef std::function<void(const BufferingObserver&)> callback_type;
+
+		/**
+		 * @param capacity: rows preallocated
+		 * @param n_turns: turns per batch
+		 * @param states: states recorded, by default only the end one
+		 *
+		 * @throws std::invalid_argument if capacity or n_turns is 0
+		 */
+		BufferingObserver(const size_t capacity, const size_t n_turns=1,
+				  const std::vector<thor_scsi::core::ObservedState>& states={thor_scsi::core::ObservedState::end});
+
+		void view(std::shared_ptr<const thor_scsi::core::CellVoid> elem, const gtpsa::ss_vect<double>      &ps, const enum thor_scsi::core::ObservedState, const int cnt) override final;
+		void view(std::shared_ptr<const thor_scsi::core::CellVoid> elem, const gtpsa::ss_vect<tps>         &ps, const enum thor_scsi::core::ObservedState, const int cnt) override final;
+		void view(std::shared_ptr<const thor_scsi::core::CellVoid> elem, const gtpsa::ss_vect<gtpsa::tpsa> &ps, const enum thor_scsi::core::ObservedState, const int cnt) override final;
+
+		inline void setCallback(callback_type callback) {
+			this->m_callback = std::move(callback);
+		}
+
+		/**
+		 * @brief hand the recorded rows to the callback and clear the buffer
+		 *
+		 * Without callback the rows are discarded.
+		 */
+		void flush(void);
+
+		/// @brief discard the recorded rows and restart turn counting
+		void reset(void);
+
+		/// rows recorded since the last flush
+		inline size_t size(void) const { return this->m_size; }
+		inline size_t capacity(void) const { return this->m_index.size(); }
+		inline size_t getTurnsPerBatch(void) const { return this->m_n_turns; }
+		/// turns completed since construction or reset
+		inline size_t getTurn(void) const { return this->m_turn; }
+
+		/// element index of each row, capacity() entries of which size() are valid
+		inline const size_t* indices(void) const { return this->m_index.data(); }
+		inline const int* states(void) const { return this->m_state.data(); }
+		inline const size_t* turns(void) const { return this->m_turns.data(); }
+		/// cnt passed to :meth:`view`, e.g. the integration step
+		inline const int* counts(void) const { return this->m_cnt.data(); }
+		/// phase space of row i at [ps_dim * i]
+		inline const double* phaseSpace(void) const { return this->m_ps.data(); }
+
+		void show(std::ostream& strm, const int level) const override final;
+
+		// python support
+		std::string repr(void) const;
+		// python support
+		std::string pstr(void) const;
+
+	private:
+		template<typename T>
+		void _view(std::shared_ptr<const thor_scsi::core::CellVoid> elem, const gtpsa::ss_vect<T> &ps, const enum thor_scsi::core::ObservedState, const int cnt);
+
+		inline bool isRecorded(const enum thor_scsi::core::ObservedState state) const {
+			const auto s = static_cast<size_t>(state);
+			return s < this->m_record.size() && this->m_record[s];
+		}
+
+		std::vector<size_t> m_index, m_turns;
+		std::vector<int> m_state, m_cnt;
+		std::vector<double> m_ps;
+		std::vector<bool> m_record;
+		size_t m_size = 0;
+		size_t m_n_turns;
+
+		/* turn detection: first row recorded */
+		bool m_has_first = false;
+		size_t m_first_index = 0;
+		int m_first_state = 0;
+		size_t m_turn = 0;
+
+		callback_type m_callback;
+	};
+
+}
+#endif /* _THOR_SCSI_ELEMENTS_BUFFERING_OBSERVER_H_ */
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -14,7 +14,7 @@ struct CheckMultipoles{
     //void only_major_multipole_set(std::shared_ptr<C> muls, const complex_type ref, const size_t n_major);
     void only_major_multipole_set(std::shared_ptr<tsc::TwoDimensionalMultipolesKnobbed<C>> muls, const typename C::complex_type ref, const size_t n_major)
     {
-        const auto& coeffs =  muls->getCoeffs();
+        const auto& coeffs =  muls->getCoeffsConst();
         for(size_t i = 0; i<coeffs.size(); ++i){
             const auto& c = coeffs[i];
             /*
@@ -20,6 +20,7 @@ namespace thor_scsi::elements{
 	const double speed_of_light = 2.99792458e8;
 	const double m_e   = 0.51099906e6;             ///< electron rest mass [eV/c^2].
 	const double h_bar = 6.58211899e-16;           //< reduced Planck constant [eVs].
+	const double r_e   = 2.8179403262e-15;         ///< classical electron radius [m].
 
         /**
 	 * See Sands ....
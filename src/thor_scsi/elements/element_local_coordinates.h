@@ -4,6 +4,7 @@
 #include <thor_scsi/core/elements_basis.h>
 #include <thor_scsi/core/config.h>
 #include <thor_scsi/core/transform_phase_space.h>
+#include <thor_scsi/core/girder.h>
 #include <tps/tps_type.h>
 
 namespace thor_scsi::elements {
@@ -14,16 +15,37 @@ namespace thor_scsi::elements {
 	 *
 	 * This class is never expected to be instantiated by it self so it gets no type name
 	 *
+	 * The element can be mounted on a girder (see thor_scsi::core::GirderKnobbed).
+	 * Then global2Local / local2Global include the transform of the girder,
+	 * while girder2Local / local2Girder only apply the element's own one. The
+	 * latter allow to pass a set of consecutive elements on one girder
+	 * transforming to the girder coordinates only once.
+	 *
+	 * The transform composed of the girder's and the element's one is
+	 * updated when either of them is set (see transformChanged), never
+	 * during the propagation: elements can be shared between threads.
+	 *
 	 * Todo:
 	 *      transformation should contain a constant part and a random part
 	 */
 	 template<class C>
-	 class LocalCoordinatesKnobbed : public ElemTypeKnobbed /* <C> */ {
+	 class LocalCoordinatesKnobbed : public ElemTypeKnobbed /* <C> */, public thor_scsi::core::TransformListener {
 
 	public:
 		 inline LocalCoordinatesKnobbed(const Config &config) : ElemTypeKnobbed /* <C> */ (config){}
-		virtual ~LocalCoordinatesKnobbed(){}
-		 LocalCoordinatesKnobbed(LocalCoordinatesKnobbed&& o) : ElemTypeKnobbed /* <C> */ (std::move(o)) {
+		virtual ~LocalCoordinatesKnobbed(){
+			if(this->m_girder){
+				this->m_girder->transform.removeListener(this);
+			}
+		}
+		 LocalCoordinatesKnobbed(LocalCoordinatesKnobbed&& o)
+			 : ElemTypeKnobbed /* <C> */ (std::move(o))
+			 , m_girder(std::move(o.m_girder))
+			 {
+			if(this->m_girder){
+				this->m_girder->transform.removeListener(&o);
+				this->m_girder->transform.addListener(this);
+			}
 			/*
 			std::cerr << __FILE__ << "::" << __FUNCTION__ << " ctor @ " << __LINE__
 				  << " name " << this->name << std::endl;
@@ -43,6 +65,28 @@ namespace thor_scsi::elements {
 		inline virtual void local2Global(gtpsa::ss_vect<gtpsa::tpsa> &ps) = 0;
 		 // inline virtual void local2Global(gtpsa::ss_vect<tps>         &ps) = 0;
 
+		inline virtual void girder2Local(gtpsa::ss_vect<double>      &ps) = 0;
+		inline virtual void girder2Local(gtpsa::ss_vect<gtpsa::tpsa> &ps) = 0;
+		inline virtual void local2Girder(gtpsa::ss_vect<double>      &ps) = 0;
+		inline virtual void local2Girder(gtpsa::ss_vect<gtpsa::tpsa> &ps) = 0;
+
+		/**
+		 * @brief mount element on girder. nullptr removes it from its girder
+		 */
+		inline void setGirder(std::shared_ptr<thor_scsi::core::GirderKnobbed<C>> girder){
+			if(this->m_girder){
+				this->m_girder->transform.removeListener(this);
+			}
+			this->m_girder = std::move(girder);
+			if(this->m_girder){
+				this->m_girder->transform.addListener(this);
+			}
+			this->transformChanged();
+		}
+		inline std::shared_ptr<thor_scsi::core::GirderKnobbed<C>> getGirder(void) const {
+			return this->m_girder;
+		}
+
 		// virtual void localPropagate(ConfigType &conf, ss_vect<double>             &ps)  = 0;
 		// virtual void localPropagate(ConfigType &conf, ss_vect<tps>                &ps)  = 0;
 
@@ -56,6 +100,15 @@ namespace thor_scsi::elements {
 		virtual inline void propagate(ConfigType &conf, gtpsa::ss_vect<gtpsa::tpsa> &ps) override final { _propagate(conf, ps); };
 		 // virtual inline void propagate(ConfigType &conf, gtpsa::ss_vect<tps>         &ps) override final { _propagate(conf, ps); };
 
+		/**
+		 * @brief propagate: phase space is (and stays) in the coordinates of the girder
+		 */
+		inline void propagateOnGirder(ConfigType &conf, gtpsa::ss_vect<double>      &ps) { _propagateOnGirder(conf, ps); };
+		inline void propagateOnGirder(ConfigType &conf, gtpsa::ss_vect<gtpsa::tpsa> &ps) { _propagateOnGirder(conf, ps); };
+
+	protected:
+		std::shared_ptr<thor_scsi::core::GirderKnobbed<C>> m_girder;
+
 	private:
 		// template<typename T>
 		// void _propagate(thor_scsi::core::ConfigType &conf, ss_vect<T> &ps){
@@ -70,6 +123,13 @@ namespace thor_scsi::elements {
 			this->localPropagate(conf, ps);
 			this->local2Global(ps);
 		}
+
+		template<typename T>
+		void _propagateOnGirder(thor_scsi::core::ConfigType &conf, gtpsa::ss_vect<T> &ps){
+			this->girder2Local(ps);
+			this->localPropagate(conf, ps);
+			this->local2Girder(ps);
+		}
 	};
 
 	/*
@@ -84,14 +144,25 @@ namespace thor_scsi::elements {
 		inline LocalGalileanKnobbed(const Config &config)
 			: LocalCoordinatesKnobbed<C>(config)
 			, transform()
-			{}
+			{
+				this->transform.addListener(this);
+			}
 		virtual ~LocalGalileanKnobbed(){}
 		inline LocalGalileanKnobbed(LocalGalileanKnobbed&& o) :
 			LocalCoordinatesKnobbed<C>(std::move(o)),
-			transform(std::move(o.transform))
+			transform(std::move(o.transform)),
+			m_composed()
 			{
+				this->transform.addListener(this);
+				this->transformChanged();
+			}
 
+		/// recompose the transform used by global2Local / local2Global
+		inline virtual void transformChanged(void) override {
+			if(this->m_girder){
+				this->m_composed.compose(this->m_girder->transform, this->transform);
 			}
+		}
 
 		// inline virtual void global2Local(ss_vect<double>             &ps) override { this->_global2Local(ps); }
 		// inline virtual void global2Local(ss_vect<tps>                &ps) override { this->_global2Local(ps); }
@@ -106,6 +177,10 @@ namespace thor_scsi::elements {
 		inline virtual void local2Global(gtpsa::ss_vect<gtpsa::tpsa> &ps) override { this->_local2Global(ps); }
 	        // inline virtual void local2Global(gtpsa::ss_vect<tps>         &ps) override { this->_local2Global(ps); }
 
+		inline virtual void girder2Local(gtpsa::ss_vect<double>      &ps) override { this->transform.forward(ps);  }
+		inline virtual void girder2Local(gtpsa::ss_vect<gtpsa::tpsa> &ps) override { this->transform.forward(ps);  }
+		inline virtual void local2Girder(gtpsa::ss_vect<double>      &ps) override { this->transform.backward(ps); }
+		inline virtual void local2Girder(gtpsa::ss_vect<gtpsa::tpsa> &ps) override { this->transform.backward(ps); }
 
 		inline auto* getTransform(void){
 			return &this->transform;
@@ -115,8 +190,15 @@ namespace thor_scsi::elements {
 	private:
 		// template<typename T> void _global2Local(ss_vect<T>        &ps){ this->transform.forward(ps);	}
 		// template<typename T> void _local2Global(ss_vect<T>        &ps){ this->transform.backward(ps);	}
-		template<typename T> void _global2Local(gtpsa::ss_vect<T> &ps){	this->transform.forward(ps);	}
-		template<typename T> void _local2Global(gtpsa::ss_vect<T> &ps){	this->transform.backward(ps);	}
+		template<typename T> void _global2Local(gtpsa::ss_vect<T> &ps){	this->effectiveTransform().forward(ps);	}
+		template<typename T> void _local2Global(gtpsa::ss_vect<T> &ps){	this->effectiveTransform().backward(ps);	}
+
+		/// own transform or the one composed with the girder's one
+		inline thor_scsi::core::PhaseSpaceGalilean2DTransformKnobbed<C>& effectiveTransform(void){
+			return this->m_girder ? this->m_composed : this->transform;
+		}
+
+		thor_scsi::core::PhaseSpaceGalilean2DTransformKnobbed<C> m_composed;
 	};
 
 	/*
@@ -131,16 +213,28 @@ namespace thor_scsi::elements {
 		inline LocalGalileanPRotKnobbed(const Config &config)
 			: LocalCoordinatesKnobbed<C>(config)
 			, transform()
-			{}
+			{
+				this->transform.addListener(this);
+			}
 
 		virtual ~LocalGalileanPRotKnobbed(){}
 		inline LocalGalileanPRotKnobbed(LocalGalileanPRotKnobbed&& o)
 			: LocalCoordinatesKnobbed<C>(std::move(o) )
 			, transform(std::move(o.transform))
+			, m_composed()
 			{
 				// this->transform = o.transform;
 				//transform(std::move(o.transform));
+				this->transform.addListener(this);
+				this->transformChanged();
+			}
+
+		/// see LocalGalileanKnobbed::transformChanged
+		inline virtual void transformChanged(void) override {
+			if(this->m_girder){
+				this->m_composed.compose(this->m_girder->transform, this->transform);
 			}
+		}
 
 		// inline virtual void global2Local(ss_vect<double> &ps) override final { this->_global2Local(ps);  }
 		// inline virtual void global2Local(ss_vect<tps>    &ps) override final { this->_global2Local(ps);  }
@@ -154,6 +248,10 @@ namespace thor_scsi::elements {
 	    // inline virtual void local2Global(gtpsa::ss_vect<tps>         &ps) override final { this->_local2Global(ps);  }
 		inline virtual void local2Global(gtpsa::ss_vect<gtpsa::tpsa> &ps) override final { this->_local2Global(ps);  }
 
+		inline virtual void girder2Local(gtpsa::ss_vect<double>      &ps) override final { this->transform.forward(ps);  }
+		inline virtual void girder2Local(gtpsa::ss_vect<gtpsa::tpsa> &ps) override final { this->transform.forward(ps);  }
+		inline virtual void local2Girder(gtpsa::ss_vect<double>      &ps) override final { this->transform.backward(ps); }
+		inline virtual void local2Girder(gtpsa::ss_vect<gtpsa::tpsa> &ps) override final { this->transform.backward(ps); }
 
 		inline auto* getTransform(void){return &this->transform;		}
 
@@ -162,8 +260,15 @@ namespace thor_scsi::elements {
 	private:
 		// template<typename T> void _global2Local(ss_vect<T> &ps){ this->transform.forward(ps);  }
 		// template<typename T> void _local2Global(ss_vect<T> &ps){ this->transform.backward(ps); }
-		template<typename T> void _global2Local(gtpsa::ss_vect<T> &ps){ this->transform.forward(ps);  }
-		template<typename T> void _local2Global(gtpsa::ss_vect<T> &ps){ this->transform.backward(ps); }
+		template<typename T> void _global2Local(gtpsa::ss_vect<T> &ps){ this->effectiveTransform().forward(ps);  }
+		template<typename T> void _local2Global(gtpsa::ss_vect<T> &ps){ this->effectiveTransform().backward(ps); }
+
+		/// see LocalGalileanKnobbed::effectiveTransform
+		inline thor_scsi::core::PhaseSpaceGalileanPRot2DTransformKnobbed<C>& effectiveTransform(void){
+			return this->m_girder ? this->m_composed : this->transform;
+		}
+
+		thor_scsi::core::PhaseSpaceGalileanPRot2DTransformKnobbed<C> m_composed;
 	};
 
     typedef LocalGalileanKnobbed<thor_scsi::core::StandardDoubleType> LocalGalilean;
@@ -22,11 +22,10 @@ using gtpsa::sin;
 
 namespace thor_scsi::elements {
 	template<typename T>
-	void edge_focus(const tsc::ConfigType &conf, const double irho, const double phi /* in degrees */,
-			    const double gap, gtpsa::ss_vect<T> &ps);
+	void edge_focus(const tsc::ConfigType &conf, const FieldKickEdgeConstants& edge, gtpsa::ss_vect<T> &ps);
 
 	template<typename T>
-	void p_rot(const tsc::ConfigType &conf, double phi, gtpsa::ss_vect<T> &ps);
+	void p_rot(const tsc::ConfigType &conf, const FieldKickEdgeConstants& edge, gtpsa::ss_vect<T> &ps);
 
 	template<typename T>
 	void bend_fringe(const tsc::ConfigType &conf, const double hb, gtpsa::ss_vect<T> &ps);
@@ -45,45 +44,59 @@ namespace thor_scsi::elements {
  * \endverbatim
  *
  */
+tse::FieldKickEdgeConstants tse::compute_edge_constants(const double irho, const double phi, const double gap)
+{
+	FieldKickEdgeConstants edge;
+	const double phi_rad = degtorad(phi);
+
+	edge.cos_phi = cos(phi_rad);
+	edge.sin_phi = sin(phi_rad);
+	edge.tan_phi = tan(phi_rad);
+	edge.irho_tan_phi = irho*edge.tan_phi;
+	/* get_psi is only defined for a bend */
+	if(irho != 0e0){
+		edge.irho_tan_phi_psi = irho*tan(phi_rad-get_psi(irho, phi, gap));
+	}
+	return edge;
+}
+
+/**
+ * @brief edge focusing of a dipole in polar coordinates
+ *
+ * edge constants see :func:`compute_edge_constants`
+ */
 template<typename T>
-void tse::edge_focus(const tsc::ConfigType &conf, const double irho, const double phi /* in degrees */,
-		    const double gap, gtpsa::ss_vect<T> &ps)
+void tse::edge_focus(const tsc::ConfigType &conf, const FieldKickEdgeConstants& edge, gtpsa::ss_vect<T> &ps)
 {
-  ps[px_] += irho*tan(degtorad(phi))*ps[x_];
+  ps[px_] += edge.irho_tan_phi*ps[x_];
   if (!conf.dip_edge_fudge) {
     // Remark: Leads to a diverging Taylor map (see SSC-141).
     // ps[py_] -=
     //   irho*tan(degtorad(phi)-get_psi(irho, phi, gap))
     //   *ps[y_]/(1e0+ps[delta_]);
     // Leading order correction.
-    ps[py_] -=
-      irho*tan(degtorad(phi)-get_psi(irho, phi, gap))*ps[y_]*(1e0-ps[delta_]);
+    ps[py_] -= edge.irho_tan_phi_psi*ps[y_]*(1e0-ps[delta_]);
   } else
-    ps[py_] -= irho*tan(degtorad(phi)-get_psi(irho, phi, gap))*ps[y_];
+    ps[py_] -= edge.irho_tan_phi_psi*ps[y_];
 }
 
 /*
  *
  * @f[\phi@f] ... dipole bend angle
  *
- * \verbatim embed:rst:leading-asterisk
- * .. Warning::
+ * edge constants see :func:`compute_edge_constants`
  *
- *     phi is in degrees
+ * \verbatim embed:rst:leading-asterisk
  *
  * .. Todo:
  *     how does it differ from PRotTransform? Should it be implemented there?
  * \endverbatim
  */
 template<typename T>
-void tse::p_rot(const tsc::ConfigType &conf, double phi, gtpsa::ss_vect<T> &ps)
+void tse::p_rot(const tsc::ConfigType &conf, const FieldKickEdgeConstants& edge, gtpsa::ss_vect<T> &ps)
 {
-    T  c(ps[0]), s(ps[0]), t(ps[0]), pz(ps[0]), val(ps[0]); // p
-
-  c = cos(degtorad(phi));
-  s = sin(degtorad(phi));
-  t = tan(degtorad(phi));
-  pz = get_p_s(conf, ps);
+  const double c = edge.cos_phi, s = edge.sin_phi, t = edge.tan_phi;
+  T pz = get_p_s(conf, ps);
 
   if (!conf.H_exact && !conf.Cart_Bend) {
      ps[px_] = s*pz + c*ps[px_];
@@ -94,7 +107,7 @@ void tse::p_rot(const tsc::ConfigType &conf, double phi, gtpsa::ss_vect<T> &ps)
     // px[ct_] += (1e0+ps1[delta_])*ps1[x_]*s/p;
 
       gtpsa::ss_vect<T> ps1 = ps.clone();
-      val = 1e0 - ps1[px_]*t/pz;
+      T val = 1e0 - ps1[px_]*t/pz;
     ps[x_]  = ps1[x_]/(c*val);
     ps[px_] = ps1[px_]*c + s*pz;
     ps[y_]  = ps1[y_] + t*ps1[x_]*ps1[py_]/(pz*val);
@@ -183,17 +196,22 @@ void tse::FieldKickForthOrder<C>::computeIntegrationSteps(void)
 		return;
 	}
 	const double Pirho = this->parent->getCurvature(), length = this->parent->getLength();
-	double dL;
-	auto n_steps = this->getNumberOfIntegrationSteps();
+	const auto n_steps = this->getNumberOfIntegrationSteps();
 
+	// polar coordinates: along the arc
+	const double dL_polar = length / n_steps;
+	double dL_cartesian;
 	if(this->parent->assumingCurvedTrajectory()){
-		// along the arc
-		dL = 2e0/ Pirho * sin(length * Pirho/2e0) / n_steps;
+		// along the chord
+		dL_cartesian = 2e0/ Pirho * sin(length * Pirho/2e0) / n_steps;
 	}else{
 		// along the straight line
-		dL = length / n_steps;
+		dL_cartesian = length / n_steps;
 	}
-	this->splitIntegrationStep(dL, &this->dL1, &this->dL2, &this->dkL1, &this->dkL2);
+	auto& p = this->m_polar;
+	this->splitIntegrationStep(dL_polar, &p.dL1, &p.dL2, &p.dkL1, &p.dkL2);
+	auto& c = this->m_cartesian;
+	this->splitIntegrationStep(dL_cartesian, &c.dL1, &c.dL2, &c.dkL1, &c.dkL2);
 }
 
 template<class C>
@@ -240,35 +258,18 @@ inline void tse::FieldKickForthOrder<C>::_localPropagate(tsc::ConfigType &conf,
 {
 
 
-	double  h_ref = 0.0;
 	auto PN = this->integration_steps;
-	auto length = this->parent->getLength();
-    double Pirho = this->parent->getCurvature();
+	const double Pirho = this->parent->getCurvature();
+	// Polar coordinates: reference curved, Cartesian: straight
+	const double h_ref = (!conf.Cart_Bend) ? Pirho : 0e0;
 
 	THOR_SCSI_LOG(DEBUG) << "\n  name = " << this->parent->name << " N = " << PN << "\n";
 
-    auto dL = length/PN;
-	if (!conf.Cart_Bend) {
-		// Polar coordinates.
-		h_ref = Pirho; dL = length/PN;
-	} else {
-		// Cartesian coordinates.
-		h_ref = 0e0;
-		//if (Pirho == 0e0){
-		if(!this->parent->assumingCurvedTrajectory()){
-			// along the straight line
-			dL = length/PN;
-		}else{
-			// along the arc
-			dL = 2e0/Pirho*sin(length*Pirho/2e0)/PN;
-		}
-	}
-
 	/*
-	 * Calculating the individual pieces
+	 * individual pieces: precomputed by computeIntegrationSteps
 	 */
-	double dL1, dL2, dkL1, dkL2;
-	this->splitIntegrationStep(dL, &dL1, &dL2, &dkL1, &dkL2);
+	const auto& steps = this->getStepConstants(conf.Cart_Bend);
+	const double dL1 = steps.dL1, dL2 = steps.dL2, dkL1 = steps.dkL1, dkL2 = steps.dkL2;
 
 	// std::cout <<  "local pass " <<  std::endl;
 	// std::cout.flush();
@@ -360,7 +361,7 @@ tse::FieldKickKnobbed<C>::FieldKickKnobbed(tse::FieldKickKnobbed<C>&& O)
 	this->setNumberOfIntegrationSteps(O.getNumberOfIntegrationSteps());
 	this->setIntegrationMethod(O.getIntegrationMethod());
 
-	this->Pgap = O.Pgap;
+	this->setGap(O.getGap());
 	this->integ4O.setParent(this);
 	this->rad_del = std::move(O.rad_del);
 	return;
@@ -442,7 +443,7 @@ void tse::FieldKickKnobbed<C>::_quadFringe(thor_scsi::core::ConfigType &conf, gt
 template<class C>
 template<typename T>
 inline void tse::FieldKickKnobbed<C>::
-thinKickAndRadiate(const thor_scsi::core::ConfigType &conf,
+thinKickAndRadiate(thor_scsi::core::ConfigType &conf,
 		   const thor_scsi::core::Field2DInterpolationKnobbed<C>& intp,
 		   const double L, const double h_bend, const double h_ref,
 		   gtpsa::ss_vect<T> &ps)
@@ -487,7 +488,7 @@ thinKickAndRadiate(const thor_scsi::core::ConfigType &conf,
  */
 template<class C>
 template<typename T>
-inline void tse::FieldKickKnobbed<C>::_localPropagateThin(const tsc::ConfigType &conf, gtpsa::ss_vect<T> &ps)
+inline void tse::FieldKickKnobbed<C>::_localPropagateThin(tsc::ConfigType &conf, gtpsa::ss_vect<T> &ps)
 {
 	// length has to be zero here
 	/// todo: add a check at least for debug purposes
@@ -563,6 +564,10 @@ void tse::FieldKickKnobbed<C>::_localPropagate(tsc::ConfigType &conf, gtpsa::ss_
 	this->_synchrotronIntegralsInit(conf, ps);
 #endif /* SYNCHROTRON_INTEGRALS */
 
+	/* element entered: restart the counter of the random numbers */
+	conf.qe_element = static_cast<uint32_t>(this->index);
+	conf.qe_kick = 0;
+
 	// Set start
 
 	// Matrix method
@@ -587,13 +592,13 @@ void tse::FieldKickKnobbed<C>::_localPropagate(tsc::ConfigType &conf, gtpsa::ss_
 
 	if (!conf.Cart_Bend) {
 		if (this->assumingCurvedTrajectory()){
-			tse::edge_focus(conf, Pirho, PTx1, Pgap, ps);
+			tse::edge_focus(conf, this->m_entrance_edge, ps);
 		}
 	} else {
 		// here in Carthesian coordinates
 
 		/* horizontal focusing: purely geometric effect */
-		tse::p_rot(conf, PTx1, ps);
+		tse::p_rot(conf, this->m_entrance_edge, ps);
 		/* vertical focusing: leading order effect */
 		tse::bend_fringe(conf, Pirho, ps);
 	}
@@ -604,10 +609,10 @@ void tse::FieldKickKnobbed<C>::_localPropagate(tsc::ConfigType &conf, gtpsa::ss_
 	// Fringe fields.
 	if (!conf.Cart_Bend) {
 		if (this->assumingCurvedTrajectory()){
-			tse::edge_focus(conf, Pirho, PTx2, Pgap, ps);
+			tse::edge_focus(conf, this->m_exit_edge, ps);
 		}
 	} else {
-		tse::bend_fringe(conf, -Pirho, ps); p_rot(conf, PTx2, ps);
+		tse::bend_fringe(conf, -Pirho, ps); p_rot(conf, this->m_exit_edge, ps);
 	}
 	this->_quadFringe(conf, ps);
 }
@@ -46,6 +46,39 @@ namespace thor_scsi::elements {
     template<class>
     class FieldKickKnobbed;
 
+    /**
+     * @brief drift and kick lengths of one 4th order integration step
+     *
+     * Depend only on length, curvature and number of integration steps.
+     * Thus computed when one of these changes and not during propagation.
+     */
+    struct FieldKickStepConstants {
+        double dL1 = 0e0, dL2 = 0e0, dkL1 = 0e0, dkL2 = 0e0;
+    };
+
+    /**
+     * @brief geometry dependent constants of a dipole edge
+     *
+     * Computed from curvature, edge angle and gap whenever one of these
+     * changes. Used by edge_focus (polar coordinates) and p_rot
+     * (Cartesian coordinates).
+     */
+    struct FieldKickEdgeConstants {
+        double
+        irho_tan_phi = 0e0,      ///< irho * tan(phi)
+            irho_tan_phi_psi = 0e0,  ///< irho * tan(phi - psi), psi: fringe field correction
+            cos_phi = 1e0,
+            sin_phi = 0e0,
+            tan_phi = 0e0;
+    };
+
+    /**
+     * @param irho curvature
+     * @param phi  edge angle in degrees
+     * @param gap  total magnet gap [m]
+     */
+    FieldKickEdgeConstants compute_edge_constants(const double irho, const double phi, const double gap);
+
 
     /**
  * Symplectic integrator
@@ -67,7 +100,9 @@ namespace thor_scsi::elements {
  *
  * d_2:  negative thus creates a negative drift
  *
- * @todo review interaction to configuration to see if integration intervals can be precomputed
+ * The step lengths are precomputed for polar and Cartesian coordinates
+ * whenever the number of steps, the length or the curvature of the parent
+ * changes (see :meth:`computeIntegrationSteps`).
  */
     template<class C>
     class FieldKickDelegate {
@@ -137,24 +172,34 @@ namespace thor_scsi::elements {
         template<typename T>
         void _localPropagate(thor_scsi::core::ConfigType &conf, gtpsa::ss_vect<T> &ps);
 
+        /**
+         * @brief step constants as used for the given coordinate system
+         *
+         * @param cartesian_bend: conf.Cart_Bend
+         */
+        inline const FieldKickStepConstants& getStepConstants(const bool cartesian_bend) const {
+            return cartesian_bend ? this->m_cartesian : this->m_polar;
+        }
+
         inline std::unique_ptr<std::vector<double>> getDriftLength(void) const {
             auto res = std::make_unique<std::vector<double>>(2);
-            res->at(0) = this->dL1;
-            res->at(1) = this->dL2;
+            res->at(0) = this->m_polar.dL1;
+            res->at(1) = this->m_polar.dL2;
             return res;
         }
 
         inline std::unique_ptr<std::vector<double>> getKickLength(void) const {
             auto res = std::make_unique<std::vector<double>>(2);
-            res->at(0) = this->dL1;
-            res->at(1) = this->dL2;
+            res->at(0) = this->m_polar.dkL1;
+            res->at(1) = this->m_polar.dkL2;
             return res;
         }
 
-        // not really useful yet ... need to push configuration into
-        // objects
-        // fix for Cartesian bend treatment
-        // don't use this internal parametes yet
+        /**
+         * @brief recompute step constants from parent's length and curvature
+         *
+         * to be called whenever these or the number of steps change
+         */
         void computeIntegrationSteps(void) override final;
 
     private:
@@ -169,9 +214,9 @@ namespace thor_scsi::elements {
         const double d_1 = 2e0*c_1;
         const double d_2 = 1e0 - 2e0*d_1;
 
-        // Consider one set for
-        // an other set for Cartesian Bends
-        double dL1 = 0e0, dL2 = 0e0, dkL1 = 0e0, dkL2 = 0e0;
+        // polar coordinates: step along the arc length
+        // Cartesian coordinates: step along the chord
+        FieldKickStepConstants m_polar, m_cartesian;
 
     };
 
@@ -319,6 +364,13 @@ namespace thor_scsi::elements {
 			} else {
 				this->asThick(true);
 			}
+			this->integ4O.computeIntegrationSteps();
+		}
+
+		virtual void inline setCurvature(const double val) override final {
+			FieldKickAPIKnobbed<C>::setCurvature(val);
+			this->integ4O.computeIntegrationSteps();
+			this->computeEdgeConstants();
 		}
 
 
@@ -347,6 +399,7 @@ namespace thor_scsi::elements {
 
 		inline void setEntranceAngle(const double angle) {
 			this->PTx1 = angle;
+			this->computeEdgeConstants();
 		}
 
 		inline double getEntranceAngle(void) const{
@@ -358,12 +411,35 @@ namespace thor_scsi::elements {
 		 */
 		inline void setExitAngle(const double angle){
 			this->PTx2 = angle;
+			this->computeEdgeConstants();
 		}
 
 		inline double getExitAngle(void) const {
 			return this->PTx2;
 		}
 
+		/**
+		 * @brief total magnet gap [m]: used for the fringe field correction
+		 *
+		 * updates the edge constants
+		 */
+		inline void setGap(const double gap){
+			this->Pgap = gap;
+			this->computeEdgeConstants();
+		}
+
+		inline double getGap(void) const {
+			return this->Pgap;
+		}
+
+		inline const FieldKickEdgeConstants& getEntranceEdgeConstants(void) const {
+			return this->m_entrance_edge;
+		}
+
+		inline const FieldKickEdgeConstants& getExitEdgeConstants(void) const {
+			return this->m_exit_edge;
+		}
+
 		virtual void localPropagate(thor_scsi::core::ConfigType &conf, gtpsa::ss_vect<double>      &ps) override final { _localPropagate(conf, ps);}
 		virtual void localPropagate(thor_scsi::core::ConfigType &conf, gtpsa::ss_vect<gtpsa::tpsa> &ps) override final { _localPropagate(conf, ps);}
 	    /*
@@ -375,7 +451,7 @@ namespace thor_scsi::elements {
 
         // Required as radiation is now handled by a delegate
         template<typename T>
-        inline void thinKickAndRadiate(const thor_scsi::core::ConfigType &conf,
+        inline void thinKickAndRadiate(thor_scsi::core::ConfigType &conf,
                                        const thor_scsi::core::Field2DInterpolationKnobbed<C>& intp,
                                        const double L, const double h_bend, const double h_ref,
                                        gtpsa::ss_vect<T> &ps);
@@ -385,12 +461,17 @@ namespace thor_scsi::elements {
 			void _localPropagate(thor_scsi::core::ConfigType &conf, gtpsa::ss_vect<T> &ps);
 
 		template<typename T>
-		        void _localPropagateThin(const thor_scsi::core::ConfigType &conf, gtpsa::ss_vect<T> &ps);
+		        void _localPropagateThin(thor_scsi::core::ConfigType &conf, gtpsa::ss_vect<T> &ps);
 
 		template<typename T>
 		        void _localPropagateBody(thor_scsi::core::ConfigType &conf, gtpsa::ss_vect<T> &ps);
 
 
+		inline void computeEdgeConstants(void){
+			this->m_entrance_edge = compute_edge_constants(this->getCurvature(), this->PTx1, this->Pgap);
+			this->m_exit_edge = compute_edge_constants(this->getCurvature(), this->PTx2, this->Pgap);
+		}
+
 		void inline validateIntegrationMethod(const int n) const {
 			switch(n){
 			case Meth_Fourth:
@@ -404,10 +485,18 @@ namespace thor_scsi::elements {
 
 	  public:
 		double
-		Pbending_angle = 0e0,                     ///<  Todo: Already defined or combination of PTx1 and PTx2?
-			PTx1 = 0e0,                      ///<  Bend angle [deg]:  hor. entrance angle
+		Pbending_angle = 0e0;                     ///<  Todo: Already defined or combination of PTx1 and PTx2?
+
+	private:
+		/*
+		 * private as the edge constants have to follow them: use
+		 * setEntranceAngle, setExitAngle and setGap
+		 */
+		double
+		PTx1 = 0e0,                              ///<  Bend angle [deg]:  hor. entrance angle
 			PTx2 = 0e0,                      ///<  Bend angle [deg]: hor. exit angle.
-			Pgap = 0e0;                      ///< Total magnet gap [m].
+			Pgap = 0e0;                      ///< Total magnet gap [m]
+		FieldKickEdgeConstants m_entrance_edge, m_exit_edge;
 
 		/*
 		 * see :any:`isThick` or :any:`asThick` for a description
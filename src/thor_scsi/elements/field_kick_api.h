@@ -30,7 +30,7 @@ namespace thor_scsi::elements {
 			return this->Pirho;
 		}
 
-		inline void setCurvature(const double val) {
+		virtual inline void setCurvature(const double val) {
 			this->Pirho = val;
 		}
 		inline int getNumberOfIntegrationSteps(void) const {
@@ -2,7 +2,11 @@
 #include <thor_scsi/elements/radiation_delegate.h>
 #include <thor_scsi/elements/element_helpers.h>
 #include <thor_scsi/elements/utils.h>
+#include <thor_scsi/core/counter_rng.h>
 #include <gtpsa/utils_tps.hpp>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
 
 
 namespace ts = thor_scsi;
@@ -161,6 +165,8 @@ inline void tse::RadiationDelegateKickKnobbed<FC>::diffusion(const T &B2_perp,
 			this->D_rad[j] +=
 			    (sqr(A_inv(j*2, delta_))+sqr(A_inv(j*2+1, delta_)))*B_66/2e0;
 		}
+		const arma::vec v = A_inv(arma::span(0, 5), delta_);
+		this->B_rad += B_66 * v * v.t();
 	}
 #endif
 }
@@ -227,25 +233,18 @@ void tse::RadiationDelegateKickKnobbed<FC>::show(std::ostream& strm, int level)
 
 /**
  * @brief Computing |B^2_perp| perpendicular to the arc of circle.
+ *
+ * xp, yp: transverse momenta normalised to the longitudinal one
  */
 template<typename T>
-void get_B2(const double h_ref, const std::array<T,3> B, const gtpsa::ss_vect<T> &xp,
-	    T &B2_perp, T &B2_par)
+static inline T get_B2_perp(const double h_ref, const std::array<T,3>& B, const T& x, const T& xp, const T& yp)
 {
-  // compute B_perp^2 and B_par^2
-  //T e[3];
+	const T xh = 1e0 + x * h_ref;
+	const T xn = 1e0 / sqrt(sqr(xh) + sqr(xp) + sqr(yp));
+	const T ex = xp * xn, ey = yp * xn, ez = xh * xn;
 
-  T xn = 1e0/sqrt(sqr(1e0+xp[x_]*h_ref)+sqr(xp[px_])+sqr(xp[py_]));
-  std::array<T, 3> e = {xp[px_]*xn, xp[py_]*xn, (1e0+xp[x_]*h_ref)*xn};
-
-  // left-handed coordinate system
-  B2_perp =
-    sqr(B[Y_]*e[Z_]-B[Z_]*e[Y_]) + sqr(B[X_]*e[Y_]-B[Y_]*e[X_])
-    + sqr(B[Z_]*e[X_]-B[X_]*e[Z_]);
-
-  THOR_SCSI_LOG(DEBUG)
-    << "\nB2_perp = " << B2_perp;
-  //  B2_par = sqr(B[X_]*e[X_]+B[Y_]*e[Y_]+B[Z_]*e[Z_]);
+	// left-handed coordinate system
+	return sqr(B[Y_]*ez-B[Z_]*ey) + sqr(B[X_]*ey-B[Y_]*ex) + sqr(B[Z_]*ex-B[X_]*ez);
 }
 
 template<class EC>
@@ -254,140 +253,96 @@ void tse::RadiationDelegateKickKnobbed<EC>::setEnergy(const double val)
   // energy in eV
   this->energy = val;
 
-  // the equation below is for GeV
-  auto energy_GeV = this->energy / 1e9;
   this->q_fluct = C_q*C_gamma/(M_PI*sqr(m_e))*pow(this->energy, 5e0);
+  this->cl_rad = C_gamma * cube(this->energy) / (2e0 * M_PI);
 }
 
+/*
+ * one pass over the (constant part of the) phase space: all
+ * coordinates finite and bound
+ */
 template<typename T>
-static bool check_ps_finite(gtpsa::ss_vect<T>& ps, const double max_val = 1e3)
+static inline bool check_ps_finite(const gtpsa::ss_vect<T>& ps, const double max_val = 1e3)
 {
-	bool check_ps_finite = true;
 	for(int i=0; i < nv_tps; ++i){
-		double ref_val = gtpsa::cst(ps[i]);
-		check_ps_finite &= std::isfinite(ref_val);
-		check_ps_finite &= (std::abs(ref_val) < max_val);
+		/* negated comparison: false for NaN too */
+		if(!(std::abs(double(gtpsa::cst(ps[i]))) < max_val)){
+			return false;
+		}
 	}
-	return check_ps_finite;
+	return true;
 }
 
 template<class FC>
-template<typename T>
-void tse::RadiationDelegateKickKnobbed<FC>::radiate(const thor_scsi::core::ConfigType &conf, gtpsa::ss_vect<T> &ps, const double L,
-				     const double h_ref, const std::array<T, 3> B)
+void tse::RadiationDelegateKickKnobbed<FC>::quantumExcitation(thor_scsi::core::ConfigType &conf, const double B2_perp,
+							  const double ds, const double p_s0, gtpsa::ss_vect<double> &ps)
 {
+	/* counted for each kick: the numbers drawn do not depend on the field elsewhere */
+	const uint32_t kick = conf.qe_kick++;
+	// variance of the energy kick: B_66 as used for the diffusion coefficients
+	const double B_66 = this->q_fluct * std::pow(B2_perp, 1.5) * std::pow(p_s0, 4) * ds;
+	if(!(B_66 > 0e0)){
+		return;
+	}
+	const auto z = tsc::Philox4x32::normal(
+		{conf.turn, conf.qe_element, kick, 0},
+		{conf.particle_id, conf.qe_seed}
+		);
+	ps[delta_] += std::sqrt(B_66) * z[0];
+}
 
-#if 0
-       throw std::runtime_error("radiate needs to be implemented  ");
-#else
+template<class FC>
+template<typename T>
+void tse::RadiationDelegateKickKnobbed<FC>::radiate(thor_scsi::core::ConfigType &conf, gtpsa::ss_vect<T> &ps, const double L,
+				     const double h_ref, const std::array<T, 3>& B)
+{
 	// M. Sands "The Physics of Electron Storage Rings" SLAC-121, p. 98.
 	// ddelta/d(ds) = -C_gamma*E_0^3*(1+delta)^2*(B_perp/(Brho))^2/(2*pi)
-
-        T B2_perp = gtpsa::same_as_instance(B[0]);
-        T B2_par = gtpsa::same_as_instance(B[2]);
-
-	// I think init sets the fields to zero ... but better to zero them for sure
-	B2_perp = 0e0;
-	B2_par = 0e0;
-
-	gtpsa::ss_vect<T> cs = ps.clone();
-	gtpsa::ss_vect<T> ps_save = ps.clone();
-
-	const bool radiation = conf.radiation;
-	const bool compute_diffusion = conf.emittance;
-	if(!radiation){
+	if(!conf.radiation){
 		return;
 	}
-#if 0
-	THOR_SCSI_LOG(DEBUG)
-		<< "\nRadiate ->:\n" << this->delegator_name << "\n" << "  ps = "
-		<< ps;
-#else
-	THOR_SCSI_LOG(INFO) << "\nRadiate ->:\n" << "\n" << "  ps = " << ps.clone();
-#endif
-
-	if(!check_ps_finite(ps)){
-		std::stringstream strm;
-		strm <<  "ps unbound "; ps.show(strm, 10, false);
-		std::cerr << strm.str() << std::endl;
-		THOR_SCSI_LOG(ERROR) <<  "Check radiation" << strm.str()
-				     << " \n";
-		throw ts::PhysicsViolation(strm.str());
-	}
+	const bool compute_diffusion = conf.emittance;
 
 	// longitudinal component
-	T p_s0 = get_p_s(conf, ps);
-	cs = ps.clone(); //.clone()
+	const T p_s0 = get_p_s(conf, ps);
 	// Large ring: x' and y' unchanged.
-	cs[px_] /= p_s0;
-	cs[py_] /= p_s0;
-
-	if(!check_ps_finite(cs)){
-		std::stringstream strm;
-		strm << "ps unbound "; ps.show(strm, 10, false);
-		std::cerr << strm.str() << std::endl;
-		THOR_SCSI_LOG(ERROR)
-			<<  "Check radiaton" << strm.str() << " \n";
-
-		throw ts::PhysicsViolation(strm.str());
-	}
+	const T xp = ps[px_] / p_s0, yp = ps[py_] / p_s0;
 
 	// H = -p_s => ds = H*L.
-	T ds = (1e0+cs[x_]*h_ref+(sqr(cs[px_])+sqr(cs[py_]))/2e0)*L;
-	THOR_SCSI_LOG(DEBUG)
-		<< "\nField contribution:\n  h_ref = " << h_ref
-		<< "\n  B     = (" <<  B[X_] << ", " << B[Y_] << ", " << B[Z_] << ")"
-		<< "\n  cs    = " <<  cs.clone();
+	const T ds = (1e0 + ps[x_] * h_ref + (sqr(xp) + sqr(yp)) / 2e0) * L;
 	// Compute perpendicular reference curve for comoving frame.
-	get_B2(h_ref, B, cs, B2_perp, B2_par);
-
-	//THOR_SCSI_LOG(INFO)
-	// Test on legacy code
-	// Should be 1 at the end ...
-	const double energy_scale = 1e0;
-	const double cl_rad =
-		C_gamma * cube(this->energy * energy_scale) / (2e0 * M_PI);
-
-	if (radiation) {
-		ps[delta_] -= cl_rad*sqr(p_s0)*B2_perp*ds;
-		T p_s1 = get_p_s(conf, ps);
-		ps[px_] = cs[px_]*p_s1;
-		ps[py_] = cs[py_]*p_s1;
-	}
-	if(!check_ps_finite(cs)){
-		std::stringstream strm;
-		strm << "ps unbound "; ps.show(strm, 10, false);
-		std::cerr << strm.str() << std::endl;
-		THOR_SCSI_LOG(ERROR) <<  "Check radiaton" << strm.str()
-				     << " \n";
+	const T B2_perp = get_B2_perp(h_ref, B, ps[x_], xp, yp);
 
-		throw ts::PhysicsViolation(strm.str());
-	}
+	THOR_SCSI_LOG(DEBUG)
+		<< "\nRadiate " << this->delegator_name << ": h_ref = " << h_ref
+		<< ", B = (" <<  B[X_] << ", " << B[Y_] << ", " << B[Z_] << ")"
+		<< ", B2_perp = " << B2_perp;
 
 	if (compute_diffusion){
+		/* phase space with normalised momenta before the kick */
+		gtpsa::ss_vect<T> cs = ps.clone();
+		cs[px_] = xp;
+		cs[py_] = yp;
 		this->diffusion(B2_perp, ds, p_s0, cs);
 	}
 
-	if(!check_ps_finite(cs)){
+	ps[delta_] -= this->cl_rad * sqr(p_s0) * B2_perp * ds;
+	if constexpr (std::is_same<T, double>::value){
+		if(conf.quantum_excitation){
+			this->quantumExcitation(conf, B2_perp, ds, p_s0, ps);
+		}
+	}
+	const T p_s1 = get_p_s(conf, ps);
+	ps[px_] = xp * p_s1;
+	ps[py_] = yp * p_s1;
+
+	/* a non finite input or intermediate ends up in the result */
+	if(!check_ps_finite(ps)){
 		std::stringstream strm;
 		strm << "ps unbound "; ps.show(strm, 10, false);
-		std::cerr << strm.str() << std::endl;
 		THOR_SCSI_LOG(ERROR) <<  "Check radiation" << strm.str() << " \n";
-
 		throw ts::PhysicsViolation(strm.str());
 	}
-
-
-	THOR_SCSI_LOG(INFO)
-		<< "\nRadiate ->:\n" << this->delegator_name << "\n" << "  ps = "
-		<< ps.clone();
-
-	THOR_SCSI_LOG(INFO) << "\nRadiate ->:\n" << "\n" << "  ps = " << ps.clone();
-
-	gtpsa::ss_vect<T> dPs = ps - ps_save;
-	THOR_SCSI_LOG(INFO) <<  "Radiation effect on ps\n" << dPs.clone() << " \n";
-
-#endif
 }
 
 
@@ -436,17 +391,17 @@ template
 void tse::RadiationDelegateKickKnobbed<fka_dvt>::view(const fka_dvt& kick, const gtpsa::ss_vect<gtpsa::tpsa> &ps, const enum tsc::ObservedState state, const int cnt);
 
 
-template void tse::RadiationDelegateKickKnobbed<fka_dt>::radiate(const thor_scsi::core::ConfigType &conf, gtpsa::ss_vect<double>      &ps, const double L,
-                                                                 const double h_ref, const std::array<double, 3>      B);
-template void tse::RadiationDelegateKickKnobbed<fka_dvt>::radiate(const thor_scsi::core::ConfigType &conf, gtpsa::ss_vect<double>      &ps, const double L,
-                                                                 const double h_ref, const std::array<double, 3>      B);
-// template void tse::RadiationDelegateKick::radiate(const thor_scsi::core::ConfigType &conf, gtpsa::ss_vect<tps>         &ps, const double L,
+template void tse::RadiationDelegateKickKnobbed<fka_dt>::radiate(thor_scsi::core::ConfigType &conf, gtpsa::ss_vect<double>      &ps, const double L,
+                                                                 const double h_ref, const std::array<double, 3>&      B);
+template void tse::RadiationDelegateKickKnobbed<fka_dvt>::radiate(thor_scsi::core::ConfigType &conf, gtpsa::ss_vect<double>      &ps, const double L,
+                                                                 const double h_ref, const std::array<double, 3>&      B);
+// template void tse::RadiationDelegateKick::radiate(thor_scsi::core::ConfigType &conf, gtpsa::ss_vect<tps>         &ps, const double L,
 //						  const double h_ref, const std::array<tps, 3>         B);
 
-template void tse::RadiationDelegateKickKnobbed<fka_dt>::radiate(const thor_scsi::core::ConfigType &conf, gtpsa::ss_vect<gtpsa::tpsa> &ps, const double L,
-                                                                   const double h_ref, const std::array<gtpsa::tpsa, 3> B);
-template void tse::RadiationDelegateKickKnobbed<fka_dvt>::radiate(const thor_scsi::core::ConfigType &conf, gtpsa::ss_vect<gtpsa::tpsa> &ps, const double L,
-                                                                   const double h_ref, const std::array<gtpsa::tpsa, 3> B);
+template void tse::RadiationDelegateKickKnobbed<fka_dt>::radiate(thor_scsi::core::ConfigType &conf, gtpsa::ss_vect<gtpsa::tpsa> &ps, const double L,
+                                                                   const double h_ref, const std::array<gtpsa::tpsa, 3>& B);
+template void tse::RadiationDelegateKickKnobbed<fka_dvt>::radiate(thor_scsi::core::ConfigType &conf, gtpsa::ss_vect<gtpsa::tpsa> &ps, const double L,
+                                                                   const double h_ref, const std::array<gtpsa::tpsa, 3>& B);
 
 template void tse::RadiationDelegateKickKnobbed<fka_dt>::show(std::ostream& strm, int level) const;
 template void tse::RadiationDelegateKickKnobbed<fka_dvt>::show(std::ostream& strm, int level) const;
@@ -4,6 +4,7 @@
 #include <thor_scsi/elements/constants.h>
 #include <tps/tpsa_lin.h>
 #include <array>
+#include <cstdint>
 
 namespace thor_scsi::elements {
 	using thor_scsi::core::ElemType;
@@ -85,6 +86,7 @@ namespace thor_scsi::elements {
 			this->curly_dH_x = 0e0;
 			this->dI.fill({0e0});
 			this->D_rad.fill({0e0});
+			this->B_rad.zeros(6, 6);
 			// this->dEnergy = 0e0;
 
 		}
@@ -130,10 +132,28 @@ namespace thor_scsi::elements {
 		 *
 		 * @todo: depends on energy of ring .... currently taken from config ...
 		 *
+		 * Works in place: neither the phase space is copied (unless
+		 * diffusion coefficients are computed) nor are constants
+		 * recomputed, these are set by :meth:`setEnergy`.
+		 *
+		 * With conf.quantum_excitation set, double phase spaces
+		 * additionally receive a Gaussian energy kick of variance
+		 * q_fluct |B_perp|^3 (1 + delta)^4 ds (the increment used
+		 * for the diffusion coefficients). Truncated power series
+		 * are not kicked. The random numbers are keyed by
+		 * (conf.qe_seed, conf.particle_id) and counted by
+		 * (conf.turn, conf.qe_element, conf.qe_kick), see
+		 * :class:`thor_scsi::core::Philox4x32`; conf.qe_kick is
+		 * incremented. Thus the delegate keeps no state and can
+		 * be shared by threads propagating with their own conf.
+		 *
+		 * @throws PhysicsViolation if the phase space is not finite
+		 *         or exceeds 1e3 afterwards
+		 *
 		 * M. Sands "The hysics of Electron Storage Rings" SLAC-121, p. 98.
 		 */
 		template<typename T>
-		void radiate(const thor_scsi::core::ConfigType &conf, gtpsa::ss_vect<T> &x, const double L, const double h_ref, const std::array<T, 3> B);
+		void radiate(thor_scsi::core::ConfigType &conf, gtpsa::ss_vect<T> &x, const double L, const double h_ref, const std::array<T, 3>& B);
 
 		inline auto getSynchrotronIntegralsIncrement(void) const {
 			return this->dI;
@@ -143,6 +163,19 @@ namespace thor_scsi::elements {
 			return this->D_rad;
 		}
 
+		/**
+		 * @brief diffusion matrix of the element, at its entrance
+		 *
+		 * Sum of the energy kick variances of the element, each
+		 * transformed back by the inverse of the map propagated up
+		 * to the kick. Thus the map propagated has to start at the
+		 * entrance with an identity Jacobian to obtain the
+		 * element's own diffusion matrix.
+		 */
+		inline const arma::mat& getDiffusionMatrixIncrement(void) const {
+			return this->B_rad;
+		}
+
 		inline double getCurlydHx(void) const {
 			return this->curly_dH_x;
 		}
@@ -176,6 +209,9 @@ namespace thor_scsi::elements {
 		template<typename T>
 		inline void _view(const FC&, const gtpsa::ss_vect<T> &ps, const enum ObservedState state, const int cnt);
 
+		void quantumExcitation(thor_scsi::core::ConfigType &conf, const double B2_perp, const double ds,
+				       const double p_s0, gtpsa::ss_vect<double> &ps);
+
 		template<typename T>
 		void diffusion(const T &B2_perp, const T &ds, const T &p_s0,  const gtpsa::ss_vect<T> &A);
 
@@ -183,9 +219,12 @@ namespace thor_scsi::elements {
 		int index;
 		std::array<double, 6> dI;           ///< Local contributions to the synchrotron integrals
 		std::array<double, 3> D_rad;        //< Diffusion coefficients (Floquet space).
+		arma::mat B_rad;                    //< Diffusion matrix (coordinates of the map propagated)
 		bool compute_diffusion = false;
 		double energy = NAN;
 		double q_fluct = NAN;
+		///< C_gamma E^3 / (2 pi), set together with the energy
+		double cl_rad = NAN;
 
 		std::string delegator_name = "";
 		int delegator_index = -1;
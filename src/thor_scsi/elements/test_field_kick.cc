@@ -4,6 +4,7 @@
 #include <boost/test/tools/output_test_stream.hpp>
 #include <cmath>
 #include <thor_scsi/elements/field_kick.h>
+#include <thor_scsi/elements/element_helpers.h>
 #include <ostream>
 
 namespace tsc = thor_scsi::core;
@@ -204,6 +205,79 @@ BOOST_AUTO_TEST_CASE(test20_4Order_lengthes)
 
 }
 
+BOOST_AUTO_TEST_CASE(test21_4Order_precomputed_lengthes)
+{
+	Config C;
+	const double length = 1.3;
+	const int n_steps = 7;
+	C.set<std::string>("name", "test");
+	C.set<double>("L", length);
+	C.set<double>("N", n_steps);
+
+	auto kick = tse::FieldKick(C);
+	auto& delegator = dynamic_cast<const tse::FieldKickForthOrder<tsc::StandardDoubleType>&>(kick.getFieldKickDelegator());
+
+	auto check = [&delegator](const tse::FieldKickStepConstants& steps, const double dL){
+		double dL1, dL2, dkL1, dkL2;
+		delegator.splitIntegrationStep(dL, &dL1, &dL2, &dkL1, &dkL2);
+		/* identical to computing them on the fly */
+		BOOST_CHECK_EQUAL(steps.dL1,  dL1);
+		BOOST_CHECK_EQUAL(steps.dL2,  dL2);
+		BOOST_CHECK_EQUAL(steps.dkL1, dkL1);
+		BOOST_CHECK_EQUAL(steps.dkL2, dkL2);
+	};
+
+	check(delegator.getStepConstants(false), length / n_steps);
+	check(delegator.getStepConstants(true),  length / n_steps);
+
+	auto kick_lengths = delegator.getKickLength();
+	BOOST_CHECK_EQUAL(kick_lengths->at(0), delegator.getStepConstants(false).dkL1);
+	BOOST_CHECK_EQUAL(kick_lengths->at(1), delegator.getStepConstants(false).dkL2);
+	auto drift_lengths = delegator.getDriftLength();
+	BOOST_CHECK_EQUAL(drift_lengths->at(0), delegator.getStepConstants(false).dL1);
+	BOOST_CHECK_EQUAL(drift_lengths->at(1), delegator.getStepConstants(false).dL2);
+
+	/* updated on parameter change */
+	const double new_length = 0.7, irho = 0.25;
+	const int new_n_steps = 5;
+	kick.setNumberOfIntegrationSteps(new_n_steps);
+	kick.setLength(new_length);
+	kick.setCurvature(irho);
+	check(delegator.getStepConstants(false), new_length / new_n_steps);
+	/* Cartesian: along the chord */
+	check(delegator.getStepConstants(true), 2e0 / irho * sin(new_length * irho / 2e0) / new_n_steps);
+}
+
+BOOST_AUTO_TEST_CASE(test22_edge_constants)
+{
+	Config C;
+	C.set<std::string>("name", "test");
+	C.set<double>("L", 1.0);
+	C.set<double>("N", 1);
+
+	auto kick = tse::FieldKick(C);
+	const double irho = 0.2, T1 = 3e0, T2 = -5e0, gap = 0.04;
+	kick.setCurvature(irho);
+	kick.setEntranceAngle(T1);
+	kick.setExitAngle(T2);
+	kick.setGap(gap);
+
+	auto check = [irho, gap](const tse::FieldKickEdgeConstants& edge, const double phi){
+		BOOST_CHECK_EQUAL(edge.irho_tan_phi, irho*tan(tse::degtorad(phi)));
+		BOOST_CHECK_EQUAL(edge.irho_tan_phi_psi, irho*tan(tse::degtorad(phi)-tse::get_psi(irho, phi, gap)));
+		BOOST_CHECK_EQUAL(edge.cos_phi, cos(tse::degtorad(phi)));
+		BOOST_CHECK_EQUAL(edge.sin_phi, sin(tse::degtorad(phi)));
+		BOOST_CHECK_EQUAL(edge.tan_phi, tan(tse::degtorad(phi)));
+	};
+	check(kick.getEntranceEdgeConstants(), T1);
+	check(kick.getExitEdgeConstants(), T2);
+
+	/* survives move */
+	auto kick2 = std::move(kick);
+	check(kick2.getEntranceEdgeConstants(), T1);
+	check(kick2.getExitEdgeConstants(), T2);
+}
+
 /*
  * Local Variables:
  * mode: c++
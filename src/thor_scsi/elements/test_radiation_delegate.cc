@@ -5,8 +5,10 @@
 #include <thor_scsi/elements/radiation_delegate.h>
 #include <thor_scsi/elements/field_kick.h>
 #include <thor_scsi/elements/marker.h>
+#include <thor_scsi/core/exceptions.h>
 #include <cmath>
 
+namespace ts = thor_scsi;
 namespace tsc = thor_scsi::core;
 namespace tse = thor_scsi::elements;
 
@@ -119,3 +121,107 @@ BOOST_AUTO_TEST_CASE(test31_rad_del_tps_identity)
 	std::cout<< tps << std::endl;
 
 }
+
+BOOST_AUTO_TEST_CASE(test40_rad_del_kick_radiate)
+{
+	const double energy = 3e9, L = 0.5, By = 1.2;
+	auto rad_del = tse::RadiationDelegateKick();
+	rad_del.setEnergy(energy);
+
+	tsc::ConfigType calc_config;
+	const std::array<double, 3> B = {0e0, By, 0e0};
+
+	/* radiation off: untouched */
+	gtpsa::ss_vect<double> ps(0e0);
+	ps.set_zero();
+	rad_del.radiate(calc_config, ps, L, 0e0, B);
+	for(int i = 0; i < 6; ++i){
+		BOOST_CHECK_EQUAL(ps[i], 0e0);
+	}
+
+	/* on axis: energy loss C_gamma E^3 B^2 L / (2 pi) */
+	calc_config.radiation = true;
+	rad_del.radiate(calc_config, ps, L, 0e0, B);
+	const double d_delta = tse::C_gamma * std::pow(energy, 3) * By * By * L / (2e0 * M_PI);
+	BOOST_CHECK_CLOSE(ps[delta_], -d_delta, 1e-10);
+	BOOST_CHECK_SMALL(ps[px_], 1e-20);
+
+	/* transverse slopes x' = px / p_s kept */
+	ps.set_zero();
+	ps[px_] = 1e-3;
+	ps[delta_] = 1e-2;
+	const double xp = ps[px_] / (1e0 + ps[delta_]);
+	rad_del.radiate(calc_config, ps, L, 0e0, B);
+	BOOST_CHECK_CLOSE(ps[px_] / (1e0 + ps[delta_]), xp, 1e-10);
+
+	/* same result for the constant part of the truncated power series */
+	gtpsa::ss_vect<gtpsa::tpsa> tps(tpsa_ref);
+	tps.set_identity();
+	tps[px_] += 1e-3;
+	tps[delta_] += 1e-2;
+	std::array<gtpsa::tpsa, 3> Bt = {tpsa_ref.clone(), tpsa_ref.clone(), tpsa_ref.clone()};
+	Bt[X_].set(0, 0e0);
+	Bt[Y_].set(0, By);
+	Bt[Z_].set(0, 0e0);
+	rad_del.radiate(calc_config, tps, L, 0e0, Bt);
+	const auto cst = tps.cst();
+	BOOST_CHECK_CLOSE(cst[delta_], ps[delta_], 1e-10);
+	BOOST_CHECK_CLOSE(cst[px_], ps[px_], 1e-10);
+
+	/* non finite phase space reported */
+	ps.set_zero();
+	ps[x_] = NAN;
+	BOOST_CHECK_THROW(rad_del.radiate(calc_config, ps, L, 0e0, B), ts::PhysicsViolation);
+	ps.set_zero();
+	ps[ct_] = NAN;
+	BOOST_CHECK_THROW(rad_del.radiate(calc_config, ps, L, 0e0, B), ts::PhysicsViolation);
+	ps.set_zero();
+	ps[py_] = INFINITY;
+	BOOST_CHECK_THROW(rad_del.radiate(calc_config, ps, L, 0e0, B), ts::PhysicsViolation);
+}
+
+BOOST_AUTO_TEST_CASE(test41_rad_del_kick_quantum_excitation)
+{
+	const double energy = 3e9, L = 0.5, By = 1.2;
+	auto rad_del = tse::RadiationDelegateKick();
+	rad_del.setEnergy(energy);
+
+	tsc::ConfigType calc_config;
+	calc_config.radiation = true;
+	const std::array<double, 3> B = {0e0, By, 0e0};
+
+	gtpsa::ss_vect<double> ps(0e0);
+	ps.set_zero();
+	rad_del.radiate(calc_config, ps, L, 0e0, B);
+	const double delta_mean = ps[delta_];
+
+	calc_config.quantum_excitation = true;
+	auto kick = [&](const uint32_t particle_id){
+		calc_config.particle_id = particle_id;
+		calc_config.qe_element = 3;
+		calc_config.qe_kick = 0;
+		ps.set_zero();
+		rad_del.radiate(calc_config, ps, L, 0e0, B);
+		return ps[delta_] - delta_mean;
+	};
+
+	/* reproducible: same key and counter, same kick */
+	const double d0 = kick(0);
+	BOOST_CHECK_EQUAL(kick(0), d0);
+	BOOST_CHECK_NE(kick(1), d0);
+	calc_config.turn = 1;
+	BOOST_CHECK_NE(kick(0), d0);
+
+	/* Gaussian of variance q_fluct |B|^3 ds */
+	const double q_fluct = tse::C_q * tse::C_gamma / (M_PI * tse::m_e * tse::m_e) * std::pow(energy, 5);
+	const double sigma = std::sqrt(q_fluct * std::pow(By, 3) * L);
+	const int n = 20000;
+	double sum = 0e0, sum2 = 0e0;
+	for(int i = 0; i < n; ++i){
+		const double d = kick(i) / sigma;
+		sum += d;
+		sum2 += d * d;
+	}
+	BOOST_CHECK_SMALL(sum / n, 5e0 / std::sqrt(double(n)));
+	BOOST_CHECK_CLOSE(sum2 / n, 1e0, 5e0);
+}
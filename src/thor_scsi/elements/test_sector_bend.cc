@@ -6,6 +6,8 @@
 #include <thor_scsi/core/field_interpolation.h>
 #include <thor_scsi/core/multipoles.h>
 #include <thor_scsi/elements/bending.h>
+#include <thor_scsi/elements/element_helpers.h>
+#include <thor_scsi/elements/utils.h>
 #include "check_multipole.h"
 #include <tps/enums.h>
 #include <ostream>
@@ -472,3 +474,97 @@ BOOST_AUTO_TEST_CASE(test30_bend_config)
 	}
 
 }
+
+/*
+ * Reference implementation of the local propagation as it was done before
+ * the geometric constants were precomputed: step lengths and edge terms
+ * are computed on every pass. Polar coordinates only, no radiation.
+ */
+template<typename T>
+static void reference_local_propagate(tsc::ConfigType& conf, tse::BendingType& bend, gtpsa::ss_vect<T>& ps)
+{
+	const double irho = bend.getCurvature(), length = bend.getLength(), gap = bend.getGap();
+	const int PN = bend.getNumberOfIntegrationSteps();
+	const auto& delegator = bend.getFieldKickDelegator();
+	auto& integ4O = dynamic_cast<const tse::FieldKickForthOrder<tsc::StandardDoubleType>&>(delegator);
+	auto intp = bend.getFieldInterpolator();
+
+	auto kick = [&conf, &intp, irho](const double L, gtpsa::ss_vect<T>& ps){
+		const gtpsa::ss_vect<T> ps0 = ps.clone();
+		T BxoBrho = gtpsa::same_as_instance(ps[0]), ByoBrho = gtpsa::same_as_instance(ps[2]);
+		intp->field(ps[x_], ps[y_], &BxoBrho, &ByoBrho);
+		tse::thin_kick(conf, BxoBrho, ByoBrho, L, irho, irho, ps0, ps);
+	};
+
+	auto edge = [&conf, irho, gap](const double phi, gtpsa::ss_vect<T>& ps){
+		ps[px_] += irho*tan(tse::degtorad(phi))*ps[x_];
+		BOOST_REQUIRE(conf.dip_edge_fudge);
+		ps[py_] -= irho*tan(tse::degtorad(phi)-tse::get_psi(irho, phi, gap))*ps[y_];
+	};
+
+	double dL1, dL2, dkL1, dkL2;
+	integ4O.splitIntegrationStep(length/PN, &dL1, &dL2, &dkL1, &dkL2);
+
+	edge(bend.getEntranceAngle(), ps);
+	for(int seg = 1; seg <= PN; ++seg){
+		tse::drift_propagate(conf, dL1, ps);
+		kick(dkL1, ps);
+		tse::drift_propagate(conf, dL2, ps);
+		kick(dkL2, ps);
+		tse::drift_propagate(conf, dL2, ps);
+		kick(dkL1, ps);
+		tse::drift_propagate(conf, dL1, ps);
+	}
+	edge(bend.getExitAngle(), ps);
+}
+
+BOOST_AUTO_TEST_CASE(test40_bend_precomputed_constants_bit_identical)
+{
+	tsc::ConfigType calc_config;
+	Config C;
+	const double length = 1.1e0, b2 = -1.2e0, phi = 20e0, T1=5e0, T2=7e0;
+	C.set<std::string>("name", "test");
+	C.set<double>("K",  b2);
+	C.set<double>("L",  length);
+	C.set<double>("T",  phi);
+	C.set<double>("T1", T1);
+	C.set<double>("T2", T2);
+	C.set<double>("N", 7);
+
+	auto bend = tse::BendingType(C);
+	bend.setGap(0.05);
+
+	const gtpsa::ss_vect<double> ps_orig = {1e-3, -2e-4, 3e-4, 1e-4, 2e-3, 0e0};
+
+	auto check = [&](void){
+		gtpsa::ss_vect<double> ps = ps_orig.clone(), ps_ref = ps_orig.clone();
+		bend.localPropagate(calc_config, ps);
+		reference_local_propagate(calc_config, bend, ps_ref);
+		for(int i=0; i<6; ++i){
+			/* bit identical: not only close */
+			BOOST_CHECK_EQUAL(ps[i], ps_ref[i]);
+		}
+
+		gtpsa::ss_vect<gtpsa::tpsa> tps(tpsa_ref);
+		tps.set_identity();
+		gtpsa::ss_vect<gtpsa::tpsa> tps_ref = tps.clone();
+		bend.localPropagate(calc_config, tps);
+		reference_local_propagate(calc_config, bend, tps_ref);
+		const arma::mat jac = tps.jacobian(), jac_ref = tps_ref.jacobian();
+		BOOST_CHECK_EQUAL(arma::accu(arma::abs(jac - jac_ref)), 0e0);
+		for(int i=0; i<6; ++i){
+			BOOST_CHECK_EQUAL(gtpsa::cst(tps[i]), gtpsa::cst(tps_ref[i]));
+		}
+	};
+
+	check();
+
+	/* constants follow parameter changes */
+	bend.setNumberOfIntegrationSteps(11);
+	bend.setLength(0.9);
+	bend.setCurvature(tse::degtorad(phi) / 0.9);
+	bend.setEntranceAngle(3e0);
+	bend.setExitAngle(-2e0);
+	bend.setGap(0.03);
+	check();
+}
@@ -2,6 +2,8 @@
 #include <thor_scsi/elements/standard_aperture.h>
 #include <thor_scsi/elements/elements_enums.h>
 #include <thor_scsi/elements/marker.h>
+#include <thor_scsi/elements/drift.h>
+#include <thor_scsi/elements/element_local_coordinates.h>
 #include <thor_scsi/core/exceptions.h>
 #include <sstream>
 #include <thor_scsi/core/multipole_types.h>
@@ -96,6 +98,71 @@ void ts::AcceleratorKnobbable<C>::addMarkerAtStartIfRequired(void)
     this->addMarkerAtStart();
 }
 
+/*
+ * Girders: consecutive elements mounted on the same girder are propagated
+ * in the coordinates of the girder. The girder transform is then applied
+ * once entering and once leaving such a run, instead of composing it
+ * into each element's transform.
+ *
+ * Observers and apertures expect global coordinates: elements using them
+ * terminate a run.
+ */
+template<class C>
+static std::shared_ptr<tse::LocalCoordinatesKnobbed<C>>
+element_on_girder(const std::shared_ptr<tsc::ElemTypeKnobbed>& elem)
+{
+	if(elem->observer() || elem->getAperture()){
+		return nullptr;
+	}
+	auto local = std::dynamic_pointer_cast<tse::LocalCoordinatesKnobbed<C>>(elem);
+	if(!local || !local->getGirder()){
+		return nullptr;
+	}
+	return local;
+}
+
+/*
+ * drifts commute with the transverse girder transform (a translation and
+ * a rotation around the longitudinal axis): they can be passed in girder
+ * coordinates
+ */
+template<class C>
+static bool
+is_plain_drift(const std::shared_ptr<tsc::ElemTypeKnobbed>& elem)
+{
+	if(elem->observer() || elem->getAperture()){
+		return false;
+	}
+	return dynamic_cast<const tse::DriftTypeWithKnob<C>*>(elem.get()) != nullptr;
+}
+
+/*
+ * true if the girder is used again by an element following (or preceeding
+ * when retreating) with only drifts in between
+ */
+template<class C>
+static bool
+girder_continues(const tsc::Machine& machine, const std::shared_ptr<tsc::GirderKnobbed<C>>& girder,
+		 int next_elem, const bool retreat)
+{
+	const int nelem = static_cast<int>(machine.size());
+	const int step = retreat ? -1 : 1;
+	for(int n = next_elem; n >= 0 && n < nelem; n += step){
+		auto elem = std::dynamic_pointer_cast<tsc::ElemTypeKnobbed>(machine.at(n));
+		if(!elem){
+			return false;
+		}
+		auto local = element_on_girder<C>(elem);
+		if(local){
+			return local->getGirder() == girder;
+		}
+		if(!is_plain_drift<C>(elem)){
+			return false;
+		}
+	}
+	return false;
+}
+
 template<class C>
 template<typename T>
 int
@@ -121,6 +188,15 @@ ts::AcceleratorKnobbable<C>::_propagate(thor_scsi::core::ConfigType& conf, gtpsa
 	int next_elem = static_cast<int>(start_elem);
 	auto trace = this->trace();
 
+	/* girder whose coordinates ps is currently given in */
+	std::shared_ptr<tsc::GirderKnobbed<C>> on_girder;
+	auto leave_girder = [&on_girder, &ps](){
+		if(on_girder){
+			on_girder->backward(ps);
+			on_girder.reset();
+		}
+	};
+
 
 	for(size_t turn=0; turn<n_turns; ++turn) {
 	    if(trace)
@@ -128,6 +204,7 @@ ts::AcceleratorKnobbable<C>::_propagate(thor_scsi::core::ConfigType& conf, gtpsa
 			 << " for a maximum of elements " << max_elements << std::endl;
 
 	    next_elem = static_cast<int>(start_elem);
+	    int n_passed = 0;
 	    for(int i=0; next_elem >= 0 && next_elem<nelem && i<std::abs(max_elements); i++)
 	    {
 		size_t n = next_elem;
@@ -139,6 +216,7 @@ ts::AcceleratorKnobbable<C>::_propagate(thor_scsi::core::ConfigType& conf, gtpsa
 		    THOR_SCSI_LOG(ERROR)
 			<< "Failed to cast to element to ElemtypeKnobbed " << cv->name << "\n";
 		    std::runtime_error("Could not cast cell void to elemtype");
+		    leave_girder();
 		    return next_elem;
 		}
 		if(retreat) {
@@ -146,11 +224,37 @@ ts::AcceleratorKnobbable<C>::_propagate(thor_scsi::core::ConfigType& conf, gtpsa
 		} else {
 		    next_elem++;
 		}
+
+		/*
+		 * stay in girder coordinates for elements on the same girder
+		 * and plain drifts, enter them if the girder is used again
+		 */
+		auto local = element_on_girder<C>(elem);
+		const bool same_girder = on_girder && local && local->getGirder() == on_girder;
+		if(on_girder && !same_girder && !(!local && is_plain_drift<C>(elem))){
+			leave_girder();
+		}
+		if(!on_girder && local && girder_continues<C>(*this, local->getGirder(), next_elem, retreat)){
+			on_girder = local->getGirder();
+			on_girder->forward(ps);
+		}
+
 		std::shared_ptr<tsc::Observer> observer = elem->observer();
 		if(observer){
 			observer->view(std::const_pointer_cast<tsc::ElemTypeKnobbed/*<C>*/>(elem), ps, tsc::ObservedState::start, 0);
 		}
-		elem->propagate(conf, ps);
+		try {
+			if(on_girder && local){
+				local->propagateOnGirder(conf, ps);
+			} else {
+				/* drifts are passed in girder coordinates too */
+				elem->propagate(conf, ps);
+			}
+		} catch(...) {
+			/* leave ps in global coordinates */
+			leave_girder();
+			throw;
+		}
 		if(observer){
 			observer->view(elem, ps, tsc::ObservedState::end, 0);
 		}
@@ -173,11 +277,19 @@ ts::AcceleratorKnobbable<C>::_propagate(thor_scsi::core::ConfigType& conf, gtpsa
 						throw ts::SanityCheckError("Particle lost but no loss plane identified!");
 					}
 				}
+				leave_girder();
 				return next_elem;
 			}
 		}
 		if(trace)
-			(*trace) << "After ["<< n<< "] " << cv->name << " " <<std::endl << ps << std::endl;
+			(*trace) << "After ["<< n<< "] " << cv->name << (on_girder ? " (girder coordinates)" : "")
+				 << " " <<std::endl << ps << std::endl;
+		++n_passed;
+	    }
+	    leave_girder();
+	    /* next turn: new random numbers for quantum excitation */
+	    if(n_passed == nelem){
+		    ++conf.turn;
 	    }
 	}
 	return next_elem;
@@ -66,6 +66,12 @@ namespace thor_scsi {
 		 *
 		 * @returns last element passed (check config type for lost plane)
 		 *
+		 * conf.turn is incremented after each turn completed, i.e.
+		 * all elements passed. Partial propagations (start, max)
+		 * leave it unchanged. It is part of the counter of the
+		 * quantum excitation random numbers: reset it when
+		 * restarting tracking.
+		 *
 		 * @throws std::exception sub-classes for various errors.
 		 *         If an exception is thrown then the state of S is undefined.
 		 *
@@ -0,0 +1,57 @@
+#include <thor_scsi/std_machine/beam_parameters.h>
+#include <thor_scsi/elements/constants.h>
+#include <tps/enums.h>
+#include <sstream>
+#include <stdexcept>
+
+namespace ts = thor_scsi;
+namespace tse = thor_scsi::elements;
+
+void ts::LatticeFunctions::check(void) const
+{
+	const size_t n = this->size();
+	for(int k = 0; k < 2; ++k){
+		if(this->alpha[k].size() != n || this->beta[k].size() != n
+		   || this->eta[k].size() != n || this->etap[k].size() != n){
+			std::stringstream strm;
+			strm << "lattice functions: plane " << k << " does not provide "
+			     << n << " values for alpha, beta, eta and etap";
+			throw std::invalid_argument(strm.str());
+		}
+		for(size_t i = 0; i < n; ++i){
+			if(!(this->beta[k][i] > 0e0)){
+				std::stringstream strm;
+				strm << "lattice functions: beta of plane " << k << " at " << i
+				     << " not positive: " << this->beta[k][i];
+				throw std::invalid_argument(strm.str());
+			}
+		}
+	}
+}
+
+void ts::BeamParameters::check(void) const
+{
+	const double values[] = {
+		this->energy, this->eps[X_], this->eps[Y_], this->sigma_delta, this->sigma_s
+	};
+	const char *names[] = {"energy", "eps_x", "eps_y", "sigma_delta", "sigma_s"};
+	for(size_t i = 0; i < 5; ++i){
+		if(!(values[i] > 0e0) || !std::isfinite(values[i])){
+			std::stringstream strm;
+			strm << "beam parameters: " << names[i] << " has to be positive and finite but is " << values[i];
+			throw std::invalid_argument(strm.str());
+		}
+	}
+	if(this->energy <= tse::m_e){
+		throw std::invalid_argument("beam parameters: energy has to be larger than the rest mass");
+	}
+	if(!(this->n_particles >= 0e0)){
+		throw std::invalid_argument("beam parameters: number of particles negative");
+	}
+}
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -0,0 +1,64 @@
+#ifndef _THOR_SCSI_STD_MACHINE_BEAM_PARAMETERS_H_
+#define _THOR_SCSI_STD_MACHINE_BEAM_PARAMETERS_H_
+
+#include <array>
+#include <cmath>
+#include <vector>
+
+namespace thor_scsi {
+
+	/**
+	 * @brief lattice functions at a set of positions around the ring
+	 *
+	 * Plane indices X_, Y_. Each position is weighted by its length
+	 * when averaging around the ring; typically the Twiss parameters
+	 * at the exit of each element together with the element length.
+	 * Used by the intrabeam scattering and Touschek calculations.
+	 */
+	struct LatticeFunctions {
+		std::vector<double> length;
+		std::array<std::vector<double>, 2> alpha, beta, eta, etap;
+
+		inline size_t size(void) const { return this->length.size(); }
+
+		/// @throws std::invalid_argument if the sizes differ or a beta is not positive
+		void check(void) const;
+
+		/// curly H of plane k at position i
+		inline double curlyH(const int k, const size_t i) const {
+			const double alpha = this->alpha[k][i], beta = this->beta[k][i];
+			const double eta = this->eta[k][i], etap = this->etap[k][i];
+			const double gamma = (1e0 + alpha * alpha) / beta;
+			return gamma * eta * eta + 2e0 * alpha * eta * etap + beta * etap * etap;
+		}
+	};
+
+	/**
+	 * @brief bunch parameters
+	 *
+	 * Emittances are (geometric) rms emittances.
+	 */
+	struct BeamParameters {
+		/// total energy [eV]
+		double energy = NAN;
+		/// number of particles in the bunch
+		double n_particles = 0e0;
+		std::array<double, 2> eps = {NAN, NAN};
+		double sigma_delta = NAN;
+		/// rms bunch length [m]
+		double sigma_s = NAN;
+		/// Coulomb logarithm, typically 10 to 20; only used for intrabeam scattering
+		double coulomb_log = NAN;
+
+		/// @throws std::invalid_argument if a parameter (but coulomb_log) is not positive
+		void check(void) const;
+	};
+
+} // namespace thor_scsi
+#endif /* _THOR_SCSI_STD_MACHINE_BEAM_PARAMETERS_H_ */
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
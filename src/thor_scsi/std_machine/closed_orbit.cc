@@ -0,0 +1,237 @@
+#include <thor_scsi/std_machine/closed_orbit.h>
+#include <thor_scsi/std_machine/dynamic_aperture.h>
+#include <thor_scsi/core/parallel.h>
+#include <thor_scsi/core/exceptions.h>
+#include <tps/enums.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+namespace ts = thor_scsi;
+namespace tsc = thor_scsi::core;
+
+static void check_options(const ts::ClosedOrbitOptions& options)
+{
+	if(!(options.eps > 0e0)){
+		std::stringstream strm;
+		strm << "closed orbit: require eps (" << options.eps << ") > 0";
+		throw std::invalid_argument(strm.str());
+	}
+}
+
+namespace {
+	/*
+	 * Newton search for the fix point of the one turn map. The buffers
+	 * are allocated once and reused by all iterations and searches.
+	 * Each search owns its TPSA descriptor: construct it in the calling
+	 * thread, then it can be used in a thread of its own.
+	 */
+	template<class C>
+	class ClosedOrbitSearch {
+	public:
+		ClosedOrbitSearch(ts::AcceleratorKnobbable<C>& acc, const ts::ClosedOrbitOptions& options)
+			: m_acc(acc)
+			, m_options(options)
+			, m_n_elements(static_cast<int>(acc.size()))
+			, m_ps(0e0)
+			, m_desc(std::make_shared<gtpsa::desc>(ps_dim, 1))
+			, m_map(m_desc, 1)
+			, m_x(ps_dim)
+			, m_x1(ps_dim)
+			, m_dx(ps_dim)
+			, m_jac(ps_dim, ps_dim)
+			{}
+
+		ts::ClosedOrbitResult search(tsc::ConfigType& conf, const gtpsa::ss_vect<double>& x0)
+		{
+			ts::ClosedOrbitResult result;
+			/* 6D with the cavity on, else transverse only */
+			const arma::uword n = conf.Cavity_on ? 6 : 4;
+			const arma::span sel(0, n - 1);
+
+			for(int k = 0; k < ps_dim; ++k){
+				this->m_x(k) = x0[k];
+			}
+			conf.dPparticle = this->m_x(delta_);
+
+			for(result.n_iter = 0; result.n_iter <= this->m_options.max_iter; ++result.n_iter){
+				if(!this->one_turn(conf, this->m_x, this->m_x1)){
+					result.lost = true;
+					break;
+				}
+				this->m_dx = this->m_x - this->m_x1;
+				result.dx_abs = arma::norm(this->m_dx(sel));
+				if(result.dx_abs < this->m_options.eps){
+					result.found = true;
+					break;
+				}
+				if(result.n_iter == this->m_options.max_iter){
+					break;
+				}
+				if(!this->jacobian(conf)){
+					result.lost = true;
+					break;
+				}
+				/* partial inverse: only the selected block of M - 1 */
+				for(arma::uword k = 0; k < n; ++k){
+					this->m_jac(k, k) -= 1e0;
+				}
+				if(!arma::solve(this->m_step, this->m_jac(sel, sel), this->m_dx(sel))){
+					break;
+				}
+				this->m_x(sel) += this->m_step;
+				/* energy dependent elements follow the momentum offset searched */
+				conf.dPparticle = this->m_x(delta_);
+			}
+
+			if(result.found && !this->jacobian(conf)){
+				result.found = false;
+				result.lost = true;
+			}
+			if(result.found){
+				result.one_turn_map = this->m_jac;
+			}
+			for(int k = 0; k < ps_dim; ++k){
+				result.x0[k] = this->m_x(k);
+			}
+			return result;
+		}
+
+	private:
+		/* x1: x propagated one turn; false if lost */
+		bool one_turn(tsc::ConfigType& conf, const arma::vec& x, arma::vec& x1)
+		{
+			for(int k = 0; k < ps_dim; ++k){
+				this->m_ps[k] = x(k);
+			}
+			if(ts::propagate_lost(this->m_acc, conf, this->m_ps, 0, this->m_n_elements)){
+				return false;
+			}
+			for(int k = 0; k < ps_dim; ++k){
+				x1(k) = this->m_ps[k];
+			}
+			return true;
+		}
+
+		/* one turn Jacobian at m_x: one pass of an order 1 map; false if lost */
+		bool jacobian(tsc::ConfigType& conf)
+		{
+			this->m_map.set_identity();
+			for(int k = 0; k < ps_dim; ++k){
+				this->m_map[k] += this->m_x(k);
+			}
+			int last = -1;
+			try {
+				last = this->m_acc.propagate(conf, this->m_map);
+			} catch(const ts::PhysicsViolation&) {
+				return false;
+			}
+			if(last != this->m_n_elements){
+				return false;
+			}
+			this->m_jac = this->m_map.jacobian().submat(0, 0, ps_dim - 1, ps_dim - 1);
+			return this->m_jac.is_finite();
+		}
+
+		ts::AcceleratorKnobbable<C>& m_acc;
+		const ts::ClosedOrbitOptions& m_options;
+		const int m_n_elements;
+		gtpsa::ss_vect<double> m_ps;
+		std::shared_ptr<gtpsa::desc> m_desc;
+		gtpsa::ss_vect<gtpsa::tpsa> m_map;
+		arma::vec m_x, m_x1, m_dx, m_step;
+		arma::mat m_jac;
+	};
+} // namespace
+
+template<class C>
+ts::ClosedOrbitResult ts::find_closed_orbit(ts::AcceleratorKnobbable<C>& acc, tsc::ConfigType& conf,
+					    const gtpsa::ss_vect<double>& x0,
+					    const ts::ClosedOrbitOptions& options)
+{
+	check_options(options);
+	for(int k = 0; k < ps_dim; ++k){
+		if(!std::isfinite(x0[k])){
+			throw std::invalid_argument("closed orbit: start x0 not finite");
+		}
+	}
+
+	ClosedOrbitSearch<C> search(acc, options);
+	auto result = search.search(conf, x0);
+	if(result.found){
+		/* observers record the orbit */
+		gtpsa::ss_vect<double> ps = result.x0.clone();
+		acc.propagate(conf, ps);
+	}
+	return result;
+}
+
+template<class C>
+std::vector<ts::ClosedOrbitResult> ts::find_closed_orbits(ts::AcceleratorKnobbable<C>& acc,
+							  const tsc::ConfigType& conf,
+							  const std::vector<double>& deltas,
+							  const ts::ClosedOrbitOptions& options)
+{
+	check_options(options);
+	if(conf.Cavity_on){
+		throw std::invalid_argument("closed orbits: momentum offsets given but cavities on,"
+					    " thus delta would be searched too");
+	}
+	for(const auto delta : deltas){
+		if(!std::isfinite(delta)){
+			throw std::invalid_argument("closed orbit: momentum offset not finite");
+		}
+	}
+	std::vector<ClosedOrbitResult> result(deltas.size());
+	if(deltas.empty()){
+		return result;
+	}
+
+	tsc::ConfigType conf_track = conf;
+	const size_t n_threads = ts::prepare_parallel_tracking(acc, conf_track, options.n_threads);
+
+	/* one search workspace per thread, created here: creating TPSA descriptors is not thread safe */
+	const size_t n = deltas.size();
+	const size_t n_thr = tsc::number_of_threads(n_threads, n);
+	const size_t chunk = n / n_thr, rest = n % n_thr;
+	std::vector<std::unique_ptr<ClosedOrbitSearch<C>>> searches;
+	for(size_t t = 0; t < n_thr; ++t){
+		searches.push_back(std::make_unique<ClosedOrbitSearch<C>>(acc, options));
+	}
+	tsc::parallel_for(n_thr, n_thr, [&](const size_t t){
+		const size_t start = t * chunk + std::min(t, rest);
+		const size_t stop = start + chunk + (t < rest ? 1 : 0);
+		auto& search = *searches[t];
+		gtpsa::ss_vect<double> ps(0e0);
+		for(size_t i = start; i < stop; ++i){
+			auto conf_delta = conf_track;
+			ps.set_zero();
+			ps[delta_] = deltas[i];
+			result[i] = search.search(conf_delta, ps);
+		}
+	});
+	return result;
+}
+
+template ts::ClosedOrbitResult ts::find_closed_orbit(ts::AcceleratorKnobbable<tsc::StandardDoubleType>& acc,
+						     tsc::ConfigType& conf, const gtpsa::ss_vect<double>& x0,
+						     const ts::ClosedOrbitOptions& options);
+template ts::ClosedOrbitResult ts::find_closed_orbit(ts::AcceleratorKnobbable<tsc::TpsaVariantType>& acc,
+						     tsc::ConfigType& conf, const gtpsa::ss_vect<double>& x0,
+						     const ts::ClosedOrbitOptions& options);
+template std::vector<ts::ClosedOrbitResult> ts::find_closed_orbits(ts::AcceleratorKnobbable<tsc::StandardDoubleType>& acc,
+								   const tsc::ConfigType& conf,
+								   const std::vector<double>& deltas,
+								   const ts::ClosedOrbitOptions& options);
+template std::vector<ts::ClosedOrbitResult> ts::find_closed_orbits(ts::AcceleratorKnobbable<tsc::TpsaVariantType>& acc,
+								   const tsc::ConfigType& conf,
+								   const std::vector<double>& deltas,
+								   const ts::ClosedOrbitOptions& options);
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -0,0 +1,100 @@
+#ifndef _THOR_SCSI_STD_MACHINE_CLOSED_ORBIT_H_
+#define _THOR_SCSI_STD_MACHINE_CLOSED_ORBIT_H_
+
+#include <thor_scsi/std_machine/accelerator.h>
+#include <thor_scsi/core/config.h>
+#include <gtpsa/ss_vect.h>
+#include <armadillo>
+#include <cmath>
+#include <vector>
+
+namespace thor_scsi {
+
+	/**
+	 * @brief parameters of the closed orbit search
+	 */
+	struct ClosedOrbitOptions {
+		/// Newton iterations at most
+		int max_iter = 10;
+		/// required |x1 - x0| over the coordinates searched
+		double eps = 1e-10;
+		/// 0: hardware concurrency
+		size_t n_threads = 0;
+	};
+
+	/**
+	 * @brief fix point of the one turn map
+	 */
+	struct ClosedOrbitResult {
+		bool found = false;
+		/// start of the closed orbit (last iterate if not found)
+		gtpsa::ss_vect<double> x0 = gtpsa::ss_vect<double>(0e0);
+		/// 6x6 Jacobian of the one turn map around x0 (zero if not found)
+		arma::mat one_turn_map = arma::mat(6, 6, arma::fill::zeros);
+		/// the particle was lost during the search
+		bool lost = false;
+		int n_iter = 0;
+		/// |x1 - x0| of the last iteration
+		double dx_abs = NAN;
+	};
+
+	/**
+	 * @brief searches the closed orbit by Newton iteration
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * Follows :func:`thor_scsi.utils.closed_orbit.compute_closed_orbit`:
+	 * with conf.Cavity_on the orbit is searched in 6D, otherwise
+	 * in the transverse coordinates (4D) at the momentum offset
+	 * x0[delta]. The step solves the selected block of
+	 * :math:`(M - 1)\,\Delta x = x_0 - x_1` (the partial inverse);
+	 * the coordinates not searched are left unchanged.
+	 *
+	 * x1 is obtained by tracking a particle, the Jacobian M by
+	 * propagating an order 1 TPSA map around x once per iteration;
+	 * thus the returned one turn map is exact up to round off. The
+	 * buffers and the TPSA descriptor are allocated once per search.
+	 *
+	 * conf.dPparticle is set to x0[delta] and, in 6D, follows the
+	 * momentum offset iterated. If the orbit is found it is
+	 * propagated once more with conf, so that observers record it.
+	 *
+	 * \endverbatim
+	 *
+	 * @throws std::invalid_argument for non positive eps or x0 not finite
+	 */
+	template<class C>
+	ClosedOrbitResult find_closed_orbit(AcceleratorKnobbable<C>& acc, thor_scsi::core::ConfigType& conf,
+					    const gtpsa::ss_vect<double>& x0,
+					    const ClosedOrbitOptions& options = ClosedOrbitOptions());
+
+	/**
+	 * @brief closed orbits for many momentum offsets, searched in parallel
+	 *
+	 * Each search starts on the axis at its momentum offset, with a
+	 * copy of conf and a TPSA descriptor of its own. It does not
+	 * install observers; the ones installed on the elements are
+	 * still called by the tracking, thus with observers installed
+	 * the searches run in a single thread.
+	 *
+	 * The searches are 4D: with conf.Cavity_on the momentum offset
+	 * would be searched too and all of them converge to the same
+	 * orbit.
+	 *
+	 * @throws std::invalid_argument for conf.Cavity_on, non positive
+	 *         eps or a momentum offset not finite
+	 */
+	template<class C>
+	std::vector<ClosedOrbitResult> find_closed_orbits(AcceleratorKnobbable<C>& acc,
+							  const thor_scsi::core::ConfigType& conf,
+							  const std::vector<double>& deltas,
+							  const ClosedOrbitOptions& options = ClosedOrbitOptions());
+
+} // namespace thor_scsi
+#endif /* _THOR_SCSI_STD_MACHINE_CLOSED_ORBIT_H_ */
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
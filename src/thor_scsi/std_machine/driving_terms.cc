@@ -0,0 +1,293 @@
+#include <thor_scsi/std_machine/driving_terms.h>
+#include <thor_scsi/std_machine/lie_poly.h>
+#include <thor_scsi/core/parallel.h>
+#include <tps/enums.h>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace ts = thor_scsi;
+namespace tsc = thor_scsi::core;
+namespace lp = thor_scsi::lie_poly;
+
+using lp::cplx;
+using lp::Poly;
+using lp::exponent;
+using lp::add_to;
+
+static const int max_multipole = 16;
+/* highest power of delta kept */
+static const lp::MaxDelta truncation{2};
+static const uint32_t one = 0, delta_key = lp::unit(lp::delta_var);
+
+static inline uint32_t pack(const unsigned i, const unsigned j, const unsigned k,
+			    const unsigned l, const unsigned m)
+{
+	const unsigned e[5] = {i, j, k, l, m};
+	uint32_t key = 0;
+	for(int v = 0; v < 5; ++v){
+		if(e[v] >= (1u << lp::n_bits)){
+			return UINT32_MAX;
+		}
+		key |= e[v] << (v * lp::n_bits);
+	}
+	return key;
+}
+
+static inline Poly multiply(const Poly& p, const Poly& q)
+{
+	return lp::multiply(p, q, truncation);
+}
+
+/* generator of a kick of unit strength b_n L = 1 */
+static Poly unit_generator(const int n, const ts::Twiss& twiss, const size_t i)
+{
+	Poly planes[2];
+	for(int k = 0; k < 2; ++k){
+		const size_t ik = ts::Twiss::index(i, k);
+		const cplx a = std::polar(std::sqrt(twiss.beta[ik]) / 2e0, 2e0 * M_PI * twiss.nu[ik]);
+		planes[k][lp::unit(2 * k)] = a;
+		planes[k][lp::unit(2 * k + 1)] = std::conj(a);
+	}
+	planes[X_][delta_key] = twiss.eta[ts::Twiss::index(i, X_)];
+
+	/* Re[z^n] = (z^n + conj(z)^n) / 2 */
+	Poly z_plus = planes[X_], z_minus = planes[X_];
+	add_to(z_plus, planes[Y_], cplx(0e0, 1e0));
+	add_to(z_minus, planes[Y_], cplx(0e0, -1e0));
+	Poly p_plus = {{one, 1e0}}, p_minus = {{one, 1e0}};
+	for(int k = 0; k < n; ++k){
+		p_plus = multiply(p_plus, z_plus);
+		p_minus = multiply(p_minus, z_minus);
+	}
+	Poly re;
+	add_to(re, p_plus, -1e0 / (2e0 * n));
+	add_to(re, p_minus, -1e0 / (2e0 * n));
+	/* the kick scales with 1 / (1 + delta) = 1 - delta + delta^2 - ... */
+	Poly g = multiply(re, {{one, 1e0}, {delta_key, -1e0}, {2 * delta_key, 1e0}});
+
+	/* constants do not drive anything */
+	for(auto it = g.begin(); it != g.end();){
+		if(exponent(it->first, 0) + exponent(it->first, 1) + exponent(it->first, 2)
+		   + exponent(it->first, 3) == 0 || it->second == 0e0){
+			it = g.erase(it);
+		} else {
+			++it;
+		}
+	}
+	return g;
+}
+
+ts::DrivingTerms::DrivingTerms(const ts::Twiss& twiss, const std::vector<ts::DrivingTermFamily>& families,
+			       const size_t n_threads)
+	: m_families(families)
+{
+	const size_t n_pos = twiss.size();
+	for(const auto *v : {&twiss.alpha, &twiss.beta, &twiss.nu, &twiss.eta, &twiss.etap}){
+		if(v->size() != 2 * n_pos){
+			throw std::invalid_argument("driving terms: twiss arrays do not match the number of positions");
+		}
+	}
+
+	/* kicks ordered along the ring */
+	const size_t n_fam = families.size();
+	std::vector<std::pair<size_t, size_t>> kicks;
+	for(size_t a = 0; a < n_fam; ++a){
+		const auto& fam = families[a];
+		if(fam.n < 2 || fam.n > max_multipole){
+			std::stringstream strm;
+			strm << "driving terms: family " << a << " " << fam.name << ": multipole number "
+			     << fam.n << " not in [2, " << max_multipole << "]";
+			throw std::invalid_argument(strm.str());
+		}
+		for(const auto i : fam.index){
+			if(i >= n_pos){
+				std::stringstream strm;
+				strm << "driving terms: family " << a << " " << fam.name << ": index " << i
+				     << " beyond the " << n_pos << " twiss positions";
+				throw std::invalid_argument(strm.str());
+			}
+			kicks.emplace_back(i, a);
+		}
+	}
+	std::stable_sort(kicks.begin(), kicks.end(),
+			 [](const auto& a, const auto& b){ return a.first < b.first; });
+
+	const size_t n_kicks = kicks.size();
+	const size_t n_thr = std::max<size_t>(tsc::number_of_threads(n_threads, n_kicks), 1);
+	const size_t chunk = n_kicks / n_thr, rest = n_kicks % n_thr;
+	auto chunk_start = [chunk, rest](const size_t t){ return t * chunk + std::min(t, rest); };
+
+	/* generators and their sums per chunk and family */
+	std::vector<Poly> generators(n_kicks);
+	std::vector<std::vector<Poly>> chunk_sums(n_thr, std::vector<Poly>(n_fam));
+	tsc::parallel_for(n_thr, n_thr, [&](const size_t t){
+		for(size_t j = chunk_start(t); j < chunk_start(t + 1); ++j){
+			generators[j] = unit_generator(families[kicks[j].second].n, twiss, kicks[j].first);
+			add_to(chunk_sums[t][kicks[j].second], generators[j]);
+		}
+	});
+
+	/*
+	 * cross terms sum_{i < j} [g_i, g_j] = sum_j [sum_{i < j} g_i, g_j]:
+	 * each chunk starts from the running sums of the chunks upstream
+	 */
+	std::vector<std::vector<Poly>> cross(n_thr, std::vector<Poly>(n_fam * n_fam));
+	tsc::parallel_for(n_thr, n_thr, [&](const size_t t){
+		std::vector<Poly> running(n_fam);
+		for(size_t u = 0; u < t; ++u){
+			for(size_t a = 0; a < n_fam; ++a){
+				add_to(running[a], chunk_sums[u][a]);
+			}
+		}
+		for(size_t j = chunk_start(t); j < chunk_start(t + 1); ++j){
+			const size_t b = kicks[j].second;
+			for(size_t a = 0; a < n_fam; ++a){
+				lp::add_bracket(cross[t][a * n_fam + b], running[a], generators[j], truncation);
+			}
+			add_to(running[b], generators[j]);
+		}
+	});
+
+	Poly first_total;
+	std::vector<Poly> first(n_fam), second(n_fam * n_fam);
+	for(size_t t = 0; t < n_thr; ++t){
+		for(size_t a = 0; a < n_fam; ++a){
+			add_to(first[a], chunk_sums[t][a]);
+		}
+		for(size_t ab = 0; ab < n_fam * n_fam; ++ab){
+			add_to(second[ab], cross[t][ab], 5e-1);
+		}
+	}
+
+	/* dense storage over the monomials driven */
+	for(const auto *polys : {&first, &second}){
+		for(const auto& p : *polys){
+			for(const auto& t : p){
+				this->m_position.emplace(t.first, 0);
+			}
+		}
+	}
+	for(auto& t : this->m_position){
+		t.second = this->m_keys.size();
+		this->m_keys.push_back(t.first);
+	}
+	auto dense = [this](const Poly& p){
+		std::vector<cplx> v(this->m_keys.size(), 0e0);
+		for(const auto& t : p){
+			v[this->m_position.at(t.first)] = t.second;
+		}
+		return v;
+	};
+	for(const auto& p : first){
+		this->m_first_unit.push_back(dense(p));
+	}
+	for(const auto& p : second){
+		this->m_second_unit.push_back(dense(p));
+	}
+
+	std::vector<double> strengths;
+	for(const auto& fam : families){
+		strengths.push_back(fam.strength);
+	}
+	this->setStrengths(strengths);
+}
+
+void ts::DrivingTerms::setStrengths(const std::vector<double>& strengths)
+{
+	const size_t n_fam = this->nFamilies(), n_keys = this->m_keys.size();
+	if(strengths.size() != n_fam){
+		std::stringstream strm;
+		strm << "driving terms: " << strengths.size() << " strengths given for " << n_fam << " families";
+		throw std::invalid_argument(strm.str());
+	}
+	for(size_t a = 0; a < n_fam; ++a){
+		this->m_families[a].strength = strengths[a];
+	}
+	this->m_first.assign(n_keys, 0e0);
+	this->m_second.assign(n_keys, 0e0);
+	for(size_t a = 0; a < n_fam; ++a){
+		const double s_a = strengths[a];
+		for(size_t m = 0; m < n_keys; ++m){
+			this->m_first[m] += s_a * this->m_first_unit[a][m];
+		}
+		for(size_t b = 0; b < n_fam; ++b){
+			const double s_ab = s_a * strengths[b];
+			const auto& c = this->m_second_unit[a * n_fam + b];
+			for(size_t m = 0; m < n_keys; ++m){
+				this->m_second[m] += s_ab * c[m];
+			}
+		}
+	}
+}
+
+void ts::DrivingTerms::setStrength(const size_t family, const double strength)
+{
+	const size_t n_fam = this->nFamilies(), n_keys = this->m_keys.size();
+	if(family >= n_fam){
+		std::stringstream strm;
+		strm << "driving terms: family " << family << " beyond the " << n_fam << " families";
+		throw std::out_of_range(strm.str());
+	}
+	const size_t a = family;
+	const double s_old = this->m_families[a].strength, ds = strength - s_old;
+	this->m_families[a].strength = strength;
+
+	for(size_t m = 0; m < n_keys; ++m){
+		this->m_first[m] += ds * this->m_first_unit[a][m];
+	}
+	/* terms of the pairs with family a: (a, b), (b, a) and (a, a) */
+	for(size_t b = 0; b < n_fam; ++b){
+		if(b == a){
+			const double ds2 = strength * strength - s_old * s_old;
+			const auto& c = this->m_second_unit[a * n_fam + a];
+			for(size_t m = 0; m < n_keys; ++m){
+				this->m_second[m] += ds2 * c[m];
+			}
+			continue;
+		}
+		const double s_b = ds * this->m_families[b].strength;
+		if(s_b == 0e0){
+			continue;
+		}
+		const auto& c_ab = this->m_second_unit[a * n_fam + b];
+		const auto& c_ba = this->m_second_unit[b * n_fam + a];
+		for(size_t m = 0; m < n_keys; ++m){
+			this->m_second[m] += s_b * (c_ab[m] + c_ba[m]);
+		}
+	}
+}
+
+cplx ts::DrivingTerms::firstOrder(const unsigned i, const unsigned j, const unsigned k,
+				  const unsigned l, const unsigned m) const
+{
+	const auto it = this->m_position.find(pack(i, j, k, l, m));
+	return (it == this->m_position.end()) ? cplx(0e0) : this->m_first[it->second];
+}
+
+cplx ts::DrivingTerms::secondOrder(const unsigned i, const unsigned j, const unsigned k,
+				   const unsigned l, const unsigned m) const
+{
+	const auto it = this->m_position.find(pack(i, j, k, l, m));
+	return (it == this->m_position.end()) ? cplx(0e0) : this->m_second[it->second];
+}
+
+std::vector<ts::DrivingTerm> ts::DrivingTerms::terms(void) const
+{
+	std::vector<DrivingTerm> result(this->m_keys.size());
+	for(size_t p = 0; p < this->m_keys.size(); ++p){
+		for(int v = 0; v < 5; ++v){
+			result[p].exponents[v] = exponent(this->m_keys[p], v);
+		}
+		result[p].first = this->m_first[p];
+		result[p].second = this->m_second[p];
+	}
+	return result;
+}
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -0,0 +1,128 @@
+#ifndef _THOR_SCSI_STD_MACHINE_DRIVING_TERMS_H_
+#define _THOR_SCSI_STD_MACHINE_DRIVING_TERMS_H_
+
+#include <thor_scsi/std_machine/twiss.h>
+#include <array>
+#include <complex>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace thor_scsi {
+
+	/**
+	 * @brief thin multipole kicks of the same strength, e.g. a sextupole family
+	 */
+	struct DrivingTermFamily {
+		std::string name;
+		/// multipole number: 2 quadrupole, 3 sextupole, 4 octupole, ...
+		int n = 3;
+		/// positions of the kicks: indices into the Twiss arrays
+		std::vector<size_t> index;
+		/// integrated strength b_n L of each kick
+		double strength = 0e0;
+	};
+
+	/**
+	 * @brief coefficient of the monomial h_x+^i h_x-^j h_y+^k h_y-^l delta^m
+	 */
+	struct DrivingTerm {
+		/// i, j, k, l, m
+		std::array<unsigned, 5> exponents = {0, 0, 0, 0, 0};
+		std::complex<double> first = 0e0, second = 0e0;
+	};
+
+	/**
+	 * @brief first and second order resonance driving terms of thin multipoles
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * Follows J. Bengtsson, SLS Note 09/97. The kick of strength
+	 * :math:`b_n L` at a position with the Twiss parameters
+	 * :math:`\beta, \mu, \eta_x` contributes the generator
+	 *
+	 * .. math::
+	 *
+	 *     f = -\frac{b_n L}{n (1 + \delta)}
+	 *         \,\mathrm{Re}\left[(x + \eta_x \delta + i y)^n\right],
+	 *     \quad
+	 *     x = \frac{\sqrt{\beta_x}}{2}
+	 *         \left(h_x^+ e^{i \mu_x} + h_x^- e^{-i \mu_x}\right)
+	 *
+	 * (y alike), expanded up to :math:`\delta^2`, i.e. with
+	 * :math:`1 / (1 + \delta) \approx 1 - \delta + \delta^2`; :math:`h^\pm =
+	 * \sqrt{2 J} e^{\pm i \phi}`. This gives e.g.
+	 * :math:`h_{21000} = -\frac{1}{8} \sum b_3 L \beta_x^{3/2} e^{i \mu_x}`
+	 * and :math:`h_{11001} = \frac{1}{4} \sum (b_2 L - 2 b_3 L \eta_x) \beta_x`.
+	 * Geometric and chromatic terms are thus handled alike. The
+	 * second order terms are the cross terms
+	 * :math:`\frac{1}{2} \sum_{i < j} [f_i, f_j]` of kicks i upstream
+	 * of j (Poisson brackets, :math:`[h^+, h^-] = 2 i`).
+	 *
+	 * All contributions are linear in the strengths. Thus the
+	 * constructor caches the sums of unit strength: per family for
+	 * the first order and per pair of families for the second; the
+	 * cross terms are computed in parallel, using running sums along
+	 * the ring. Afterwards a change of the strength of a family
+	 * updates the driving terms in O(n_families) operations per term,
+	 * independent of the number of kicks.
+	 *
+	 * The kicks are placed at the positions of the Twiss arrays
+	 * (element exits); split thick magnets to place kicks inside.
+	 * Kicks at the same position commute.
+	 *
+	 * \endverbatim
+	 */
+	class DrivingTerms {
+	public:
+		/**
+		 * @throws std::invalid_argument for a multipole number outside
+		 *         [2, 16], an index outside of twiss or inconsistent
+		 *         twiss arrays
+		 */
+		DrivingTerms(const Twiss& twiss, const std::vector<DrivingTermFamily>& families,
+			     const size_t n_threads = 0);
+
+		inline size_t nFamilies(void) const { return this->m_families.size(); }
+		inline const DrivingTermFamily& getFamily(const size_t family) const { return this->m_families.at(family); }
+		inline double getStrength(const size_t family) const { return this->m_families.at(family).strength; }
+
+		/// incremental update of the driving terms
+		void setStrength(const size_t family, const double strength);
+		/// recomputes the driving terms from the cached sums
+		void setStrengths(const std::vector<double>& strengths);
+
+		/// first order term h_ijklm (zero if not driven)
+		std::complex<double> firstOrder(const unsigned i, const unsigned j, const unsigned k,
+						const unsigned l, const unsigned m = 0) const;
+		/// second order (cross) term h_ijklm (zero if not driven)
+		std::complex<double> secondOrder(const unsigned i, const unsigned j, const unsigned k,
+						 const unsigned l, const unsigned m = 0) const;
+		inline std::complex<double> get(const unsigned i, const unsigned j, const unsigned k,
+						const unsigned l, const unsigned m = 0) const {
+			return this->firstOrder(i, j, k, l, m) + this->secondOrder(i, j, k, l, m);
+		}
+
+		/// all terms driven, in a fixed order
+		std::vector<DrivingTerm> terms(void) const;
+
+	private:
+		std::vector<DrivingTermFamily> m_families;
+		/// monomials driven (packed exponents) and their position in the dense vectors
+		std::vector<uint32_t> m_keys;
+		std::map<uint32_t, size_t> m_position;
+		/// unit strength sums: per family, and per pair (a upstream of b) at a * n_families + b
+		std::vector<std::vector<std::complex<double>>> m_first_unit, m_second_unit;
+		/// at the present strengths
+		std::vector<std::complex<double>> m_first, m_second;
+	};
+
+} // namespace thor_scsi
+#endif /* _THOR_SCSI_STD_MACHINE_DRIVING_TERMS_H_ */
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -0,0 +1,589 @@
+#include <thor_scsi/std_machine/dynamic_aperture.h>
+#include <thor_scsi/std_machine/naff.h>
+#include <thor_scsi/core/parallel.h>
+#include <thor_scsi/core/exceptions.h>
+#include <tps/enums.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace ts = thor_scsi;
+namespace tsc = thor_scsi::core;
+
+template<class C>
+bool ts::propagate_lost(ts::AcceleratorKnobbable<C>& acc, tsc::ConfigType& conf,
+			gtpsa::ss_vect<double>& ps, const size_t start, const int n_elements,
+			const double amplitude_limit)
+{
+	const int end = static_cast<int>(start) + n_elements;
+	int last = -1;
+	try {
+		last = acc.propagate(conf, ps, start, n_elements, 1);
+	} catch(const ts::PhysicsViolation&) {
+		return true;
+	}
+	if(last != end){
+		return true;
+	}
+	/* a loss at the last element returns the same index as passing it */
+	auto elem = std::dynamic_pointer_cast<tsc::ElemTypeKnobbed>(acc.at((n_elements < 0) ? end + 1 : end - 1));
+	if(elem && !elem->checkAmplitude(ps)){
+		return true;
+	}
+	for(int k = 0; k < nv_tps; ++k){
+		if(!std::isfinite(ps[k])){
+			return true;
+		}
+	}
+	return std::abs(ps[x_]) > amplitude_limit || std::abs(ps[y_]) > amplitude_limit;
+}
+
+template<class C>
+size_t ts::track_survival(ts::AcceleratorKnobbable<C>& acc, tsc::ConfigType& conf,
+			  gtpsa::ss_vect<double>& ps, const size_t n_turns, const double amplitude_limit)
+{
+	const int n_elements = static_cast<int>(acc.size());
+	for(size_t turn = 0; turn < n_turns; ++turn){
+		if(ts::propagate_lost(acc, conf, ps, 0, n_elements, amplitude_limit)){
+			return turn;
+		}
+	}
+	return n_turns;
+}
+
+template<class C>
+size_t ts::prepare_parallel_tracking(ts::AcceleratorKnobbable<C>& acc, tsc::ConfigType& conf, size_t n_threads)
+{
+	conf.emittance = false;
+
+	for(const auto& cv : acc){
+		auto elem = std::dynamic_pointer_cast<tsc::ElemTypeKnobbed>(cv);
+		if(elem && elem->observer()){
+			n_threads = 1;
+			break;
+		}
+	}
+	return n_threads;
+}
+
+static void check_options(const ts::DynamicApertureOptions& options)
+{
+	if(!(options.r_start > 0e0) || !(options.r_max >= options.r_start) || !(options.r_tolerance > 0e0)){
+		std::stringstream strm;
+		strm << "dynamic aperture: require 0 < r_start (" << options.r_start
+		     << ") <= r_max (" << options.r_max << ") and r_tolerance ("
+		     << options.r_tolerance << ") > 0";
+		throw std::invalid_argument(strm.str());
+	}
+	if(!(options.amplitude_limit > 0e0)){
+		throw std::invalid_argument("dynamic aperture: amplitude limit has to be positive");
+	}
+}
+
+template<class C>
+ts::DynamicApertureBoundary ts::dynamic_aperture(ts::AcceleratorKnobbable<C>& acc, const tsc::ConfigType& conf,
+						 const gtpsa::ss_vect<double>& x0, const std::vector<double>& deltas,
+						 const ts::DynamicApertureOptions& options)
+{
+	check_options(options);
+	if(!options.n_rays){
+		throw std::invalid_argument("dynamic aperture: at least one ray required");
+	}
+
+	DynamicApertureBoundary boundary;
+	boundary.delta = deltas;
+	const size_t n_rays = options.n_rays;
+	for(size_t i = 0; i < n_rays; ++i){
+		const double frac = (n_rays > 1) ? double(i) / double(n_rays - 1) : 0e0;
+		boundary.angle.push_back(options.angle_min + frac * (options.angle_max - options.angle_min));
+	}
+	boundary.x.assign(deltas.size(), std::vector<double>(n_rays, 0e0));
+	boundary.y.assign(deltas.size(), std::vector<double>(n_rays, 0e0));
+	boundary.area.assign(deltas.size(), 0e0);
+
+	tsc::ConfigType conf_track = conf;
+	const size_t n_threads =
+		ts::prepare_parallel_tracking(acc, conf_track, options.n_threads);
+
+	tsc::parallel_for(deltas.size() * n_rays, n_threads, [&](const size_t task){
+		const size_t i_delta = task / n_rays, i_ray = task % n_rays;
+		const double phi = boundary.angle[i_ray], delta = deltas[i_delta];
+		tsc::ConfigType conf_ray = conf_track;
+		conf_ray.particle_id = static_cast<uint32_t>(task);
+
+		auto survives = [&](const double r){
+			gtpsa::ss_vect<double> ps(0e0);
+			for(int k = 0; k < nv_tps; ++k){
+				ps[k] = x0[k];
+			}
+			ps[x_] += r * std::cos(phi);
+			ps[y_] += r * std::sin(phi);
+			ps[delta_] += delta;
+			conf_ray.turn = 0;
+			return ts::track_survival(acc, conf_ray, ps, options.n_turns, options.amplitude_limit)
+				== options.n_turns;
+		};
+
+		/* bracket: r_lo survives, r_hi is lost */
+		double r_lo = 0e0, r_hi = options.r_start;
+		bool bracketed = false;
+		while(!bracketed){
+			if(!survives(r_hi)){
+				bracketed = true;
+			} else if(r_hi >= options.r_max){
+				r_lo = r_hi;
+				break;
+			} else {
+				r_lo = r_hi;
+				r_hi = std::min(2e0 * r_hi, options.r_max);
+			}
+		}
+		while(bracketed && r_hi - r_lo > options.r_tolerance){
+			const double r = (r_lo + r_hi) / 2e0;
+			if(survives(r)){
+				r_lo = r;
+			} else {
+				r_hi = r;
+			}
+		}
+		boundary.x[i_delta][i_ray] = r_lo * std::cos(phi);
+		boundary.y[i_delta][i_ray] = r_lo * std::sin(phi);
+	});
+
+	for(size_t i = 0; i < deltas.size(); ++i){
+		double area = 0e0;
+		for(size_t j = 0; j + 1 < n_rays; ++j){
+			area += boundary.x[i][j] * boundary.y[i][j + 1] - boundary.x[i][j + 1] * boundary.y[i][j];
+		}
+		boundary.area[i] = std::abs(area) / 2e0;
+	}
+	return boundary;
+}
+
+template<class C>
+ts::SurvivalMap ts::survival_map(ts::AcceleratorKnobbable<C>& acc, const tsc::ConfigType& conf,
+				 const gtpsa::ss_vect<double>& x0, const std::vector<double>& deltas,
+				 const std::vector<double>& xs, const std::vector<double>& ys,
+				 const ts::DynamicApertureOptions& options)
+{
+	if(!(options.amplitude_limit > 0e0)){
+		throw std::invalid_argument("survival map: amplitude limit has to be positive");
+	}
+	SurvivalMap result;
+	result.delta = deltas;
+	result.x = xs;
+	result.y = ys;
+	const size_t n_x = xs.size(), n_y = ys.size();
+	result.turns.assign(deltas.size() * n_y * n_x, 0);
+
+	tsc::ConfigType conf_track = conf;
+	const size_t n_threads =
+		ts::prepare_parallel_tracking(acc, conf_track, options.n_threads);
+
+	tsc::parallel_for(result.turns.size(), n_threads, [&](const size_t task){
+		const size_t i_x = task % n_x, i_y = (task / n_x) % n_y, i_delta = task / (n_x * n_y);
+		tsc::ConfigType conf_point = conf_track;
+		conf_point.particle_id = static_cast<uint32_t>(task);
+
+		gtpsa::ss_vect<double> ps(0e0);
+		for(int k = 0; k < nv_tps; ++k){
+			ps[k] = x0[k];
+		}
+		ps[x_] += xs[i_x];
+		ps[y_] += ys[i_y];
+		ps[delta_] += deltas[i_delta];
+		result.turns[task] = ts::track_survival(acc, conf_point, ps, options.n_turns, options.amplitude_limit);
+	});
+	return result;
+}
+
+template<class C>
+ts::MomentumAperture ts::momentum_aperture(ts::AcceleratorKnobbable<C>& acc, const tsc::ConfigType& conf,
+					   const gtpsa::ss_vect<double>& x0, const std::vector<size_t>& indices,
+					   const ts::MomentumApertureOptions& options)
+{
+	if(!(options.delta_max > 0e0) || !(options.delta_tolerance > 0e0)){
+		std::stringstream strm;
+		strm << "momentum aperture: require delta_max (" << options.delta_max
+		     << ") > 0 and delta_tolerance (" << options.delta_tolerance << ") > 0";
+		throw std::invalid_argument(strm.str());
+	}
+	if(!(options.amplitude_limit > 0e0)){
+		throw std::invalid_argument("momentum aperture: amplitude limit has to be positive");
+	}
+	const size_t n_elements = acc.size();
+	for(const auto index : indices){
+		if(index >= n_elements){
+			std::stringstream strm;
+			strm << "momentum aperture: element index " << index
+			     << " beyond the last element " << n_elements - 1;
+			throw std::invalid_argument(strm.str());
+		}
+	}
+
+	MomentumAperture result;
+	result.index = indices;
+	result.delta_plus.assign(indices.size(), 0e0);
+	result.delta_minus.assign(indices.size(), 0e0);
+	if(indices.empty()){
+		return result;
+	}
+
+	tsc::ConfigType conf_track = conf;
+	const size_t n_threads =
+		ts::prepare_parallel_tracking(acc, conf_track, options.n_threads);
+
+	/* reference orbit at the exit of each element */
+	const size_t last_index = *std::max_element(indices.begin(), indices.end());
+	std::vector<gtpsa::ss_vect<double>> orbit;
+	orbit.reserve(last_index + 1);
+	{
+		gtpsa::ss_vect<double> ps(0e0);
+		for(int k = 0; k < nv_tps; ++k){
+			ps[k] = x0[k];
+		}
+		auto conf_orbit = conf_track;
+		for(size_t i = 0; i <= last_index; ++i){
+			if(ts::propagate_lost(acc, conf_orbit, ps, i, 1, options.amplitude_limit)){
+				std::stringstream strm;
+				strm << "momentum aperture: reference particle lost at element " << i;
+				throw std::runtime_error(strm.str());
+			}
+			orbit.push_back(ps.clone());
+		}
+	}
+
+	tsc::parallel_for(2 * indices.size(), n_threads, [&](const size_t task){
+		const size_t i_index = task / 2, index = indices[i_index];
+		const double sign = (task % 2) ? -1e0 : 1e0;
+		tsc::ConfigType conf_task = conf_track;
+		conf_task.particle_id = static_cast<uint32_t>(task);
+
+		auto survives = [&](const double delta){
+			gtpsa::ss_vect<double> ps = orbit[index].clone();
+			ps[delta_] += sign * delta;
+			conf_task.turn = 0;
+			/* complete the turn the particle started in */
+			const int n_rest = static_cast<int>(n_elements - index - 1);
+			if(n_rest > 0 && ts::propagate_lost(acc, conf_task, ps, index + 1, n_rest, options.amplitude_limit)){
+				return false;
+			}
+			return ts::track_survival(acc, conf_task, ps, options.n_turns, options.amplitude_limit)
+				== options.n_turns;
+		};
+
+		double delta_lo = 0e0, delta_hi = options.delta_max;
+		if(survives(delta_hi)){
+			delta_lo = delta_hi;
+		} else {
+			while(delta_hi - delta_lo > options.delta_tolerance){
+				const double delta = (delta_lo + delta_hi) / 2e0;
+				if(survives(delta)){
+					delta_lo = delta;
+				} else {
+					delta_hi = delta;
+				}
+			}
+		}
+		if(sign > 0e0){
+			result.delta_plus[i_index] = delta_lo;
+		} else {
+			result.delta_minus[i_index] = -delta_lo;
+		}
+	});
+	return result;
+}
+
+template<class C>
+ts::FrequencyMap ts::frequency_map(ts::AcceleratorKnobbable<C>& acc, const tsc::ConfigType& conf,
+				   const gtpsa::ss_vect<double>& x0, const std::vector<double>& xs,
+				   const std::vector<double>& second, const ts::FrequencyMapPlane plane,
+				   const ts::FrequencyMapOptions& options)
+{
+	if(options.n_turns < 2){
+		throw std::invalid_argument("frequency map: at least 2 turns per half required");
+	}
+	if(!(options.amplitude_limit > 0e0)){
+		throw std::invalid_argument("frequency map: amplitude limit has to be positive");
+	}
+
+	FrequencyMap result;
+	result.plane = plane;
+	result.x = xs;
+	result.second = second;
+	const size_t n_x = xs.size(), n_points = n_x * second.size(), n_turns = options.n_turns;
+	for(int h = 0; h < 2; ++h){
+		result.nu_x[h].assign(n_points, NAN);
+		result.nu_y[h].assign(n_points, NAN);
+	}
+	result.diffusion.assign(n_points, NAN);
+	result.lost_turn.assign(n_points, 2 * n_turns);
+	if(!n_points){
+		return result;
+	}
+
+	tsc::ConfigType conf_track = conf;
+	const size_t n_threads =
+		ts::prepare_parallel_tracking(acc, conf_track, options.n_threads);
+	const int n_elements = static_cast<int>(acc.size());
+
+	/* fractional tune of the turn by turn data relative to their mean */
+	auto tune = [n_turns](ts::NAFF& naff, std::vector<double>& q, std::vector<double>& p){
+		double q_mean = 0e0, p_mean = 0e0;
+		for(size_t i = 0; i < n_turns; ++i){
+			q_mean += q[i];
+			p_mean += p[i];
+		}
+		q_mean /= double(n_turns);
+		p_mean /= double(n_turns);
+		for(size_t i = 0; i < n_turns; ++i){
+			q[i] -= q_mean;
+			p[i] -= p_mean;
+		}
+		const double nu = naff.frequency(q.data(), p.data());
+		return (nu < 0e0) ? nu + 1e0 : nu;
+	};
+
+	/* one NAFF workspace and turn by turn buffer per thread */
+	const size_t n_thr = tsc::number_of_threads(n_threads, n_points);
+	const size_t chunk = n_points / n_thr, rest = n_points % n_thr;
+	tsc::parallel_for(n_thr, n_thr, [&](const size_t t){
+		const size_t start = t * chunk + std::min(t, rest);
+		const size_t stop = start + chunk + (t < rest ? 1 : 0);
+		ts::NAFF naff(n_turns, 1, options.window_order);
+		std::array<std::vector<double>, 4> tbt;
+		for(auto& v : tbt){
+			v.resize(2 * n_turns);
+		}
+		std::vector<double> q(n_turns), p(n_turns);
+		tsc::ConfigType conf_point = conf_track;
+
+		for(size_t i = start; i < stop; ++i){
+			const size_t i_x = i % n_x, i_second = i / n_x;
+			conf_point.particle_id = static_cast<uint32_t>(i);
+			conf_point.turn = 0;
+
+			gtpsa::ss_vect<double> ps(0e0);
+			for(int k = 0; k < nv_tps; ++k){
+				ps[k] = x0[k];
+			}
+			ps[x_] += xs[i_x];
+			if(plane == FrequencyMapPlane::XY){
+				ps[y_] += second[i_second];
+			} else {
+				ps[delta_] += second[i_second];
+			}
+
+			size_t turn = 0;
+			for(; turn < 2 * n_turns; ++turn){
+				if(ts::propagate_lost(acc, conf_point, ps, 0, n_elements, options.amplitude_limit)){
+					break;
+				}
+				tbt[0][turn] = ps[x_];
+				tbt[1][turn] = ps[px_];
+				tbt[2][turn] = ps[y_];
+				tbt[3][turn] = ps[py_];
+			}
+			result.lost_turn[i] = turn;
+			if(turn < 2 * n_turns){
+				continue;
+			}
+
+			for(int h = 0; h < 2; ++h){
+				const size_t offset = h * n_turns;
+				for(int plane_index = 0; plane_index < 2; ++plane_index){
+					std::copy_n(tbt[2 * plane_index].begin() + offset, n_turns, q.begin());
+					std::copy_n(tbt[2 * plane_index + 1].begin() + offset, n_turns, p.begin());
+					auto& nu = (plane_index == 0) ? result.nu_x[h] : result.nu_y[h];
+					nu[i] = tune(naff, q, p);
+				}
+			}
+			const double d_nu_x = result.nu_x[1][i] - result.nu_x[0][i];
+			const double d_nu_y = result.nu_y[1][i] - result.nu_y[0][i];
+			result.diffusion[i] = std::log10(std::sqrt(d_nu_x * d_nu_x + d_nu_y * d_nu_y));
+		}
+	});
+	return result;
+}
+
+/* time reversal: momenta and path length change sign */
+static void reverse_time(gtpsa::ss_vect<double>& ps)
+{
+	ps[px_] = -ps[px_];
+	ps[py_] = -ps[py_];
+	ps[ct_] = -ps[ct_];
+}
+
+template<class C>
+ts::ChaosResult ts::track_chaos(ts::AcceleratorKnobbable<C>& acc, const tsc::ConfigType& conf,
+				const std::vector<gtpsa::ss_vect<double>>& particles,
+				const ts::ChaosOptions& options)
+{
+	if(!options.check_interval){
+		throw std::invalid_argument("chaos tracking: check interval has to be positive");
+	}
+	if(!(options.amplitude_limit > 0e0)){
+		throw std::invalid_argument("chaos tracking: amplitude limit has to be positive");
+	}
+
+	const size_t n_particles = particles.size();
+	ChaosResult result;
+	result.indicator.assign(n_particles, NAN);
+	result.turns.assign(n_particles, 0);
+	result.state.assign(n_particles, ChaosState::Survived);
+	result.reversibility_error.assign(n_particles, NAN);
+	if(!n_particles){
+		return result;
+	}
+
+	tsc::ConfigType conf_track = conf;
+	const size_t n_threads = ts::prepare_parallel_tracking(acc, conf_track, options.n_threads);
+	const int n_elements = static_cast<int>(acc.size());
+	/* displacement of the shadow particle */
+	const double eps = 1e-9;
+
+	tsc::parallel_for(n_particles, n_threads, [&](const size_t i){
+		tsc::ConfigType conf_particle = conf_track;
+		conf_particle.particle_id = static_cast<uint32_t>(i);
+		conf_particle.turn = 0;
+		tsc::ConfigType conf_shadow = conf_particle;
+
+		gtpsa::ss_vect<double> ps = particles[i].clone();
+		double w[nv_tps] = {0e0};
+		w[x_] = w[y_] = 1e0 / std::sqrt(2e0);
+
+		/* ln |w_k|, sum_k k ln(|w_k| / |w_k-1|), sum_k Y_k */
+		double ln_w = 0e0, fli = -INFINITY, megno_sum = 0e0, y_sum = 0e0, indicator = NAN;
+		size_t turn = 0;
+		ChaosState state = ChaosState::Survived;
+		while(turn < options.n_turns){
+			gtpsa::ss_vect<double> shadow = ps.clone();
+			for(int k = 0; k < nv_tps; ++k){
+				shadow[k] += eps * w[k];
+			}
+			if(ts::propagate_lost(acc, conf_particle, ps, 0, n_elements, options.amplitude_limit)
+			   || ts::propagate_lost(acc, conf_shadow, shadow, 0, n_elements, options.amplitude_limit)){
+				state = ChaosState::Lost;
+				break;
+			}
+			++turn;
+
+			double norm = 0e0;
+			for(int k = 0; k < nv_tps; ++k){
+				w[k] = (shadow[k] - ps[k]) / eps;
+				norm += w[k] * w[k];
+			}
+			norm = std::sqrt(norm);
+			if(!(norm > 0e0) || !std::isfinite(norm)){
+				state = ChaosState::Chaotic;
+				break;
+			}
+			for(auto& v : w){
+				v /= norm;
+			}
+			const double ln_growth = std::log(norm);
+			ln_w += ln_growth;
+
+			if(options.indicator == ChaosIndicator::MEGNO){
+				megno_sum += double(turn) * ln_growth;
+				y_sum += 2e0 * megno_sum / double(turn);
+				indicator = y_sum / double(turn);
+			} else {
+				fli = std::max(fli, ln_w / std::log(10e0));
+				indicator = fli - std::log10(double(turn));
+			}
+
+			if(turn >= options.min_turns && !(turn % options.check_interval)){
+				if(indicator > options.chaotic_threshold){
+					state = ChaosState::Chaotic;
+					break;
+				}
+				if(options.stop_regular && indicator < options.regular_threshold){
+					state = ChaosState::Regular;
+					break;
+				}
+			}
+		}
+		result.indicator[i] = indicator;
+		result.turns[i] = turn;
+		result.state[i] = state;
+
+		if(!options.reversibility || state == ChaosState::Lost){
+			return;
+		}
+		gtpsa::ss_vect<double> back = ps.clone();
+		reverse_time(back);
+		for(size_t t = 0; t < turn; ++t){
+			if(ts::propagate_lost(acc, conf_particle, back, n_elements - 1, -n_elements, options.amplitude_limit)){
+				result.reversibility_error[i] = INFINITY;
+				return;
+			}
+		}
+		reverse_time(back);
+		double error = 0e0;
+		for(int k = 0; k < nv_tps; ++k){
+			error = std::max(error, std::abs(back[k] - particles[i][k]));
+		}
+		result.reversibility_error[i] = error;
+	});
+	return result;
+}
+
+template bool ts::propagate_lost(ts::AcceleratorKnobbable<tsc::StandardDoubleType>& acc, tsc::ConfigType& conf,
+				 gtpsa::ss_vect<double>& ps, const size_t start, const int n_elements,
+				 const double amplitude_limit);
+template bool ts::propagate_lost(ts::AcceleratorKnobbable<tsc::TpsaVariantType>& acc, tsc::ConfigType& conf,
+				 gtpsa::ss_vect<double>& ps, const size_t start, const int n_elements,
+				 const double amplitude_limit);
+template size_t ts::prepare_parallel_tracking(ts::AcceleratorKnobbable<tsc::StandardDoubleType>& acc,
+					      tsc::ConfigType& conf, size_t n_threads);
+template size_t ts::prepare_parallel_tracking(ts::AcceleratorKnobbable<tsc::TpsaVariantType>& acc,
+					      tsc::ConfigType& conf, size_t n_threads);
+template size_t ts::track_survival(ts::AcceleratorKnobbable<tsc::StandardDoubleType>& acc, tsc::ConfigType& conf,
+				   gtpsa::ss_vect<double>& ps, const size_t n_turns, const double amplitude_limit);
+template size_t ts::track_survival(ts::AcceleratorKnobbable<tsc::TpsaVariantType>& acc, tsc::ConfigType& conf,
+				   gtpsa::ss_vect<double>& ps, const size_t n_turns, const double amplitude_limit);
+template ts::DynamicApertureBoundary ts::dynamic_aperture(ts::AcceleratorKnobbable<tsc::StandardDoubleType>& acc,
+							  const tsc::ConfigType& conf, const gtpsa::ss_vect<double>& x0,
+							  const std::vector<double>& deltas, const ts::DynamicApertureOptions& options);
+template ts::DynamicApertureBoundary ts::dynamic_aperture(ts::AcceleratorKnobbable<tsc::TpsaVariantType>& acc,
+							  const tsc::ConfigType& conf, const gtpsa::ss_vect<double>& x0,
+							  const std::vector<double>& deltas, const ts::DynamicApertureOptions& options);
+template ts::SurvivalMap ts::survival_map(ts::AcceleratorKnobbable<tsc::StandardDoubleType>& acc,
+					  const tsc::ConfigType& conf, const gtpsa::ss_vect<double>& x0,
+					  const std::vector<double>& deltas, const std::vector<double>& xs,
+					  const std::vector<double>& ys, const ts::DynamicApertureOptions& options);
+template ts::SurvivalMap ts::survival_map(ts::AcceleratorKnobbable<tsc::TpsaVariantType>& acc,
+					  const tsc::ConfigType& conf, const gtpsa::ss_vect<double>& x0,
+					  const std::vector<double>& deltas, const std::vector<double>& xs,
+					  const std::vector<double>& ys, const ts::DynamicApertureOptions& options);
+template ts::MomentumAperture ts::momentum_aperture(ts::AcceleratorKnobbable<tsc::StandardDoubleType>& acc,
+						    const tsc::ConfigType& conf, const gtpsa::ss_vect<double>& x0,
+						    const std::vector<size_t>& indices, const ts::MomentumApertureOptions& options);
+template ts::MomentumAperture ts::momentum_aperture(ts::AcceleratorKnobbable<tsc::TpsaVariantType>& acc,
+						    const tsc::ConfigType& conf, const gtpsa::ss_vect<double>& x0,
+						    const std::vector<size_t>& indices, const ts::MomentumApertureOptions& options);
+template ts::FrequencyMap ts::frequency_map(ts::AcceleratorKnobbable<tsc::StandardDoubleType>& acc,
+					    const tsc::ConfigType& conf, const gtpsa::ss_vect<double>& x0,
+					    const std::vector<double>& xs, const std::vector<double>& second,
+					    const ts::FrequencyMapPlane plane, const ts::FrequencyMapOptions& options);
+template ts::FrequencyMap ts::frequency_map(ts::AcceleratorKnobbable<tsc::TpsaVariantType>& acc,
+					    const tsc::ConfigType& conf, const gtpsa::ss_vect<double>& x0,
+					    const std::vector<double>& xs, const std::vector<double>& second,
+					    const ts::FrequencyMapPlane plane, const ts::FrequencyMapOptions& options);
+template ts::ChaosResult ts::track_chaos(ts::AcceleratorKnobbable<tsc::StandardDoubleType>& acc,
+					 const tsc::ConfigType& conf,
+					 const std::vector<gtpsa::ss_vect<double>>& particles,
+					 const ts::ChaosOptions& options);
+template ts::ChaosResult ts::track_chaos(ts::AcceleratorKnobbable<tsc::TpsaVariantType>& acc,
+					 const tsc::ConfigType& conf,
+					 const std::vector<gtpsa::ss_vect<double>>& particles,
+					 const ts::ChaosOptions& options);
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
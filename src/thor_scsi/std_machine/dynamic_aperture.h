@@ -0,0 +1,415 @@
+#ifndef _THOR_SCSI_STD_MACHINE_DYNAMIC_APERTURE_H_
+#define _THOR_SCSI_STD_MACHINE_DYNAMIC_APERTURE_H_
+
+#include <thor_scsi/std_machine/accelerator.h>
+#include <thor_scsi/core/config.h>
+#include <gtpsa/ss_vect.h>
+#include <array>
+#include <cmath>
+#include <vector>
+
+namespace thor_scsi {
+
+	/**
+	 * @brief parameters of the dynamic aperture search
+	 *
+	 * Lengths in m, angles in rad.
+	 */
+	struct DynamicApertureOptions {
+		/// turns a particle has to survive
+		size_t n_turns = 1000;
+		/// rays of the polar search, equally spaced in [angle_min, angle_max]
+		size_t n_rays = 11;
+		double angle_min = 0e0, angle_max = M_PI;
+		/// first radius tried along a ray, doubled until the particle is lost
+		double r_start = 1e-3;
+		/// largest radius tried: reported as boundary if the particle survives
+		double r_max = 0.1;
+		/// resolution of the binary search along a ray
+		double r_tolerance = 1e-5;
+		/// particles beyond this transverse amplitude are considered lost
+		double amplitude_limit = 1e0;
+		/// 0: hardware concurrency
+		size_t n_threads = 0;
+	};
+
+	/**
+	 * @brief dynamic aperture found along rays, per momentum offset
+	 *
+	 * Coordinates are relative to the reference orbit. Outer index
+	 * momentum offset, inner one ray.
+	 */
+	struct DynamicApertureBoundary {
+		std::vector<double> delta, angle;
+		/// last stable point found along each ray
+		std::vector<std::vector<double>> x, y;
+		/// area of the fan spanned by the rays
+		std::vector<double> area;
+	};
+
+	/**
+	 * @brief turns survived on a grid of initial conditions
+	 *
+	 * turns holds n_delta x n_y x n_x values, x running fastest;
+	 * n_turns is stored for particles surviving all turns.
+	 */
+	struct SurvivalMap {
+		std::vector<double> delta, x, y;
+		std::vector<size_t> turns;
+
+		inline size_t at(const size_t i_delta, const size_t i_y, const size_t i_x) const {
+			return this->turns.at((i_delta * this->y.size() + i_y) * this->x.size() + i_x);
+		}
+	};
+
+	/**
+	 * @brief parameters of the local momentum aperture search
+	 */
+	struct MomentumApertureOptions {
+		/// turns a particle has to survive (after completing its first one)
+		size_t n_turns = 500;
+		/// largest momentum offset tried: reported if the particle survives
+		double delta_max = 0.05;
+		/// resolution of the binary search
+		double delta_tolerance = 1e-4;
+		/// particles beyond this transverse amplitude are considered lost
+		double amplitude_limit = 1e0;
+		/// 0: hardware concurrency
+		size_t n_threads = 0;
+	};
+
+	/**
+	 * @brief local momentum aperture at the exit of the selected elements
+	 *
+	 * delta_minus holds negative values.
+	 */
+	struct MomentumAperture {
+		std::vector<size_t> index;
+		std::vector<double> delta_plus, delta_minus;
+	};
+
+	/**
+	 * @brief second axis of a frequency map grid
+	 */
+	enum class FrequencyMapPlane {
+		/// grid in (x, y)
+		XY = 0,
+		/// grid in (x, delta)
+		XDelta = 1
+	};
+
+	/**
+	 * @brief parameters of the frequency map analysis
+	 */
+	struct FrequencyMapOptions {
+		/// turns analysed per half: particles are tracked twice as many
+		size_t n_turns = 512;
+		/// particles beyond this transverse amplitude are considered lost
+		double amplitude_limit = 1e0;
+		/// of the Hanning window used by NAFF
+		unsigned window_order = 1;
+		/// 0: hardware concurrency
+		size_t n_threads = 0;
+	};
+
+	/**
+	 * @brief tunes and tune diffusion on a grid of initial conditions
+	 *
+	 * Values are stored for n_second x n_x points, x running fastest.
+	 * Tunes are fractional parts in [0, 1), half index 0 for the
+	 * first n_turns, 1 for the second. Particles lost are marked by
+	 * lost_turn < 2 n_turns and NaN tunes.
+	 */
+	struct FrequencyMap {
+		FrequencyMapPlane plane = FrequencyMapPlane::XY;
+		/// second: y or delta depending on plane
+		std::vector<double> x, second;
+		std::array<std::vector<double>, 2> nu_x, nu_y;
+		/// log10 of the tune change between the halves
+		std::vector<double> diffusion;
+		std::vector<size_t> lost_turn;
+
+		inline size_t index(const size_t i_second, const size_t i_x) const {
+			return i_second * this->x.size() + i_x;
+		}
+	};
+
+	/**
+	 * @brief chaos indicator computed along with the tracking
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * Both follow the growth of a deviation vector w, estimated by
+	 * finite differences of two particles (see :func:`track_chaos`):
+	 *
+	 * * MEGNO: :math:`\langle Y \rangle` of P. Cincotta and C. Simo;
+	 *   tends to 2 for quasi periodic orbits (0 for linear motion)
+	 *   and grows linearly with the turns for chaotic ones.
+	 * * FLI: fast Lyapunov indicator of C. Froeschle et al.,
+	 *   :math:`\max_k \log_{10} |w_k|`. Reported (and compared to
+	 *   the thresholds) as the excess over the linear growth of
+	 *   regular orbits, :math:`\mathrm{FLI} - \log_{10} n`.
+	 *
+	 * \endverbatim
+	 */
+	enum class ChaosIndicator {
+		MEGNO = 0,
+		FLI = 1
+	};
+
+	/**
+	 * @brief state of a particle at the end of chaos tracking
+	 */
+	enum class ChaosState {
+		/// tracked all turns without being classified
+		Survived = 0,
+		/// stopped early: indicator below the regular threshold
+		Regular = 1,
+		/// stopped early: indicator above the chaotic threshold
+		Chaotic = 2,
+		Lost = 3
+	};
+
+	/**
+	 * @brief parameters of tracking with chaos indicators
+	 */
+	struct ChaosOptions {
+		ChaosIndicator indicator = ChaosIndicator::MEGNO;
+		/// turns tracked at most
+		size_t n_turns = 100000;
+		/// no classification before
+		size_t min_turns = 2000;
+		/// turns between classifications
+		size_t check_interval = 1000;
+		/// indicator above: chaotic, tracking stopped
+		double chaotic_threshold = 4e0;
+		/// indicator below: regular, tracking stopped if stop_regular
+		double regular_threshold = 2.5;
+		bool stop_regular = false;
+		/// track the particle back and report the distance to its start
+		bool reversibility = false;
+		/// particles beyond this transverse amplitude are considered lost
+		double amplitude_limit = 1e0;
+		/// 0: hardware concurrency
+		size_t n_threads = 0;
+	};
+
+	/**
+	 * @brief chaos indicators per particle
+	 *
+	 * reversibility_error is NaN if not requested or the particle was lost.
+	 */
+	struct ChaosResult {
+		std::vector<double> indicator;
+		std::vector<size_t> turns;
+		std::vector<ChaosState> state;
+		std::vector<double> reversibility_error;
+	};
+
+	/**
+	 * @brief propagates ps through n_elements elements starting at start
+	 *
+	 * Backwards for n_elements negative. Returns true if the particle
+	 * is lost on the way: stopped by an aperture (including the one of
+	 * the last element passed), a coordinate not finite, a transverse
+	 * amplitude beyond amplitude_limit at the end or a
+	 * PhysicsViolation.
+	 */
+	template<class C>
+	bool propagate_lost(AcceleratorKnobbable<C>& acc, thor_scsi::core::ConfigType& conf,
+			    gtpsa::ss_vect<double>& ps, const size_t start, const int n_elements,
+			    const double amplitude_limit = 1e0);
+
+	/**
+	 * @brief prepares conf for propagating particles in parallel
+	 *
+	 * Elements are shared by the threads: the propagation has to
+	 * leave them unchanged. Thus conf.emittance is switched off, and
+	 * with observers installed (these keep state) a single thread is
+	 * used. The counter of the quantum excitation random numbers is
+	 * part of conf: each thread draws from its copy, the results do
+	 * not depend on the number of threads. The elements keep no
+	 * caches updated by the propagation: the transforms composed
+	 * with the girders are updated when these are moved.
+	 *
+	 * @returns the number of threads to use
+	 */
+	template<class C>
+	size_t prepare_parallel_tracking(AcceleratorKnobbable<C>& acc, thor_scsi::core::ConfigType& conf,
+					 size_t n_threads);
+
+	/**
+	 * @brief turns survived by a particle starting at ps
+	 *
+	 * Lost: stopped by an aperture, a coordinate not finite or a
+	 * transverse amplitude beyond amplitude_limit after a turn, or a
+	 * PhysicsViolation (e.g. the particle's longitudinal momentum
+	 * becoming imaginary). Returns n_turns if the particle survives.
+	 */
+	template<class C>
+	size_t track_survival(AcceleratorKnobbable<C>& acc, thor_scsi::core::ConfigType& conf,
+			      gtpsa::ss_vect<double>& ps, const size_t n_turns,
+			      const double amplitude_limit = 1e0);
+
+	/**
+	 * @brief dynamic aperture by binary search along rays
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * For each momentum offset delta and each ray angle phi particles
+	 * start at x0 + (r cos(phi), 0, r sin(phi), 0, delta, 0). The
+	 * radius is doubled from r_start until the particle is lost (at
+	 * most r_max), then the boundary is bisected to r_tolerance.
+	 * Tracking of a particle stops at its loss.
+	 *
+	 * x0 is typically the fix point on momentum; off momentum
+	 * particles start on it as well, thus with a betatron amplitude
+	 * given by the dispersion.
+	 *
+	 * The rays (all momentum offsets) are distributed over threads.
+	 * Each thread uses its copy of conf. Elements are shared: the
+	 * propagation has to leave them unchanged. Thus conf.emittance is
+	 * switched off, and with observers installed (these keep state)
+	 * a single thread is used. Each particle draws its quantum
+	 * excitation random numbers keyed by its task index as
+	 * conf.particle_id: results do not depend on the number of
+	 * threads.
+	 *
+	 * \endverbatim
+	 *
+	 * @throws std::invalid_argument for inconsistent options
+	 */
+	template<class C>
+	DynamicApertureBoundary dynamic_aperture(AcceleratorKnobbable<C>& acc,
+						 const thor_scsi::core::ConfigType& conf,
+						 const gtpsa::ss_vect<double>& x0,
+						 const std::vector<double>& deltas,
+						 const DynamicApertureOptions& options = DynamicApertureOptions());
+
+	/**
+	 * @brief turns survived for each point of the grid xs x ys (x0 added)
+	 *
+	 * Same parallelisation and loss criteria as
+	 * :func:`dynamic_aperture`, of the options n_turns,
+	 * amplitude_limit and n_threads are used.
+	 */
+	template<class C>
+	SurvivalMap survival_map(AcceleratorKnobbable<C>& acc,
+				 const thor_scsi::core::ConfigType& conf,
+				 const gtpsa::ss_vect<double>& x0,
+				 const std::vector<double>& deltas,
+				 const std::vector<double>& xs, const std::vector<double>& ys,
+				 const DynamicApertureOptions& options = DynamicApertureOptions());
+
+	/**
+	 * @brief local momentum aperture by binary search in the momentum offset
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * For each element index the reference particle x0 (typically
+	 * the fix point) is propagated to the exit of the element. A
+	 * particle on this orbit receives a momentum kick delta (as a
+	 * Touschek scattered one does), completes the turn and has to
+	 * survive n_turns further ones. The largest delta surviving is
+	 * searched by bisection in [0, delta_max] to delta_tolerance, for
+	 * positive and negative offsets separately. The search assumes
+	 * that all smaller offsets survive as well.
+	 *
+	 * Each search (index and sign) is a task distributed over the
+	 * threads; the same restrictions as for :func:`dynamic_aperture`
+	 * apply.
+	 *
+	 * \endverbatim
+	 *
+	 * @throws std::invalid_argument for inconsistent options or an
+	 *         index beyond the last element
+	 * @throws std::runtime_error if the reference particle is lost
+	 */
+	template<class C>
+	MomentumAperture momentum_aperture(AcceleratorKnobbable<C>& acc,
+					   const thor_scsi::core::ConfigType& conf,
+					   const gtpsa::ss_vect<double>& x0,
+					   const std::vector<size_t>& indices,
+					   const MomentumApertureOptions& options = MomentumApertureOptions());
+
+	/**
+	 * @brief frequency map analysis on the grid xs x second
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * Particles start at x0 + (x, 0, y, 0, delta, 0) with second
+	 * giving y or delta (plane). For an (x, delta) grid a small
+	 * vertical amplitude has to be given in x0 to obtain a vertical
+	 * tune. Each particle is tracked 2 n_turns; the turn by turn
+	 * data relative to their mean are analysed with :class:`NAFF`
+	 * for both halves. The diffusion is
+	 * :math:`\log_{10}\sqrt{\Delta\nu_x^2 + \Delta\nu_y^2}`.
+	 *
+	 * Grid points are distributed over the threads; each thread
+	 * keeps the turn by turn data of one particle only. Same
+	 * restrictions as for :func:`dynamic_aperture`.
+	 *
+	 * \endverbatim
+	 *
+	 * @throws std::invalid_argument for inconsistent options
+	 */
+	template<class C>
+	FrequencyMap frequency_map(AcceleratorKnobbable<C>& acc,
+				   const thor_scsi::core::ConfigType& conf,
+				   const gtpsa::ss_vect<double>& x0,
+				   const std::vector<double>& xs, const std::vector<double>& second,
+				   const FrequencyMapPlane plane = FrequencyMapPlane::XY,
+				   const FrequencyMapOptions& options = FrequencyMapOptions());
+
+	/**
+	 * @brief multi turn tracking with a chaos indicator and early termination
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * The indicators are a finite difference (two particle) estimate,
+	 * not the tangent map: each particle is tracked turn by turn
+	 * together with a shadow particle displaced by 1e-9 along the
+	 * deviation vector w. Their difference divided by 1e-9 stands for
+	 * the tangent map applied to w; w is renormalised every turn and
+	 * its growth accumulated. Limits of the estimate:
+	 *
+	 * * round off: the difference of two coordinates of order 1e-3
+	 *   loses about 1e-7 relative per turn, which sets a floor to the
+	 *   growth resolved, in particular of MEGNO close to regular.
+	 * * with quantum excitation on the results are meaningless: the
+	 *   shadow particle receives kicks of its own (the random numbers
+	 *   scaled by its own field), which enter the difference.
+	 *
+	 * After min_turns and then every check_interval turns the
+	 * indicator is compared to the thresholds: chaotic particles (and
+	 * regular ones if stop_regular) are not tracked further.
+	 *
+	 * With reversibility on, particles not lost are tracked back the
+	 * same number of turns: the momenta (and ct) are reversed and the
+	 * elements passed in reverse order. This is the inverse for
+	 * elements with symmetric integrators (drifts, multipoles with
+	 * the 4th order method); for bendings with different edge
+	 * angles, cavities or radiation the error contains a systematic
+	 * part. Compare errors between particles, not with zero.
+	 *
+	 * Particles are distributed over the threads; same restrictions
+	 * as for :func:`dynamic_aperture`.
+	 *
+	 * \endverbatim
+	 *
+	 * @throws std::invalid_argument for inconsistent options
+	 */
+	template<class C>
+	ChaosResult track_chaos(AcceleratorKnobbable<C>& acc,
+				const thor_scsi::core::ConfigType& conf,
+				const std::vector<gtpsa::ss_vect<double>>& particles,
+				const ChaosOptions& options = ChaosOptions());
+
+} // namespace thor_scsi
+#endif /* _THOR_SCSI_STD_MACHINE_DYNAMIC_APERTURE_H_ */
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -0,0 +1,224 @@
+#include <thor_scsi/std_machine/envelope.h>
+#include <thor_scsi/elements/field_kick.h>
+#include <thor_scsi/elements/radiation_delegate.h>
+#include <cmath>
+#include <complex>
+#include <sstream>
+#include <stdexcept>
+
+namespace ts = thor_scsi;
+namespace tsc = thor_scsi::core;
+namespace tse = thor_scsi::elements;
+
+static const int ps_dim = 6;
+
+template<class C>
+ts::EnvelopeTracker::EnvelopeTracker(ts::AcceleratorKnobbable<C>& acc, tsc::ConfigType& conf,
+				     const gtpsa::ss_vect<double>& x0)
+	: m_turn_map(arma::eye(ps_dim, ps_dim))
+	, m_turn_diffusion(ps_dim, ps_dim, arma::fill::zeros)
+{
+	const size_t n_elements = acc.size();
+	this->m_maps.reserve(n_elements);
+	this->m_diffusion.reserve(n_elements);
+
+	auto desc = std::make_shared<gtpsa::desc>(ps_dim, 1);
+	std::array<double, ps_dim> x;
+	for(int k = 0; k < ps_dim; ++k){
+		x[k] = x0[k];
+	}
+
+	/* diffusion matrices are only accumulated when computing emittances */
+	const bool emittance = conf.emittance;
+	conf.emittance = conf.radiation;
+
+	for(size_t i = 0; i < n_elements; ++i){
+		std::shared_ptr<tse::RadiationDelegateKickKnobbed<tse::FieldKickAPIKnobbed<C>>> rad_del;
+		auto kick = std::dynamic_pointer_cast<tse::FieldKickKnobbed<C>>(acc.at(i));
+		if(kick && conf.radiation){
+			rad_del = kick->getRadiationDelegate();
+		}
+		if(rad_del){
+			rad_del->reset();
+		}
+
+		gtpsa::ss_vect<gtpsa::tpsa> ps(desc, 1);
+		ps.set_identity();
+		for(int k = 0; k < ps_dim; ++k){
+			ps[k] += x[k];
+		}
+
+		int last = -1;
+		try {
+			last = acc.propagate(conf, ps, i, 1);
+		} catch(...) {
+			conf.emittance = emittance;
+			throw;
+		}
+		if(last != static_cast<int>(i + 1)){
+			conf.emittance = emittance;
+			std::stringstream strm;
+			strm << "envelope: orbit lost at element " << i << " " << acc.at(i)->name;
+			throw std::runtime_error(strm.str());
+		}
+
+		const arma::mat jac = ps.jacobian();
+		const arma::mat M = jac.submat(0, 0, ps_dim - 1, ps_dim - 1);
+		for(int k = 0; k < ps_dim; ++k){
+			x[k] = ps[k].cst();
+		}
+
+		arma::mat B(ps_dim, ps_dim, arma::fill::zeros);
+		if(rad_del){
+			const arma::mat& B_entrance = rad_del->getDiffusionMatrixIncrement();
+			B = M * B_entrance * M.t();
+		}
+
+		this->m_turn_map = M * this->m_turn_map;
+		this->m_turn_diffusion = M * this->m_turn_diffusion * M.t() + B;
+		this->m_maps.push_back(M);
+		this->m_diffusion.push_back(B);
+	}
+	conf.emittance = emittance;
+}
+
+static void check_sigma(const arma::mat& sigma)
+{
+	if(sigma.n_rows != ps_dim || sigma.n_cols != ps_dim){
+		std::stringstream strm;
+		strm << "envelope: sigma matrix has to be " << ps_dim << "x" << ps_dim
+		     << " but is " << sigma.n_rows << "x" << sigma.n_cols;
+		throw std::invalid_argument(strm.str());
+	}
+}
+
+void ts::EnvelopeTracker::propagate(arma::mat& sigma, const size_t n_turns) const
+{
+	check_sigma(sigma);
+	for(size_t turn = 0; turn < n_turns; ++turn){
+		sigma = this->m_turn_map * sigma * this->m_turn_map.t() + this->m_turn_diffusion;
+	}
+}
+
+std::vector<arma::mat> ts::EnvelopeTracker::alongRing(const arma::mat& sigma) const
+{
+	check_sigma(sigma);
+	std::vector<arma::mat> result;
+	result.reserve(this->size());
+	arma::mat s = sigma;
+	for(size_t i = 0; i < this->size(); ++i){
+		s = this->m_maps[i] * s * this->m_maps[i].t() + this->m_diffusion[i];
+		result.push_back(s);
+	}
+	return result;
+}
+
+std::vector<arma::mat> ts::EnvelopeTracker::turnByTurn(const arma::mat& sigma, const size_t n_turns) const
+{
+	check_sigma(sigma);
+	std::vector<arma::mat> result;
+	result.reserve(n_turns);
+	arma::mat s = sigma;
+	for(size_t turn = 0; turn < n_turns; ++turn){
+		this->propagate(s, 1);
+		result.push_back(s);
+	}
+	return result;
+}
+
+arma::mat ts::EnvelopeTracker::equilibrium(void) const
+{
+	return solve_discrete_lyapunov(this->m_turn_map, this->m_turn_diffusion);
+}
+
+arma::mat ts::solve_discrete_lyapunov(const arma::mat& M, const arma::mat& B)
+{
+	const size_t n = M.n_rows;
+	if(M.n_cols != n || B.n_rows != n || B.n_cols != n){
+		std::stringstream strm;
+		strm << "discrete lyapunov: M (" << M.n_rows << "x" << M.n_cols
+		     << ") and B (" << B.n_rows << "x" << B.n_cols << ") have to be square and of the same size";
+		throw std::invalid_argument(strm.str());
+	}
+
+	arma::cx_mat U, T;
+	if(!arma::schur(U, T, arma::cx_mat(M, arma::zeros(n, n)))){
+		throw std::runtime_error("discrete lyapunov: Schur decomposition failed");
+	}
+	for(size_t j = 0; j < n; ++j){
+		if(std::abs(T(j, j)) >= 1e0){
+			std::stringstream strm;
+			strm << "discrete lyapunov: M not damped, eigenvalue " << T(j, j)
+			     << " of modulus " << std::abs(T(j, j));
+			throw std::runtime_error(strm.str());
+		}
+	}
+
+	/* X = T X T^H + C, column j depends on the columns k > j */
+	const arma::cx_mat C = U.t() * arma::cx_mat(B, arma::zeros(n, n)) * U;
+	const arma::cx_mat I = arma::eye<arma::cx_mat>(n, n);
+	arma::cx_mat X(n, n, arma::fill::zeros);
+	for(size_t jj = n; jj > 0; --jj){
+		const size_t j = jj - 1;
+		arma::cx_vec s(n, arma::fill::zeros);
+		for(size_t k = j + 1; k < n; ++k){
+			s += X.col(k) * std::conj(T(j, k));
+		}
+		const arma::cx_vec rhs = C.col(j) + T * s;
+		const arma::cx_mat A = I - std::conj(T(j, j)) * T;
+		X.col(j) = arma::solve(arma::trimatu(A), rhs);
+	}
+
+	const arma::mat S = arma::real(U * X * U.t());
+	/* symmetric up to round off */
+	return (S + S.t()) / 2e0;
+}
+
+std::array<double, 3> ts::eigen_emittances(const arma::mat& sigma)
+{
+	if(sigma.n_rows != ps_dim || sigma.n_cols != ps_dim){
+		throw std::invalid_argument("eigen emittances: sigma matrix has to be 6x6");
+	}
+	arma::mat J(ps_dim, ps_dim, arma::fill::zeros);
+	for(int k = 0; k < 3; ++k){
+		J(2 * k, 2 * k + 1) = 1e0;
+		J(2 * k + 1, 2 * k) = -1e0;
+	}
+
+	arma::cx_vec w;
+	arma::cx_mat v;
+	if(!arma::eig_gen(w, v, arma::mat(sigma * J))){
+		throw std::runtime_error("eigen emittances: eigen decomposition failed");
+	}
+	/* eigenvalues come in pairs +/- i eps */
+	const arma::uvec order = arma::sort_index(arma::imag(w), "descend");
+
+	std::array<double, 3> eps = {0e0, 0e0, 0e0};
+	std::array<bool, 3> assigned = {false, false, false};
+	for(int n = 0; n < 3; ++n){
+		const auto idx = order(n);
+		int plane = -1;
+		double weight_max = -1e0;
+		for(int k = 0; k < 3; ++k){
+			const double weight = std::norm(v(2 * k, idx)) + std::norm(v(2 * k + 1, idx));
+			if(!assigned[k] && weight > weight_max){
+				weight_max = weight;
+				plane = k;
+			}
+		}
+		assigned[plane] = true;
+		eps[plane] = std::abs(w(idx).imag());
+	}
+	return eps;
+}
+
+template ts::EnvelopeTracker::EnvelopeTracker(ts::AcceleratorKnobbable<tsc::StandardDoubleType>& acc, tsc::ConfigType& conf,
+					      const gtpsa::ss_vect<double>& x0);
+template ts::EnvelopeTracker::EnvelopeTracker(ts::AcceleratorKnobbable<tsc::TpsaVariantType>& acc, tsc::ConfigType& conf,
+					      const gtpsa::ss_vect<double>& x0);
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
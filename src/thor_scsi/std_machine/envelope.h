@@ -0,0 +1,124 @@
+#ifndef _THOR_SCSI_STD_MACHINE_ENVELOPE_H_
+#define _THOR_SCSI_STD_MACHINE_ENVELOPE_H_
+
+#include <thor_scsi/std_machine/accelerator.h>
+#include <thor_scsi/core/config.h>
+#include <gtpsa/ss_vect.h>
+#include <armadillo>
+#include <array>
+#include <vector>
+
+namespace thor_scsi {
+
+	/**
+	 * @brief transport of the beam covariance (sigma) matrix
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * On construction each element is linearised once around the
+	 * orbit starting at x0: its Jacobian M and, with radiation on,
+	 * its diffusion matrix B (quantum excitation of the
+	 * :class:`RadiationDelegateKick` installed) are stored. The
+	 * Jacobian includes the radiation damping. Then a sigma matrix
+	 * is transported element by element as
+	 *
+	 * .. math::
+	 *
+	 *     \Sigma \rightarrow M \Sigma M^T + B
+	 *
+	 * which costs a few 6x6 products per element. The one turn map
+	 * and diffusion matrix are composed as well, so turn by turn
+	 * damping needs two products per turn.
+	 *
+	 * The configuration's switches (radiation, cavity, ...) select
+	 * the physics included. With radiation on, diffusion is computed
+	 * independent of conf.emittance.
+	 *
+	 * \endverbatim
+	 */
+	class EnvelopeTracker {
+	public:
+		/**
+		 * @param acc accelerator, delegates have to be installed for diffusion
+		 * @param conf calculation configuration
+		 * @param x0 start of the orbit, typically the fix point
+		 *
+		 * @throws std::runtime_error if the orbit is lost
+		 */
+		template<class C>
+		EnvelopeTracker(AcceleratorKnobbable<C>& acc, thor_scsi::core::ConfigType& conf,
+				const gtpsa::ss_vect<double>& x0);
+
+		/// number of elements linearised
+		inline size_t size(void) const { return this->m_maps.size(); }
+		/// Jacobian of element i
+		inline const arma::mat& getMap(const size_t i) const { return this->m_maps.at(i); }
+		/// diffusion matrix of element i, at its exit
+		inline const arma::mat& getDiffusion(const size_t i) const { return this->m_diffusion.at(i); }
+		inline const arma::mat& getOneTurnMap(void) const { return this->m_turn_map; }
+		/// diffusion matrix of one turn, at the end of the turn
+		inline const arma::mat& getOneTurnDiffusion(void) const { return this->m_turn_diffusion; }
+
+		/**
+		 * @brief transport sigma through the machine for n_turns turns
+		 *
+		 * @throws std::invalid_argument if sigma is not 6x6
+		 */
+		void propagate(arma::mat& sigma, const size_t n_turns=1) const;
+
+		/// sigma at the exit of each element during one turn
+		std::vector<arma::mat> alongRing(const arma::mat& sigma) const;
+
+		/// sigma at the end of each of n_turns turns
+		std::vector<arma::mat> turnByTurn(const arma::mat& sigma, const size_t n_turns) const;
+
+		/**
+		 * @brief equilibrium sigma matrix at the start of the turn
+		 *
+		 * Ohmi envelope: the fix point of one turn,
+		 * see :func:`solve_discrete_lyapunov`.
+		 */
+		arma::mat equilibrium(void) const;
+
+	private:
+		std::vector<arma::mat> m_maps, m_diffusion;
+		arma::mat m_turn_map, m_turn_diffusion;
+	};
+
+	/**
+	 * @brief solve the discrete Lyapunov equation M S M^T + B = S
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * Bartels-Stewart: with the complex Schur decomposition
+	 * M = U T U^H the equation becomes X = T X T^H + U^H B U, which
+	 * is solved column by column from the last one, each a
+	 * triangular system. Then S = U X U^H. The cost is that of the
+	 * Schur decomposition, negligible for 6x6 matrices.
+	 *
+	 * \endverbatim
+	 *
+	 * @throws std::invalid_argument if the shapes do not match
+	 * @throws std::runtime_error if M is not damped (an eigenvalue
+	 *         of modulus 1 or larger), thus no equilibrium exists
+	 */
+	arma::mat solve_discrete_lyapunov(const arma::mat& M, const arma::mat& B);
+
+	/**
+	 * @brief eigen emittances of a 6x6 sigma matrix
+	 *
+	 * The moduli of the eigenvalues of sigma J (J the symplectic
+	 * form), invariant under symplectic transformations and thus
+	 * valid for fully coupled motion. Each is assigned to the plane
+	 * (X_, Y_, Z_) its eigenvector has most of its weight in.
+	 */
+	std::array<double, 3> eigen_emittances(const arma::mat& sigma);
+
+} // namespace thor_scsi
+#endif /* _THOR_SCSI_STD_MACHINE_ENVELOPE_H_ */
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -0,0 +1,78 @@
+#include <thor_scsi/std_machine/girders.h>
+#include <thor_scsi/elements/element_local_coordinates.h>
+#include <thor_scsi/core/exceptions.h>
+#include <sstream>
+
+namespace ts = thor_scsi;
+namespace tsc = thor_scsi::core;
+namespace tse = thor_scsi::elements;
+
+template<class C>
+std::vector<std::shared_ptr<tsc::GirderKnobbed<C>>>
+ts::mount_on_girders(ts::AcceleratorKnobbable<C>& acc, const std::string& start_marker, const std::string& end_marker)
+{
+	std::vector<std::shared_ptr<tsc::GirderKnobbed<C>>> girders;
+	std::shared_ptr<tsc::GirderKnobbed<C>> girder;
+
+	for(size_t n = 0; n < acc.size(); ++n){
+		auto cv = acc.at(n);
+		if(cv->name == start_marker){
+			if(girder){
+				std::stringstream strm;
+				strm << "Girder start marker '" << start_marker << "' at element " << n
+				     << " found within girder " << girder->name << ": girders can not be nested";
+				throw ts::SanityCheckError(strm.str());
+			}
+			std::stringstream name;
+			name << start_marker << "_" << girders.size();
+			girder = std::make_shared<tsc::GirderKnobbed<C>>(name.str());
+			girders.push_back(girder);
+		}
+		const bool at_end = (cv->name == end_marker);
+		if(at_end && !girder){
+			std::stringstream strm;
+			strm << "Girder end marker '" << end_marker << "' at element " << n
+			     << " without preceeding start marker '" << start_marker << "'";
+			throw ts::SanityCheckError(strm.str());
+		}
+		if(girder){
+			auto local = std::dynamic_pointer_cast<tse::LocalCoordinatesKnobbed<C>>(cv);
+			if(local){
+				local->setGirder(girder);
+			}
+		}
+		if(at_end){
+			girder.reset();
+		}
+	}
+	if(girder){
+		std::stringstream strm;
+		strm << "Girder " << girder->name << " not terminated by end marker '" << end_marker << "'";
+		throw ts::SanityCheckError(strm.str());
+	}
+	return girders;
+}
+
+template<class C>
+void ts::unmount_from_girders(ts::AcceleratorKnobbable<C>& acc)
+{
+	for(auto& cv : acc){
+		auto local = std::dynamic_pointer_cast<tse::LocalCoordinatesKnobbed<C>>(cv);
+		if(local){
+			local->setGirder(nullptr);
+		}
+	}
+}
+
+template std::vector<std::shared_ptr<tsc::GirderKnobbed<tsc::StandardDoubleType>>>
+ts::mount_on_girders(ts::AcceleratorKnobbable<tsc::StandardDoubleType>& acc, const std::string& start_marker, const std::string& end_marker);
+template std::vector<std::shared_ptr<tsc::GirderKnobbed<tsc::TpsaVariantType>>>
+ts::mount_on_girders(ts::AcceleratorKnobbable<tsc::TpsaVariantType>& acc, const std::string& start_marker, const std::string& end_marker);
+template void ts::unmount_from_girders(ts::AcceleratorKnobbable<tsc::StandardDoubleType>& acc);
+template void ts::unmount_from_girders(ts::AcceleratorKnobbable<tsc::TpsaVariantType>& acc);
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
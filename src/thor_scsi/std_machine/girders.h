@@ -0,0 +1,55 @@
+#ifndef _THOR_SCSI_STD_MACHINE_GIRDERS_H_
+#define _THOR_SCSI_STD_MACHINE_GIRDERS_H_
+
+#include <thor_scsi/std_machine/accelerator.h>
+#include <thor_scsi/core/girder.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace thor_scsi {
+
+	/**
+	 * @brief mount the elements between girder start and end markers on girders
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * The lattice is scanned for elements named `start_marker` and
+	 * `end_marker`. For each such pair a girder is created and all
+	 * elements from the start marker up to and including the end marker,
+	 * which support local coordinates (i.e. can be misaligned), are
+	 * mounted on it. Drifts in between are not misaligned: they commute
+	 * with the girder transform.
+	 *
+	 * The girders are named after the start marker with the index of the
+	 * pair appended (e.g. `gs_0`, `gs_1`, ...).
+	 *
+	 * This replaces the girder start / end marker families `gs` and `ge`
+	 * of :class:`ConfigType` used by the former girder setup.
+	 *
+	 * \endverbatim
+	 *
+	 * @returns the created girders in lattice order
+	 *
+	 * @throws thor_scsi::SanityCheckError if markers are not found in pairs
+	 *         (start followed by end, not nested).
+	 */
+	template<class C>
+	std::vector<std::shared_ptr<thor_scsi::core::GirderKnobbed<C>>>
+	mount_on_girders(AcceleratorKnobbable<C>& acc, const std::string& start_marker, const std::string& end_marker);
+
+	/**
+	 * @brief remove all elements from their girders
+	 */
+	template<class C>
+	void unmount_from_girders(AcceleratorKnobbable<C>& acc);
+
+} // namespace thor_scsi
+
+#endif /* _THOR_SCSI_STD_MACHINE_GIRDERS_H_ */
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
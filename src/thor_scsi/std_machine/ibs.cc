@@ -0,0 +1,274 @@
+#include <thor_scsi/std_machine/ibs.h>
+#include <thor_scsi/elements/constants.h>
+#include <thor_scsi/core/parallel.h>
+#include <tps/enums.h>
+#include <armadillo>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace ts = thor_scsi;
+namespace tsc = thor_scsi::core;
+namespace tse = thor_scsi::elements;
+
+/* the Coulomb logarithm is only required here */
+static void check_input(const ts::LatticeFunctions& lf, const ts::BeamParameters& beam)
+{
+	lf.check();
+	beam.check();
+	if(!(beam.coulomb_log > 0e0) || !std::isfinite(beam.coulomb_log)){
+		std::stringstream strm;
+		strm << "IBS: coulomb_log has to be positive and finite but is " << beam.coulomb_log;
+		throw std::invalid_argument(strm.str());
+	}
+}
+
+double ts::ibs_bane_g(const double alpha)
+{
+	if(!(alpha > 0e0)){
+		throw std::invalid_argument("IBS: argument of Bane's g function has to be positive");
+	}
+	/* arithmetic geometric mean, converges quadratically */
+	double a = 1e0, b = alpha;
+	while(std::abs(a - b) > 1e-15 * a){
+		const double a_next = (a + b) / 2e0;
+		b = std::sqrt(a * b);
+		a = a_next;
+	}
+	return std::sqrt(alpha) / a;
+}
+
+namespace {
+/* optics at one position */
+struct LocalOptics {
+	double beta[2], curly_H[2], phi[2];
+
+	LocalOptics(const ts::LatticeFunctions& lf, const size_t i) {
+		for(int k = 0; k < 2; ++k){
+			const double alpha = lf.alpha[k][i], beta = lf.beta[k][i];
+			this->beta[k] = beta;
+			this->curly_H[k] = lf.curlyH(k, i);
+			this->phi[k] = lf.etap[k][i] + alpha * lf.eta[k][i] / beta;
+		}
+	}
+};
+
+/* Gauss-Legendre, 4 nodes on [-1, 1] */
+const double gl_node[] = {-0.8611363115940526, -0.3399810435848563, 0.3399810435848563, 0.8611363115940526};
+const double gl_weight[] = {0.3478548451374538, 0.6521451548625461, 0.6521451548625461, 0.3478548451374538};
+
+/*
+ * Bjorken-Mtingwa integrals of the three planes at one position
+ *
+ * With L = V diag(l) V^T the integrand is a sum of terms
+ * c_ik / (l_k + lambda) / sqrt(prod(l_m + lambda)). It is integrated
+ * in t = ln(lambda) on unit intervals, 4 Gauss nodes each, all nodes
+ * evaluated at once. The integrand decays as exp(1.5 t) below the
+ * smallest eigenvalue and as exp(-t) above the largest one.
+ */
+std::array<double, 3> bm_integrals(const LocalOptics& o, const ts::BeamParameters& beam, const double gamma)
+{
+	arma::mat::fixed<3, 3> L_p(arma::fill::zeros), L_x(arma::fill::zeros), L_y(arma::fill::zeros);
+	L_p(1, 1) = gamma * gamma / (beam.sigma_delta * beam.sigma_delta);
+
+	const double bx = o.beta[X_] / beam.eps[X_], by = o.beta[Y_] / beam.eps[Y_];
+	L_x(0, 0) = bx;
+	L_x(0, 1) = L_x(1, 0) = -bx * gamma * o.phi[X_];
+	L_x(1, 1) = gamma * gamma * o.curly_H[X_] / beam.eps[X_];
+	L_y(2, 2) = by;
+	L_y(1, 2) = L_y(2, 1) = -by * gamma * o.phi[Y_];
+	L_y(1, 1) = gamma * gamma * o.curly_H[Y_] / beam.eps[Y_];
+
+	const arma::mat::fixed<3, 3> L = L_p + L_x + L_y;
+	arma::vec l;
+	arma::mat V;
+	if(!arma::eig_sym(l, V, arma::mat(L))){
+		throw std::runtime_error("IBS: eigen decomposition of the Bjorken-Mtingwa matrix failed");
+	}
+	/* positive semi definite, guard against round off */
+	const double l_max = l.max();
+	l = arma::clamp(l, 1e-30 * l_max, l_max);
+
+	/* c(i, k): coefficient of plane i (x, y, p) for eigenvalue k */
+	arma::mat::fixed<3, 3> c;
+	const arma::mat::fixed<3, 3>* L_i[] = {&L_x, &L_y, &L_p};
+	for(int i = 0; i < 3; ++i){
+		const arma::mat M = V.t() * (*L_i[i]) * V;
+		const double tr = arma::trace(*L_i[i]);
+		for(int k = 0; k < 3; ++k){
+			c(i, k) = tr - 3e0 * M(k, k);
+		}
+	}
+
+	const double t_lo = std::log(l.min()) - 30e0, t_hi = std::log(l_max) + 40e0;
+	const int n_intervals = static_cast<int>(std::ceil(t_hi - t_lo));
+	const int n_nodes = 4;
+	arma::vec t(n_intervals * n_nodes), w(n_intervals * n_nodes);
+	for(int j = 0; j < n_intervals; ++j){
+		for(int q = 0; q < n_nodes; ++q){
+			t(j * n_nodes + q) = t_lo + j + 0.5 + 0.5 * gl_node[q];
+			w(j * n_nodes + q) = 0.5 * gl_weight[q];
+		}
+	}
+	const arma::vec lambda = arma::exp(t);
+	const arma::vec d0 = l(0) + lambda, d1 = l(1) + lambda, d2 = l(2) + lambda;
+	/* dlambda = lambda dt */
+	const arma::vec common = w % arma::pow(lambda, 1.5) / arma::sqrt(d0 % d1 % d2);
+
+	std::array<double, 3> result;
+	for(int i = 0; i < 3; ++i){
+		result[i] = arma::accu(common % (c(i, 0) / d0 + c(i, 1) / d1 + c(i, 2) / d2));
+	}
+	return result;
+}
+
+std::array<double, 3> bm_rates(const LocalOptics& o, const ts::BeamParameters& beam, const double gamma)
+{
+	const double beta_rel = std::sqrt(1e0 - 1e0 / (gamma * gamma));
+	const double A =
+		tse::r_e * tse::r_e * tse::speed_of_light * beam.n_particles
+		/ (64e0 * M_PI * M_PI * std::pow(beta_rel, 3) * std::pow(gamma, 4)
+		   * beam.eps[X_] * beam.eps[Y_] * beam.sigma_s * beam.sigma_delta);
+	const auto integrals = bm_integrals(o, beam, gamma);
+	std::array<double, 3> rates;
+	for(int i = 0; i < 3; ++i){
+		rates[i] = 4e0 * M_PI * A * beam.coulomb_log * integrals[i];
+	}
+	return rates;
+}
+
+std::array<double, 3> bane_rates(const LocalOptics& o, const ts::BeamParameters& beam, const double gamma)
+{
+	const double sigma_delta2 = beam.sigma_delta * beam.sigma_delta;
+	const double sigma_H = 1e0 / std::sqrt(1e0 / sigma_delta2
+					       + o.curly_H[X_] / beam.eps[X_] + o.curly_H[Y_] / beam.eps[Y_]);
+	const double a = sigma_H / gamma * std::sqrt(o.beta[X_] / beam.eps[X_]);
+	const double b = sigma_H / gamma * std::sqrt(o.beta[Y_] / beam.eps[Y_]);
+
+	const double rate_p =
+		tse::r_e * tse::r_e * tse::speed_of_light * beam.n_particles * beam.coulomb_log
+		/ (16e0 * std::pow(gamma, 3) * std::pow(beam.eps[X_] * beam.eps[Y_], 0.75)
+		   * beam.sigma_s * sigma_delta2 * beam.sigma_delta)
+		* sigma_H * ts::ibs_bane_g(a / b) / std::pow(o.beta[X_] * o.beta[Y_], 0.25);
+
+	return {
+		sigma_delta2 * o.curly_H[X_] / beam.eps[X_] * rate_p,
+		sigma_delta2 * o.curly_H[Y_] / beam.eps[Y_] * rate_p,
+		rate_p
+	};
+}
+} // namespace
+
+ts::IBSGrowthRates ts::ibs_growth_rates(const ts::LatticeFunctions& lf, const ts::BeamParameters& beam,
+					const ts::IBSModel model, const size_t n_threads)
+{
+	check_input(lf, beam);
+
+	const size_t n = lf.size();
+	const double gamma = beam.energy / tse::m_e;
+
+	IBSGrowthRates result;
+	for(auto& local : result.local){
+		local.assign(n, 0e0);
+	}
+
+	tsc::parallel_for(n, n_threads, [&](const size_t i){
+		const LocalOptics optics(lf, i);
+		std::array<double, 3> rates;
+		switch(model){
+		case IBSModel::BjorkenMtingwa:
+			rates = bm_rates(optics, beam, gamma);
+			break;
+		case IBSModel::Bane:
+			rates = bane_rates(optics, beam, gamma);
+			break;
+		default:
+			throw std::invalid_argument("IBS: unknown model");
+		}
+		for(int k = 0; k < 3; ++k){
+			result.local[k][i] = rates[k];
+		}
+	});
+
+	double length = 0e0;
+	for(size_t i = 0; i < n; ++i){
+		length += lf.length[i];
+		for(int k = 0; k < 3; ++k){
+			result.rate[k] += lf.length[i] * result.local[k][i];
+		}
+	}
+	if(!(length > 0e0)){
+		throw std::invalid_argument("IBS: total length of the lattice functions not positive");
+	}
+	for(auto& rate : result.rate){
+		rate /= length;
+	}
+	return result;
+}
+
+ts::BeamParameters ts::ibs_equilibrium(const ts::LatticeFunctions& lf, const ts::BeamParameters& beam0,
+				const std::array<double, 3>& tau, const ts::IBSModel model,
+				const double tolerance, const int max_iter, const size_t n_threads)
+{
+	beam0.check();
+	for(int k = 0; k < 3; ++k){
+		if(!(tau[k] > 0e0)){
+			std::stringstream strm;
+			strm << "IBS equilibrium: damping time " << k << " has to be positive but is " << tau[k];
+			throw std::invalid_argument(strm.str());
+		}
+	}
+
+	BeamParameters beam = beam0;
+	for(int iter = 0; iter < max_iter; ++iter){
+		const auto rates = ibs_growth_rates(lf, beam, model, n_threads).rate;
+
+		double factor[3];
+		for(int k = 0; k < 3; ++k){
+			factor[k] = 1e0 - tau[k] * rates[k];
+			if(factor[k] <= 0e0){
+				std::stringstream strm;
+				strm << "IBS equilibrium: growth rate " << rates[k] << " of plane " << k
+				     << " exceeds the damping rate " << 1e0 / tau[k] << ", no equilibrium";
+				throw std::runtime_error(strm.str());
+			}
+		}
+		const double eps_x = beam0.eps[X_] / factor[X_], eps_y = beam0.eps[Y_] / factor[Y_];
+		const double sigma_delta = beam0.sigma_delta / std::sqrt(factor[Z_]);
+
+		const double change = std::max({
+				std::abs(eps_x / beam.eps[X_] - 1e0),
+				std::abs(eps_y / beam.eps[Y_] - 1e0),
+				std::abs(sigma_delta / beam.sigma_delta - 1e0)
+			});
+
+		/* geometric mean of old and new: damps the oscillation for strong IBS */
+		beam.eps[X_] = std::sqrt(beam.eps[X_] * eps_x);
+		beam.eps[Y_] = std::sqrt(beam.eps[Y_] * eps_y);
+		beam.sigma_delta = std::sqrt(beam.sigma_delta * sigma_delta);
+		beam.sigma_s = beam0.sigma_s * beam.sigma_delta / beam0.sigma_delta;
+		if(change < tolerance){
+			return beam;
+		}
+	}
+	std::stringstream strm;
+	strm << "IBS equilibrium: not converged within " << max_iter << " iterations";
+	throw std::runtime_error(strm.str());
+}
+
+ts::BeamParameters ts::ibs_equilibrium(const ts::LatticeFunctions& lf, const ts::RadiationSummary& summary,
+				const ts::BeamParameters& beam, const ts::IBSModel model,
+				const double tolerance, const int max_iter, const size_t n_threads)
+{
+	BeamParameters beam0 = beam;
+	beam0.eps[X_] = summary.eps[X_];
+	beam0.sigma_delta = summary.sigma_delta;
+	return ibs_equilibrium(lf, beam0, summary.tau, model, tolerance, max_iter, n_threads);
+}
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
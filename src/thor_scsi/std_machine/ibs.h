@@ -0,0 +1,124 @@
+#ifndef _THOR_SCSI_STD_MACHINE_IBS_H_
+#define _THOR_SCSI_STD_MACHINE_IBS_H_
+
+#include <thor_scsi/std_machine/radiation_summary.h>
+#include <thor_scsi/std_machine/beam_parameters.h>
+#include <array>
+#include <cmath>
+#include <vector>
+
+namespace thor_scsi {
+
+	/**
+	 * @brief models for the intrabeam scattering growth rates
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * * BjorkenMtingwa: J. D. Bjorken, S. K. Mtingwa, "Intrabeam
+	 *   scattering", Part. Accel. 13, 115 (1983), in the matrix form
+	 *   of K. Kubo, K. Oide and K. Bane. Includes vertical
+	 *   dispersion. The integral is evaluated numerically.
+	 * * Bane: high energy approximation of K. Bane, "An accurate,
+	 *   simplified model of intrabeam scattering", SLAC-AP-141
+	 *   (2002). Closed form, valid for a, b << 1 (typically the case
+	 *   for electron storage rings above a few hundred MeV).
+	 *
+	 * \endverbatim
+	 */
+	enum class IBSModel {
+		BjorkenMtingwa = 0,
+		Bane = 1
+	};
+
+	/**
+	 * @brief amplitude growth rates [1/s]
+	 *
+	 * 1/T_x = 1/sqrt(eps_x) d sqrt(eps_x)/dt, 1/T_y likewise and
+	 * 1/T_p = 1/sigma_delta d sigma_delta/dt. Indices X_, Y_, Z_,
+	 * with Z_ the one of sigma_delta.
+	 */
+	struct IBSGrowthRates {
+		/// averaged around the ring, weighted by the length
+		std::array<double, 3> rate = {0e0, 0e0, 0e0};
+		/// at each position
+		std::array<std::vector<double>, 3> local;
+	};
+
+	/**
+	 * @brief intrabeam scattering growth rates at each position
+	 *
+	 * The positions are independent and distributed over n_threads
+	 * threads (0: hardware concurrency).
+	 *
+	 * @throws std::invalid_argument for inconsistent input, including
+	 *         a Coulomb logarithm not positive
+	 */
+	IBSGrowthRates ibs_growth_rates(const LatticeFunctions& lf, const BeamParameters& beam,
+					const IBSModel model = IBSModel::BjorkenMtingwa,
+					const size_t n_threads = 0);
+
+	/**
+	 * @brief equilibrium of radiation damping, quantum excitation and IBS
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * With the amplitude damping times tau and zero current
+	 * parameters (index 0) the equilibrium satisfies
+	 *
+	 * .. math::
+	 *
+	 *     \epsilon_{x,y} = \frac{\epsilon_{x,y,0}}{1 - \tau_{x,y} / T_{x,y}},
+	 *     \qquad
+	 *     \sigma_\delta^2 = \frac{\sigma_{\delta,0}^2}{1 - \tau_z / T_p}
+	 *
+	 * with the growth rates evaluated at the equilibrium. The bunch
+	 * length scales with the energy spread. Solved by fix point
+	 * iteration until the relative change of the emittances and the
+	 * energy spread is below tolerance.
+	 *
+	 * \endverbatim
+	 *
+	 * @param beam0 zero current beam parameters
+	 * @param tau amplitude damping times [s], indices X_, Y_, Z_
+	 *
+	 * @returns beam parameters at equilibrium
+	 *
+	 * @throws std::runtime_error if IBS is stronger than damping
+	 *         (no equilibrium) or the iteration does not converge
+	 */
+	BeamParameters ibs_equilibrium(const LatticeFunctions& lf, const BeamParameters& beam0,
+				const std::array<double, 3>& tau,
+				const IBSModel model = IBSModel::BjorkenMtingwa,
+				const double tolerance = 1e-6, const int max_iter = 100,
+				const size_t n_threads = 0);
+
+	/**
+	 * @brief equilibrium with the zero current parameters of a radiation summary
+	 *
+	 * eps[X_], sigma_delta and the damping times are taken from the
+	 * summary, the remaining parameters (energy, number of particles,
+	 * eps[Y_] given by coupling, bunch length given by the cavity
+	 * and Coulomb logarithm) from beam.
+	 */
+	BeamParameters ibs_equilibrium(const LatticeFunctions& lf, const RadiationSummary& summary,
+				const BeamParameters& beam,
+				const IBSModel model = IBSModel::BjorkenMtingwa,
+				const double tolerance = 1e-6, const int max_iter = 100,
+				const size_t n_threads = 0);
+
+	/**
+	 * @brief Bane's g function
+	 *
+	 * g(alpha) = 2 sqrt(alpha) / pi \int_0^\infty du / sqrt((1 + u^2)(alpha^2 + u^2))
+	 * evaluated as sqrt(alpha) / AGM(1, alpha). g(1) = 1 and g(alpha) = g(1/alpha).
+	 */
+	double ibs_bane_g(const double alpha);
+
+} // namespace thor_scsi
+#endif /* _THOR_SCSI_STD_MACHINE_IBS_H_ */
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -0,0 +1,277 @@
+#include <thor_scsi/std_machine/lattice_hash.h>
+#include <thor_scsi/elements/field_kick.h>
+#include <thor_scsi/elements/cavity.h>
+#include <thor_scsi/core/multipoles.h>
+#include <thor_scsi/custom/aircoil_interpolation.h>
+#include <thor_scsi/custom/field_map_interpolation.h>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <typeinfo>
+
+namespace ts = thor_scsi;
+namespace tsc = thor_scsi::core;
+namespace tse = thor_scsi::elements;
+namespace tsu = thor_scsi::custom;
+
+void ts::ContentHasher::addBytes(const void *data, const size_t n)
+{
+	auto p = static_cast<const unsigned char *>(data);
+	for(size_t i=0; i<n; ++i){
+		this->m_state ^= static_cast<uint64_t>(p[i]);
+		this->m_state *= prime;
+	}
+}
+
+ts::ContentHasher& ts::ContentHasher::add(const double val)
+{
+	double tmp = val;
+	if(std::isnan(tmp)){
+		tmp = NAN;
+	} else if(tmp == 0e0){
+		/* -0.0 == 0.0 */
+		tmp = 0e0;
+	}
+	uint64_t bits;
+	std::memcpy(&bits, &tmp, sizeof(bits));
+	this->addBytes(&bits, sizeof(bits));
+	return *this;
+}
+
+ts::ContentHasher& ts::ContentHasher::add(const double *vals, const size_t n)
+{
+	this->add(static_cast<int64_t>(n));
+	for(size_t i=0; i<n; ++i){
+		this->add(vals[i]);
+	}
+	return *this;
+}
+
+ts::ContentHasher& ts::ContentHasher::add(const int64_t val)
+{
+	this->addBytes(&val, sizeof(val));
+	return *this;
+}
+
+ts::ContentHasher& ts::ContentHasher::add(const std::string& val)
+{
+	this->add(static_cast<int64_t>(val.size()));
+	this->addBytes(val.data(), val.size());
+	return *this;
+}
+
+template<class C>
+static void hash_field_kick(ts::ContentHasher& hasher, const tse::FieldKickKnobbed<C>& fk)
+{
+	hasher.add(fk.getIntegrationMethod())
+		.add(fk.getNumberOfIntegrationSteps())
+		.add(fk.isThick())
+		.add(gtpsa::cst(fk.getCurvature()))
+		.add(fk.getBendingAngle())
+		.add(fk.getEntranceAngle())
+		.add(fk.getExitAngle())
+		.add(fk.getGap());
+}
+
+template<class C>
+static void hash_galilean(ts::ContentHasher& hasher, const tsc::Galilean2DTransformKnobbed<C>& tf)
+{
+	hasher.add(gtpsa::cst(tf.getDx()))
+		.add(gtpsa::cst(tf.getDy()))
+		.add(gtpsa::cst(tf.getRoll()));
+}
+
+template<class C>
+static void hash_girder(ts::ContentHasher& hasher, const std::shared_ptr<tsc::GirderKnobbed<C>>& girder)
+{
+	hasher.add(bool(girder));
+	if(girder){
+		hasher.add(girder->name);
+		hash_galilean(hasher, girder->transform);
+	}
+}
+
+template<class C>
+static void hash_prot(ts::ContentHasher& hasher, const tsc::PhaseSpaceGalileanPRot2DTransformKnobbed<C>& tf)
+{
+	hash_galilean(hasher, tf);
+	hasher.add(gtpsa::cst(tf.getC0()))
+		.add(gtpsa::cst(tf.getC1()))
+		.add(gtpsa::cst(tf.getS1()));
+}
+
+/*
+ * interpolations without access to their parameters: the field on a
+ * few points in the typical aperture
+ */
+template<class C>
+static void hash_field_samples(ts::ContentHasher& hasher, const tsc::Field2DInterpolationKnobbed<C>& intp)
+{
+	hasher.add(std::string(typeid(intp).name()));
+	const double pos[] = {0e0, 1e-3, -2e-3, 5e-3, -1e-2};
+	for(const double x : pos){
+		for(const double y : pos){
+			double Bx = NAN, By = NAN;
+			try {
+				intp.field(x, y, &Bx, &By);
+			} catch(const std::exception&) {
+				/* e.g. outside of a field map: hashed as NaN */
+			}
+			hasher.add(Bx).add(By);
+		}
+	}
+}
+
+template<class C>
+static void hash_interpolation(ts::ContentHasher& hasher, const tsc::Field2DInterpolationKnobbed<C>& intp)
+{
+	if(auto mul = dynamic_cast<const tsc::TwoDimensionalMultipolesKnobbed<C>*>(&intp)){
+		const auto& coeffs = mul->getCoeffs();
+		hasher.add(std::string("multipoles")).add(static_cast<int64_t>(coeffs.size()));
+		for(const auto& c : coeffs){
+			const std::complex<double> v = gtpsa::cst(c);
+			hasher.add(v.real()).add(v.imag());
+		}
+	} else if(auto coil = dynamic_cast<const tsu::AirCoilMagneticFieldKnobbed<C>*>(&intp)){
+		const auto filaments = coil->getUsedFilaments();
+		hasher.add(std::string("aircoil"))
+			.add(std::string(typeid(intp).name()))
+			.add(coil->getScale())
+			.add(static_cast<int64_t>(filaments.size()));
+		for(const auto& f : filaments){
+			hasher.add(f.x).add(f.y).add(f.current);
+		}
+		/* the expansion replaces the exact sum within its radius */
+		hasher.add(coil->hasMultipoleExpansion());
+		if(coil->hasMultipoleExpansion()){
+			const auto& expansion = coil->getMultipoleExpansion();
+			hasher.add(coil->getExpansionRadius()).add(static_cast<int64_t>(expansion.size()));
+			for(const auto& c : expansion){
+				hasher.add(c.real()).add(c.imag());
+			}
+		}
+	} else if(auto fm = dynamic_cast<const tsu::FieldMapInterpolationKnobbed<C>*>(&intp)){
+		const auto grid = fm->getGrid();
+		hasher.add(std::string("field map")).add(fm->getScale()).add(bool(grid));
+		if(grid){
+			hasher.add(static_cast<int64_t>(grid->nx()))
+				.add(static_cast<int64_t>(grid->ny()))
+				.add(grid->x0()).add(grid->y0())
+				.add(grid->dx()).add(grid->dy())
+				.add(grid->coefficients(), grid->nCoefficients());
+		}
+	} else {
+		hash_field_samples(hasher, intp);
+	}
+}
+
+void ts::hash_element(ts::ContentHasher& hasher, const tsc::ElemType& elem)
+{
+	hasher.add(std::string(elem.type_name()))
+		.add(elem.name)
+		.add(elem.getLength());
+
+	if(auto p = dynamic_cast<const tse::LocalGalilean*>(&elem)){
+		hash_galilean(hasher, p->transform);
+	} else if(auto p = dynamic_cast<const tse::LocalGalileanPRot*>(&elem)){
+		hash_prot<tsc::StandardDoubleType>(hasher, p->transform);
+	} else if(auto p = dynamic_cast<const tse::LocalGalileanPRotKnobbed<tsc::TpsaVariantType>*>(&elem)){
+		hash_prot<tsc::TpsaVariantType>(hasher, p->transform);
+	}
+
+	if(auto p = dynamic_cast<const tse::LocalCoordinatesKnobbed<tsc::StandardDoubleType>*>(&elem)){
+		hash_girder(hasher, p->getGirder());
+	} else if(auto p = dynamic_cast<const tse::LocalCoordinatesKnobbed<tsc::TpsaVariantType>*>(&elem)){
+		hash_girder(hasher, p->getGirder());
+	}
+
+	if(auto p = dynamic_cast<const tse::FieldKick*>(&elem)){
+		hash_field_kick(hasher, *p);
+		auto intp = p->getFieldInterpolator();
+		if(intp){
+			hash_interpolation(hasher, *intp);
+		}
+	} else if(auto p = dynamic_cast<const tse::FieldKickTpsa*>(&elem)){
+		hash_field_kick(hasher, *p);
+		auto intp = p->getFieldInterpolator();
+		if(intp){
+			hash_interpolation(hasher, *intp);
+		}
+	}
+
+	if(auto p = dynamic_cast<const tse::CavityType*>(&elem)){
+		hasher.add(p->getVoltage())
+			.add(p->getFrequency())
+			.add(p->getPhase())
+			.add(p->getHarmonicNumber());
+	}
+}
+
+void ts::hash_config(ts::ContentHasher& hasher, const tsc::ConfigType& conf)
+{
+	hasher.add(conf.Cavity_on)
+		.add(conf.radiation)
+		.add(conf.emittance)
+		.add(conf.quad_fringe)
+		.add(conf.H_exact)
+		.add(conf.Cart_Bend)
+		.add(conf.dip_edge_fudge)
+		.add(conf.pathlength)
+		.add(conf.Aperture_on)
+		.add(conf.IBS)
+		.add(conf.RingType)
+		.add(conf.dPparticle)
+		.add(conf.Energy);
+	/* hashes without quantum excitation unchanged */
+	if(conf.quantum_excitation){
+		hasher.add(conf.quantum_excitation)
+			.add(static_cast<int64_t>(conf.qe_seed))
+			.add(static_cast<int64_t>(conf.particle_id))
+			.add(static_cast<int64_t>(conf.turn));
+	}
+}
+
+template<class C>
+uint64_t ts::lattice_hash(const ts::AcceleratorKnobbable<C>& acc)
+{
+	ContentHasher hasher;
+	hasher.add(static_cast<int64_t>(acc.size()));
+	for(const auto& cv : acc){
+		auto elem = std::dynamic_pointer_cast<const tsc::ElemType>(cv);
+		if(!elem){
+			/* not tracked thus only the identity matters */
+			hasher.add(cv->name);
+			continue;
+		}
+		hash_element(hasher, *elem);
+	}
+	return hasher.digest();
+}
+
+template<class C>
+uint64_t ts::lattice_hash(const ts::AcceleratorKnobbable<C>& acc, const tsc::ConfigType& conf)
+{
+	ContentHasher hasher;
+	hasher.add(static_cast<int64_t>(lattice_hash(acc)));
+	hash_config(hasher, conf);
+	return hasher.digest();
+}
+
+std::string ts::hash_to_string(const uint64_t hash)
+{
+	std::stringstream strm;
+	strm << std::hex << std::setw(16) << std::setfill('0') << hash;
+	return strm.str();
+}
+
+template uint64_t ts::lattice_hash(const ts::AcceleratorKnobbable<tsc::StandardDoubleType>& acc);
+template uint64_t ts::lattice_hash(const ts::AcceleratorKnobbable<tsc::TpsaVariantType>& acc);
+template uint64_t ts::lattice_hash(const ts::AcceleratorKnobbable<tsc::StandardDoubleType>& acc, const tsc::ConfigType& conf);
+template uint64_t ts::lattice_hash(const ts::AcceleratorKnobbable<tsc::TpsaVariantType>& acc, const tsc::ConfigType& conf);
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -0,0 +1,111 @@
+#ifndef _THOR_SCSI_STD_MACHINE_LATTICE_HASH_H_
+#define _THOR_SCSI_STD_MACHINE_LATTICE_HASH_H_
+
+#include <thor_scsi/std_machine/accelerator.h>
+#include <thor_scsi/core/config.h>
+#include <cstdint>
+#include <string>
+
+namespace thor_scsi {
+
+	/**
+	 * @brief incremental 64 bit FNV-1a hash
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * Values are fed in their binary representation. Doubles are
+	 * normalised first so that -0.0 and 0.0 as well as all NaNs hash
+	 * the same. Strings are prefixed with their length so that
+	 * concatenations can not collide.
+	 *
+	 * The hash is stable across runs and processes, but depends on the
+	 * byte order of the machine. Thus it is suitable as key for a local
+	 * cache, not as a portable identifier.
+	 *
+	 * \endverbatim
+	 */
+	class ContentHasher {
+	public:
+		inline ContentHasher(void) : m_state(offset_basis) {}
+
+		ContentHasher& add(const double val);
+		ContentHasher& add(const std::string& val);
+		ContentHasher& add(const int64_t val);
+		inline ContentHasher& add(const int val)  { return this->add(static_cast<int64_t>(val)); }
+		inline ContentHasher& add(const long val) { return this->add(static_cast<int64_t>(val)); }
+		inline ContentHasher& add(const bool val) { return this->add(static_cast<int64_t>(val)); }
+		ContentHasher& add(const double *vals, const size_t n);
+
+		inline uint64_t digest(void) const { return this->m_state; }
+
+	private:
+		void addBytes(const void *data, const size_t n);
+
+		static constexpr uint64_t offset_basis = 14695981039346656037ULL;
+		static constexpr uint64_t prime = 1099511628211ULL;
+		uint64_t m_state;
+	};
+
+	/**
+	 * @brief hash over the parameters of an element relevant for tracking
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * Covers type name, name, length, the Galilean misalignment, the
+	 * field kick settings (integration method and steps, curvature,
+	 * bending, entrance and exit angle, gap), the multipole coefficients
+	 * and the cavity parameters.
+	 *
+	 * Elements with TPSA knobs are hashed using their constant part. The
+	 * coefficients of multipoles, air coils and field maps are hashed at
+	 * full precision. Other field interpolations are represented by
+	 * their type and the field sampled at a fixed set of points.
+	 *
+	 * \endverbatim
+	 */
+	void hash_element(ContentHasher& hasher, const thor_scsi::core::ElemType& elem);
+
+	/**
+	 * @brief hash over the switches of the configuration that change the result
+	 *
+	 * Only the input parameters are hashed. Quantities the calculation
+	 * stores as result (e.g. tunes, dE, loss plane) are ignored.
+	 */
+	void hash_config(ContentHasher& hasher, const thor_scsi::core::ConfigType& conf);
+
+	/**
+	 * @brief canonical content hash of the lattice
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * Two accelerators with the same sequence of elements and the same
+	 * element parameters will give the same hash, independent of how they
+	 * were constructed. Observers and radiation delegates are not part
+	 * of the hash.
+	 *
+	 * If a configuration is given its switches are included so that the
+	 * hash can be used to identify results which depend on them (e.g.
+	 * radiation or cavity on).
+	 *
+	 * \endverbatim
+	 */
+	template<class C>
+	uint64_t lattice_hash(const AcceleratorKnobbable<C>& acc);
+
+	template<class C>
+	uint64_t lattice_hash(const AcceleratorKnobbable<C>& acc, const thor_scsi::core::ConfigType& conf);
+
+	/**
+	 * @brief hash as fixed width hexadecimal string e.g. for file names
+	 */
+	std::string hash_to_string(const uint64_t hash);
+
+} // namespace thor_scsi
+
+#endif /* _THOR_SCSI_STD_MACHINE_LATTICE_HASH_H_ */
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
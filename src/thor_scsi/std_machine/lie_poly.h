@@ -0,0 +1,113 @@
+#ifndef _THOR_SCSI_STD_MACHINE_LIE_POLY_H_
+#define _THOR_SCSI_STD_MACHINE_LIE_POLY_H_
+
+/*
+ * Polynomial algebra shared by the driving terms and the tune shift.
+ * Internal: only included by the translation units, not installed.
+ */
+
+#include <complex>
+#include <cstdint>
+#include <map>
+
+namespace thor_scsi {
+	namespace lie_poly {
+
+		typedef std::complex<double> cplx;
+
+		/*
+		 * polynomials in h_x+, h_x-, h_y+, h_y-, delta: exponents packed into 6
+		 * bits each, so that adding keys multiplies monomials
+		 */
+		typedef std::map<uint32_t, cplx> Poly;
+
+		static const int n_bits = 6, delta_var = 4;
+
+		inline unsigned exponent(const uint32_t key, const int v)
+		{
+			return (key >> (v * n_bits)) & ((1u << n_bits) - 1);
+		}
+
+		/* the monomial of variable v */
+		inline uint32_t unit(const int v)
+		{
+			return 1u << (v * n_bits);
+		}
+
+		inline unsigned transverse_degree(const uint32_t key)
+		{
+			return exponent(key, 0) + exponent(key, 1) + exponent(key, 2) + exponent(key, 3);
+		}
+
+		inline unsigned degree(const uint32_t key)
+		{
+			return transverse_degree(key) + exponent(key, delta_var);
+		}
+
+		/* truncations: keep the monomials up to a total degree ... */
+		struct MaxDegree {
+			unsigned max;
+			inline bool operator()(const uint32_t key) const { return degree(key) <= this->max; }
+		};
+
+		/* ... or up to a power of delta */
+		struct MaxDelta {
+			unsigned max;
+			inline bool operator()(const uint32_t key) const { return exponent(key, delta_var) <= this->max; }
+		};
+
+		inline void add_to(Poly& p, const Poly& q, const cplx scale = 1e0)
+		{
+			for(const auto& t : q){
+				p[t.first] += scale * t.second;
+			}
+		}
+
+		/* p q, only the monomials keep accepts */
+		template<class Truncation>
+		inline Poly multiply(const Poly& p, const Poly& q, const Truncation& keep)
+		{
+			Poly r;
+			for(const auto& a : p){
+				for(const auto& b : q){
+					const uint32_t key = a.first + b.first;
+					if(keep(key)){
+						r[key] += a.second * b.second;
+					}
+				}
+			}
+			return r;
+		}
+
+		/* Poisson bracket scale * [p, q], [h+, h-] = 2 i; accumulated to r */
+		template<class Truncation>
+		inline void add_bracket(Poly& r, const Poly& p, const Poly& q, const Truncation& keep,
+					const cplx scale = 1e0)
+		{
+			for(const auto& a : p){
+				for(const auto& b : q){
+					for(int plane = 0; plane < 2; ++plane){
+						const int vp = 2 * plane, vm = 2 * plane + 1;
+						const int c = int(exponent(a.first, vp) * exponent(b.first, vm))
+							- int(exponent(a.first, vm) * exponent(b.first, vp));
+						if(!c){
+							continue;
+						}
+						const uint32_t key = a.first + b.first - unit(vp) - unit(vm);
+						if(keep(key)){
+							r[key] += cplx(0e0, 2e0 * c) * scale * a.second * b.second;
+						}
+					}
+				}
+			}
+		}
+
+	} // namespace lie_poly
+} // namespace thor_scsi
+#endif /* _THOR_SCSI_STD_MACHINE_LIE_POLY_H_ */
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
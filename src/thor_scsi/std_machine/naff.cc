@@ -0,0 +1,263 @@
+#include <thor_scsi/std_machine/naff.h>
+#include <thor_scsi/core/parallel.h>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace ts = thor_scsi;
+namespace tsc = thor_scsi::core;
+
+typedef std::complex<double> cplx;
+
+/* in place radix 2 FFT, sum_n a_n exp(-2 pi i k n / N); size a power of 2 */
+static void fft(std::vector<cplx>& a)
+{
+	const size_t n = a.size();
+	for(size_t i = 1, j = 0; i < n; ++i){
+		size_t bit = n >> 1;
+		for(; j & bit; bit >>= 1){
+			j ^= bit;
+		}
+		j ^= bit;
+		if(i < j){
+			std::swap(a[i], a[j]);
+		}
+	}
+	for(size_t len = 2; len <= n; len <<= 1){
+		const cplx w_len = std::polar(1e0, -2e0 * M_PI / double(len));
+		for(size_t i = 0; i < n; i += len){
+			cplx w = 1e0;
+			for(size_t j = 0; j < len / 2; ++j){
+				const cplx u = a[i + j], v = a[i + j + len / 2] * w;
+				a[i + j] = u + v;
+				a[i + j + len / 2] = u - v;
+				w *= w_len;
+			}
+		}
+	}
+}
+
+ts::NAFF::NAFF(const size_t n_samples, const size_t max_terms, const unsigned window_order)
+	: m_n_samples(n_samples)
+	, m_n_padded(2)
+	, m_window_order(window_order)
+{
+	if(n_samples < 2){
+		std::stringstream strm;
+		strm << "NAFF: at least 2 samples required, got " << n_samples;
+		throw std::invalid_argument(strm.str());
+	}
+	/* twice the next power of 2: a finer grid for the coarse estimate */
+	while(this->m_n_padded < 2 * n_samples){
+		this->m_n_padded <<= 1;
+	}
+
+	const size_t n = n_samples;
+	this->m_window.resize(n);
+	double sum = 0e0;
+	for(size_t i = 0; i < n; ++i){
+		const double tau = 2e0 * double(i) / double(n - 1) - 1e0;
+		this->m_window[i] = std::pow(1e0 + std::cos(M_PI * tau), int(window_order));
+		sum += this->m_window[i];
+	}
+	for(auto& w : this->m_window){
+		w *= double(n) / sum;
+	}
+
+	this->m_residual.resize(n);
+	this->m_spectrum.resize(this->m_n_padded);
+	this->m_basis.reserve(max_terms);
+	this->m_expansion.reserve(max_terms);
+}
+
+/* windowed projection (1/N) sum_n w_n f_n exp(-2 pi i nu n) */
+cplx ts::NAFF::project(const cplx *f, const double frequency) const
+{
+	const size_t n = this->m_n_samples;
+	const double omega = -2e0 * M_PI * frequency;
+	const cplx rotation = std::polar(1e0, omega);
+	cplx sum = 0e0, e = 1e0;
+	for(size_t i = 0; i < n; ++i){
+		/* resynchronise the recurrence now and then */
+		if(!(i % 64)){
+			e = std::polar(1e0, omega * double(i));
+		}
+		sum += this->m_window[i] * f[i] * e;
+		e *= rotation;
+	}
+	return sum / double(n);
+}
+
+double ts::NAFF::coarse(const cplx *f, const bool real)
+{
+	const size_t n = this->m_n_samples, n_padded = this->m_n_padded;
+	auto& spectrum = this->m_spectrum;
+	for(size_t i = 0; i < n; ++i){
+		spectrum[i] = this->m_window[i] * f[i];
+	}
+	std::fill(spectrum.begin() + n, spectrum.end(), cplx(0e0));
+	fft(spectrum);
+
+	const size_t k_max = real ? n_padded / 2 + 1 : n_padded;
+	size_t k_best = 0;
+	double best = -1e0;
+	for(size_t k = 0; k < k_max; ++k){
+		const double a = std::norm(spectrum[k]);
+		if(a > best){
+			best = a;
+			k_best = k;
+		}
+	}
+	double frequency = double(k_best) / double(n_padded);
+	if(frequency >= 0.5 && !real){
+		frequency -= 1e0;
+	}
+	return frequency;
+}
+
+/* golden section search for the maximum of the projection around the coarse estimate */
+double ts::NAFF::refine(const cplx *f, const double frequency, const bool real) const
+{
+	const double h = 1e0 / double(this->m_n_padded);
+	double a = frequency - h, b = frequency + h;
+	if(real){
+		a = std::max(a, 0e0);
+		b = std::min(b, 0.5);
+	}
+	const double r = (std::sqrt(5e0) - 1e0) / 2e0;
+	double c = b - r * (b - a), d = a + r * (b - a);
+	double fc = std::norm(this->project(f, c)), fd = std::norm(this->project(f, d));
+	for(int iter = 0; iter < 100 && b - a > 1e-15; ++iter){
+		if(fc > fd){
+			b = d;
+			d = c;
+			fd = fc;
+			c = b - r * (b - a);
+			fc = std::norm(this->project(f, c));
+		} else {
+			a = c;
+			c = d;
+			fc = fd;
+			d = a + r * (b - a);
+			fd = std::norm(this->project(f, d));
+		}
+	}
+	return (a + b) / 2e0;
+}
+
+std::vector<ts::NAFFTerm> ts::NAFF::analyse(const double *x, const double *px, const size_t n_terms)
+{
+	const size_t n = this->m_n_samples;
+	const bool real = (px == nullptr);
+	auto& residual = this->m_residual;
+	for(size_t i = 0; i < n; ++i){
+		residual[i] = real ? cplx(x[i], 0e0) : cplx(x[i], -px[i]);
+	}
+
+	const auto& window = this->m_window;
+	auto inner = [&window, n](const std::vector<cplx>& f, const std::vector<cplx>& g){
+		cplx sum = 0e0;
+		for(size_t i = 0; i < n; ++i){
+			sum += window[i] * f[i] * std::conj(g[i]);
+		}
+		return sum / double(n);
+	};
+
+	std::vector<NAFFTerm> terms;
+	std::vector<double> frequencies;
+	std::vector<cplx> amplitudes;
+	auto& basis = this->m_basis;
+	auto& expansion = this->m_expansion;
+	basis.resize(std::max(basis.size(), n_terms));
+	expansion.resize(std::max(expansion.size(), n_terms));
+
+	for(size_t k = 0; k < n_terms; ++k){
+		const double frequency = this->refine(residual.data(), this->coarse(residual.data(), real), real);
+		if(!(std::abs(this->project(residual.data(), frequency)) > 0e0)){
+			break;
+		}
+
+		/* Gram-Schmidt: u_k = sum_j A_kj e_j orthonormal to u_0 .. u_k-1 */
+		auto& u = basis[k];
+		u.resize(n);
+		for(size_t i = 0; i < n; ++i){
+			u[i] = std::polar(1e0, 2e0 * M_PI * frequency * double(i));
+		}
+		auto& A = expansion[k];
+		A.assign(k + 1, cplx(0e0));
+		A[k] = 1e0;
+		for(size_t j = 0; j < k; ++j){
+			const cplx c = inner(u, basis[j]);
+			for(size_t i = 0; i < n; ++i){
+				u[i] -= c * basis[j][i];
+			}
+			for(size_t m = 0; m <= j; ++m){
+				A[m] -= c * expansion[j][m];
+			}
+		}
+		const double norm = std::sqrt(std::real(inner(u, u)));
+		if(!(norm > 1e-10)){
+			/* frequency found before: nothing new left */
+			break;
+		}
+		for(auto& v : u){
+			v /= norm;
+		}
+		for(auto& v : A){
+			v /= norm;
+		}
+
+		const cplx a = inner(residual, u);
+		for(size_t i = 0; i < n; ++i){
+			residual[i] -= a * u[i];
+		}
+		frequencies.push_back(frequency);
+		amplitudes.push_back(0e0);
+		for(size_t m = 0; m <= k; ++m){
+			amplitudes[m] += a * A[m];
+		}
+	}
+
+	terms.resize(frequencies.size());
+	for(size_t k = 0; k < terms.size(); ++k){
+		terms[k].frequency = frequencies[k];
+		terms[k].amplitude = amplitudes[k];
+	}
+	return terms;
+}
+
+double ts::NAFF::frequency(const double *x, const double *px)
+{
+	const auto terms = this->analyse(x, px, 1);
+	return terms.empty() ? NAN : terms[0].frequency;
+}
+
+std::vector<std::vector<ts::NAFFTerm>> ts::naff_analyse(const double *x, const double *px,
+							const size_t n_signals, const size_t n_samples,
+							const size_t n_terms, const unsigned window_order,
+							const size_t n_threads)
+{
+	std::vector<std::vector<NAFFTerm>> result(n_signals);
+	if(!n_signals){
+		return result;
+	}
+	/* one workspace per thread */
+	const size_t n_thr = tsc::number_of_threads(n_threads, n_signals);
+	const size_t chunk = n_signals / n_thr, rest = n_signals % n_thr;
+	tsc::parallel_for(n_thr, n_thr, [&](const size_t t){
+		const size_t start = t * chunk + std::min(t, rest);
+		const size_t stop = start + chunk + (t < rest ? 1 : 0);
+		NAFF naff(n_samples, n_terms, window_order);
+		for(size_t i = start; i < stop; ++i){
+			result[i] = naff.analyse(x + i * n_samples, px ? px + i * n_samples : nullptr, n_terms);
+		}
+	});
+	return result;
+}
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
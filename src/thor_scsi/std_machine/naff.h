@@ -0,0 +1,103 @@
+#ifndef _THOR_SCSI_STD_MACHINE_NAFF_H_
+#define _THOR_SCSI_STD_MACHINE_NAFF_H_
+
+#include <complex>
+#include <vector>
+
+namespace thor_scsi {
+
+	/**
+	 * @brief a quasi periodic term a exp(2 pi i nu n) of a signal sampled at n = 0 .. N-1
+	 */
+	struct NAFFTerm {
+		/// frequency [cycles per sample], i.e. the tune for turn by turn data
+		double frequency = 0e0;
+		std::complex<double> amplitude = 0e0;
+	};
+
+	/**
+	 * @brief numerical analysis of fundamental frequencies (J. Laskar)
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * The signal :math:`z_n = x_n - i p_{x,n}` (or :math:`x_n` if no
+	 * momentum is given) is multiplied by a Hanning window of order
+	 * window_order. The strongest frequency is estimated from the
+	 * spectrum (FFT, zero padded) and refined by maximising the
+	 * windowed projection of the signal on :math:`e^{2 \pi i \nu n}`.
+	 * The term is orthogonalised (Gram-Schmidt) against the terms
+	 * found before and subtracted from the signal; then the next
+	 * term is searched. Amplitudes are given in the basis of the
+	 * exponentials.
+	 *
+	 * With a momentum given, frequencies lie in [-1/2, 1/2); for a
+	 * real signal only [0, 1/2] is searched (the negative frequency
+	 * terms of a real signal are mirror images).
+	 *
+	 * An object owns the workspace for signals of n_samples: it is
+	 * reentrant, but not thread safe. Use one object per thread, as
+	 * :func:`naff_analyse` does.
+	 *
+	 * \endverbatim
+	 */
+	class NAFF {
+	public:
+		/**
+		 * @param n_samples: length of the signals analysed
+		 * @param max_terms: workspace reserved for this number of terms
+		 * @param window_order: 0 rectangular, 1 Hanning, 2 ...
+		 *
+		 * @throws std::invalid_argument if n_samples is smaller than 2
+		 */
+		NAFF(const size_t n_samples, const size_t max_terms = 1, const unsigned window_order = 1);
+
+		inline size_t nSamples(void) const { return this->m_n_samples; }
+		inline unsigned windowOrder(void) const { return this->m_window_order; }
+
+		/**
+		 * @brief the n_terms strongest terms of the signal
+		 *
+		 * @param x: n_samples values
+		 * @param px: n_samples values or nullptr for a real signal
+		 *
+		 * Returns fewer terms if the signal is exhausted.
+		 */
+		std::vector<NAFFTerm> analyse(const double *x, const double *px, const size_t n_terms);
+
+		/// @brief frequency of the strongest term (NaN for a vanishing signal)
+		double frequency(const double *x, const double *px = nullptr);
+
+	private:
+		std::complex<double> project(const std::complex<double> *f, const double frequency) const;
+		double refine(const std::complex<double> *f, const double frequency, const bool real) const;
+		double coarse(const std::complex<double> *f, const bool real);
+
+		size_t m_n_samples, m_n_padded;
+		unsigned m_window_order;
+		/// normalised to a mean of 1
+		std::vector<double> m_window;
+		std::vector<std::complex<double>> m_residual, m_spectrum;
+		/// orthonormal basis and its expansion in the exponentials (row k: terms 0 .. k)
+		std::vector<std::vector<std::complex<double>>> m_basis, m_expansion;
+	};
+
+	/**
+	 * @brief terms of many signals, distributed over n_threads threads
+	 *
+	 * x and px (nullptr for real signals) hold n_signals x n_samples
+	 * values, the samples of a signal contiguous. Returns n_terms
+	 * (or less) terms per signal.
+	 */
+	std::vector<std::vector<NAFFTerm>> naff_analyse(const double *x, const double *px,
+							const size_t n_signals, const size_t n_samples,
+							const size_t n_terms = 1, const unsigned window_order = 1,
+							const size_t n_threads = 0);
+
+} // namespace thor_scsi
+#endif /* _THOR_SCSI_STD_MACHINE_NAFF_H_ */
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
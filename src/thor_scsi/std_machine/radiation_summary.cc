@@ -0,0 +1,158 @@
+#include <thor_scsi/std_machine/radiation_summary.h>
+#include <thor_scsi/elements/field_kick.h>
+#include <thor_scsi/elements/radiation_delegate.h>
+#include <thor_scsi/elements/constants.h>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace ts = thor_scsi;
+namespace tsc = thor_scsi::core;
+namespace tse = thor_scsi::elements;
+
+namespace {
+/* switches of the configuration modified by the summary */
+struct ConfigSwitches {
+	bool radiation, emittance, Cavity_on;
+
+	explicit ConfigSwitches(const tsc::ConfigType& conf)
+		: radiation(conf.radiation)
+		, emittance(conf.emittance)
+		, Cavity_on(conf.Cavity_on)
+		{}
+
+	void restore(tsc::ConfigType& conf) const {
+		conf.radiation = this->radiation;
+		conf.emittance = this->emittance;
+		conf.Cavity_on = this->Cavity_on;
+	}
+};
+} // namespace
+
+template<class C>
+static void check_passed(const ts::AcceleratorKnobbable<C>& acc, const int last, const char *what)
+{
+	if(last != static_cast<int>(acc.size())){
+		std::stringstream strm;
+		strm << "radiation summary: particle lost at element " << last
+		     << " while " << what;
+		throw std::runtime_error(strm.str());
+	}
+}
+
+template<class C>
+ts::RadiationSummary ts::compute_radiation_summary(ts::AcceleratorKnobbable<C>& acc, tsc::ConfigType& conf,
+						   const gtpsa::ss_vect<gtpsa::tpsa>& A,
+						   const std::array<double, 3>& alpha_rad)
+{
+	typedef tse::RadiationDelegateKickKnobbed<tse::FieldKickAPIKnobbed<C>> rad_del_t;
+
+	if(!std::isfinite(conf.Energy)){
+		throw std::invalid_argument("radiation summary: energy of the configuration is not finite");
+	}
+
+	RadiationSummary summary;
+	summary.alpha_rad = alpha_rad;
+
+	std::vector<std::shared_ptr<rad_del_t>> delegates;
+	for(const auto& cv : acc){
+		auto elem = std::dynamic_pointer_cast<tsc::ElemTypeKnobbed>(cv);
+		if(!elem){
+			continue;
+		}
+		summary.circumference += elem->getLength();
+		auto kick = std::dynamic_pointer_cast<tse::FieldKickKnobbed<C>>(elem);
+		if(!kick){
+			continue;
+		}
+		auto rad_del = kick->getRadiationDelegate();
+		if(rad_del){
+			rad_del->reset();
+			delegates.push_back(rad_del);
+		}
+	}
+	if(delegates.empty()){
+		throw std::runtime_error("radiation summary: no radiation delegate installed");
+	}
+
+	const ConfigSwitches switches(conf);
+
+	/* energy loss: fix point through the machine */
+	gtpsa::ss_vect<double> x0(0e0);
+	for(int i = 0; i < nv_tps; ++i){
+		x0[i] = A[i].cst();
+	}
+	const double delta0 = x0[delta_];
+	conf.radiation = true;
+	conf.emittance = false;
+	conf.Cavity_on = true;
+	conf.dE = 0e0;
+	try {
+		check_passed(acc, acc.propagate(conf, x0), "computing the energy loss");
+		/* the cavities accumulate in dE again below */
+		const double dE = conf.dE;
+
+		/* diffusion coefficients: with the cavities as for the energy loss */
+		auto A_prop = A.clone();
+		conf.emittance = true;
+		check_passed(acc, acc.propagate(conf, A_prop), "propagating A");
+		for(const auto& rad_del : delegates){
+			const auto dD = rad_del->getDiffusionCoefficientsIncrement();
+			for(size_t k = 0; k < summary.D_rad.size(); ++k){
+				summary.D_rad[k] += dD[k];
+			}
+		}
+
+		/*
+		 * synchrotron integrals: only computed by the field kicks
+		 * with the cavities off, see computeSynchrotronIntegrals
+		 */
+		auto A_si = A.clone();
+		conf.Cavity_on = false;
+		check_passed(acc, acc.propagate(conf, A_si), "computing the synchrotron integrals");
+		conf.dE = dE;
+		for(const auto& rad_del : delegates){
+			const auto dI = rad_del->getSynchrotronIntegralsIncrement();
+			for(size_t i = 0; i < summary.I.size(); ++i){
+				summary.I[i] += dI[i];
+			}
+		}
+	} catch(...) {
+		switches.restore(conf);
+		throw;
+	}
+	switches.restore(conf);
+
+	const double c0 = tse::speed_of_light;
+	summary.dE = conf.dE;
+	summary.U0 = conf.Energy * summary.dE;
+	for(int k = 0; k < 3; ++k){
+		summary.J[k] = 2e0 * (1e0 + delta0) * alpha_rad[k] / summary.dE;
+		summary.tau[k] = -summary.circumference / (c0 * alpha_rad[k]);
+		summary.eps[k] = -summary.D_rad[k] / (2e0 * alpha_rad[k]);
+	}
+	const double gamma = conf.Energy / tse::m_e;
+	summary.sigma_delta = std::sqrt(tse::C_q * gamma * gamma * summary.I[3] / (2e0 * summary.I[2] + summary.I[4]));
+
+	conf.U0 = 1e-3 * summary.U0;
+	for(int k = 0; k < 3; ++k){
+		conf.alpha_rad[k] = summary.alpha_rad[k];
+		conf.D_rad[k] = summary.D_rad[k];
+		conf.J[k] = summary.J[k];
+		conf.tau[k] = summary.tau[k];
+		conf.eps[k] = summary.eps[k];
+	}
+	return summary;
+}
+
+template ts::RadiationSummary ts::compute_radiation_summary(ts::AcceleratorKnobbable<tsc::StandardDoubleType>& acc, tsc::ConfigType& conf,
+							    const gtpsa::ss_vect<gtpsa::tpsa>& A, const std::array<double, 3>& alpha_rad);
+template ts::RadiationSummary ts::compute_radiation_summary(ts::AcceleratorKnobbable<tsc::TpsaVariantType>& acc, tsc::ConfigType& conf,
+							    const gtpsa::ss_vect<gtpsa::tpsa>& A, const std::array<double, 3>& alpha_rad);
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -0,0 +1,81 @@
+#ifndef _THOR_SCSI_STD_MACHINE_RADIATION_SUMMARY_H_
+#define _THOR_SCSI_STD_MACHINE_RADIATION_SUMMARY_H_
+
+#include <thor_scsi/std_machine/accelerator.h>
+#include <thor_scsi/core/config.h>
+#include <gtpsa/ss_vect.h>
+#include <array>
+
+namespace thor_scsi {
+
+	/**
+	 * @brief equilibrium properties of the beam with radiation
+	 *
+	 * Indices of the arrays: planes X_, Y_, Z_ of
+	 * :any:`spatial_index`. Energies in eV.
+	 */
+	struct RadiationSummary {
+		double circumference = 0e0;
+		/// energy lost per turn
+		double U0 = 0e0;
+		/// relative energy lost per turn, as found in conf.dE
+		double dE = 0e0;
+		/// rms energy spread, from the synchrotron integrals
+		double sigma_delta = 0e0;
+		/// synchrotron integrals I1 ... I5 at index 1 ... 5
+		std::array<double, 6> I = {0e0, 0e0, 0e0, 0e0, 0e0, 0e0};
+		std::array<double, 3> alpha_rad = {0e0, 0e0, 0e0};
+		/// diffusion coefficients
+		std::array<double, 3> D_rad = {0e0, 0e0, 0e0};
+		/// damping partition numbers
+		std::array<double, 3> J = {0e0, 0e0, 0e0};
+		/// damping times [s]
+		std::array<double, 3> tau = {0e0, 0e0, 0e0};
+		/// equilibrium (eigen) emittances
+		std::array<double, 3> eps = {0e0, 0e0, 0e0};
+	};
+
+	/**
+	 * @brief compute the radiation summary of the accelerator in C++
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * Requires the radiation delegates to be installed (e.g. by
+	 * :func:`thor_scsi.utils.accelerator.instrument_with_radiators`)
+	 * and the linear normal form of the one turn map with
+	 * radiation and cavity on:
+	 *
+	 *   * A: its constant part the fix point, its Jacobian the
+	 *     transformation to Floquet space (including dispersion)
+	 *   * alpha_rad: the damping coefficients, i.e. the logarithm of
+	 *     the moduli of the eigenvalues
+	 *
+	 * The fix point is propagated once (cavity on) to obtain the
+	 * energy loss. Then A is propagated with the cavities on, which
+	 * gives the diffusion coefficients of each delegate, and once
+	 * more with the cavities off, as the field kicks only compute
+	 * the synchrotron integrals then. These are summed here. All
+	 * delegates are reset beforehand.
+	 *
+	 * The results are also stored in conf (dE, U0 in keV, alpha_rad,
+	 * D_rad, J, tau, eps). The switches of conf are restored.
+	 *
+	 * \endverbatim
+	 *
+	 * @throws std::runtime_error if no radiation delegate is installed
+	 * @throws std::invalid_argument if the energy of conf is not finite
+	 */
+	template<class C>
+	RadiationSummary compute_radiation_summary(AcceleratorKnobbable<C>& acc,
+						   thor_scsi::core::ConfigType& conf,
+						   const gtpsa::ss_vect<gtpsa::tpsa>& A,
+						   const std::array<double, 3>& alpha_rad);
+
+} // namespace thor_scsi
+#endif /* _THOR_SCSI_STD_MACHINE_RADIATION_SUMMARY_H_ */
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -0,0 +1,240 @@
+#include <thor_scsi/std_machine/result_cache.h>
+#include <thor_scsi/std_machine/lattice_hash.h>
+#include <thor_scsi/core/exceptions.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ts = thor_scsi;
+namespace fs = std::filesystem;
+
+/*
+ * File layout: all fields native byte order
+ *
+ *  offset  0: magic      char[8]  "TSCACHE\0"
+ *  offset  8: version    uint32
+ *  offset 12: ndim       uint32
+ *  offset 16: shape      uint64[max_dims]
+ *  padding up to header_size
+ *  offset header_size: data double[prod(shape)]
+ */
+static const char magic[8] = {'T', 'S', 'C', 'A', 'C', 'H', 'E', '\0'};
+static const uint32_t version = 1;
+static const size_t max_dims = 4;
+static const size_t header_size = 64;
+
+static_assert(16 + max_dims * sizeof(uint64_t) <= header_size, "header too small for shape");
+
+static size_t shape_size(const std::vector<size_t>& shape)
+{
+	return std::accumulate(shape.begin(), shape.end(), size_t(1), std::multiplies<size_t>());
+}
+
+size_t ts::CachedArray::size(void) const
+{
+	return shape_size(this->m_shape);
+}
+
+arma::mat ts::CachedArray::asMatrix(void) const
+{
+	const auto& s = this->m_shape;
+	switch(s.size()){
+	case 1:
+		return arma::mat(this->m_data, s[0], 1);
+	case 2:
+		return arma::mat(this->m_data, s[0], s[1]);
+	default:
+		std::stringstream strm;
+		strm << "Can not represent array with " << s.size() << " dimensions as matrix";
+		throw std::runtime_error(strm.str());
+	}
+}
+
+std::vector<double> ts::CachedArray::asVector(void) const
+{
+	return std::vector<double>(this->m_data, this->m_data + this->size());
+}
+
+std::string ts::ResultCache::defaultDirectory(void)
+{
+	const char *dir = std::getenv("THOR_SCSI_CACHE_DIR");
+	if(dir && *dir){
+		return dir;
+	}
+	const char *xdg = std::getenv("XDG_CACHE_HOME");
+	if(xdg && *xdg){
+		return (fs::path(xdg) / "thor_scsi").string();
+	}
+	const char *home = std::getenv("HOME");
+	if(home && *home){
+		return (fs::path(home) / ".cache" / "thor_scsi").string();
+	}
+	return (fs::temp_directory_path() / "thor_scsi_cache").string();
+}
+
+ts::ResultCache::ResultCache(const std::string& directory)
+	: m_directory(directory.empty() ? defaultDirectory() : directory)
+{
+	std::error_code ec;
+	fs::create_directories(this->m_directory, ec);
+	if(ec){
+		std::stringstream strm;
+		strm << "Could not create cache directory '" << this->m_directory
+		     << "': " << ec.message();
+		throw std::runtime_error(strm.str());
+	}
+}
+
+std::string ts::ResultCache::filename(const uint64_t key, const std::string& product) const
+{
+	if(product.empty() ||
+	   std::any_of(product.begin(), product.end(),
+		       [](char c){ return !(std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-' || c == '.'); })){
+		std::stringstream strm;
+		strm << "Product name '" << product << "' must only consist of [A-Za-z0-9_.-]";
+		throw std::invalid_argument(strm.str());
+	}
+	return (fs::path(this->m_directory) / (hash_to_string(key) + "_" + product + ".tsc")).string();
+}
+
+bool ts::ResultCache::contains(const uint64_t key, const std::string& product) const
+{
+	std::error_code ec;
+	return fs::is_regular_file(this->filename(key, product), ec);
+}
+
+void ts::ResultCache::store(const uint64_t key, const std::string& product,
+			    const double *data, const std::vector<size_t>& shape)
+{
+	if(shape.size() == 0 || shape.size() > max_dims){
+		std::stringstream strm;
+		strm << "Number of dimensions " << shape.size() << " not in range 1.." << max_dims;
+		throw std::invalid_argument(strm.str());
+	}
+
+	char header[header_size];
+	std::memset(header, 0, header_size);
+	std::memcpy(header, magic, sizeof(magic));
+	const uint32_t ndim = static_cast<uint32_t>(shape.size());
+	std::memcpy(header + 8, &version, sizeof(version));
+	std::memcpy(header + 12, &ndim, sizeof(ndim));
+	for(size_t i=0; i<shape.size(); ++i){
+		const uint64_t n = shape[i];
+		std::memcpy(header + 16 + i * sizeof(uint64_t), &n, sizeof(n));
+	}
+
+	const auto target = this->filename(key, product);
+	/*
+	 * unique per process, thread and call: concurrent writers must not
+	 * share the temporary
+	 */
+	static std::atomic<uint64_t> tmp_counter{0};
+	std::stringstream tmp_name;
+	tmp_name << target << ".tmp." << ::getpid()
+		 << "." << std::hash<std::thread::id>{}(std::this_thread::get_id())
+		 << "." << tmp_counter++;
+	const auto tmp = tmp_name.str();
+	{
+		std::ofstream strm(tmp, std::ios::binary | std::ios::trunc);
+		strm.write(header, header_size);
+		strm.write(reinterpret_cast<const char *>(data), shape_size(shape) * sizeof(double));
+		strm.close();
+		if(!strm){
+			std::remove(tmp.c_str());
+			throw std::runtime_error("Failed to write cache file " + tmp);
+		}
+	}
+	std::error_code ec;
+	fs::rename(tmp, target, ec);
+	if(ec){
+		std::remove(tmp.c_str());
+		throw std::runtime_error("Failed to rename cache file to " + target + ": " + ec.message());
+	}
+}
+
+void ts::ResultCache::store(const uint64_t key, const std::string& product, const arma::mat& mat)
+{
+	this->store(key, product, mat.memptr(),
+		    {static_cast<size_t>(mat.n_rows), static_cast<size_t>(mat.n_cols)});
+}
+
+void ts::ResultCache::store(const uint64_t key, const std::string& product, const std::vector<double>& vec)
+{
+	this->store(key, product, vec.data(), {vec.size()});
+}
+
+std::unique_ptr<ts::CachedArray>
+ts::ResultCache::load(const uint64_t key, const std::string& product) const
+{
+	const auto name = this->filename(key, product);
+	const int fd = ::open(name.c_str(), O_RDONLY);
+	if(fd < 0){
+		if(errno == ENOENT){
+			return nullptr;
+		}
+		throw ts::LoadException(std::strerror(errno), "Could not open cache file " + name + ":");
+	}
+
+	struct stat st;
+	if(::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < header_size){
+		::close(fd);
+		throw ts::LoadException("truncated header", "Cache file " + name + ":");
+	}
+	const size_t length = static_cast<size_t>(st.st_size);
+	void *addr = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	/* mapping stays valid after closing the descriptor */
+	::close(fd);
+	if(addr == MAP_FAILED){
+		throw ts::LoadException(std::strerror(errno), "Could not map cache file " + name + ":");
+	}
+	std::shared_ptr<const void> mapping(addr, [length](const void *p){ ::munmap(const_cast<void *>(p), length); });
+
+	const char *header = static_cast<const char *>(addr);
+	uint32_t file_version = 0, ndim = 0;
+	std::memcpy(&file_version, header + 8, sizeof(file_version));
+	std::memcpy(&ndim, header + 12, sizeof(ndim));
+	if(std::memcmp(header, magic, sizeof(magic)) != 0 || file_version != version
+	   || ndim == 0 || ndim > max_dims){
+		throw ts::LoadException("unknown format or version", "Cache file " + name + ":");
+	}
+
+	std::vector<size_t> shape(ndim);
+	for(size_t i=0; i<ndim; ++i){
+		uint64_t n;
+		std::memcpy(&n, header + 16 + i * sizeof(uint64_t), sizeof(n));
+		shape[i] = static_cast<size_t>(n);
+	}
+	if(length != header_size + shape_size(shape) * sizeof(double)){
+		throw ts::LoadException("size does not match shape", "Cache file " + name + ":");
+	}
+
+	auto data = reinterpret_cast<const double *>(header + header_size);
+	return std::make_unique<CachedArray>(std::move(mapping), data, std::move(shape));
+}
+
+bool ts::ResultCache::erase(const uint64_t key, const std::string& product)
+{
+	std::error_code ec;
+	return fs::remove(this->filename(key, product), ec);
+}
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -0,0 +1,128 @@
+#ifndef _THOR_SCSI_STD_MACHINE_RESULT_CACHE_H_
+#define _THOR_SCSI_STD_MACHINE_RESULT_CACHE_H_
+
+#include <armadillo>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace thor_scsi {
+
+	/**
+	 * @brief read only view of an array stored in the cache
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * The file is memory mapped. The data stay valid as long as this
+	 * object (or a copy of it) exists. Data are stored in column major
+	 * order (i.e. the order armadillo uses).
+	 *
+	 * \endverbatim
+	 */
+	class CachedArray {
+	public:
+		CachedArray(std::shared_ptr<const void> mapping, const double *data, std::vector<size_t> shape)
+			: m_mapping(std::move(mapping))
+			, m_data(data)
+			, m_shape(std::move(shape))
+			{}
+
+		inline const double* data(void) const { return this->m_data; }
+		inline const std::vector<size_t>& shape(void) const { return this->m_shape; }
+		size_t size(void) const;
+
+		/// copy the data to a matrix. 1 dimensional data give a column vector
+		arma::mat asMatrix(void) const;
+		std::vector<double> asVector(void) const;
+
+	private:
+		std::shared_ptr<const void> m_mapping;
+		const double *m_data;
+		std::vector<size_t> m_shape;
+	};
+
+	/**
+	 * @brief on disk cache for expensive results (one turn maps, twiss, ...)
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * Results are stored in a directory, one file per (key, product)
+	 * pair. The key is typically computed by :func:`lattice_hash`, the
+	 * product a short name describing what is stored (e.g. "twiss" or
+	 * "one_turn_map"). Additional parameters of the calculation should
+	 * be folded into the product name or into the key.
+	 *
+	 * Files consist of a fixed size header (magic, version, number of
+	 * dimensions, shape) followed by the doubles in native byte order.
+	 * The header is padded so that the data are 64 byte aligned, which
+	 * allows using the mapped memory directly.
+	 *
+	 * Files are written to a temporary file first and then renamed, so
+	 * concurrent processes sharing one directory will never see a
+	 * partially written entry.
+	 *
+	 * .. Warning::
+	 *     The cache is a local one: files are written in native byte
+	 *     order and the key depends on it.
+	 *
+	 * \endverbatim
+	 */
+	class ResultCache {
+	public:
+		/**
+		 * @param directory where to store the files. It is created if it
+		 *        does not exist. If empty :meth:`defaultDirectory` is used.
+		 */
+		ResultCache(const std::string& directory = "");
+
+		/**
+		 * @brief $THOR_SCSI_CACHE_DIR, $XDG_CACHE_HOME/thor_scsi or $HOME/.cache/thor_scsi
+		 */
+		static std::string defaultDirectory(void);
+
+		inline const std::string& directory(void) const { return this->m_directory; }
+
+		bool contains(const uint64_t key, const std::string& product) const;
+
+		/**
+		 * @brief store data with given shape
+		 *
+		 * data has to hold the product of shape doubles: it is not
+		 * checked for the raw pointer.
+		 *
+		 * @throws std::invalid_argument for a number of dimensions
+		 *         outside 1..4
+		 * @throws std::runtime_error if the file can not be written
+		 */
+		void store(const uint64_t key, const std::string& product,
+			   const double *data, const std::vector<size_t>& shape);
+		void store(const uint64_t key, const std::string& product, const arma::mat& mat);
+		void store(const uint64_t key, const std::string& product, const std::vector<double>& vec);
+
+		/**
+		 * @brief load stored data
+		 *
+		 * @returns nullptr if no entry exists
+		 * @throws thor_scsi::LoadException if the entry exists but is corrupt
+		 */
+		std::unique_ptr<CachedArray> load(const uint64_t key, const std::string& product) const;
+
+		/// @brief remove an entry. returns true if it existed
+		bool erase(const uint64_t key, const std::string& product);
+
+		std::string filename(const uint64_t key, const std::string& product) const;
+
+	private:
+		std::string m_directory;
+	};
+
+} // namespace thor_scsi
+
+#endif /* _THOR_SCSI_STD_MACHINE_RESULT_CACHE_H_ */
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -9,6 +9,7 @@
 #include <thor_scsi/elements/bending.h>
 #include <thor_scsi/elements/corrector.h>
 #include <thor_scsi/custom/nonlinear_kicker.h>
+#include <thor_scsi/custom/field_map_kick.h>
 
 namespace ts = thor_scsi;
 namespace tsc = thor_scsi::core;
@@ -29,6 +30,7 @@ ts::register_elements(void)
 	tsc::Machine::registerElement<tse::VerticalSteererType>("VerticalSteerer");
 	tsc::Machine::registerElement<tse::BendingType>("Bending");
 	tsc::Machine::registerElement<tsu::NonLinearKickerType>("NonLinearKicker");
+	tsc::Machine::registerElement<tsu::FieldMapKickType>("FieldMap");
 
 	// tsc::Machine::registerElement<tse::MpoleType>("mpole");
 	return 1;
@@ -5,6 +5,13 @@
 
 #include <thor_scsi/std_machine/accelerator.h>
 #include <thor_scsi/std_machine/std_machine.h>
+#include <thor_scsi/std_machine/radiation_summary.h>
+#include <thor_scsi/std_machine/envelope.h>
+#include <thor_scsi/std_machine/dynamic_aperture.h>
+#include <thor_scsi/std_machine/closed_orbit.h>
+#include <thor_scsi/std_machine/twiss.h>
+#include <thor_scsi/std_machine/tune_shift.h>
+#include <thor_scsi/std_machine/naff.h>
 #include <thor_scsi/elements/drift.h>
 #include <thor_scsi/elements/marker.h>
 #include <thor_scsi/elements/cavity.h>
@@ -13,10 +20,15 @@
 #include <thor_scsi/elements/octupole.h>
 #include <thor_scsi/elements/bending.h>
 #include <thor_scsi/elements/standard_observer.h>
+#include <thor_scsi/elements/buffering_observer.h>
+#include <thor_scsi/elements/radiation_delegate.h>
 #include <thor_scsi/elements/standard_aperture.h>
 #include <thor_scsi/core/config.h>
+#include <cmath>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace tse = thor_scsi::elements;
 namespace tsc = thor_scsi::core;
@@ -52,6 +64,31 @@ BOOST_AUTO_TEST_CASE(test10_drift)
 
 }
 
+BOOST_AUTO_TEST_CASE(test11_turn_counter)
+{
+	const std::string txt(
+		"d1: Drift, L = 0.25;"
+		"d2: Drift, L = 0.5;"
+		"mini_cell : LINE = (d1, d2, d1);\n");
+
+	GLPSParser parse;
+	Config *C = parse.parse_byte(txt);
+	auto machine = ts::Accelerator(*C);
+
+	auto calc_config = tsc::ConfigType();
+	gtpsa::ss_vect<double> ps = {1e-3, 0e0, 0e0, 0e0, 0e0, 0e0};
+	machine.propagate(calc_config, ps, 0, std::numeric_limits<int>::max(), 3);
+	BOOST_CHECK_EQUAL(calc_config.turn, 3u);
+
+	/* partial propagations do not complete a turn */
+	machine.propagate(calc_config, ps, 1);
+	BOOST_CHECK_EQUAL(calc_config.turn, 3u);
+	machine.propagate(calc_config, ps, 0, 2);
+	BOOST_CHECK_EQUAL(calc_config.turn, 3u);
+	machine.propagate(calc_config, ps);
+	BOOST_CHECK_EQUAL(calc_config.turn, 4u);
+}
+
 
 BOOST_AUTO_TEST_CASE(test20_marker)
 {
@@ -139,6 +176,499 @@ BOOST_AUTO_TEST_CASE(test40_dipole)
 }
 
 
+BOOST_AUTO_TEST_CASE(test41_radiation_summary)
+{
+	const std::string txt(
+		"d1     : Drift, L = 0.4;"
+		"bend   : Bending, L = 1.1, T = 20, K = 0, N = 4, method = 4;"
+		"mini_cell : LINE = (d1, bend, d1);"
+		);
+
+	GLPSParser parse;
+	Config *C = parse.parse_byte(txt);
+	auto machine = ts::Accelerator(*C);
+	auto bend = std::dynamic_pointer_cast<tse::BendingType>(machine[1]);
+	BOOST_REQUIRE(bend);
+
+	tsc::ConfigType calc_config;
+	calc_config.Energy = 3e9;
+
+	auto desc = std::make_shared<gtpsa::desc>(6, 1);
+	gtpsa::ss_vect<gtpsa::tpsa> A(desc, 1);
+	A.set_identity();
+	const std::array<double, 3> alpha_rad = {-1e-4, -1.5e-4, -2e-4};
+
+	BOOST_CHECK_THROW(ts::compute_radiation_summary(machine, calc_config, A, alpha_rad), std::runtime_error);
+
+	auto rad_del = std::make_shared<tse::RadiationDelegateKick>();
+	rad_del->setEnergy(calc_config.Energy);
+	bend->setRadiationDelegate(rad_del);
+
+	const auto summary = ts::compute_radiation_summary(machine, calc_config, A, alpha_rad);
+	const double h = bend->getCurvature(), L = bend->getLength();
+	BOOST_CHECK_CLOSE(summary.circumference, 1.9, 1e-10);
+	BOOST_CHECK_CLOSE(summary.I[2], L * h * h, 1e-10);
+	BOOST_CHECK_CLOSE(summary.I[3], L * std::abs(h * h * h), 1e-10);
+	BOOST_CHECK_GT(summary.D_rad[2], 0e0);
+	{
+		/* diffusion coefficients as computed with the cavities on */
+		tsc::ConfigType conf_ref;
+		conf_ref.Energy = calc_config.Energy;
+		conf_ref.radiation = true;
+		conf_ref.emittance = true;
+		conf_ref.Cavity_on = true;
+		rad_del->reset();
+		auto A_ref = A.clone();
+		machine.propagate(conf_ref, A_ref);
+		const auto D_ref = rad_del->getDiffusionCoefficientsIncrement();
+		for(int k = 0; k < 3; ++k){
+			BOOST_CHECK_CLOSE(summary.D_rad[k], D_ref[k], 1e-10);
+		}
+	}
+	for(int k = 0; k < 3; ++k){
+		BOOST_CHECK_CLOSE(summary.tau[k], -1.9 / (tse::speed_of_light * alpha_rad[k]), 1e-10);
+		BOOST_CHECK_CLOSE(summary.eps[k], -summary.D_rad[k] / (2e0 * alpha_rad[k]), 1e-10);
+		BOOST_CHECK_CLOSE(calc_config.eps[k], summary.eps[k], 1e-10);
+	}
+	/* switches restored */
+	BOOST_CHECK(!calc_config.radiation);
+	BOOST_CHECK(!calc_config.emittance);
+	BOOST_CHECK(!calc_config.Cavity_on);
+
+	calc_config.Energy = NAN;
+	BOOST_CHECK_THROW(ts::compute_radiation_summary(machine, calc_config, A, alpha_rad), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test42_envelope)
+{
+	const std::string txt(
+		"d1     : Drift, L = 0.4;"
+		"q1     : Quadrupole, L = 0.3, K = 1.2, N = 4, Method = 4;"
+		"bend   : Bending, L = 1.1, T = 20, K = 0, N = 4, method = 4;"
+		"mini_cell : LINE = (d1, q1, d1, bend, d1);"
+		);
+
+	GLPSParser parse;
+	Config *C = parse.parse_byte(txt);
+	auto machine = ts::Accelerator(*C);
+
+	tsc::ConfigType calc_config;
+	calc_config.Energy = 3e9;
+	gtpsa::ss_vect<double> x0(0e0);
+	x0.set_zero();
+
+	/* without radiation: plain linear transport */
+	ts::EnvelopeTracker env(machine, calc_config, x0);
+	BOOST_CHECK_EQUAL(env.size(), machine.size());
+
+	auto desc = std::make_shared<gtpsa::desc>(6, 1);
+	gtpsa::ss_vect<gtpsa::tpsa> ps(desc, 1);
+	ps.set_identity();
+	machine.propagate(calc_config, ps);
+	const arma::mat M = ps.jacobian();
+	BOOST_CHECK_SMALL(arma::abs(env.getOneTurnMap() - M.submat(0, 0, 5, 5)).max(), 1e-12);
+	BOOST_CHECK_SMALL(arma::abs(env.getOneTurnDiffusion()).max(), 1e-30);
+
+	arma::mat sigma = arma::diagmat(arma::vec({1e-8, 1e-8, 1e-9, 1e-9, 1e-6, 1e-6}));
+	const auto along = env.alongRing(sigma);
+	BOOST_CHECK_EQUAL(along.size(), machine.size());
+	arma::mat s = sigma;
+	env.propagate(s);
+	BOOST_CHECK_SMALL(arma::abs(along.back() - s).max(), 1e-20);
+	const arma::mat s_ref = M.submat(0, 0, 5, 5) * sigma * M.submat(0, 0, 5, 5).t();
+	BOOST_CHECK_SMALL(arma::abs(s - s_ref).max(), 1e-20);
+	const auto tbt = env.turnByTurn(sigma, 3);
+	BOOST_CHECK_EQUAL(tbt.size(), 3);
+	BOOST_CHECK_SMALL(arma::abs(tbt[0] - s).max(), 1e-20);
+
+	arma::mat wrong(5, 5, arma::fill::zeros);
+	BOOST_CHECK_THROW(env.propagate(wrong), std::invalid_argument);
+
+	/* with radiation: damping and diffusion */
+	auto bend = std::dynamic_pointer_cast<tse::BendingType>(machine[3]);
+	BOOST_REQUIRE(bend);
+	auto rad_del = std::make_shared<tse::RadiationDelegateKick>();
+	rad_del->setEnergy(calc_config.Energy);
+	bend->setRadiationDelegate(rad_del);
+	calc_config.radiation = true;
+
+	ts::EnvelopeTracker env_rad(machine, calc_config, x0);
+	BOOST_CHECK(!calc_config.emittance);
+	BOOST_CHECK_GT(env_rad.getDiffusion(3)(delta_, delta_), 0e0);
+	BOOST_CHECK_SMALL(arma::abs(env_rad.getDiffusion(2)).max(), 1e-30);
+	BOOST_CHECK_GT(env_rad.getOneTurnDiffusion()(delta_, delta_), 0e0);
+	BOOST_CHECK_LT(arma::det(env_rad.getOneTurnMap()), 1e0);
+}
+
+BOOST_AUTO_TEST_CASE(test43_discrete_lyapunov)
+{
+	/* coupled, damped rotation */
+	arma::mat M(6, 6, arma::fill::zeros);
+	const double damping[] = {0.999, 0.998, 0.995}, mu[] = {0.31, 0.17, 0.01};
+	for(int k = 0; k < 3; ++k){
+		M(2*k,     2*k) =  damping[k] * std::cos(2e0 * M_PI * mu[k]);
+		M(2*k,   2*k+1) =  damping[k] * std::sin(2e0 * M_PI * mu[k]);
+		M(2*k+1,   2*k) = -damping[k] * std::sin(2e0 * M_PI * mu[k]);
+		M(2*k+1, 2*k+1) =  damping[k] * std::cos(2e0 * M_PI * mu[k]);
+	}
+	M(0, 2) = 1e-3;
+	M(3, 1) = -2e-3;
+	M(1, 4) = 0.1;
+	arma::mat B(6, 6, arma::fill::zeros);
+	B(4, 4) = 1e-10;
+	B(1, 1) = 1e-12;
+	B(1, 4) = B(4, 1) = 5e-12;
+
+	const arma::mat S = ts::solve_discrete_lyapunov(M, B);
+	BOOST_CHECK_SMALL(arma::abs(M * S * M.t() + B - S).max(), 1e-20);
+	BOOST_CHECK_SMALL(arma::abs(S - S.t()).max(), 1e-24);
+
+	/* uncoupled: S = B / (1 - lambda^2) */
+	const arma::mat S_diag = ts::solve_discrete_lyapunov(0.5 * arma::eye(6, 6), B);
+	BOOST_CHECK_CLOSE(S_diag(4, 4), B(4, 4) / 0.75, 1e-10);
+
+	BOOST_CHECK_THROW(ts::solve_discrete_lyapunov(arma::eye(6, 6), B), std::runtime_error);
+	BOOST_CHECK_THROW(ts::solve_discrete_lyapunov(M, arma::mat(5, 5, arma::fill::zeros)), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test44_eigen_emittances)
+{
+	/* Twiss parameters: sigma = eps [[beta, -alpha], [-alpha, gamma]] */
+	const double eps[] = {1e-9, 1e-11, 1e-6}, beta[] = {10e0, 3e0, 5e0}, alpha[] = {-1e0, 0.5, 0e0};
+	arma::mat sigma(6, 6, arma::fill::zeros);
+	for(int k = 0; k < 3; ++k){
+		const double gamma = (1e0 + alpha[k] * alpha[k]) / beta[k];
+		sigma(2*k,     2*k) =  eps[k] * beta[k];
+		sigma(2*k,   2*k+1) = -eps[k] * alpha[k];
+		sigma(2*k+1,   2*k) = -eps[k] * alpha[k];
+		sigma(2*k+1, 2*k+1) =  eps[k] * gamma;
+	}
+	const auto e = ts::eigen_emittances(sigma);
+	for(int k = 0; k < 3; ++k){
+		BOOST_CHECK_CLOSE(e[k], eps[k], 1e-6);
+	}
+
+	/* invariant under a symplectic coupling transformation */
+	arma::mat R = arma::eye(6, 6);
+	/* x += 0.1 y, p_y -= 0.1 p_x: generated by 0.1 p_x y */
+	R(0, 2) = 0.1;
+	R(3, 1) = -0.1;
+	const auto e_rot = ts::eigen_emittances(R * sigma * R.t());
+	for(int k = 0; k < 3; ++k){
+		BOOST_CHECK_CLOSE(e_rot[k], eps[k], 1e-4);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test45_dynamic_aperture)
+{
+	/* a drift: the aperture alone limits the motion */
+	const std::string txt(
+		"d1: Drift, L = 1.0;"
+		"mini_cell : LINE = (d1);"
+		);
+	GLPSParser parse;
+	Config *C = parse.parse_byte(txt);
+	auto machine = ts::Accelerator(*C);
+	const double width = 20e-3, height = 10e-3;
+	for(auto& cv: machine){
+		auto elem = std::dynamic_pointer_cast<tse::ElemType>(cv);
+		auto ap = std::make_shared<tse::RectangularAperture>(width, height);
+		elem->setAperture(std::dynamic_pointer_cast<tsc::TwoDimensionalAperture>(ap));
+	}
+
+	tsc::ConfigType calc_config;
+	gtpsa::ss_vect<double> x0(0e0);
+	x0.set_zero();
+
+	ts::DynamicApertureOptions options;
+	options.n_turns = 10;
+	options.n_rays = 3;
+	options.r_tolerance = 1e-7;
+	options.n_threads = 4;
+
+	const auto da = ts::dynamic_aperture(machine, calc_config, x0, {0e0, 1e-2}, options);
+	BOOST_CHECK_EQUAL(da.angle.size(), 3u);
+	for(size_t i = 0; i < 2; ++i){
+		BOOST_CHECK_CLOSE(da.x[i][0],  width / 2e0, 1e-3);
+		BOOST_CHECK_CLOSE(da.y[i][1], height / 2e0, 1e-3);
+		BOOST_CHECK_CLOSE(da.x[i][2], -width / 2e0, 1e-3);
+		BOOST_CHECK_CLOSE(da.area[i], width * height / 4e0, 1e-2);
+	}
+
+	const std::vector<double> xs = {0e0, 8e-3, 12e-3}, ys = {0e0, 6e-3};
+	const auto smap = ts::survival_map(machine, calc_config, x0, {0e0}, xs, ys, options);
+	BOOST_CHECK_EQUAL(smap.turns.size(), 6u);
+	BOOST_CHECK_EQUAL(smap.at(0, 0, 0), 10u);
+	BOOST_CHECK_EQUAL(smap.at(0, 0, 1), 10u);
+	BOOST_CHECK_EQUAL(smap.at(0, 0, 2), 0u);
+	BOOST_CHECK_EQUAL(smap.at(0, 1, 0), 0u);
+
+	/* independent of the number of threads */
+	options.n_threads = 1;
+	const auto smap_single = ts::survival_map(machine, calc_config, x0, {0e0}, xs, ys, options);
+	BOOST_CHECK(smap_single.turns == smap.turns);
+
+	options.r_start = 0e0;
+	BOOST_CHECK_THROW(ts::dynamic_aperture(machine, calc_config, x0, {0e0}, options), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test46_momentum_aperture)
+{
+	/* a drift with an aperture */
+	const std::string txt(
+		"d1: Drift, L = 1.0;"
+		"mini_cell : LINE = (d1);"
+		);
+	GLPSParser parse;
+	Config *C = parse.parse_byte(txt);
+	auto machine = ts::Accelerator(*C);
+	const double width = 20e-3, height = 10e-3;
+	for(auto& cv: machine){
+		auto elem = std::dynamic_pointer_cast<tse::ElemType>(cv);
+		auto ap = std::make_shared<tse::RectangularAperture>(width, height);
+		elem->setAperture(std::dynamic_pointer_cast<tsc::TwoDimensionalAperture>(ap));
+	}
+	const size_t n_last = machine.size() - 1;
+
+	tsc::ConfigType calc_config;
+	gtpsa::ss_vect<double> x0(0e0);
+	x0.set_zero();
+
+	ts::MomentumApertureOptions options;
+	options.n_turns = 99;
+	options.delta_max = 0.05;
+	options.delta_tolerance = 1e-7;
+	options.n_threads = 2;
+
+	/* on axis the momentum offset is irrelevant */
+	auto ma = ts::momentum_aperture(machine, calc_config, x0, {n_last}, options);
+	BOOST_CHECK_EQUAL(ma.index.size(), 1u);
+	BOOST_CHECK_CLOSE(ma.delta_plus[0], options.delta_max, 1e-12);
+	BOOST_CHECK_CLOSE(ma.delta_minus[0], -options.delta_max, 1e-12);
+
+	/*
+	 * with an angle px the particle reaches the edge after 100 passes
+	 * (the one to the start and 99 turns) for
+	 * px + 99 px / (1 + delta) = width / 2
+	 */
+	const double px = 0.99e-4;
+	x0[px_] = px;
+	ma = ts::momentum_aperture(machine, calc_config, x0, {n_last}, options);
+	BOOST_CHECK_CLOSE(ma.delta_plus[0], options.delta_max, 1e-12);
+	const double delta_expected = 99e0 * px / (width / 2e0 - px) - 1e0;
+	BOOST_CHECK_CLOSE(ma.delta_minus[0], delta_expected, 1e-2);
+
+	BOOST_CHECK_THROW(ts::momentum_aperture(machine, calc_config, x0, {n_last + 1}, options),
+			  std::invalid_argument);
+	options.delta_tolerance = 0e0;
+	BOOST_CHECK_THROW(ts::momentum_aperture(machine, calc_config, x0, {n_last}, options),
+			  std::invalid_argument);
+}
+
+/*
+ * the FODO cell of the analysis tests: a line built from qf, qd, d1
+ * and bend, further element definitions inserted before it
+ */
+static std::string fodo_lattice(const std::string& line, const std::string& elements = "")
+{
+	return std::string(
+		"qf:   Quadrupole, L = 0.2, K =  1.2, N = 4, Method = 4;"
+		"qd:   Quadrupole, L = 0.2, K = -1.2, N = 4, Method = 4;"
+		"d1:   Drift, L = 1.0;"
+		"bend: Bending, L = 1.0, T = 5, K = 0, N = 4, Method = 4;"
+		) + elements + "mini_cell : LINE = (" + line + ");";
+}
+
+BOOST_AUTO_TEST_CASE(test47_frequency_map)
+{
+	/* a linear FODO cell: tunes independent of the amplitude */
+	const std::string txt = fodo_lattice("qf, d1, qd, d1");
+	GLPSParser parse;
+	Config *C = parse.parse_byte(txt);
+	auto machine = ts::Accelerator(*C);
+	for(auto& cv: machine){
+		auto elem = std::dynamic_pointer_cast<tse::ElemType>(cv);
+		auto ap = std::make_shared<tse::RectangularAperture>(40e-3, 40e-3);
+		elem->setAperture(std::dynamic_pointer_cast<tsc::TwoDimensionalAperture>(ap));
+	}
+
+	tsc::ConfigType calc_config;
+	gtpsa::ss_vect<double> x0(0e0);
+	x0.set_zero();
+
+	/* tunes of the one turn matrix, by finite differences */
+	const double eps = 1e-6;
+	double nu[2];
+	for(int k = 0; k < 2; ++k){
+		double M[2][2];
+		for(int j = 0; j < 2; ++j){
+			gtpsa::ss_vect<double> ps(0e0);
+			ps.set_zero();
+			ps[2 * k + j] = eps;
+			machine.propagate(calc_config, ps);
+			M[0][j] = ps[2 * k] / eps;
+			M[1][j] = ps[2 * k + 1] / eps;
+		}
+		const double mu = std::acos((M[0][0] + M[1][1]) / 2e0);
+		nu[k] = ((M[0][1] > 0e0) ? mu : 2e0 * M_PI - mu) / (2e0 * M_PI);
+	}
+
+	ts::FrequencyMapOptions options;
+	options.n_turns = 256;
+	options.n_threads = 3;
+	const std::vector<double> xs = {1e-4, 1e-3, 30e-3}, ys = {1e-4, 2e-4};
+	const auto fmap = ts::frequency_map(machine, calc_config, x0, xs, ys, ts::FrequencyMapPlane::XY, options);
+	BOOST_CHECK_EQUAL(fmap.lost_turn.size(), 6u);
+	for(size_t i_y = 0; i_y < ys.size(); ++i_y){
+		for(size_t i_x = 0; i_x < 2; ++i_x){
+			const size_t i = fmap.index(i_y, i_x);
+			BOOST_CHECK_EQUAL(fmap.lost_turn[i], 2 * options.n_turns);
+			for(int h = 0; h < 2; ++h){
+				BOOST_CHECK_SMALL(fmap.nu_x[h][i] - nu[0], 1e-6);
+				BOOST_CHECK_SMALL(fmap.nu_y[h][i] - nu[1], 1e-6);
+			}
+			BOOST_CHECK(fmap.diffusion[i] < -6e0);
+		}
+		/* outside the aperture */
+		const size_t i = fmap.index(i_y, 2);
+		BOOST_CHECK(fmap.lost_turn[i] < 2 * options.n_turns);
+		BOOST_CHECK(std::isnan(fmap.nu_x[0][i]));
+	}
+
+	options.n_threads = 1;
+	const auto fmap_single = ts::frequency_map(machine, calc_config, x0, xs, ys, ts::FrequencyMapPlane::XY, options);
+	BOOST_CHECK(fmap_single.lost_turn == fmap.lost_turn);
+	BOOST_CHECK_EQUAL(fmap_single.nu_x[0][0], fmap.nu_x[0][0]);
+
+	options.n_turns = 1;
+	BOOST_CHECK_THROW(ts::frequency_map(machine, calc_config, x0, xs, ys, ts::FrequencyMapPlane::XY, options),
+			  std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test48_chaos_indicators)
+{
+	/* a linear FODO cell: regular motion, time reversible elements */
+	const std::string txt = fodo_lattice("qf, d1, qd, d1");
+	GLPSParser parse;
+	Config *C = parse.parse_byte(txt);
+	auto machine = ts::Accelerator(*C);
+	tsc::ConfigType calc_config;
+
+	std::vector<gtpsa::ss_vect<double>> particles;
+	for(const double a : {1e-4, 1e-3, 5e-2}){
+		gtpsa::ss_vect<double> ps(0e0);
+		ps.set_zero();
+		ps[x_] = a;
+		ps[y_] = a / 2e0;
+		particles.push_back(ps);
+	}
+
+	ts::ChaosOptions options;
+	options.n_turns = 3000;
+	options.min_turns = 1000;
+	options.check_interval = 500;
+	options.amplitude_limit = 2e-2;
+	options.reversibility = true;
+	options.n_threads = 2;
+
+	auto result = ts::track_chaos(machine, calc_config, particles, options);
+	BOOST_CHECK_EQUAL(result.state.size(), 3u);
+	for(size_t i = 0; i < 2; ++i){
+		BOOST_CHECK(result.state[i] == ts::ChaosState::Survived);
+		BOOST_CHECK_EQUAL(result.turns[i], options.n_turns);
+		/* linear motion: MEGNO tends to 0 */
+		BOOST_CHECK(std::abs(result.indicator[i]) < 1e0);
+		BOOST_CHECK_SMALL(result.reversibility_error[i], 1e-10);
+	}
+	/* beyond the amplitude limit */
+	BOOST_CHECK(result.state[2] == ts::ChaosState::Lost);
+	BOOST_CHECK_EQUAL(result.turns[2], 0u);
+	BOOST_CHECK(std::isnan(result.reversibility_error[2]));
+
+	/* regular particles stopped at the first classification */
+	options.stop_regular = true;
+	options.reversibility = false;
+	result = ts::track_chaos(machine, calc_config, particles, options);
+	for(size_t i = 0; i < 2; ++i){
+		BOOST_CHECK(result.state[i] == ts::ChaosState::Regular);
+		BOOST_CHECK_EQUAL(result.turns[i], options.min_turns);
+		BOOST_CHECK(std::isnan(result.reversibility_error[i]));
+	}
+
+	/* FLI: bounded deviation vector, excess over linear growth negative */
+	options.indicator = ts::ChaosIndicator::FLI;
+	options.stop_regular = false;
+	result = ts::track_chaos(machine, calc_config, particles, options);
+	for(size_t i = 0; i < 2; ++i){
+		BOOST_CHECK(result.state[i] == ts::ChaosState::Survived);
+		BOOST_CHECK(result.indicator[i] < 0e0);
+	}
+
+	options.check_interval = 0;
+	BOOST_CHECK_THROW(ts::track_chaos(machine, calc_config, particles, options), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test49_quantum_excitation_threads)
+{
+	const std::string txt = fodo_lattice("qf, d1, qd, bend");
+	GLPSParser parse;
+	Config *C = parse.parse_byte(txt);
+	auto machine = ts::Accelerator(*C);
+	auto bend = std::dynamic_pointer_cast<tse::BendingType>(machine.find("bend"));
+	BOOST_REQUIRE(bend);
+
+	tsc::ConfigType calc_config;
+	calc_config.Energy = 3e9;
+	calc_config.radiation = true;
+	calc_config.quantum_excitation = true;
+	calc_config.qe_seed = 42;
+	auto rad_del = std::make_shared<tse::RadiationDelegateKick>();
+	rad_del->setEnergy(calc_config.Energy);
+	bend->setRadiationDelegate(rad_del);
+
+	std::vector<gtpsa::ss_vect<double>> particles;
+	for(int i = 0; i < 7; ++i){
+		gtpsa::ss_vect<double> ps(0e0);
+		ps.set_zero();
+		ps[x_] = 1e-4 * (i + 1);
+		ps[y_] = 5e-5 * (i + 1);
+		particles.push_back(ps);
+	}
+
+	ts::ChaosOptions options;
+	options.n_turns = 200;
+	/* no classification: all particles tracked all turns */
+	options.min_turns = options.n_turns + 1;
+	options.reversibility = true;
+	options.amplitude_limit = 2e-2;
+
+	/*
+	 * random numbers counted in the copy of conf of each thread. The
+	 * indicators mean nothing with quantum excitation, here they are
+	 * only compared
+	 */
+	options.n_threads = 1;
+	const auto serial = ts::track_chaos(machine, calc_config, particles, options);
+	options.n_threads = 3;
+	const auto parallel = ts::track_chaos(machine, calc_config, particles, options);
+	for(size_t i = 0; i < particles.size(); ++i){
+		BOOST_CHECK(serial.state[i] == ts::ChaosState::Survived);
+		BOOST_CHECK_EQUAL(parallel.turns[i], serial.turns[i]);
+		/* bit identical */
+		BOOST_CHECK_EQUAL(parallel.indicator[i], serial.indicator[i]);
+		BOOST_CHECK_EQUAL(parallel.reversibility_error[i], serial.reversibility_error[i]);
+	}
+
+	/* the kicks were applied */
+	calc_config.quantum_excitation = false;
+	const auto no_qe = ts::track_chaos(machine, calc_config, particles, options);
+	bool differs = false;
+	for(size_t i = 0; i < particles.size(); ++i){
+		differs = differs || (no_qe.reversibility_error[i] != serial.reversibility_error[i]);
+	}
+	BOOST_CHECK(differs);
+}
+
 BOOST_AUTO_TEST_CASE(test50_quadrupole)
 {
 	const std::string txt(
@@ -259,6 +789,108 @@ BOOST_AUTO_TEST_CASE(test80_standard_observer)
 
 }
 
+BOOST_AUTO_TEST_CASE(test81_buffering_observer)
+{
+	const std::string txt(
+		"d1: Drift, L = 0.25;"
+		"q1: Quadrupole, L = 0.5, K = 1.4, N = 4, Method = 4;"
+		"mini_cell : LINE = (d1, q1, d1);\n"
+		);
+
+	GLPSParser parse;
+	Config *C = parse.parse_byte(txt);
+	auto machine = ts::Accelerator(*C);
+	const size_t n_elements = machine.size();
+
+	/* 2 turns per batch, start and end recorded */
+	auto ob = std::make_shared<tse::BufferingObserver>(
+		100, 2, std::vector<tsc::ObservedState>{tsc::ObservedState::start, tsc::ObservedState::end});
+	for(auto& cv: machine){
+		cv->set_observer(std::dynamic_pointer_cast<tsc::Observer>(ob));
+	}
+
+	std::vector<size_t> batch_sizes, indices, turns;
+	std::vector<int> states;
+	std::vector<double> xs;
+	ob->setCallback([&](const tse::BufferingObserver& o){
+		batch_sizes.push_back(o.size());
+		for(size_t i = 0; i < o.size(); ++i){
+			indices.push_back(o.indices()[i]);
+			states.push_back(o.states()[i]);
+			turns.push_back(o.turns()[i]);
+			xs.push_back(o.phaseSpace()[tse::BufferingObserver::ps_dim * i]);
+		}
+	});
+
+	gtpsa::ss_vect<double> ps = {1e-3, 0e0, 0e0, 0e0, 0e0, 0e0};
+	auto calc_config = tsc::ConfigType();
+	machine.propagate(calc_config, ps, 0, std::numeric_limits<int>::max(), 5);
+	/* batches of 2 turns, the last turn once flushed */
+	BOOST_CHECK_EQUAL(batch_sizes.size(), 2u);
+	BOOST_CHECK_EQUAL(ob->size(), 2 * n_elements);
+	ob->flush();
+	BOOST_CHECK_EQUAL(ob->size(), 0u);
+	BOOST_REQUIRE_EQUAL(batch_sizes.size(), 3u);
+	BOOST_CHECK_EQUAL(batch_sizes[0], 4 * n_elements);
+	BOOST_CHECK_EQUAL(batch_sizes[1], 4 * n_elements);
+	BOOST_CHECK_EQUAL(batch_sizes[2], 2 * n_elements);
+	BOOST_CHECK_EQUAL(ob->getTurn(), 4u);
+
+	BOOST_REQUIRE_EQUAL(indices.size(), 10 * n_elements);
+	for(size_t turn = 0; turn < 5; ++turn){
+		for(size_t e = 0; e < n_elements; ++e){
+			const size_t row = 2 * (turn * n_elements + e);
+			BOOST_CHECK_EQUAL(indices[row], e);
+			BOOST_CHECK_EQUAL(indices[row + 1], e);
+			BOOST_CHECK_EQUAL(states[row], int(tsc::ObservedState::start));
+			BOOST_CHECK_EQUAL(states[row + 1], int(tsc::ObservedState::end));
+			BOOST_CHECK_EQUAL(turns[row], turn);
+		}
+	}
+	/* last row: state after tracking */
+	BOOST_CHECK_CLOSE(xs.back(), ps[0], 1e-12);
+
+	/* small buffer: flushed when full */
+	auto small = std::make_shared<tse::BufferingObserver>(2);
+	size_t n_calls = 0;
+	small->setCallback([&](const tse::BufferingObserver& o){ ++n_calls; BOOST_CHECK(o.size() <= 2); });
+	for(auto& cv: machine){
+		cv->set_observer(std::dynamic_pointer_cast<tsc::Observer>(small));
+	}
+	machine.propagate(calc_config, ps, 0, std::numeric_limits<int>::max(), 1);
+	small->flush();
+	BOOST_CHECK_EQUAL(n_calls, (n_elements + 1) / 2);
+
+	/* buffer full within a batch: the following batches still end every 2 turns */
+	auto split = std::make_shared<tse::BufferingObserver>(n_elements + 1, 2);
+	std::vector<std::pair<size_t, size_t>> batch_turns;
+	split->setCallback([&](const tse::BufferingObserver& o){
+		batch_turns.emplace_back(o.turns()[0], o.turns()[o.size() - 1]);
+	});
+	for(auto& cv: machine){
+		cv->set_observer(std::dynamic_pointer_cast<tsc::Observer>(split));
+	}
+	machine.propagate(calc_config, ps, 0, std::numeric_limits<int>::max(), 6);
+	split->flush();
+	BOOST_REQUIRE(!batch_turns.empty());
+	for(const auto& bt : batch_turns){
+		/* turns 0, 1 | 2, 3 | 4, 5 never mixed */
+		BOOST_CHECK_EQUAL(bt.first / 2, bt.second / 2);
+	}
+	BOOST_CHECK_EQUAL(batch_turns.back().second, 5u);
+
+	/* count passed by the element is kept */
+	std::vector<int> counts;
+	small->setCallback([&](const tse::BufferingObserver& o){ counts.assign(o.counts(), o.counts() + o.size()); });
+	small->reset();
+	small->view(machine.at(1), ps, tsc::ObservedState::end, 7);
+	small->flush();
+	BOOST_REQUIRE_EQUAL(counts.size(), 1u);
+	BOOST_CHECK_EQUAL(counts[0], 7);
+
+	BOOST_CHECK_THROW(tse::BufferingObserver(0), std::invalid_argument);
+	BOOST_CHECK_THROW(tse::BufferingObserver(10, 0), std::invalid_argument);
+}
 
 class Log2Stream : public tsc::Machine::Logger
 {
@@ -556,6 +1188,256 @@ BOOST_AUTO_TEST_CASE(test131_no_marker_add_start_required)
 	auto quad = std::dynamic_pointer_cast<tse::QuadrupoleType>(cv2);
 	BOOST_CHECK( (quad) );
 }
+
+BOOST_AUTO_TEST_CASE(test140_closed_orbit)
+{
+	/* a FODO cell with a dipole: off momentum orbits follow the dispersion */
+	const std::string txt = fodo_lattice("qf, d1, qd, bend");
+	GLPSParser parse;
+	Config *C = parse.parse_byte(txt);
+	auto machine = ts::Accelerator(*C);
+	tsc::ConfigType calc_config;
+
+	ts::ClosedOrbitOptions options;
+	options.n_threads = 3;
+	const std::vector<double> deltas = {-1e-2, -5e-3, 0e0, 5e-3, 1e-2};
+	const auto orbits = ts::find_closed_orbits(machine, calc_config, deltas, options);
+	BOOST_REQUIRE_EQUAL(orbits.size(), deltas.size());
+	for(size_t i = 0; i < deltas.size(); ++i){
+		const auto& r = orbits[i];
+		BOOST_REQUIRE(r.found);
+		BOOST_CHECK(!r.lost);
+		BOOST_CHECK(r.dx_abs < options.eps);
+		BOOST_CHECK_EQUAL(r.x0[delta_], deltas[i]);
+
+		/* closed after one turn */
+		gtpsa::ss_vect<double> ps = r.x0.clone();
+		machine.propagate(calc_config, ps);
+		for(int k = 0; k < 4; ++k){
+			BOOST_CHECK_SMALL(ps[k] - r.x0[k], 1e-10);
+		}
+	}
+	BOOST_CHECK_SMALL(orbits[2].x0[x_], 1e-14);
+	BOOST_CHECK(std::abs(orbits[4].x0[x_]) > 1e-5);
+	/* linear in delta to first order */
+	BOOST_CHECK_CLOSE(orbits[3].x0[x_], -orbits[1].x0[x_], 5e0);
+
+	/* the same search in the caller's thread */
+	gtpsa::ss_vect<double> x0(0e0);
+	x0.set_zero();
+	x0[delta_] = deltas[4];
+	const auto single = ts::find_closed_orbit(machine, calc_config, x0, options);
+	BOOST_CHECK(single.found);
+	BOOST_CHECK_EQUAL(calc_config.dPparticle, deltas[4]);
+	for(int k = 0; k < 6; ++k){
+		BOOST_CHECK_EQUAL(single.x0[k], orbits[4].x0[k]);
+	}
+
+	/* one turn map compared to the TPSA one */
+	auto desc = std::make_shared<gtpsa::desc>(6, 1);
+	gtpsa::ss_vect<gtpsa::tpsa> M(desc, 1);
+	M.set_identity();
+	for(int k = 0; k < 6; ++k){
+		M[k] += single.x0[k];
+	}
+	machine.propagate(calc_config, M);
+	const arma::mat jac = M.jacobian();
+	/* same map up to round off */
+	BOOST_CHECK_SMALL(arma::abs(single.one_turn_map - jac.submat(0, 0, 5, 5)).max(), 1e-12);
+
+	/* with the cavities on delta is searched too: all offsets would give the same orbit */
+	calc_config.Cavity_on = true;
+	BOOST_CHECK_THROW(ts::find_closed_orbits(machine, calc_config, deltas, options), std::invalid_argument);
+	calc_config.Cavity_on = false;
+
+	options.eps = 0e0;
+	BOOST_CHECK_THROW(ts::find_closed_orbits(machine, calc_config, deltas, options), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test141_twiss_along_lattice)
+{
+	const std::string txt = fodo_lattice("qf, d1, qd, bend");
+	GLPSParser parse;
+	Config *C = parse.parse_byte(txt);
+	auto machine = ts::Accelerator(*C);
+	tsc::ConfigType calc_config;
+	gtpsa::ss_vect<double> x0(0e0);
+	x0.set_zero();
+
+	auto desc = std::make_shared<gtpsa::desc>(6, 1);
+	gtpsa::ss_vect<gtpsa::tpsa> M_tps(desc, 1);
+	M_tps.set_identity();
+	machine.propagate(calc_config, M_tps);
+	const arma::mat M = M_tps.jacobian().submat(0, 0, 5, 5);
+
+	/* periodic solution of the uncoupled cell */
+	const arma::vec eta = arma::solve(arma::eye(4, 4) - M.submat(0, 0, 3, 3), M.submat(0, delta_, 3, delta_));
+	double alpha[2], beta[2], tune[2];
+	arma::mat A0 = arma::eye(6, 6), B = arma::eye(6, 6);
+	for(int k = 0; k < 2; ++k){
+		const double m11 = M(2 * k, 2 * k), m12 = M(2 * k, 2 * k + 1), m22 = M(2 * k + 1, 2 * k + 1);
+		double mu = std::acos((m11 + m22) / 2e0);
+		if(m12 < 0e0){
+			mu = 2e0 * M_PI - mu;
+		}
+		tune[k] = mu / (2e0 * M_PI);
+		beta[k] = m12 / std::sin(mu);
+		alpha[k] = (m11 - m22) / (2e0 * std::sin(mu));
+		A0(2 * k, 2 * k) = std::sqrt(beta[k]);
+		A0(2 * k + 1, 2 * k) = -alpha[k] / std::sqrt(beta[k]);
+		A0(2 * k + 1, 2 * k + 1) = 1e0 / std::sqrt(beta[k]);
+	}
+	B(x_, delta_) = eta(x_);
+	B(px_, delta_) = eta(px_);
+	B(ct_, x_) = eta(px_);
+	B(ct_, px_) = -eta(x_);
+	const arma::mat A = B * A0;
+
+	const auto twiss = ts::twiss_along_lattice(machine, calc_config, A, x0);
+	const size_t n = machine.size();
+	BOOST_REQUIRE_EQUAL(twiss.size(), n);
+	BOOST_CHECK_EQUAL(twiss.beta.size(), 2 * n);
+	BOOST_CHECK_CLOSE(twiss.s.back(), 2.4, 1e-12);
+	BOOST_CHECK(std::abs(eta(x_)) > 1e-3);
+
+	/* periodic: back at the start after one turn */
+	for(int k = 0; k < 2; ++k){
+		const size_t ik = ts::Twiss::index(n - 1, k);
+		BOOST_CHECK_CLOSE(twiss.beta[ik], beta[k], 1e-8);
+		BOOST_CHECK_SMALL(twiss.alpha[ik] - alpha[k], 1e-8);
+		BOOST_CHECK_SMALL(twiss.eta[ik] - eta(2 * k), 1e-10);
+		BOOST_CHECK_SMALL(twiss.etap[ik] - eta(2 * k + 1), 1e-10);
+		BOOST_CHECK_CLOSE(twiss.nu[ik], tune[k], 1e-8);
+		for(size_t i = 0; i < n; ++i){
+			BOOST_CHECK(twiss.beta[ts::Twiss::index(i, k)] > 0e0);
+			if(i){
+				BOOST_CHECK(twiss.nu[ts::Twiss::index(i, k)] >= twiss.nu[ts::Twiss::index(i - 1, k)]);
+			}
+		}
+	}
+
+	const auto lf = twiss.latticeFunctions();
+	BOOST_CHECK_NO_THROW(lf.check());
+	BOOST_CHECK_EQUAL(lf.beta[Y_][1], twiss.beta[ts::Twiss::index(1, Y_)]);
+
+	BOOST_CHECK_THROW(ts::twiss_along_lattice(machine, calc_config, arma::mat(4, 4, arma::fill::eye), x0),
+			  std::invalid_argument);
+}
+
+/* fractional tunes of the linear one turn map around x0 */
+static std::array<double, 2> linear_tunes(ts::Accelerator& machine, tsc::ConfigType& calc_config,
+					  const gtpsa::ss_vect<double>& x0)
+{
+	auto desc = std::make_shared<gtpsa::desc>(6, 1);
+	gtpsa::ss_vect<gtpsa::tpsa> M_tps(desc, 1);
+	M_tps.set_identity();
+	for(int k = 0; k < ps_dim; ++k){
+		M_tps[k] += x0[k];
+	}
+	machine.propagate(calc_config, M_tps);
+	const arma::mat M = M_tps.jacobian();
+	std::array<double, 2> tune;
+	for(int k = 0; k < 2; ++k){
+		double mu = std::acos((M(2 * k, 2 * k) + M(2 * k + 1, 2 * k + 1)) / 2e0);
+		if(M(2 * k, 2 * k + 1) < 0e0){
+			mu = 2e0 * M_PI - mu;
+		}
+		tune[k] = mu / (2e0 * M_PI);
+	}
+	return tune;
+}
+
+BOOST_AUTO_TEST_CASE(test142_tune_shift)
+{
+	const std::string txt = fodo_lattice(
+		"qf, sf, d1, qd, oc, bend",
+		"sf:   Sextupole, L = 0.1, K = 8, N = 4, Method = 4;"
+		"oc:   Octupole, L = 0.1, K = 60, N = 4, Method = 4;"
+		);
+	GLPSParser parse;
+	Config *C = parse.parse_byte(txt);
+	auto machine = ts::Accelerator(*C);
+	tsc::ConfigType calc_config;
+	gtpsa::ss_vect<double> x0(0e0);
+	x0.set_zero();
+
+	ts::TuneShiftAnalysis analysis(3);
+	BOOST_CHECK_EQUAL(analysis.getOrder(), 3);
+	const auto tune_shift = analysis.compute(machine, calc_config, x0);
+	const auto tune = linear_tunes(machine, calc_config, x0);
+	for(int k = 0; k < 2; ++k){
+		BOOST_CHECK_CLOSE(tune_shift.nu[k], tune[k], 1e-8);
+		BOOST_CHECK_EQUAL(tune_shift.coefficient(k, 0, 0, 0), tune_shift.nu[k]);
+	}
+	/* K is a function: cross terms agree */
+	BOOST_CHECK_CLOSE(tune_shift.detuning(X_, Y_), tune_shift.detuning(Y_, X_), 1e-6);
+	BOOST_CHECK(std::abs(tune_shift.detuning(X_, X_)) > 1e-3);
+	BOOST_CHECK(std::abs(tune_shift.chromaticity(X_, 2)) > 0e0);
+
+	/* chromaticity: tunes of the linear maps around the off momentum closed orbits */
+	const double delta = 1e-4;
+	std::array<double, 2> tune_delta[2];
+	for(int s = 0; s < 2; ++s){
+		gtpsa::ss_vect<double> ps(0e0);
+		ps.set_zero();
+		ps[delta_] = s ? delta : -delta;
+		tsc::ConfigType conf;
+		const auto co = ts::find_closed_orbit(machine, conf, ps);
+		BOOST_REQUIRE(co.found);
+		tune_delta[s] = linear_tunes(machine, conf, co.x0);
+	}
+	for(int k = 0; k < 2; ++k){
+		BOOST_CHECK_CLOSE((tune_delta[1][k] - tune_delta[0][k]) / (2e0 * delta), tune_shift.chromaticity(k), 1e-3);
+		BOOST_CHECK_CLOSE(tune_delta[1][k], tune_shift.tune(k, 0e0, 0e0, delta), 1e-7);
+	}
+
+	/* detuning with amplitude: tune of a tracked particle */
+	const size_t n_turns = 1024;
+	auto desc = std::make_shared<gtpsa::desc>(6, 1);
+	gtpsa::ss_vect<gtpsa::tpsa> M_tps(desc, 1);
+	M_tps.set_identity();
+	machine.propagate(calc_config, M_tps);
+	const arma::mat M = M_tps.jacobian();
+	ts::NAFF naff(n_turns);
+	for(int k = 0; k < 2; ++k){
+		const double sin_mu = std::sin(2e0 * M_PI * tune[k]);
+		const double beta = M(2 * k, 2 * k + 1) / sin_mu;
+		const double alpha = (M(2 * k, 2 * k) - M(2 * k + 1, 2 * k + 1)) / (2e0 * sin_mu);
+		const double J = std::min(1e-6, 1e-5 / std::abs(tune_shift.detuning(k, k)));
+
+		gtpsa::ss_vect<double> ps(0e0);
+		ps.set_zero();
+		ps[2 * k] = std::sqrt(2e0 * J * beta);
+		ps[2 * k + 1] = -alpha * std::sqrt(2e0 * J / beta);
+		std::vector<double> x(n_turns), px(n_turns);
+		for(size_t turn = 0; turn < n_turns; ++turn){
+			x[turn] = ps[2 * k];
+			px[turn] = ps[2 * k + 1];
+			machine.propagate(calc_config, ps);
+		}
+		const double nu = naff.frequency(x.data(), px.data());
+		BOOST_CHECK_CLOSE(nu - tune_shift.nu[k], tune_shift.detuning(k, k) * J, 2);
+		BOOST_CHECK_CLOSE(tune_shift.tune(k, (k == X_) ? J : 0e0, (k == Y_) ? J : 0e0), nu, 1e-3);
+	}
+
+	/* workspaces reused: same result again */
+	const auto again = analysis.compute(machine, calc_config, x0);
+	BOOST_REQUIRE_EQUAL(again.terms.size(), tune_shift.terms.size());
+	for(size_t i = 0; i < again.terms.size(); ++i){
+		BOOST_CHECK(again.terms[i].exponents == tune_shift.terms[i].exponents);
+		BOOST_CHECK_EQUAL(again.terms[i].nu[X_], tune_shift.terms[i].nu[X_]);
+		BOOST_CHECK_EQUAL(again.terms[i].nu[Y_], tune_shift.terms[i].nu[Y_]);
+	}
+	/* order 4: same terms up to J delta, more beyond */
+	const auto order4 = ts::tune_shift(machine, calc_config, x0, 4);
+	BOOST_CHECK_CLOSE(order4.detuning(X_, X_), tune_shift.detuning(X_, X_), 1e-6);
+	BOOST_CHECK(order4.terms.size() > tune_shift.terms.size());
+
+	BOOST_CHECK_THROW(ts::TuneShiftAnalysis(1), std::invalid_argument);
+	tsc::ConfigType cavity_on;
+	cavity_on.Cavity_on = true;
+	BOOST_CHECK_THROW(analysis.compute(machine, cavity_on, x0), std::invalid_argument);
+}
 /*
  * Local Variables:
  * mode: c++
@@ -0,0 +1,176 @@
+#define BOOST_TEST_MODULE driving_terms
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <thor_scsi/std_machine/driving_terms.h>
+#include <tps/enums.h>
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+
+namespace ts = thor_scsi;
+typedef std::complex<double> cplx;
+
+/* positions with arbitrary, but fixed Twiss parameters */
+static ts::Twiss make_twiss(const size_t n)
+{
+	ts::Twiss twiss;
+	twiss.length.assign(n, 0.5);
+	for(size_t i = 0; i < n; ++i){
+		twiss.s.push_back(0.5 * double(i + 1));
+		for(int k = 0; k < 2; ++k){
+			twiss.alpha.push_back(0.1 * double(k) - 0.2);
+			twiss.beta.push_back(2e0 + double(i % 3) + 4e0 * double(k));
+			twiss.nu.push_back((0.13 + 0.07 * double(k)) * double(i + 1));
+			twiss.eta.push_back(k ? 0e0 : 0.1 + 0.02 * double(i));
+			twiss.etap.push_back(0e0);
+		}
+	}
+	return twiss;
+}
+
+static std::vector<ts::DrivingTermFamily> make_families(void)
+{
+	return {
+		{"qf", 2, {0, 5}, 1.3},
+		{"sf", 3, {1, 3, 6}, 4.0},
+		{"sd", 3, {2, 4}, -5.0},
+		{"oc", 4, {4}, 20.0}
+	};
+}
+
+static inline cplx phase(const ts::Twiss& twiss, const size_t i, const int k, const double p)
+{
+	return std::polar(1e0, 2e0 * M_PI * p * twiss.nu[ts::Twiss::index(i, k)]);
+}
+
+BOOST_AUTO_TEST_CASE(test10_first_order)
+{
+	const auto twiss = make_twiss(8);
+	const auto families = make_families();
+	ts::DrivingTerms rdt(twiss, families, 2);
+	BOOST_CHECK_EQUAL(rdt.nFamilies(), 4u);
+
+	/* sums of SLS Note 09/97 */
+	cplx h21000 = 0e0, h30000 = 0e0, h10110 = 0e0, h10020 = 0e0, h10200 = 0e0;
+	cplx h11001 = 0e0, h00111 = 0e0, h20001 = 0e0, h00201 = 0e0, h10002 = 0e0, h22000 = 0e0;
+	/* second order chromaticity: kicks scale with 1 / (1 + delta) = 1 - delta + delta^2 */
+	cplx h11002 = 0e0, h00112 = 0e0;
+	for(const auto& fam : families){
+		for(const auto i : fam.index){
+			const double bx = twiss.beta[ts::Twiss::index(i, X_)], by = twiss.beta[ts::Twiss::index(i, Y_)];
+			const double eta = twiss.eta[ts::Twiss::index(i, X_)];
+			const double b2 = (fam.n == 2) ? fam.strength : 0e0, b3 = (fam.n == 3) ? fam.strength : 0e0;
+			const double b4 = (fam.n == 4) ? fam.strength : 0e0;
+			h21000 += -b3 * std::pow(bx, 1.5) / 8e0 * phase(twiss, i, X_, 1);
+			h30000 += -b3 * std::pow(bx, 1.5) / 24e0 * phase(twiss, i, X_, 3);
+			h10110 += b3 * std::sqrt(bx) * by / 4e0 * phase(twiss, i, X_, 1);
+			h10020 += b3 * std::sqrt(bx) * by / 8e0 * phase(twiss, i, X_, 1) * phase(twiss, i, Y_, -2);
+			h10200 += b3 * std::sqrt(bx) * by / 8e0 * phase(twiss, i, X_, 1) * phase(twiss, i, Y_, 2);
+			h11001 += (b2 - 2e0 * b3 * eta) * bx / 4e0;
+			h00111 += -(b2 - 2e0 * b3 * eta) * by / 4e0;
+			h20001 += (b2 - 2e0 * b3 * eta) * bx / 8e0 * phase(twiss, i, X_, 2);
+			h00201 += -(b2 - 2e0 * b3 * eta) * by / 8e0 * phase(twiss, i, Y_, 2);
+			h10002 += (b2 - b3 * eta) * eta * std::sqrt(bx) / 2e0 * phase(twiss, i, X_, 1);
+			h22000 += -3e0 * b4 * bx * bx / 32e0;
+			h11002 += -(b2 - 2e0 * b3 * eta + 3e0 * b4 * eta * eta) * bx / 4e0;
+			h00112 += (b2 - 2e0 * b3 * eta + 3e0 * b4 * eta * eta) * by / 4e0;
+		}
+	}
+	BOOST_CHECK_SMALL(std::abs(rdt.firstOrder(2, 1, 0, 0) - h21000), 1e-12);
+	BOOST_CHECK_SMALL(std::abs(rdt.firstOrder(3, 0, 0, 0) - h30000), 1e-12);
+	BOOST_CHECK_SMALL(std::abs(rdt.firstOrder(1, 0, 1, 1) - h10110), 1e-12);
+	BOOST_CHECK_SMALL(std::abs(rdt.firstOrder(1, 0, 0, 2) - h10020), 1e-12);
+	BOOST_CHECK_SMALL(std::abs(rdt.firstOrder(1, 0, 2, 0) - h10200), 1e-12);
+	BOOST_CHECK_SMALL(std::abs(rdt.firstOrder(1, 1, 0, 0, 1) - h11001), 1e-12);
+	BOOST_CHECK_SMALL(std::abs(rdt.firstOrder(0, 0, 1, 1, 1) - h00111), 1e-12);
+	BOOST_CHECK_SMALL(std::abs(rdt.firstOrder(2, 0, 0, 0, 1) - h20001), 1e-12);
+	BOOST_CHECK_SMALL(std::abs(rdt.firstOrder(0, 0, 2, 0, 1) - h00201), 1e-12);
+	BOOST_CHECK_SMALL(std::abs(rdt.firstOrder(1, 0, 0, 0, 2) - h10002), 1e-12);
+	BOOST_CHECK_SMALL(std::abs(rdt.firstOrder(2, 2, 0, 0) - h22000), 1e-12);
+	BOOST_CHECK_SMALL(std::abs(rdt.firstOrder(1, 1, 0, 0, 2) - h11002), 1e-12);
+	BOOST_CHECK_SMALL(std::abs(rdt.firstOrder(0, 0, 1, 1, 2) - h00112), 1e-12);
+
+	/* real generator: h_jilkm = conj(h_ijklm) */
+	BOOST_CHECK_SMALL(std::abs(rdt.firstOrder(1, 2, 0, 0) - std::conj(h21000)), 1e-12);
+	/* not driven */
+	BOOST_CHECK_EQUAL(rdt.firstOrder(7, 0, 0, 0), cplx(0e0));
+	BOOST_CHECK_EQUAL(rdt.get(63, 63, 63, 63, 63), cplx(0e0));
+	BOOST_CHECK(!rdt.terms().empty());
+}
+
+BOOST_AUTO_TEST_CASE(test20_second_order)
+{
+	/* two sextupole kicks: h40000 of 1/2 [f_1, f_2], worked out by hand */
+	const auto twiss = make_twiss(4);
+	const double b1 = 3e0, b2 = -2e0;
+	ts::DrivingTerms rdt(twiss, {{"s1", 3, {1}, b1}, {"s2", 3, {3}, b2}});
+
+	const double c1 = -b1 / 3e0, c2 = -b2 / 3e0;
+	const cplx a1 = std::sqrt(twiss.beta[ts::Twiss::index(1, X_)]) / 2e0 * phase(twiss, 1, X_, 1);
+	const cplx a2 = std::sqrt(twiss.beta[ts::Twiss::index(3, X_)]) / 2e0 * phase(twiss, 3, X_, 1);
+	const cplx h40000 = cplx(0e0, 9e0) * c1 * c2 * (a1 * std::conj(a2) - std::conj(a1) * a2) * a1 * a1 * a2 * a2;
+	BOOST_CHECK_SMALL(std::abs(rdt.secondOrder(4, 0, 0, 0) - h40000), 1e-12 * std::abs(h40000));
+	BOOST_CHECK(std::abs(h40000) > 1e-3);
+	/* no first order octupole like terms */
+	BOOST_CHECK_EQUAL(rdt.firstOrder(4, 0, 0, 0), cplx(0e0));
+
+	/* kicks at the same position commute */
+	ts::DrivingTerms same(twiss, {{"s1", 3, {2}, b1}, {"s2", 3, {2}, b2}});
+	for(const auto& t : same.terms()){
+		BOOST_CHECK_SMALL(std::abs(t.second), 1e-12);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test30_incremental)
+{
+	const auto twiss = make_twiss(8);
+	auto families = make_families();
+	ts::DrivingTerms rdt(twiss, families, 1);
+	const ts::DrivingTerms rdt_parallel(twiss, families, 3);
+
+	rdt.setStrength(1, -7.0);
+	rdt.setStrength(3, 0e0);
+	rdt.setStrength(1, 6.5);
+	BOOST_CHECK_EQUAL(rdt.getStrength(1), 6.5);
+	families[1].strength = 6.5;
+	families[3].strength = 0e0;
+	const ts::DrivingTerms fresh(twiss, families, 2);
+
+	const auto terms = rdt.terms(), terms_fresh = fresh.terms(), terms_parallel = rdt_parallel.terms();
+	BOOST_REQUIRE_EQUAL(terms.size(), terms_fresh.size());
+	BOOST_REQUIRE_EQUAL(terms.size(), terms_parallel.size());
+	for(size_t p = 0; p < terms.size(); ++p){
+		BOOST_CHECK(terms[p].exponents == terms_fresh[p].exponents);
+		BOOST_CHECK_SMALL(std::abs(terms[p].first - terms_fresh[p].first), 1e-10);
+		BOOST_CHECK_SMALL(std::abs(terms[p].second - terms_fresh[p].second), 1e-10);
+		const auto& e = terms[p].exponents;
+		BOOST_CHECK_SMALL(std::abs(rdt_parallel.get(e[0], e[1], e[2], e[3], e[4])
+					   - terms_parallel[p].first - terms_parallel[p].second), 1e-10);
+	}
+
+	/* second order scales with the square of the strengths */
+	std::vector<double> strengths;
+	for(const auto& fam : families){
+		strengths.push_back(2e0 * fam.strength);
+	}
+	rdt.setStrengths(strengths);
+	BOOST_CHECK_SMALL(std::abs(rdt.secondOrder(2, 2, 0, 0) - 4e0 * fresh.secondOrder(2, 2, 0, 0)),
+			  1e-10 * std::abs(fresh.secondOrder(2, 2, 0, 0)));
+	BOOST_CHECK_SMALL(std::abs(rdt.firstOrder(2, 1, 0, 0) - 2e0 * fresh.firstOrder(2, 1, 0, 0)), 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE(test40_check_input)
+{
+	const auto twiss = make_twiss(3);
+	BOOST_CHECK_THROW(ts::DrivingTerms(twiss, {{"b", 1, {0}, 1e0}}), std::invalid_argument);
+	BOOST_CHECK_THROW(ts::DrivingTerms(twiss, {{"s", 3, {3}, 1e0}}), std::invalid_argument);
+	ts::DrivingTerms rdt(twiss, {{"s", 3, {0, 2}, 1e0}});
+	BOOST_CHECK_THROW(rdt.setStrengths({1e0, 2e0}), std::invalid_argument);
+	BOOST_CHECK_THROW(rdt.setStrength(1, 1e0), std::out_of_range);
+}
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -0,0 +1,325 @@
+#define BOOST_TEST_MODULE girders
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <thor_scsi/std_machine/accelerator.h>
+#include <thor_scsi/std_machine/std_machine.h>
+#include <thor_scsi/std_machine/girders.h>
+#include <thor_scsi/elements/quadrupole.h>
+#include <thor_scsi/elements/marker.h>
+#include <thor_scsi/elements/standard_observer.h>
+#include <thor_scsi/elements/standard_aperture.h>
+#include <thor_scsi/core/config.h>
+#include <thor_scsi/core/exceptions.h>
+#include <cmath>
+#include <memory>
+#include <string>
+
+namespace tse = thor_scsi::elements;
+namespace tsc = thor_scsi::core;
+namespace ts = thor_scsi;
+
+int reg_done = ts::register_elements();
+
+static const std::string lattice_txt(
+	"d1: Drift, L = 0.25;"
+	"gs: Marker;"
+	"ge: Marker;"
+	"qf: Quadrupole, L = 0.5, K = 1.2, N = 4, Method = 4;"
+	"qd: Quadrupole, L = 0.5, K = -1.2, N = 4, Method = 4;"
+	"mini_cell : LINE = (d1, gs, qf, d1, qd, ge, d1);\n"
+	);
+
+static const gtpsa::ss_vect<double> ps_start{1e-3, -2e-4, -7e-4, 3e-4, 1e-3, 0e0};
+
+static void misalign_elements(ts::Accelerator& acc)
+{
+	auto qf = std::dynamic_pointer_cast<tse::QuadrupoleType>(acc.find("qf", 0));
+	auto qd = std::dynamic_pointer_cast<tse::QuadrupoleType>(acc.find("qd", 0));
+	BOOST_REQUIRE(qf);
+	BOOST_REQUIRE(qd);
+	qf->transform.setDx(3e-5);
+	qf->transform.setRoll(1e-3);
+	qd->transform.setDy(-4e-5);
+}
+
+/*
+ * reference: each element between the markers is passed with the girder
+ * transform applied separately around it
+ */
+static gtpsa::ss_vect<double> reference_propagate(const double dx, const double dy, const double roll)
+{
+	GLPSParser parse;
+	Config *C = parse.parse_byte(lattice_txt);
+	auto acc = ts::Accelerator(*C);
+	misalign_elements(acc);
+
+	tsc::Girder girder;
+	girder.transform.setdS(dx, dy);
+	girder.transform.setRoll(roll);
+
+	tsc::ConfigType calc_config;
+	gtpsa::ss_vect<double> ps = ps_start.clone();
+	bool on_girder = false;
+	for(auto& cv : acc){
+		auto elem = std::dynamic_pointer_cast<tsc::ElemType>(cv);
+		if(cv->name == "gs"){
+			on_girder = true;
+		}
+		const bool mounted = on_girder && std::dynamic_pointer_cast<tse::LocalGalileanPRot>(cv);
+		if(mounted){
+			girder.forward(ps);
+		}
+		elem->propagate(calc_config, ps);
+		if(mounted){
+			girder.backward(ps);
+		}
+		if(cv->name == "ge"){
+			on_girder = false;
+		}
+	}
+	return ps;
+}
+
+static void check_ps_equal(const gtpsa::ss_vect<double>& ps, const gtpsa::ss_vect<double>& ref)
+{
+	for(int i=0; i<6; ++i){
+		BOOST_CHECK_SMALL(ps[i] - ref[i], 1e-16);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test10_mount)
+{
+	GLPSParser parse;
+	Config *C = parse.parse_byte(lattice_txt);
+	auto acc = ts::Accelerator(*C);
+
+	auto girders = ts::mount_on_girders(acc, "gs", "ge");
+	BOOST_CHECK_EQUAL(girders.size(), 1u);
+	BOOST_CHECK_EQUAL(girders[0]->name, "gs_0");
+
+	auto qf = std::dynamic_pointer_cast<tse::QuadrupoleType>(acc.find("qf", 0));
+	auto qd = std::dynamic_pointer_cast<tse::QuadrupoleType>(acc.find("qd", 0));
+	auto gs = std::dynamic_pointer_cast<tse::MarkerType>(acc.find("gs", 0));
+	auto ge = std::dynamic_pointer_cast<tse::MarkerType>(acc.find("ge", 0));
+	BOOST_CHECK(qf->getGirder() == girders[0]);
+	BOOST_CHECK(qd->getGirder() == girders[0]);
+	BOOST_CHECK(gs->getGirder() == girders[0]);
+	BOOST_CHECK(ge->getGirder() == girders[0]);
+
+	ts::unmount_from_girders(acc);
+	BOOST_CHECK(!qf->getGirder());
+	BOOST_CHECK(!ge->getGirder());
+}
+
+BOOST_AUTO_TEST_CASE(test11_mount_unmatched)
+{
+	GLPSParser parse;
+	{
+		Config *C = parse.parse_byte(
+			"d1: Drift, L = 0.25; gs: Marker; ge: Marker;"
+			"mini_cell : LINE = (gs, d1, gs, d1, ge);\n");
+		auto acc = ts::Accelerator(*C);
+		BOOST_CHECK_THROW(ts::mount_on_girders(acc, "gs", "ge"), ts::SanityCheckError);
+	}
+	{
+		Config *C = parse.parse_byte(
+			"d1: Drift, L = 0.25; gs: Marker; ge: Marker;"
+			"mini_cell : LINE = (gs, d1);\n");
+		auto acc = ts::Accelerator(*C);
+		BOOST_CHECK_THROW(ts::mount_on_girders(acc, "gs", "ge"), ts::SanityCheckError);
+	}
+	{
+		Config *C = parse.parse_byte(
+			"d1: Drift, L = 0.25; gs: Marker; ge: Marker;"
+			"mini_cell : LINE = (d1, ge);\n");
+		auto acc = ts::Accelerator(*C);
+		BOOST_CHECK_THROW(ts::mount_on_girders(acc, "gs", "ge"), ts::SanityCheckError);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test20_propagate_on_girder)
+{
+	const double dx = 2e-4, dy = -1e-4, roll = 3e-3;
+
+	GLPSParser parse;
+	Config *C = parse.parse_byte(lattice_txt);
+	auto acc = ts::Accelerator(*C);
+	misalign_elements(acc);
+	auto girders = ts::mount_on_girders(acc, "gs", "ge");
+	girders[0]->transform.setdS(dx, dy);
+	girders[0]->transform.setRoll(roll);
+
+	tsc::ConfigType calc_config;
+	gtpsa::ss_vect<double> ps = ps_start.clone();
+	acc.propagate(calc_config, ps);
+	check_ps_equal(ps, reference_propagate(dx, dy, roll));
+
+	/* element by element: each one uses the composed transform */
+	gtpsa::ss_vect<double> ps_elem = ps_start.clone();
+	for(auto& cv : acc){
+		std::dynamic_pointer_cast<tsc::ElemType>(cv)->propagate(calc_config, ps_elem);
+	}
+	check_ps_equal(ps_elem, ps);
+}
+
+BOOST_AUTO_TEST_CASE(test30_girder_moved)
+{
+	GLPSParser parse;
+	Config *C = parse.parse_byte(lattice_txt);
+	auto acc = ts::Accelerator(*C);
+	misalign_elements(acc);
+	auto girders = ts::mount_on_girders(acc, "gs", "ge");
+	auto qf = std::dynamic_pointer_cast<tse::QuadrupoleType>(acc.find("qf", 0));
+
+	tsc::ConfigType calc_config;
+	{
+		gtpsa::ss_vect<double> ps = ps_start.clone();
+		qf->propagate(calc_config, ps);
+	}
+	girders[0]->transform.setDx(5e-4);
+	{
+		/* composed transform updated by the setter */
+		gtpsa::ss_vect<double> ps = ps_start.clone(), ps_ref = ps_start.clone();
+		qf->propagate(calc_config, ps);
+		girders[0]->forward(ps_ref);
+		qf->propagateOnGirder(calc_config, ps_ref);
+		girders[0]->backward(ps_ref);
+		check_ps_equal(ps, ps_ref);
+	}
+	qf->transform.setDy(1e-5);
+	{
+		/* element moved on girder */
+		gtpsa::ss_vect<double> ps = ps_start.clone(), ps_ref = ps_start.clone();
+		qf->propagate(calc_config, ps);
+		girders[0]->forward(ps_ref);
+		qf->propagateOnGirder(calc_config, ps_ref);
+		girders[0]->backward(ps_ref);
+		check_ps_equal(ps, ps_ref);
+	}
+	qf->transform.setC1(std::cos(2e-3));
+	qf->transform.setS1(std::sin(2e-3));
+	{
+		/* momentum kick part of the element transform */
+		gtpsa::ss_vect<double> ps = ps_start.clone(), ps_ref = ps_start.clone();
+		qf->propagate(calc_config, ps);
+		girders[0]->forward(ps_ref);
+		qf->propagateOnGirder(calc_config, ps_ref);
+		girders[0]->backward(ps_ref);
+		check_ps_equal(ps, ps_ref);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test31_girder_moved_before_propagation)
+{
+	GLPSParser parse;
+	Config *C = parse.parse_byte(lattice_txt);
+	auto acc = ts::Accelerator(*C);
+	misalign_elements(acc);
+	auto qf = std::dynamic_pointer_cast<tse::QuadrupoleType>(acc.find("qf", 0));
+
+	/* mounted on one girder, remounted on an other one: only the latter counts */
+	auto first = std::make_shared<tsc::Girder>("first");
+	auto second = std::make_shared<tsc::Girder>("second");
+	qf->setGirder(first);
+	qf->setGirder(second);
+	second->transform.setdS(-3e-4, 2e-4);
+	second->transform.setRoll(-2e-3);
+	first->transform.setDx(1e-3);
+
+	/* global2Local only reads the transform composed when the girder was set */
+	tsc::ConfigType calc_config;
+	gtpsa::ss_vect<double> ps = ps_start.clone(), ps_ref = ps_start.clone();
+	qf->propagate(calc_config, ps);
+	second->forward(ps_ref);
+	qf->propagateOnGirder(calc_config, ps_ref);
+	second->backward(ps_ref);
+	check_ps_equal(ps, ps_ref);
+
+	/* unmounted: the element's own transform */
+	qf->setGirder(nullptr);
+	second->transform.setDx(7e-4);
+	ps = ps_start.clone();
+	ps_ref = ps_start.clone();
+	qf->propagate(calc_config, ps);
+	qf->propagateOnGirder(calc_config, ps_ref);
+	check_ps_equal(ps, ps_ref);
+}
+
+BOOST_AUTO_TEST_CASE(test40_observer_on_girder)
+{
+	const double dx = -1e-4, dy = 2e-4, roll = -2e-3;
+
+	GLPSParser parse;
+	Config *C = parse.parse_byte(lattice_txt);
+	auto acc = ts::Accelerator(*C);
+	misalign_elements(acc);
+	auto girders = ts::mount_on_girders(acc, "gs", "ge");
+	girders[0]->transform.setdS(dx, dy);
+	girders[0]->transform.setRoll(roll);
+
+	/* observers see global coordinates: run is interrupted */
+	auto qf = acc.find("qf", 0);
+	auto observer = std::make_shared<tse::StandardObserver>();
+	qf->set_observer(observer);
+
+	GLPSParser parse_ref;
+	Config *C_ref = parse_ref.parse_byte(lattice_txt);
+	auto acc_ref = ts::Accelerator(*C_ref);
+	misalign_elements(acc_ref);
+	auto girders_ref = ts::mount_on_girders(acc_ref, "gs", "ge");
+	girders_ref[0]->transform.setdS(dx, dy);
+	girders_ref[0]->transform.setRoll(roll);
+	/* only elements up to qf */
+	tsc::ConfigType calc_config;
+	gtpsa::ss_vect<double> ps_ref = ps_start.clone();
+	acc_ref.propagate(calc_config, ps_ref, 0, 3);
+
+	gtpsa::ss_vect<double> ps = ps_start.clone();
+	acc.propagate(calc_config, ps);
+	BOOST_CHECK(observer->hasPhaseSpace());
+	check_ps_equal(observer->getPhaseSpace(), ps_ref);
+	check_ps_equal(ps, reference_propagate(dx, dy, roll));
+}
+
+BOOST_AUTO_TEST_CASE(test50_lost_on_girder)
+{
+	const double dx = 2e-4, dy = -1e-4, roll = 3e-3;
+
+	GLPSParser parse;
+	Config *C = parse.parse_byte(lattice_txt);
+	auto acc = ts::Accelerator(*C);
+	misalign_elements(acc);
+	auto girders = ts::mount_on_girders(acc, "gs", "ge");
+	girders[0]->transform.setdS(dx, dy);
+	girders[0]->transform.setRoll(roll);
+
+	GLPSParser parse_ref;
+	Config *C_ref = parse_ref.parse_byte(lattice_txt);
+	auto acc_ref = ts::Accelerator(*C_ref);
+	misalign_elements(acc_ref);
+	auto girders_ref = ts::mount_on_girders(acc_ref, "gs", "ge");
+	girders_ref[0]->transform.setdS(dx, dy);
+	girders_ref[0]->transform.setRoll(roll);
+
+	/* drift between qf and qd: particle lost there */
+	auto d1 = std::dynamic_pointer_cast<tsc::ElemType>(acc.at(3));
+	BOOST_REQUIRE(d1);
+	d1->setAperture(std::make_shared<tse::RectangularAperture>(1e-6, 1e-6));
+
+	tsc::ConfigType calc_config;
+	gtpsa::ss_vect<double> ps_ref = ps_start.clone();
+	acc_ref.propagate(calc_config, ps_ref, 0, 4);
+
+	gtpsa::ss_vect<double> ps = ps_start.clone();
+	const int next_elem = acc.propagate(calc_config, ps);
+	BOOST_CHECK_EQUAL(next_elem, 4);
+	/* left in global coordinates */
+	check_ps_equal(ps, ps_ref);
+}
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
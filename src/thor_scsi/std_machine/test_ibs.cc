@@ -0,0 +1,133 @@
+#define BOOST_TEST_MODULE ibs
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <thor_scsi/std_machine/ibs.h>
+#include <tps/enums.h>
+#include <cmath>
+#include <stdexcept>
+
+namespace ts = thor_scsi;
+
+/* a ring of n identical positions, no vertical dispersion */
+static ts::LatticeFunctions make_lattice_functions(const size_t n, const double eta_x, const double etap_x)
+{
+	ts::LatticeFunctions lf;
+	lf.length.assign(n, 1e0);
+	for(int k = 0; k < 2; ++k){
+		lf.alpha[k].assign(n, 0e0);
+		lf.eta[k].assign(n, 0e0);
+		lf.etap[k].assign(n, 0e0);
+	}
+	lf.alpha[X_].assign(n, 0.5);
+	lf.beta[X_].assign(n, 8e0);
+	lf.beta[Y_].assign(n, 12e0);
+	lf.eta[X_].assign(n, eta_x);
+	lf.etap[X_].assign(n, etap_x);
+	return lf;
+}
+
+static ts::BeamParameters make_beam(void)
+{
+	ts::BeamParameters beam;
+	beam.energy = 3e9;
+	beam.n_particles = 1e10;
+	beam.eps = {1e-10, 1e-10};
+	beam.sigma_delta = 1e-3;
+	beam.sigma_s = 3e-3;
+	beam.coulomb_log = 15e0;
+	return beam;
+}
+
+BOOST_AUTO_TEST_CASE(test10_bane_g)
+{
+	BOOST_CHECK_CLOSE(ts::ibs_bane_g(1e0), 1e0, 1e-12);
+	BOOST_CHECK_CLOSE(ts::ibs_bane_g(0.1), ts::ibs_bane_g(10e0), 1e-10);
+	/* Bane's fit alpha^(0.021 - 0.044 ln(alpha)), accurate to about 1.5 % */
+	const double alpha = 0.1;
+	BOOST_CHECK_CLOSE(ts::ibs_bane_g(alpha), std::pow(alpha, 0.021 - 0.044 * std::log(alpha)), 2e0);
+	BOOST_CHECK_THROW(ts::ibs_bane_g(0e0), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test20_bjorken_mtingwa_vs_bane)
+{
+	/* phi_x = eta' + alpha eta / beta = 0: the high energy approximation holds */
+	const double eta_x = 0.1;
+	const auto lf = make_lattice_functions(16, eta_x, -0.5 * eta_x / 8e0);
+	const auto beam = make_beam();
+
+	const auto bm = ts::ibs_growth_rates(lf, beam, ts::IBSModel::BjorkenMtingwa, 4);
+	const auto bane = ts::ibs_growth_rates(lf, beam, ts::IBSModel::Bane, 1);
+
+	BOOST_CHECK_EQUAL(bm.local[X_].size(), 16u);
+	BOOST_CHECK_GT(bm.rate[X_], 0e0);
+	BOOST_CHECK_GT(bm.rate[Z_], 0e0);
+	/* agree up to terms of order a, b (here a few percent) */
+	BOOST_CHECK_CLOSE(bm.rate[X_], bane.rate[X_], 6e0);
+	BOOST_CHECK_CLOSE(bm.rate[Z_], bane.rate[Z_], 6e0);
+	/* no vertical dispersion: vertical rate small compared to the others */
+	BOOST_CHECK_SMALL(bm.rate[Y_], 1e-3 * bm.rate[X_]);
+	BOOST_CHECK_EQUAL(bane.rate[Y_], 0e0);
+
+	/* identical positions */
+	BOOST_CHECK_CLOSE(bm.local[X_].front(), bm.local[X_].back(), 1e-10);
+	BOOST_CHECK_CLOSE(bm.local[X_].front(), bm.rate[X_], 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE(test21_growth_rates_scale_with_current)
+{
+	const auto lf = make_lattice_functions(4, 0.1, 0.02);
+	auto beam = make_beam();
+	const auto r1 = ts::ibs_growth_rates(lf, beam);
+	beam.n_particles *= 2e0;
+	const auto r2 = ts::ibs_growth_rates(lf, beam);
+	for(int k = 0; k < 3; ++k){
+		BOOST_CHECK_CLOSE(r2.rate[k], 2e0 * r1.rate[k], 1e-10);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test22_growth_rates_check_input)
+{
+	auto lf = make_lattice_functions(4, 0.1, 0.02);
+	auto beam = make_beam();
+	beam.coulomb_log = NAN;
+	BOOST_CHECK_THROW(ts::ibs_growth_rates(lf, beam), std::invalid_argument);
+	beam = make_beam();
+	lf.eta[Y_].pop_back();
+	BOOST_CHECK_THROW(ts::ibs_growth_rates(lf, beam), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test30_equilibrium)
+{
+	const auto lf = make_lattice_functions(8, 0.1, 0.02);
+	const std::array<double, 3> tau = {10e-3, 10e-3, 5e-3};
+
+	auto beam0 = make_beam();
+	beam0.n_particles = 0e0;
+	const auto zero = ts::ibs_equilibrium(lf, beam0, tau);
+	BOOST_CHECK_CLOSE(zero.eps[X_], beam0.eps[X_], 1e-12);
+	BOOST_CHECK_CLOSE(zero.sigma_delta, beam0.sigma_delta, 1e-12);
+
+	beam0 = make_beam();
+	beam0.n_particles = 1e9;
+	const auto eq = ts::ibs_equilibrium(lf, beam0, tau, ts::IBSModel::BjorkenMtingwa, 1e-9, 200);
+	BOOST_CHECK_GT(eq.eps[X_], beam0.eps[X_]);
+	BOOST_CHECK_GT(eq.sigma_delta, beam0.sigma_delta);
+	BOOST_CHECK_CLOSE(eq.sigma_s / eq.sigma_delta, beam0.sigma_s / beam0.sigma_delta, 1e-10);
+
+	/* fix point: eps = eps_0 / (1 - tau / T) */
+	const auto rates = ts::ibs_growth_rates(lf, eq).rate;
+	BOOST_CHECK_CLOSE(eq.eps[X_] * (1e0 - tau[X_] * rates[X_]), beam0.eps[X_], 1e-5);
+	BOOST_CHECK_CLOSE(std::pow(eq.sigma_delta, 2) * (1e0 - tau[Z_] * rates[Z_]),
+			  std::pow(beam0.sigma_delta, 2), 1e-5);
+
+	/* IBS stronger than damping */
+	const std::array<double, 3> tau_long = {10e0, 10e0, 10e0};
+	BOOST_CHECK_THROW(ts::ibs_equilibrium(lf, beam0, tau_long), std::runtime_error);
+}
+
+/*
+ * Local Variables:
+ * mode: c++
+ * c-file-style: "python"
+ * End:
+ */
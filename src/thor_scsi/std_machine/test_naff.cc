@@ -0,0 +1,99 @@
+#define BOOST_TEST_MODULE naff
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <thor_scsi/std_machine/naff.h>
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+#include <vector>
+
+namespace ts = thor_scsi;
+
+/* x - i px = sum_k a_k exp(2 pi i nu_k n) */
+static void make_signal(const std::vector<double>& nu, const std::vector<std::complex<double>>& a,
+			const size_t n, std::vector<double>& x, std::vector<double>& px)
+{
+	x.assign(n, 0e0);
+	px.assign(n, 0e0);
+	for(size_t i = 0; i < n; ++i){
+		std::complex<double> z = 0e0;
+		for(size_t k = 0; k < nu.size(); ++k){
+			z += a[k] * std::polar(1e0, 2e0 * M_PI * nu[k] * double(i));
+		}
+		x[i] = std::real(z);
+		px[i] = -std::imag(z);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test10_single_frequency)
+{
+	const size_t n = 1024;
+	std::vector<double> x, px;
+	make_signal({0.2345678}, {std::polar(1e-3, 0.3)}, n, x, px);
+
+	ts::NAFF naff(n);
+	BOOST_CHECK_CLOSE(naff.frequency(x.data(), px.data()), 0.2345678, 1e-8);
+	/* negative frequencies for complex signals */
+	make_signal({-0.31}, {1e0}, n, x, px);
+	BOOST_CHECK_CLOSE(naff.frequency(x.data(), px.data()), -0.31, 1e-8);
+
+	/* real signal: positive frequency */
+	make_signal({0.2345678}, {1e0}, n, x, px);
+	BOOST_CHECK_CLOSE(naff.frequency(x.data(), nullptr), 0.2345678, 1e-5);
+
+	const std::vector<double> zero(n, 0e0);
+	BOOST_CHECK(std::isnan(naff.frequency(zero.data(), zero.data())));
+	BOOST_CHECK_THROW(ts::NAFF(1), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test20_terms)
+{
+	const size_t n = 2048;
+	const std::vector<double> nu = {0.31234, 0.12345, -0.2};
+	const std::vector<std::complex<double>> a = {
+		std::polar(1e0, 0.1), std::polar(0.1, -1.0), std::polar(0.01, 2.0)
+	};
+	std::vector<double> x, px;
+	make_signal(nu, a, n, x, px);
+
+	ts::NAFF naff(n, 3);
+	const auto terms = naff.analyse(x.data(), px.data(), 3);
+	BOOST_REQUIRE_EQUAL(terms.size(), 3u);
+	for(size_t k = 0; k < 3; ++k){
+		BOOST_CHECK_SMALL(terms[k].frequency - nu[k], 1e-9);
+		BOOST_CHECK_SMALL(std::abs(terms[k].amplitude - a[k]), 1e-6 * std::abs(a[0]));
+	}
+
+	/* the workspace is reused: same result again */
+	const auto again = naff.analyse(x.data(), px.data(), 3);
+	for(size_t k = 0; k < 3; ++k){
+		BOOST_CHECK_EQUAL(again[k].frequency, terms[k].frequency);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test30_many_signals)
+{
+	const size_t n = 512, n_signals = 7;
+	std::vector<double> x, px, xs, pxs;
+	std::vector<double> nu;
+	for(size_t i = 0; i < n_signals; ++i){
+		nu.push_back(0.1 + 0.05 * double(i));
+		make_signal({nu.back()}, {1e0}, n, x, px);
+		xs.insert(xs.end(), x.begin(), x.end());
+		pxs.insert(pxs.end(), px.begin(), px.end());
+	}
+	const auto result = ts::naff_analyse(xs.data(), pxs.data(), n_signals, n, 1, 1, 3);
+	const auto single = ts::naff_analyse(xs.data(), pxs.data(), n_signals, n, 1, 1, 1);
+	BOOST_REQUIRE_EQUAL(result.size(), n_signals);
+	for(size_t i = 0; i < n_signals; ++i){
+		BOOST_REQUIRE_EQUAL(result[i].size(), 1u);
+		BOOST_CHECK_SMALL(result[i][0].frequency - nu[i], 1e-8);
+		BOOST_CHECK_EQUAL(result[i][0].frequency, single[i][0].frequency);
+	}
+}
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
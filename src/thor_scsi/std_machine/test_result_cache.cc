@@ -0,0 +1,154 @@
+#define BOOST_TEST_MODULE result_cache
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <thor_scsi/std_machine/accelerator.h>
+#include <thor_scsi/std_machine/std_machine.h>
+#include <thor_scsi/std_machine/lattice_hash.h>
+#include <thor_scsi/std_machine/result_cache.h>
+#include <thor_scsi/elements/quadrupole.h>
+#include <thor_scsi/core/config.h>
+#include <thor_scsi/core/exceptions.h>
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+
+namespace tse = thor_scsi::elements;
+namespace tsc = thor_scsi::core;
+namespace ts = thor_scsi;
+namespace fs = std::filesystem;
+
+int reg_done = ts::register_elements();
+
+static const std::string lattice_txt(
+	"Nquad = 12;"
+	"d1: Drift, L = 0.25;"
+	"q4m2d1r: Quadrupole, L = 0.5, K = 1.4, N = Nquad, Method = 4;"
+	"mini_cell : LINE = (d1, q4m2d1r, d1);\n"
+	);
+
+static std::string test_cache_directory(const std::string& name)
+{
+	auto dir = fs::temp_directory_path() / ("thor_scsi_test_" + name + "_" + std::to_string(::getpid()));
+	fs::remove_all(dir);
+	return dir.string();
+}
+
+BOOST_AUTO_TEST_CASE(test10_hash_reproducible)
+{
+	GLPSParser parse;
+	Config *C1 = parse.parse_byte(lattice_txt);
+	Config *C2 = parse.parse_byte(lattice_txt);
+	auto acc1 = ts::Accelerator(*C1);
+	auto acc2 = ts::Accelerator(*C2);
+
+	BOOST_CHECK_EQUAL(ts::lattice_hash(acc1), ts::lattice_hash(acc2));
+	BOOST_CHECK_EQUAL(ts::hash_to_string(ts::lattice_hash(acc1)).size(), 16u);
+}
+
+BOOST_AUTO_TEST_CASE(test20_hash_sensitive_to_parameters)
+{
+	GLPSParser parse;
+	Config *C = parse.parse_byte(lattice_txt);
+	auto acc = ts::Accelerator(*C);
+	const auto ref = ts::lattice_hash(acc);
+
+	auto quad = std::dynamic_pointer_cast<tse::QuadrupoleType>(acc.find("q4m2d1r", 0));
+	BOOST_REQUIRE(quad);
+
+	quad->setMainMultipoleStrength(1.4000001);
+	const auto h_K = ts::lattice_hash(acc);
+	BOOST_CHECK(h_K != ref);
+	quad->setMainMultipoleStrength(1.4);
+	BOOST_CHECK_EQUAL(ts::lattice_hash(acc), ref);
+	/* full precision, not the one of the representation */
+	quad->setMainMultipoleStrength(1.4 * (1e0 + 1e-14));
+	BOOST_CHECK(ts::lattice_hash(acc) != ref);
+	quad->setMainMultipoleStrength(1.4);
+
+	quad->setNumberOfIntegrationSteps(13);
+	BOOST_CHECK(ts::lattice_hash(acc) != ref);
+	quad->setNumberOfIntegrationSteps(12);
+
+	quad->transform.setDx(1e-6);
+	BOOST_CHECK(ts::lattice_hash(acc) != ref);
+	quad->transform.setDx(0e0);
+	BOOST_CHECK_EQUAL(ts::lattice_hash(acc), ref);
+
+	quad->transform.setC0(1e-6);
+	BOOST_CHECK(ts::lattice_hash(acc) != ref);
+	quad->transform.setC0(0e0);
+	quad->transform.setS1(1e-6);
+	BOOST_CHECK(ts::lattice_hash(acc) != ref);
+	quad->transform.setS1(0e0);
+	BOOST_CHECK_EQUAL(ts::lattice_hash(acc), ref);
+
+	tsc::ConfigType calc_config;
+	const auto h_conf = ts::lattice_hash(acc, calc_config);
+	calc_config.radiation = true;
+	BOOST_CHECK(ts::lattice_hash(acc, calc_config) != h_conf);
+	/* results of a calculation are not part of the hash */
+	calc_config.radiation = false;
+	calc_config.dE = 42e0;
+	BOOST_CHECK_EQUAL(ts::lattice_hash(acc, calc_config), h_conf);
+}
+
+BOOST_AUTO_TEST_CASE(test30_cache_roundtrip)
+{
+	const auto dir = test_cache_directory("roundtrip");
+	ts::ResultCache cache(dir);
+	const uint64_t key = 0x0123456789abcdefULL;
+
+	BOOST_CHECK(!cache.contains(key, "twiss"));
+	BOOST_CHECK(!cache.load(key, "twiss"));
+
+	arma::mat mat(6, 7);
+	for(arma::uword i=0; i<mat.n_elem; ++i){
+		mat(i) = 1e0 / (i + 1) - 0.25;
+	}
+	cache.store(key, "twiss", mat);
+	BOOST_CHECK(cache.contains(key, "twiss"));
+
+	auto entry = cache.load(key, "twiss");
+	BOOST_REQUIRE(entry);
+	BOOST_CHECK_EQUAL(entry->shape().size(), 2u);
+	BOOST_CHECK_EQUAL(entry->shape()[0], 6u);
+	BOOST_CHECK_EQUAL(entry->shape()[1], 7u);
+	BOOST_CHECK((reinterpret_cast<uintptr_t>(entry->data()) % 64) == 0);
+
+	arma::mat chk = entry->asMatrix();
+	for(arma::uword i=0; i<mat.n_elem; ++i){
+		/* bit identical */
+		BOOST_CHECK_EQUAL(chk(i), mat(i));
+	}
+
+	std::vector<double> vec{1e0, 2e0, 3e0};
+	cache.store(key, "orbit", vec);
+	BOOST_CHECK(cache.load(key, "orbit")->asVector() == vec);
+
+	BOOST_CHECK(cache.erase(key, "twiss"));
+	BOOST_CHECK(!cache.contains(key, "twiss"));
+	BOOST_CHECK_THROW(cache.store(key, "../escape", vec), std::invalid_argument);
+
+	fs::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_CASE(test40_cache_corrupt_entry)
+{
+	const auto dir = test_cache_directory("corrupt");
+	ts::ResultCache cache(dir);
+	const uint64_t key = 42;
+
+	std::vector<double> vec{1e0, 2e0, 3e0};
+	cache.store(key, "orbit", vec);
+	fs::resize_file(cache.filename(key, "orbit"), 64 + 2 * sizeof(double));
+	BOOST_CHECK_THROW(cache.load(key, "orbit"), ts::LoadException);
+
+	fs::remove_all(dir);
+}
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
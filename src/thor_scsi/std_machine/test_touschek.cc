@@ -0,0 +1,92 @@
+#define BOOST_TEST_MODULE touschek
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <thor_scsi/std_machine/touschek.h>
+#include <tps/enums.h>
+#include <cmath>
+#include <stdexcept>
+
+namespace ts = thor_scsi;
+
+/* a ring of n identical positions without dispersion */
+static ts::LatticeFunctions make_lattice_functions(const size_t n)
+{
+	ts::LatticeFunctions lf;
+	lf.length.assign(n, 1e0);
+	for(int k = 0; k < 2; ++k){
+		lf.alpha[k].assign(n, 0e0);
+		lf.eta[k].assign(n, 0e0);
+		lf.etap[k].assign(n, 0e0);
+	}
+	lf.beta[X_].assign(n, 8e0);
+	lf.beta[Y_].assign(n, 12e0);
+	return lf;
+}
+
+static ts::BeamParameters make_beam(void)
+{
+	ts::BeamParameters beam;
+	beam.energy = 3e9;
+	beam.n_particles = 1e10;
+	beam.eps = {1e-10, 1e-11};
+	beam.sigma_delta = 1e-3;
+	beam.sigma_s = 3e-3;
+	return beam;
+}
+
+BOOST_AUTO_TEST_CASE(test10_integral)
+{
+	/* D(u) / sqrt(u) with D in terms of exponential integrals */
+	BOOST_CHECK_CLOSE(ts::touschek_integral(1e-2), 2.6580472111969824, 1e-8);
+	BOOST_CHECK_CLOSE(ts::touschek_integral(1e-1), 0.8497138553147624, 1e-8);
+	BOOST_CHECK_CLOSE(ts::touschek_integral(1e0), 0.0455622728207533, 1e-7);
+	BOOST_CHECK_CLOSE(ts::touschek_integral(1e1), 1.7547454788125498e-07, 1e-4);
+
+	/* diverges logarithmically for u -> 0 */
+	BOOST_CHECK(ts::touschek_integral(1e-8) > ts::touschek_integral(1e-6));
+	BOOST_CHECK_THROW(ts::touschek_integral(0e0), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test20_lifetime)
+{
+	const size_t n = 5;
+	const auto lf = make_lattice_functions(n);
+	auto beam = make_beam();
+	const std::vector<double> delta_plus(n, 0.03), delta_minus(n, -0.03);
+
+	const auto t1 = ts::touschek_lifetime(lf, beam, delta_plus, delta_minus, 2);
+	BOOST_CHECK_EQUAL(t1.rate.size(), n);
+	/* legacy Touschek_loc: N r_e^2 c F(u) / (8 pi gamma^3 sigma_s sigma_x sigma_y sigma_x' delta^2) */
+	BOOST_CHECK_CLOSE(t1.rate[0], 9.352630819536e-06, 1e-6);
+	BOOST_CHECK_CLOSE(t1.lifetime, 1e0 / 9.352630819536e-06, 1e-6);
+	BOOST_CHECK(t1.lifetime > 1e5);
+
+	/* loss rate proportional to the number of particles */
+	beam.n_particles *= 2e0;
+	const auto t2 = ts::touschek_lifetime(lf, beam, delta_plus, delta_minus);
+	BOOST_CHECK_CLOSE(t2.lifetime, t1.lifetime / 2e0, 1e-10);
+
+	/* a larger aperture on one side only: mean of both sides */
+	beam = make_beam();
+	const std::vector<double> delta_large(n, 0.05);
+	const auto t_large = ts::touschek_lifetime(lf, beam, delta_large, delta_large);
+	const auto t_mixed = ts::touschek_lifetime(lf, beam, delta_large, delta_minus);
+	BOOST_CHECK(t_large.lifetime > t1.lifetime);
+	BOOST_CHECK_CLOSE(1e0 / t_mixed.lifetime, (1e0 / t_large.lifetime + 1e0 / t1.lifetime) / 2e0, 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE(test21_lifetime_check_input)
+{
+	const auto lf = make_lattice_functions(3);
+	const auto beam = make_beam();
+	BOOST_CHECK_THROW(ts::touschek_lifetime(lf, beam, {0.03, 0.03}, {-0.03, -0.03, -0.03}),
+			  std::invalid_argument);
+	BOOST_CHECK_THROW(ts::touschek_lifetime(lf, beam, {0.03, 0e0, 0.03}, {-0.03, -0.03, -0.03}),
+			  std::invalid_argument);
+}
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -0,0 +1,108 @@
+#include <thor_scsi/std_machine/touschek.h>
+#include <thor_scsi/elements/constants.h>
+#include <thor_scsi/core/parallel.h>
+#include <tps/enums.h>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace ts = thor_scsi;
+namespace tsc = thor_scsi::core;
+namespace tse = thor_scsi::elements;
+
+/* Gauss-Legendre, 4 nodes on [-1, 1] */
+static const double gl_node[] = {-0.8611363115940526, -0.3399810435848563, 0.3399810435848563, 0.8611363115940526};
+static const double gl_weight[] = {0.3478548451374538, 0.6521451548625461, 0.6521451548625461, 0.3478548451374538};
+
+double ts::touschek_integral(const double u)
+{
+	if(!(u > 0e0)){
+		std::stringstream strm;
+		strm << "Touschek integral: argument has to be positive but is " << u;
+		throw std::invalid_argument(strm.str());
+	}
+	/*
+	 * with v = exp(-t) the integrand reads (1 - (1 + t/2) exp(-t)) exp(-u exp(t)):
+	 * it vanishes for exp(t) >> 1/u and is confined to t < 1/u for u >> 1
+	 */
+	const double t_max = std::max(std::log(1e0 / u), 0e0) + 40e0 / std::max(u, 8e0);
+	const int n_intervals = static_cast<int>(std::ceil(4e0 * t_max * std::max(u, 1e0)));
+	const double h = t_max / n_intervals;
+	double sum = 0e0;
+	for(int j = 0; j < n_intervals; ++j){
+		for(int q = 0; q < 4; ++q){
+			const double t = (j + 0.5 + 0.5 * gl_node[q]) * h;
+			sum += gl_weight[q] * (1e0 - (1e0 + t / 2e0) * std::exp(-t)) * std::exp(-u * std::exp(t));
+		}
+	}
+	return sum * h / 2e0;
+}
+
+ts::TouschekLifetime ts::touschek_lifetime(const ts::LatticeFunctions& lf, const ts::BeamParameters& beam,
+					   const std::vector<double>& delta_plus,
+					   const std::vector<double>& delta_minus,
+					   const size_t n_threads)
+{
+	lf.check();
+	beam.check();
+	const size_t n = lf.size();
+	if(delta_plus.size() != n || delta_minus.size() != n){
+		std::stringstream strm;
+		strm << "Touschek lifetime: momentum aperture given at " << delta_plus.size()
+		     << " (positive) and " << delta_minus.size() << " (negative) positions, but lattice functions at "
+		     << n;
+		throw std::invalid_argument(strm.str());
+	}
+	for(size_t i = 0; i < n; ++i){
+		if(!(delta_plus[i] != 0e0) || !(delta_minus[i] != 0e0)){
+			std::stringstream strm;
+			strm << "Touschek lifetime: momentum aperture at position " << i << " is zero";
+			throw std::invalid_argument(strm.str());
+		}
+	}
+
+	const double gamma = beam.energy / tse::m_e, sigma_delta2 = beam.sigma_delta * beam.sigma_delta;
+	const double scale =
+		tse::r_e * tse::r_e * tse::speed_of_light * beam.n_particles
+		/ (8e0 * M_PI * gamma * gamma * beam.sigma_s);
+
+	TouschekLifetime result;
+	result.rate.assign(n, 0e0);
+	tsc::parallel_for(n, n_threads, [&](const size_t i){
+		double sigma[2];
+		for(int k = 0; k < 2; ++k){
+			const double eta = lf.eta[k][i];
+			sigma[k] = std::sqrt(lf.beta[k][i] * beam.eps[k] + eta * eta * sigma_delta2);
+		}
+		const double sigma_xp =
+			beam.eps[X_] / sigma[X_] * std::sqrt(1e0 + lf.curlyH(X_, i) * sigma_delta2 / beam.eps[X_]);
+
+		double rate = 0e0;
+		for(const double delta : {std::abs(delta_plus[i]), std::abs(delta_minus[i])}){
+			const double u = std::pow(delta / (gamma * sigma_xp), 2);
+			/* D(u) = sqrt(u) F(u) */
+			rate += scale * std::sqrt(u) * ts::touschek_integral(u)
+				/ (sigma[X_] * sigma[Y_] * std::pow(delta, 3));
+		}
+		result.rate[i] = rate / 2e0;
+	});
+
+	double length = 0e0, rate = 0e0;
+	for(size_t i = 0; i < n; ++i){
+		length += lf.length[i];
+		rate += lf.length[i] * result.rate[i];
+	}
+	if(!(length > 0e0)){
+		throw std::invalid_argument("Touschek lifetime: total length not positive");
+	}
+	rate /= length;
+	result.lifetime = (rate > 0e0) ? 1e0 / rate : INFINITY;
+	return result;
+}
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -0,0 +1,85 @@
+#ifndef _THOR_SCSI_STD_MACHINE_TOUSCHEK_H_
+#define _THOR_SCSI_STD_MACHINE_TOUSCHEK_H_
+
+#include <thor_scsi/std_machine/beam_parameters.h>
+#include <vector>
+
+namespace thor_scsi {
+
+	/**
+	 * @brief Touschek lifetime and the loss rate along the ring
+	 */
+	struct TouschekLifetime {
+		/// [s]
+		double lifetime = 0e0;
+		/// loss rate [1/s] at each position, mean of the positive and negative side
+		std::vector<double> rate;
+	};
+
+	/**
+	 * @brief Touschek lifetime for a local momentum aperture
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * Flat, ultra relativistic beam (A. Piwinski, H. Wiedemann):
+	 *
+	 * .. math::
+	 *
+	 *     \frac{1}{T} = \frac{r_e^2 c N}{8 \pi \sigma_x \sigma_y \sigma_s
+	 *                   \gamma^2 \delta_{acc}^3} D(u)
+	 *                = \frac{r_e^2 c N}{8 \pi \sigma_x \sigma_y \sigma_s
+	 *                   \sigma_{x'} \gamma^3 \delta_{acc}^2} F(u),
+	 *     \qquad
+	 *     u = \left(\frac{\delta_{acc}}{\gamma \sigma_{x'}}\right)^2
+	 *
+	 * with the beam sizes including the dispersive contributions and
+	 * :math:`\sigma_{x'} = \epsilon_x / \sigma_x \sqrt{1 + \mathcal{H}_x
+	 * \sigma_\delta^2 / \epsilon_x}`. The rates for delta_plus and
+	 * delta_minus are averaged at each position, the lifetime is the
+	 * inverse of the length weighted ring average.
+	 *
+	 * The momentum aperture is given at the positions of the lattice
+	 * functions, e.g. by :func:`momentum_aperture` at the exit of
+	 * each element. It is taken as is: limit it to the RF acceptance
+	 * if required. Positions are independent and distributed over
+	 * n_threads threads (0: hardware concurrency).
+	 *
+	 * \endverbatim
+	 *
+	 * @param delta_minus negative side; the sign is ignored
+	 *
+	 * @throws std::invalid_argument for inconsistent input or a
+	 *         momentum aperture of zero
+	 */
+	TouschekLifetime touschek_lifetime(const LatticeFunctions& lf, const BeamParameters& beam,
+					   const std::vector<double>& delta_plus,
+					   const std::vector<double>& delta_minus,
+					   const size_t n_threads = 0);
+
+	/**
+	 * @brief Touschek loss function D(u) / sqrt(u)
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * .. math::
+	 *
+	 *     F(u) = \int_0^1 \left(\frac{1}{v} - \frac{1}{2} \ln\frac{1}{v} - 1\right)
+	 *            e^{-u / v} \, dv
+	 *
+	 * evaluated by Gauss-Legendre quadrature in t = -ln(v). Replaces
+	 * the series of f_int_Touschek.
+	 *
+	 * \endverbatim
+	 *
+	 * @throws std::invalid_argument if u is not positive
+	 */
+	double touschek_integral(const double u);
+
+} // namespace thor_scsi
+#endif /* _THOR_SCSI_STD_MACHINE_TOUSCHEK_H_ */
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -0,0 +1,435 @@
+#include <thor_scsi/std_machine/tune_shift.h>
+#include <thor_scsi/std_machine/lie_poly.h>
+#include <tps/enums.h>
+#include <armadillo>
+#include <algorithm>
+#include <complex>
+#include <cstdint>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace ts = thor_scsi;
+namespace tsc = thor_scsi::core;
+namespace lp = thor_scsi::lie_poly;
+
+using lp::cplx;
+using lp::Poly;
+using lp::exponent;
+using lp::unit;
+using lp::transverse_degree;
+using lp::degree;
+using lp::add_to;
+
+static const int n_transverse = 4, min_order = 2, max_order = 10;
+static const cplx I(0e0, 1e0);
+
+/* phase factor exp(i theta) a monomial gets by the rotation: h_k+- -> exp(+- i mu_k) h_k+- */
+static inline double rotation_phase(const uint32_t key, const double mu[2])
+{
+	return (int(exponent(key, 0)) - int(exponent(key, 1))) * mu[X_]
+		+ (int(exponent(key, 2)) - int(exponent(key, 3))) * mu[Y_];
+}
+
+/* a function of the actions and delta only */
+static inline bool resonant(const uint32_t key)
+{
+	return exponent(key, 0) == exponent(key, 1) && exponent(key, 2) == exponent(key, 3);
+}
+
+static Poly multiply(const Poly& p, const Poly& q, const unsigned max_degree)
+{
+	return lp::multiply(p, q, lp::MaxDegree{max_degree});
+}
+
+static Poly homogeneous_part(const Poly& p, const unsigned d)
+{
+	Poly r;
+	for(const auto& t : p){
+		if(degree(t.first) == d){
+			r.insert(t);
+		}
+	}
+	return r;
+}
+
+/* exp(scale :g:) p, truncated at max_degree */
+static Poly lie_exp(const Poly& g, const Poly& p, const unsigned max_degree, const double scale = 1e0)
+{
+	Poly result = p, term = p;
+	for(int l = 1; !term.empty(); ++l){
+		Poly next;
+		lp::add_bracket(next, g, term, lp::MaxDegree{max_degree}, scale / l);
+		term.swap(next);
+		add_to(result, term);
+	}
+	return result;
+}
+
+/*
+ * Dragt-Finn factorisation: components[j] = exp(:g_3:) ... exp(:g_n+1:) h_j,
+ * h_j = h_x+, h_x-, h_y+, h_y-. Returns g indexed by degree. The terms
+ * of delta only commute with all and are dropped.
+ */
+static std::vector<Poly> factorise(std::vector<Poly> components, const int order)
+{
+	std::vector<Poly> g(order + 2);
+	for(int d = 2; d <= order; ++d){
+		/*
+		 * the terms of degree d are [g_d+1, h_j]: -2 i dg/dh- for h+,
+		 * 2 i dg/dh+ for h-. Euler's theorem on the transverse variables
+		 * gives g back
+		 */
+		Poly euler;
+		for(int plane = 0; plane < 2; ++plane){
+			const int vp = 2 * plane, vm = 2 * plane + 1;
+			for(const auto& t : homogeneous_part(components[vm], d)){
+				euler[t.first + unit(vp)] += t.second / (2e0 * I);
+			}
+			for(const auto& t : homogeneous_part(components[vp], d)){
+				euler[t.first + unit(vm)] += t.second * I / 2e0;
+			}
+		}
+		auto& gd = g[d + 1];
+		for(const auto& t : euler){
+			const unsigned td = transverse_degree(t.first);
+			if(td && t.second != 0e0){
+				gd[t.first] = t.second / double(td);
+			}
+		}
+		if(d < order){
+			for(auto& c : components){
+				c = lie_exp(gd, c, order, -1e0);
+			}
+		}
+	}
+	return g;
+}
+
+/* components of exp(:f_0:) exp(:f_1:) ... h_j */
+static std::vector<Poly> components(const std::vector<Poly>& factors, const int order)
+{
+	std::vector<Poly> result(n_transverse);
+	for(int j = 0; j < n_transverse; ++j){
+		Poly c = {{unit(j), 1e0}};
+		for(auto f = factors.rbegin(); f != factors.rend(); ++f){
+			c = lie_exp(*f, c, order);
+		}
+		result[j].swap(c);
+	}
+	return result;
+}
+
+/*
+ * the normalising matrix of the transverse block from its eigenvectors:
+ * A^-1 M A = rotation by mu_k, symplectic, A(2k, 2k + 1) = 0
+ */
+static arma::mat normalise_linear(const arma::mat& M, double mu[2])
+{
+	arma::cx_vec lambda;
+	arma::cx_mat V;
+	if(!arma::eig_gen(lambda, V, M)){
+		throw std::runtime_error("tune shift: eigen decomposition of the linear map failed");
+	}
+	arma::mat S(n_transverse, n_transverse, arma::fill::zeros);
+	S(x_, px_) = S(y_, py_) = 1e0;
+	S(px_, x_) = S(py_, y_) = -1e0;
+	const arma::cx_mat S_c = arma::conv_to<arma::cx_mat>::from(S);
+
+	arma::mat A(n_transverse, n_transverse, arma::fill::zeros);
+	bool found[2] = {false, false};
+	for(arma::uword c = 0; c < n_transverse; ++c){
+		const cplx l = lambda(c);
+		if(std::abs(std::abs(l) - 1e0) > 1e-6 || std::abs(l.imag()) < 1e-12){
+			std::stringstream strm;
+			strm << "tune shift: linear motion unstable, eigen value " << l;
+			throw std::runtime_error(strm.str());
+		}
+		/* v = a_1 - i a_2 with a_1^T S a_2 = 1, thus v^H S v = -2 i */
+		arma::cx_vec v = V.col(c);
+		const double s = arma::cdot(v, S_c * v).imag();
+		if(s >= 0e0){
+			continue;
+		}
+		const int plane = (std::norm(v(x_)) + std::norm(v(px_)) >= std::norm(v(y_)) + std::norm(v(py_))) ? X_ : Y_;
+		if(found[plane]){
+			throw std::runtime_error("tune shift: eigen modes can not be assigned to the planes");
+		}
+		found[plane] = true;
+		v *= std::sqrt(2e0 / -s) * std::polar(1e0, -std::arg(v(2 * plane)));
+		A.col(2 * plane) = arma::real(v);
+		A.col(2 * plane + 1) = -arma::imag(v);
+		mu[plane] = -std::arg(l);
+		if(mu[plane] < 0e0){
+			mu[plane] += 2e0 * M_PI;
+		}
+	}
+	if(!found[X_] || !found[Y_]){
+		throw std::runtime_error("tune shift: eigen modes can not be assigned to the planes");
+	}
+	return A;
+}
+
+/*
+ * normal form of the transverse one turn map, given by the coefficients
+ * of the monomials (degree 1 first) for x, px, y, py
+ */
+static ts::TuneShift normal_form(const int order, const std::vector<std::vector<ord_t>>& monomials,
+				 const std::vector<double>& coefficients)
+{
+	const size_t n_mono = monomials.size();
+	auto coefficient = [&](const int i, const size_t m){ return coefficients[i * n_mono + m]; };
+
+	/* linear part: the first monomials are x, px, y, py, delta */
+	arma::mat M(n_transverse, n_transverse);
+	arma::vec D(n_transverse);
+	for(int i = 0; i < n_transverse; ++i){
+		for(int v = 0; v < n_transverse; ++v){
+			M(i, v) = coefficient(i, v);
+		}
+		D(i) = coefficient(i, delta_);
+	}
+	/* dispersion: fix point of the linear map for delta = 1 */
+	arma::vec eta;
+	if(!arma::solve(eta, arma::eye(n_transverse, n_transverse) - M, D)){
+		throw std::runtime_error("tune shift: dispersion: linear map on an integer resonance");
+	}
+	double mu[2] = {0e0, 0e0};
+	const arma::mat A = normalise_linear(M, mu), A_inv = arma::inv(A);
+	const arma::vec A_inv_eta = A_inv * eta;
+
+	/* z = A w + eta delta, w_2k = (h_k+ + h_k-) / 2, w_2k+1 = i (h_k+ - h_k-) / 2 */
+	std::vector<std::vector<Poly>> powers(n_transverse + 1);
+	for(int v = 0; v <= n_transverse; ++v){
+		Poly linear;
+		if(v == delta_){
+			linear[unit(4)] = 1e0;
+		} else {
+			for(int plane = 0; plane < 2; ++plane){
+				const double a = A(v, 2 * plane), b = A(v, 2 * plane + 1);
+				linear[unit(2 * plane)] += (a + I * b) / 2e0;
+				linear[unit(2 * plane + 1)] += (a - I * b) / 2e0;
+			}
+			linear[unit(4)] += eta(v);
+		}
+		powers[v].push_back(Poly{{0, 1e0}});
+		for(int e = 1; e <= order; ++e){
+			powers[v].push_back(multiply(powers[v].back(), linear, order));
+		}
+	}
+	std::vector<Poly> z(n_transverse);
+	for(size_t m = 0; m < n_mono; ++m){
+		Poly term = {{0, 1e0}};
+		for(int v = 0; v <= n_transverse; ++v){
+			if(monomials[m][v]){
+				term = multiply(term, powers[v][monomials[m][v]], order);
+			}
+		}
+		for(int i = 0; i < n_transverse; ++i){
+			if(coefficient(i, m) != 0e0){
+				add_to(z[i], term, coefficient(i, m));
+			}
+		}
+	}
+
+	/* w = A^-1 (z - eta delta), in the resonance basis with the rotation removed */
+	std::vector<Poly> h(n_transverse);
+	for(int plane = 0; plane < 2; ++plane){
+		Poly w[2];
+		for(int r = 0; r < 2; ++r){
+			const int u = 2 * plane + r;
+			for(int i = 0; i < n_transverse; ++i){
+				add_to(w[r], z[i], A_inv(u, i));
+			}
+			w[r][unit(4)] -= A_inv_eta(u);
+		}
+		const cplx rot = std::polar(1e0, -mu[plane]);
+		add_to(h[2 * plane], w[0], rot);
+		add_to(h[2 * plane], w[1], -I * rot);
+		add_to(h[2 * plane + 1], w[0], std::conj(rot));
+		add_to(h[2 * plane + 1], w[1], I * std::conj(rot));
+	}
+
+	/*
+	 * exp(:F:) N exp(-:F:) = exp(:F:) exp(:g_3:) ... exp(-:R F:) R changes
+	 * g_k by F - R F: removes the non resonant terms of degree k. For
+	 * the highest degree this changes nothing else
+	 */
+	auto g = factorise(std::move(h), order);
+	for(int k = 3; k <= order; ++k){
+		Poly F, RF;
+		for(const auto& t : g[k]){
+			if(resonant(t.first)){
+				continue;
+			}
+			const cplx rot = std::polar(1e0, rotation_phase(t.first, mu));
+			if(std::abs(1e0 - rot) < 1e-8){
+				std::stringstream strm;
+				strm << "tune shift: tunes " << mu[X_] / (2e0 * M_PI) << ", " << mu[Y_] / (2e0 * M_PI)
+				     << " on a resonance of order " << transverse_degree(t.first);
+				throw std::runtime_error(strm.str());
+			}
+			F[t.first] = -t.second / (1e0 - rot);
+			RF[t.first] = F[t.first] * rot;
+		}
+		if(F.empty()){
+			continue;
+		}
+		std::vector<Poly> factors;
+		factors.push_back(F);
+		factors.insert(factors.end(), g.begin() + 3, g.end());
+		Poly minus_RF;
+		add_to(minus_RF, RF, -1e0);
+		factors.push_back(minus_RF);
+		g = factorise(components(factors, order), order);
+	}
+
+	/* K = sum c (2 J_x)^a (2 J_y)^b delta^m: nu_k = (mu_k - dK/dJ_k) / (2 pi) */
+	std::map<std::array<unsigned, 3>, std::array<double, 2>> nu;
+	for(int k = 3; k <= order + 1; ++k){
+		for(const auto& t : g[k]){
+			/* the non resonant terms left are round off */
+			if(!resonant(t.first)){
+				continue;
+			}
+			const unsigned a = exponent(t.first, 0), b = exponent(t.first, 2), m = exponent(t.first, 4);
+			const double c = -t.second.real() * std::ldexp(1e0, a + b) / (2e0 * M_PI);
+			if(a){
+				nu[{a - 1, b, m}][X_] += c * a;
+			}
+			if(b){
+				nu[{a, b - 1, m}][Y_] += c * b;
+			}
+		}
+	}
+
+	ts::TuneShift result;
+	result.order = order;
+	result.nu = {mu[X_] / (2e0 * M_PI), mu[Y_] / (2e0 * M_PI)};
+	for(const auto& t : nu){
+		result.terms.push_back({t.first, t.second});
+	}
+	std::stable_sort(result.terms.begin(), result.terms.end(), [](const auto& p, const auto& q){
+		const auto& e = p.exponents, &f = q.exponents;
+		return e[0] + e[1] + e[2] < f[0] + f[1] + f[2];
+	});
+	return result;
+}
+
+double ts::TuneShift::coefficient(const int k, const unsigned i, const unsigned j, const unsigned m) const
+{
+	const double nu0 = this->nu.at(k);
+	if(!i && !j && !m){
+		return nu0;
+	}
+	for(const auto& t : this->terms){
+		if(t.exponents[0] == i && t.exponents[1] == j && t.exponents[2] == m){
+			return t.nu[k];
+		}
+	}
+	return 0e0;
+}
+
+double ts::TuneShift::tune(const int k, const double J_x, const double J_y, const double delta) const
+{
+	double nu = this->nu.at(k);
+	for(const auto& t : this->terms){
+		const auto& e = t.exponents;
+		nu += t.nu[k] * std::pow(J_x, e[0]) * std::pow(J_y, e[1]) * std::pow(delta, e[2]);
+	}
+	return nu;
+}
+
+static int check_order(const int order)
+{
+	if(order < min_order || order > max_order){
+		std::stringstream strm;
+		strm << "tune shift: order " << order << " not in [" << min_order << ", " << max_order << "]";
+		throw std::invalid_argument(strm.str());
+	}
+	return order;
+}
+
+ts::TuneShiftAnalysis::TuneShiftAnalysis(const int order)
+	: m_order(check_order(order))
+	, m_desc(std::make_shared<gtpsa::desc>(ps_dim, order))
+	, m_map(m_desc, order)
+{
+	/* transverse variables and delta, ordered by degree */
+	for(int d = 1; d <= order; ++d){
+		for(int ex = d; ex >= 0; --ex){
+			for(int epx = d - ex; epx >= 0; --epx){
+				for(int ey = d - ex - epx; ey >= 0; --ey){
+					for(int epy = d - ex - epx - ey; epy >= 0; --epy){
+						const int edelta = d - ex - epx - ey - epy;
+						std::vector<ord_t> m(ps_dim, 0);
+						m[x_] = ex;
+						m[px_] = epx;
+						m[y_] = ey;
+						m[py_] = epy;
+						m[delta_] = edelta;
+						this->m_monomials.push_back(m);
+					}
+				}
+			}
+		}
+	}
+	this->m_coefficients.resize(n_transverse * this->m_monomials.size());
+}
+
+template<class C>
+ts::TuneShift ts::TuneShiftAnalysis::compute(ts::AcceleratorKnobbable<C>& acc, tsc::ConfigType& conf,
+					     const gtpsa::ss_vect<double>& x0)
+{
+	if(conf.Cavity_on || conf.radiation){
+		throw std::invalid_argument("tune shift: requires a symplectic map conserving delta:"
+					    " cavity and radiation off");
+	}
+
+	this->m_map.set_identity();
+	for(int k = 0; k < ps_dim; ++k){
+		this->m_map[k] += x0[k];
+	}
+	const int n_elements = static_cast<int>(acc.size());
+	const int last = acc.propagate(conf, this->m_map, 0, n_elements);
+	if(last != n_elements){
+		std::stringstream strm;
+		strm << "tune shift: orbit lost at element " << last;
+		throw std::runtime_error(strm.str());
+	}
+
+	const size_t n_mono = this->m_monomials.size();
+	for(int i = 0; i < n_transverse; ++i){
+		for(size_t m = 0; m < n_mono; ++m){
+			const double c = this->m_map[i].get(this->m_monomials[m]);
+			if(!std::isfinite(c)){
+				throw std::runtime_error("tune shift: one turn map not finite");
+			}
+			this->m_coefficients[i * n_mono + m] = c;
+		}
+	}
+	return normal_form(this->m_order, this->m_monomials, this->m_coefficients);
+}
+
+template<class C>
+ts::TuneShift ts::tune_shift(ts::AcceleratorKnobbable<C>& acc, tsc::ConfigType& conf,
+			     const gtpsa::ss_vect<double>& x0, const int order)
+{
+	TuneShiftAnalysis analysis(order);
+	return analysis.compute(acc, conf, x0);
+}
+
+template ts::TuneShift ts::TuneShiftAnalysis::compute(ts::AcceleratorKnobbable<tsc::StandardDoubleType>& acc,
+						      tsc::ConfigType& conf, const gtpsa::ss_vect<double>& x0);
+template ts::TuneShift ts::TuneShiftAnalysis::compute(ts::AcceleratorKnobbable<tsc::TpsaVariantType>& acc,
+						      tsc::ConfigType& conf, const gtpsa::ss_vect<double>& x0);
+template ts::TuneShift ts::tune_shift(ts::AcceleratorKnobbable<tsc::StandardDoubleType>& acc,
+				      tsc::ConfigType& conf, const gtpsa::ss_vect<double>& x0, const int order);
+template ts::TuneShift ts::tune_shift(ts::AcceleratorKnobbable<tsc::TpsaVariantType>& acc,
+				      tsc::ConfigType& conf, const gtpsa::ss_vect<double>& x0, const int order);
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -0,0 +1,127 @@
+#ifndef _THOR_SCSI_STD_MACHINE_TUNE_SHIFT_H_
+#define _THOR_SCSI_STD_MACHINE_TUNE_SHIFT_H_
+
+#include <thor_scsi/std_machine/accelerator.h>
+#include <thor_scsi/core/config.h>
+#include <gtpsa/ss_vect.h>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace thor_scsi {
+
+	/**
+	 * @brief coefficient of J_x^i J_y^j delta^m in the tunes
+	 */
+	struct TuneShiftTerm {
+		/// i, j, m
+		std::array<unsigned, 3> exponents = {0, 0, 0};
+		/// of nu_x and nu_y
+		std::array<double, 2> nu = {0e0, 0e0};
+	};
+
+	/**
+	 * @brief tunes as polynomial of the actions and the momentum offset
+	 */
+	struct TuneShift {
+		/// order of the one turn map
+		int order = 0;
+		/// fractional tunes on the orbit
+		std::array<double, 2> nu = {NAN, NAN};
+		/// all other terms of nu_k(J_x, J_y, delta), ordered by degree
+		std::vector<TuneShiftTerm> terms;
+
+		/// coefficient of J_x^i J_y^j delta^m in nu_k (zero if absent)
+		double coefficient(const int k, const unsigned i, const unsigned j, const unsigned m) const;
+		/// d nu_k / d J_l
+		inline double detuning(const int k, const int l) const {
+			return this->coefficient(k, l == 0, l == 1, 0);
+		}
+		/// coefficient of delta^m in nu_k: m = 1 linear, m = 2 second order chromaticity
+		inline double chromaticity(const int k, const unsigned m = 1) const {
+			return this->coefficient(k, 0, 0, m);
+		}
+		/// nu_k evaluated
+		double tune(const int k, const double J_x, const double J_y, const double delta = 0e0) const;
+	};
+
+	/**
+	 * @brief amplitude and momentum dependent tunes from the normal form of the one turn map
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * The one turn map around the orbit x0 is propagated as TPSA of the
+	 * given order. The map is normalised linearly (eigenvectors of
+	 * the transverse block, dispersion as fix point) and factorised
+	 * (Dragt-Finn) into Lie generators in the resonance basis
+	 * :math:`h_k^\pm = \sqrt{2 J_k} e^{\pm i \phi_k}`, with delta a
+	 * parameter. The normal form then removes the non resonant
+	 * generators order by order, each by a similarity transform
+	 * :math:`e^{:F:}`; what remains is the generator
+	 * :math:`K(J_x, J_y, \delta)` and
+	 *
+	 * .. math::
+	 *
+	 *     \nu_k = \frac{1}{2 \pi}
+	 *            \left(\mu_k - \frac{\partial K}{\partial J_k}\right).
+	 *
+	 * A map of order n gives K up to degree n + 1: chromaticities need
+	 * n >= 2, the detuning with amplitude n >= 3.
+	 *
+	 * The descriptor, the TPSA map and the list of monomials read are
+	 * kept between the calls, so that optimisation loops can call
+	 * :meth:`compute` at high rate.
+	 *
+	 * \endverbatim
+	 */
+	class TuneShiftAnalysis {
+	public:
+		/**
+		 * @throws std::invalid_argument for an order outside [2, 10]
+		 */
+		explicit TuneShiftAnalysis(const int order = 3);
+
+		inline int getOrder(void) const { return this->m_order; }
+
+		/**
+		 * @brief normal form of the one turn map around x0
+		 *
+		 * x0 is expected to be the closed orbit, e.g. of
+		 * :func:`find_closed_orbit`. The map has to be symplectic
+		 * with delta conserved: conf.Cavity_on and conf.radiation off.
+		 *
+		 * @throws std::invalid_argument for the cavity or radiation on
+		 * @throws std::runtime_error if the orbit is lost, the linear
+		 *         motion unstable or a tune on a resonance of the
+		 *         order of the map
+		 */
+		template<class C>
+		TuneShift compute(AcceleratorKnobbable<C>& acc, thor_scsi::core::ConfigType& conf,
+				  const gtpsa::ss_vect<double>& x0);
+
+	private:
+		int m_order;
+		std::shared_ptr<gtpsa::desc> m_desc;
+		gtpsa::ss_vect<gtpsa::tpsa> m_map;
+		/// exponents (x, px, y, py, delta, ct) of the transverse monomials read from the map
+		std::vector<std::vector<ord_t>> m_monomials;
+		/// their coefficients: component major
+		std::vector<double> m_coefficients;
+	};
+
+	/**
+	 * @brief tune shift with a fresh analysis, see :class:`TuneShiftAnalysis`
+	 */
+	template<class C>
+	TuneShift tune_shift(AcceleratorKnobbable<C>& acc, thor_scsi::core::ConfigType& conf,
+			     const gtpsa::ss_vect<double>& x0, const int order = 3);
+
+} // namespace thor_scsi
+#endif /* _THOR_SCSI_STD_MACHINE_TUNE_SHIFT_H_ */
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
@@ -0,0 +1,123 @@
+#include <thor_scsi/std_machine/twiss.h>
+#include <tps/enums.h>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace ts = thor_scsi;
+namespace tsc = thor_scsi::core;
+
+ts::LatticeFunctions ts::Twiss::latticeFunctions(void) const
+{
+	const size_t n = this->size();
+	LatticeFunctions lf;
+	lf.length = this->length;
+	for(int k = 0; k < 2; ++k){
+		lf.alpha[k].resize(n);
+		lf.beta[k].resize(n);
+		lf.eta[k].resize(n);
+		lf.etap[k].resize(n);
+		for(size_t i = 0; i < n; ++i){
+			lf.alpha[k][i] = this->alpha[index(i, k)];
+			lf.beta[k][i] = this->beta[index(i, k)];
+			lf.eta[k][i] = this->eta[index(i, k)];
+			lf.etap[k][i] = this->etap[index(i, k)];
+		}
+	}
+	return lf;
+}
+
+/* phase of plane k of the (not rotated) normalising map, in units of 2 pi */
+static inline double phase(const arma::mat& A, const int k)
+{
+	return std::atan2(A(2 * k, 2 * k + 1), A(2 * k, 2 * k)) / (2e0 * M_PI);
+}
+
+template<class C>
+ts::Twiss ts::twiss_along_lattice(ts::AcceleratorKnobbable<C>& acc, tsc::ConfigType& conf,
+				  const arma::mat& A, const gtpsa::ss_vect<double>& x0)
+{
+	if(A.n_rows != ps_dim || A.n_cols != ps_dim){
+		std::stringstream strm;
+		strm << "twiss: expected a " << ps_dim << "x" << ps_dim << " matrix A, got "
+		     << A.n_rows << "x" << A.n_cols;
+		throw std::invalid_argument(strm.str());
+	}
+	if(!A.is_finite()){
+		throw std::invalid_argument("twiss: matrix A not finite");
+	}
+
+	const size_t n = acc.size();
+	Twiss twiss;
+	twiss.length.resize(n);
+	twiss.s.resize(n);
+	for(auto *v : {&twiss.alpha, &twiss.beta, &twiss.nu, &twiss.eta, &twiss.etap}){
+		v->resize(2 * n);
+	}
+
+	/* A and the orbit as order 1 TPSA */
+	auto desc = std::make_shared<gtpsa::desc>(ps_dim, 1);
+	gtpsa::ss_vect<gtpsa::tpsa> I(desc, 1), ps(desc, 1);
+	I.set_identity();
+	ps.set_zero();
+	for(int i = 0; i < ps_dim; ++i){
+		for(int j = 0; j < ps_dim; ++j){
+			if(A(i, j) != 0e0){
+				ps[i] += I[j] * A(i, j);
+			}
+		}
+		ps[i] += x0[i];
+	}
+
+	double mu[2] = {phase(A, X_), phase(A, Y_)}, nu[2] = {0e0, 0e0}, s = 0e0;
+	arma::mat jac;
+	for(size_t i = 0; i < n; ++i){
+		const int last = acc.propagate(conf, ps, i, 1);
+		if(last != static_cast<int>(i + 1)){
+			std::stringstream strm;
+			strm << "twiss: orbit lost at element " << i << " " << acc.at(i)->name;
+			throw std::runtime_error(strm.str());
+		}
+
+		auto elem = std::dynamic_pointer_cast<tsc::ElemTypeKnobbed>(acc.at(i));
+		twiss.length[i] = elem ? elem->getLength() : 0e0;
+		s += twiss.length[i];
+		twiss.s[i] = s;
+
+		jac = ps.jacobian();
+		for(int k = 0; k < 2; ++k){
+			const double a11 = jac(2 * k, 2 * k), a12 = jac(2 * k, 2 * k + 1);
+			const double a21 = jac(2 * k + 1, 2 * k), a22 = jac(2 * k + 1, 2 * k + 1);
+			const size_t ik = Twiss::index(i, k);
+			twiss.alpha[ik] = -(a11 * a21 + a12 * a22);
+			twiss.beta[ik] = a11 * a11 + a12 * a12;
+			twiss.eta[ik] = jac(2 * k, delta_);
+			twiss.etap[ik] = jac(2 * k + 1, delta_);
+
+			/* phase advance of the element: what the Courant-Snyder rotation would remove */
+			const double mu_k = phase(jac, k);
+			double dnu = mu_k - mu[k];
+			dnu -= std::floor(dnu);
+			if(dnu > 1e0 - 1e-15){
+				dnu = 0e0;
+			}
+			mu[k] = mu_k;
+			nu[k] += dnu;
+			twiss.nu[ik] = nu[k];
+		}
+	}
+	return twiss;
+}
+
+template ts::Twiss ts::twiss_along_lattice(ts::AcceleratorKnobbable<tsc::StandardDoubleType>& acc,
+					   tsc::ConfigType& conf, const arma::mat& A,
+					   const gtpsa::ss_vect<double>& x0);
+template ts::Twiss ts::twiss_along_lattice(ts::AcceleratorKnobbable<tsc::TpsaVariantType>& acc,
+					   tsc::ConfigType& conf, const arma::mat& A,
+					   const gtpsa::ss_vect<double>& x0);
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */
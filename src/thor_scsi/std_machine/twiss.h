@@ -0,0 +1,73 @@
+#ifndef _THOR_SCSI_STD_MACHINE_TWISS_H_
+#define _THOR_SCSI_STD_MACHINE_TWISS_H_
+
+#include <thor_scsi/std_machine/accelerator.h>
+#include <thor_scsi/std_machine/beam_parameters.h>
+#include <thor_scsi/core/config.h>
+#include <gtpsa/ss_vect.h>
+#include <armadillo>
+#include <vector>
+
+namespace thor_scsi {
+
+	/**
+	 * @brief Twiss parameters at the exit of each element
+	 *
+	 * Each quantity is stored contiguously as n_elements x 2 values,
+	 * the plane (X_, Y_) running fastest; use index(i, k). The phase
+	 * advance nu is counted from the start of the lattice in units
+	 * of 2 pi.
+	 */
+	struct Twiss {
+		/// element lengths and position s at the exit of each element
+		std::vector<double> length, s;
+		std::vector<double> alpha, beta, nu, eta, etap;
+
+		inline size_t size(void) const { return this->length.size(); }
+		static inline size_t index(const size_t i, const int k) { return 2 * i + k; }
+
+		/// as input for the intrabeam scattering and Touschek calculations
+		LatticeFunctions latticeFunctions(void) const;
+	};
+
+	/**
+	 * @brief propagates the normalising map A through the lattice
+	 *
+	 * \verbatim embed:rst:leading-asterisk
+	 *
+	 * Native counterpart of
+	 * :func:`thor_scsi.utils.linear_optics.compute_Twiss_along_lattice`:
+	 * A (6x6, e.g. of :func:`compute_map_and_diag`) is propagated as
+	 * an order 1 TPSA around the orbit starting at x0, one element
+	 * at a time. It does not install observers; the ones installed
+	 * on the elements are still called. At each exit the transverse
+	 * blocks give
+	 *
+	 * .. math::
+	 *
+	 *     \beta = a_{11}^2 + a_{12}^2, \quad
+	 *     \alpha = -(a_{11} a_{21} + a_{12} a_{22}), \quad
+	 *     \mu = \operatorname{atan2}(a_{12}, a_{11})
+	 *
+	 * and the delta column the dispersion. The Courant-Snyder
+	 * rotation is not applied to the map itself: the phase advance
+	 * of each element is taken as the increase of :math:`\mu`,
+	 * folded into [0, 1) turn.
+	 *
+	 * \endverbatim
+	 *
+	 * @throws std::invalid_argument if A is not 6x6 or not finite
+	 * @throws std::runtime_error if the orbit is lost
+	 */
+	template<class C>
+	Twiss twiss_along_lattice(AcceleratorKnobbable<C>& acc, thor_scsi::core::ConfigType& conf,
+				  const arma::mat& A, const gtpsa::ss_vect<double>& x0);
+
+} // namespace thor_scsi
+#endif /* _THOR_SCSI_STD_MACHINE_TWISS_H_ */
+/*
+ * Local Variables:
+ * mode: c++
+ * c++-file-style: "python"
+ * End:
+ */